@@ -1,11 +1,16 @@
 #ifndef ORDER_H
 #define ORDER_H
 
+#include <boost/optional.hpp>
+#include <vector>
 #include "vda5050_msgs/Order.h"
 
 /**
  * @brief Wrapper class to add functionalities to the VDA 5050 Order messages.
  *
+ * Accepting or updating an order computes its geometry: the length of each edge, the distance
+ * along the path and the estimated time of arrival from the first node to each node. Queries of
+ * the geometry take constant time.
  */
 class Order {
  public:
@@ -45,7 +50,7 @@ class Order {
    * order sequence.
    *
    */
-  void Validate();
+  void Validate() const;
 
   // ----- Getters and Setters -----
 
@@ -78,8 +83,73 @@ class Order {
    */
   inline const std::vector<vda5050_msgs::Edge>& GetEdges() const { return order.edges; }
 
+  /**
+   * @brief Get the order message, e.g. to store it.
+   *
+   * @return vda5050_msgs::Order
+   */
+  inline const vda5050_msgs::Order& GetOrderMsg() const { return order; }
+
+  /**
+   * @brief Set the speed of the vehicle, used for edges without a speed limit and as upper bound
+   * of the speed limits of the edges. Applies to orders accepted or updated afterwards.
+   *
+   * @param max_speed Speed in m/s.
+   */
+  inline void SetMaxSpeed(double max_speed) { maxSpeed = max_speed; }
+
+  // ----- Geometry -----
+
+  /**
+   * @brief Get the length of an edge along its trajectory, or the straight distance between its
+   * nodes if it has none.
+   *
+   * @param edge Index of the edge in GetEdges().
+   * @return double Length in m.
+   */
+  inline double GetEdgeLength(size_t edge) const { return edgeLengths[edge]; }
+
+  /**
+   * @brief Get the distance along the path from the first node to a node.
+   *
+   * @param node Index of the node in GetNodes().
+   * @return double Distance in m.
+   */
+  inline double GetDistanceToNode(size_t node) const { return nodeDistances[node]; }
+
+  /**
+   * @brief Get the estimated time to drive from the first node to a node at the speed limits of
+   * the edges.
+   *
+   * @param node Index of the node in GetNodes().
+   * @return double Time in s.
+   */
+  inline double GetEtaToNode(size_t node) const { return nodeEtas[node]; }
+
+  /**
+   * @brief Get the index of a node from its sequence id.
+   *
+   * @param sequence_id Sequence id of the node.
+   * @return boost::optional<size_t> Index in GetNodes(), none if the order has no such node.
+   */
+  boost::optional<size_t> GetNodeIndex(uint32_t sequence_id) const;
+
  private:
   vda5050_msgs::Order order; /**< Order message */
+
+  double maxSpeed{1.0}; /**< Speed of the vehicle in m/s. */
+
+  std::vector<double> edgeLengths;   /**< Length of each edge in m. */
+  std::vector<double> nodeDistances; /**< Distance from the first node to each node in m. */
+  std::vector<double> nodeEtas;      /**< Time from the first node to each node in s. */
+
+  /**
+   * @brief Computes the geometry of the edges from an edge on, the geometry of the edges and nodes
+   * before it is kept.
+   *
+   * @param first_edge Index of the first edge to compute.
+   */
+  void ComputeGeometry(size_t first_edge);
 };
 
 #endif
\ No newline at end of file
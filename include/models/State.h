@@ -2,8 +2,12 @@
 #define STATE_H
 
 #include <boost/optional.hpp>
+#include <utility>
+#include <vector>
 #include "models/Order.h"
+#include "vda5050_msgs/Information.h"
 #include "vda5050_msgs/InteractionZoneStates.h"
+#include "vda5050_msgs/Loads.h"
 #include "vda5050_msgs/Node.h"
 #include "vda5050_msgs/State.h"
 #include "vda5050_msgs/Visualization.h"
@@ -11,6 +15,11 @@
 /**
  * @brief Wrapper class to add functionalities to the VDA 5050 State messages.
  *
+ * The loads, the information, the interaction zones and the node, edge and action states of the
+ * order state are kept as the incoming messages. They are copied into the state message only when
+ * it is composed by GetState(), so messages that are replaced before the next state message are
+ * never copied. The composed message is reused, so composing it again allocates no memory unless
+ * the sections grow.
  */
 class State {
  public:
@@ -84,6 +93,14 @@ class State {
    */
   inline void ClearAllErrors() { state.errors.clear(); };
 
+  /**
+   * @brief Updates the action states with the provided ones. Existing action states are replaced
+   * based on their action id, unknown ones are appended.
+   *
+   * @param action_states
+   */
+  void UpdateActionStates(const std::vector<vda5050_msgs::ActionState>& action_states);
+
   /**
    * @brief Create a Visualization message from the current state message.
    *
@@ -91,6 +108,15 @@ class State {
    */
   vda5050_msgs::Visualization CreateVisualizationMsg();
 
+  /**
+   * @brief Create a copy of the state message without its optional content, used while the uplink
+   * is over budget. Descriptions, edge trajectories and the information messages are left out, the
+   * fields the master control needs to follow the order are kept.
+   *
+   * @return vda5050_msgs::State
+   */
+  vda5050_msgs::State CreateTrimmedStateMsg();
+
   /**
    * @brief Tests if the robot's position is within the deviation range of the provided node.
    *
@@ -102,11 +128,11 @@ class State {
   // ----- Getters and Setters -----
 
   /**
-   * @brief Get the State object
+   * @brief Compose the state message from the kept incoming messages.
    *
-   * @return vda5050_msgs::State
+   * @return The composed message, valid until the state is changed.
    */
-  inline vda5050_msgs::State GetState() { return state; }
+  const vda5050_msgs::State& GetState();
 
   // Header information.
 
@@ -182,14 +208,14 @@ class State {
    *
    * @return std::string
    */
-  inline const std::string& GetOrderId() { return state.orderId; };
+  inline const std::string& GetOrderId() const { return state.orderId; };
 
   /**
    * @brief Return the order update id. 0 is the default value.
    *
    * @return uint32_t
    */
-  inline const uint32_t GetOrderUpdateId() { return state.orderUpdateId; };
+  inline const uint32_t GetOrderUpdateId() const { return state.orderUpdateId; };
 
   // Battery information.
 
@@ -249,15 +275,17 @@ class State {
    *
    * @param errors
    */
-  inline void SetErrors(const std::vector<vda5050_msgs::Error> errors) { state.errors = errors; }
+  inline void SetErrors(std::vector<vda5050_msgs::Error> errors) {
+    state.errors = std::move(errors);
+  }
 
   /**
-   * @brief Set the information array.
+   * @brief Set the information array. The message is kept until the state message is composed.
    *
    * @param information
    */
-  inline void SetInformation(const std::vector<vda5050_msgs::Info> information) {
-    state.information = information;
+  inline void SetInformation(const vda5050_msgs::Information::ConstPtr& information) {
+    this->information = information;
   }
 
   /**
@@ -290,6 +318,13 @@ class State {
     state.agvPosition.theta = theta;
   }
 
+  /**
+   * @brief Get the position of the vehicle on the map, including the map id.
+   *
+   * @return const vda5050_msgs::AGVPosition&
+   */
+  inline const vda5050_msgs::AGVPosition& GetAGVPosition() { return state.agvPosition; }
+
   /**
    * @brief Set the localization score.
    *
@@ -329,11 +364,11 @@ class State {
   inline void SetVelocity(const vda5050_msgs::Velocity vel) { state.velocity = vel; }
 
   /**
-   * @brief Set the vehicle's loads.
+   * @brief Set the vehicle's loads. The message is kept until the state message is composed.
    *
    * @param loads
    */
-  inline void SetLoads(const std::vector<vda5050_msgs::Load> loads) { state.loads = loads; }
+  inline void SetLoads(const vda5050_msgs::Loads::ConstPtr& loads) { this->loads = loads; }
 
   /**
    * @brief Set the value of the paused field.
@@ -370,39 +405,51 @@ class State {
   }
 
   /**
-   * @brief Set the safety state of the vehicle.
+   * @brief Set the interaction zones of the vehicle. The message is kept until the state message is
+   * composed.
    *
    * If the provided zoneStatus is different than 0, then it's forced to 1 to be understood by MC.
    *
-   * @param safety_state
+   * @param interaction_zones
    */
-  inline void SetInteractionZones(const vda5050_msgs::InteractionZoneStates& interaction_zones) {
-    auto zones = interaction_zones;
-
-    for (auto& zone : zones.interactionZones) {
-      if (zone.zoneStatus != 0) zone.zoneStatus = 1;
-    }
-
-    state.interactionZones = zones.interactionZones;
+  inline void SetInteractionZones(
+      const vda5050_msgs::InteractionZoneStates::ConstPtr& interaction_zones) {
+    interactionZones = interaction_zones;
   }
 
   /**
    * @brief Fill the state from a pre-filled state message containing information about the running
-   * order.
+   * order. The node, edge and action states are kept in the message until they are needed.
    *
    */
-  inline void SetOrderState(const vda5050_msgs::State order_state) {
-    state.orderId = order_state.orderId;
-    state.orderUpdateId = order_state.orderUpdateId;
-    state.lastNodeId = order_state.lastNodeId;
-    state.lastNodeSequenceId = order_state.lastNodeSequenceId;
-    state.actionStates = order_state.actionStates;
-    state.nodeStates = order_state.nodeStates;
-    state.edgeStates = order_state.edgeStates;
+  inline void SetOrderState(const vda5050_msgs::State::ConstPtr& order_state) {
+    state.orderId = order_state->orderId;
+    state.orderUpdateId = order_state->orderUpdateId;
+    state.lastNodeId = order_state->lastNodeId;
+    state.lastNodeSequenceId = order_state->lastNodeSequenceId;
+    orderState = order_state;
   }
 
  private:
-  vda5050_msgs::State state; /**< State message */
+  vda5050_msgs::State state; /**< State message, holds the sections of the kept messages once they
+                                  are composed. */
+
+  vda5050_msgs::State::ConstPtr orderState; /**< Order state not yet copied into the state. */
+
+  vda5050_msgs::Loads::ConstPtr loads; /**< Loads not yet copied into the state. */
+
+  vda5050_msgs::Information::ConstPtr
+      information; /**< Information not yet copied into the state. */
+
+  vda5050_msgs::InteractionZoneStates::ConstPtr
+      interactionZones; /**< Interaction zones not yet copied into the state. */
+
+  /**
+   * @brief Copy the node, edge and action states of a kept order state into the state message,
+   * before they are read or changed.
+   *
+   */
+  void ComposeOrderState();
 
   /**
    * @brief Transform a VDA Node to a Node state object.
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef BANDWIDTH_GOVERNOR_H
+#define BANDWIDTH_GOVERNOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mqtt_bridge/outbound_scheduler.h"
+
+namespace mqtt_bridge {
+
+/**
+ * Budget and reaction times of the bandwidth governor.
+ */
+struct GovernorOptions {
+  double budget{0.0}; /**< Uplink budget in bytes per second, the governor is off if zero. */
+
+  double recoverFraction{0.7}; /**< Fraction of the budget the rate has to stay below to recover. */
+
+  double raiseDelay{2.0}; /**< Seconds after a change before the level is raised again. */
+
+  double recoverDelay{10.0}; /**< Seconds the rate has to stay low before the level is lowered. */
+
+  double smoothing{0.5}; /**< Weight of the latest sample in the smoothed rates, in (0, 1]. */
+
+  int maxLevel{3}; /**< Highest throttle level. */
+};
+
+/**
+ * Rate of an outbound topic as measured by the governor.
+ */
+struct TopicRate {
+  std::string topic; /**< MQTT topic. */
+
+  double bytesPerSecond; /**< Smoothed rate of the payload bytes handed to the transport. */
+};
+
+/**
+ * Governor of the uplink bandwidth. It samples the byte counters of the outbound scheduler and
+ * keeps smoothed rates per topic. If the total rate exceeds the budget, the throttle level is
+ * raised by one, at most once per raise delay, so the producers have time to react. Once the rate
+ * stayed below the recover fraction of the budget for the recover delay, the level is lowered by
+ * one again. The gap between both thresholds keeps the level from toggling on a rate close to the
+ * budget.
+ *
+ * The governor only decides on the level, the producers of the messages decide what to leave out,
+ * e.g. the connector stretches the visualization period. Without budget, only the rates are kept.
+ * The governor is not thread-safe.
+ */
+class BandwidthGovernor {
+ public:
+  /**
+   * Constructor for the governor.
+   *
+   * @param options  Budget and reaction times.
+   */
+  explicit BandwidthGovernor(const GovernorOptions& options);
+
+  /**
+   * Samples the byte counters and updates the rates and the level. The first sample only sets the
+   * counters the rates are measured from.
+   *
+   * @param now    Time of the sample in seconds, monotonic.
+   * @param stats  Counters of all topics, in the order of their ids.
+   *
+   * @return       True if the level changed.
+   */
+  bool Update(double now, const std::vector<OutboundStats>& stats);
+
+  /**
+   * Get the throttle level, 0 while the uplink is within its budget.
+   */
+  inline int GetLevel() const { return level; }
+
+  /**
+   * Get the smoothed total rate in bytes per second.
+   */
+  double GetRate() const;
+
+  /**
+   * Get the smoothed rates of all topics.
+   */
+  inline const std::vector<TopicRate>& GetTopicRates() const { return rates; }
+
+  /**
+   * Get the options of the governor.
+   */
+  inline const GovernorOptions& GetOptions() const { return options; }
+
+  /**
+   * Get the number of times the level was raised.
+   */
+  inline uint64_t GetRaises() const { return raises; }
+
+  /**
+   * Get the number of times the level was lowered.
+   */
+  inline uint64_t GetRecoveries() const { return recoveries; }
+
+ private:
+  GovernorOptions options; /**< Budget and reaction times. */
+
+  int level{0}; /**< Current throttle level. */
+
+  bool sampled{false}; /**< True once the first sample was taken. */
+
+  double lastSample{0.0}; /**< Time of the last sample. */
+
+  double lastChange{0.0}; /**< Time of the last change of the level. */
+
+  double lowSince{-1.0}; /**< Time the rate fell below the recover threshold, -1 if above. */
+
+  std::vector<uint64_t> sentBytes; /**< Byte counters of the last sample by topic id. */
+
+  std::vector<TopicRate> rates; /**< Smoothed rates by topic id. */
+
+  uint64_t raises{0}; /**< Number of raises of the level. */
+
+  uint64_t recoveries{0}; /**< Number of recoveries of the level. */
+
+  /**
+   * Raises or lowers the level according to the total rate.
+   *
+   * @param now  Time of the sample in seconds.
+   *
+   * @return     True if the level changed.
+   */
+  bool Govern(double now);
+};
+
+}  // namespace mqtt_bridge
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef CBOR_TRANSCODER_H
+#define CBOR_TRANSCODER_H
+
+#include <string>
+#include <vector>
+#include "mqtt_bridge/json_reader.h"
+#include "mqtt_bridge/json_writer.h"
+
+namespace mqtt_bridge {
+
+/**
+ * Converts CBOR payloads, e.g. the ones of CborWriter, back to standard JSON. Meant for gateways
+ * that receive the binary messages of the vehicles and forward JSON to the master control.
+ *
+ * Any CBOR without byte strings is accepted, as long as map keys are text strings or indexes of
+ * the packed key table and numbers fit into 64 bit. Tags are ignored, undefined becomes null. The
+ * JSON of a CborWriter payload, with or without packed keys, is the same as the one the JsonWriter
+ * writes for the message.
+ *
+ * The transcoder keeps its buffers across payloads. Errors are thrown as DecodeError, with the
+ * byte offset in the CBOR payload.
+ */
+class CborTranscoder {
+ public:
+  explicit CborTranscoder(const DecodeLimits& limits = DecodeLimits());
+
+  /**
+   * Converts a payload.
+   *
+   * @param cbor  CBOR payload holding a single data item.
+   * @param json  Writer to write the JSON to, it is not cleared before.
+   */
+  void ToJson(const std::string& cbor, JsonWriter& json);
+
+ private:
+  /**
+   * Open map or array, for the path of errors.
+   */
+  struct Frame {
+    bool array;      /**< True for arrays. */
+    size_t index;    /**< Number of read elements of an array. */
+    std::string key; /**< Key of the current member of a map. */
+  };
+
+  DecodeLimits limits; /**< Limits of the payloads. */
+
+  const unsigned char* begin{nullptr}; /**< Begin of the payload. */
+  const unsigned char* pos{nullptr};   /**< Current position in the payload. */
+  const unsigned char* end{nullptr};   /**< End of the payload. */
+
+  std::vector<Frame> frames; /**< Open maps and arrays, innermost last. */
+
+  std::string text; /**< Buffer of the current string. */
+
+  /**
+   * Converts the data item at the current position.
+   */
+  void Item(JsonWriter& json);
+
+  /**
+   * Reads the initial byte and the argument of a data item.
+   *
+   * @param major  Set to the major type.
+   * @param info   Set to the additional information, 31 for items of indefinite length.
+   *
+   * @return       Argument of the item.
+   */
+  uint64_t Head(int* major, int* info);
+
+  /**
+   * Reads the characters of a text string whose head was read into the text buffer.
+   *
+   * @param length      Length of the string.
+   * @param indefinite  True if the string is split into chunks.
+   */
+  void Text(uint64_t length, bool indefinite);
+
+  /**
+   * Reads a map key into the text buffer, a text string or a packed key.
+   */
+  void KeyText();
+
+  /**
+   * Returns true and skips the break code if it follows.
+   */
+  bool Break();
+
+  /**
+   * Reads bytes in network byte order.
+   */
+  uint64_t BigEndian(int bytes);
+
+  void Push(bool array);
+
+  std::string Path() const;
+
+  [[noreturn]] void Fail(DecodeError::Code code, const std::string& reason) const;
+};
+
+}  // namespace mqtt_bridge
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mqtt_bridge {
+
+/**
+ * Get the index of a VDA 5050 key in the packed key table, or -1 if the table does not hold it.
+ * The table holds the keys of all messages the encoders write. Its order is part of the payload
+ * format, so keys are only ever appended.
+ *
+ * @param key   Characters of the key.
+ * @param size  Length of the key.
+ */
+int PackedKeyIndex(const char* key, size_t size);
+
+/**
+ * Get the key at an index of the packed key table, or nullptr if the index is out of range.
+ */
+const char* PackedKey(uint64_t index);
+
+/**
+ * Writes CBOR (RFC 8949) with the interface of JsonWriter, so the VDA 5050 encoders write binary
+ * payloads as well. The payloads hold the same data model as the JSON ones: objects are maps with
+ * text keys, numbers are written as integers if they are integral and as single precision floats if
+ * that is exact, double precision floats otherwise. Objects are written with indefinite length, as
+ * their size is not known in advance, arrays with their size.
+ *
+ * With packed keys, keys of the packed key table are written as their index instead of their
+ * text, which takes one or two bytes instead of up to 22. Readers need the table to restore the
+ * keys, like the CborTranscoder does.
+ *
+ * The buffer keeps its capacity across messages, like the one of JsonWriter.
+ */
+class CborWriter {
+ public:
+  /**
+   * Constructor for the writer.
+   *
+   * @param packKeys  True to write keys as indexes of the packed key table.
+   */
+  explicit CborWriter(bool packKeys = false) : packKeys(packKeys) {}
+
+  /**
+   * Clears the buffer while keeping its capacity.
+   */
+  void Clear();
+
+  void BeginObject();
+  void EndObject();
+
+  /**
+   * Begins an array.
+   *
+   * @param size  Number of elements.
+   */
+  void BeginArray(size_t size);
+  void EndArray() {}
+
+  /**
+   * Writes the key of an object member.
+   *
+   * @param key  Key literal.
+   */
+  template <size_t N>
+  void Key(const char (&key)[N]) {
+    int index = packKeys ? PackedKeyIndex(key, N - 1) : -1;
+    if (index >= 0) {
+      AppendHead(UNSIGNED_INT, index);
+      return;
+    }
+    AppendHead(TEXT_STRING, N - 1);
+    buffer.append(key, N - 1);
+  }
+
+  void String(const std::string& value);
+  void Double(double value);
+  void Int(int64_t value);
+  void Uint(uint64_t value);
+  void Bool(bool value);
+  void Null();
+
+  /**
+   * Get the written CBOR.
+   */
+  inline const std::string& str() const { return buffer; }
+
+ private:
+  static constexpr uint8_t UNSIGNED_INT = 0; /**< Major type of unsigned integers. */
+  static constexpr uint8_t TEXT_STRING = 3;  /**< Major type of text strings. */
+
+  bool packKeys; /**< True to write keys as indexes of the packed key table. */
+
+  std::string buffer; /**< Output buffer. */
+
+  /**
+   * Appends the initial byte of a data item and its argument in the shortest form.
+   *
+   * @param major  Major type of the item.
+   * @param value  Argument, e.g. the length of a string or the value of an integer.
+   */
+  void AppendHead(uint8_t major, uint64_t value);
+
+  /**
+   * Appends the lowest bytes of a value in network byte order.
+   */
+  void AppendBigEndian(uint64_t value, int bytes);
+};
+
+}  // namespace mqtt_bridge
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace mqtt_bridge {
+
+/**
+ * Limits of the JSON reader. Payloads exceeding them are rejected before they are decoded
+ * completely.
+ */
+struct DecodeLimits {
+  size_t maxPayloadSize{4 * 1024 * 1024}; /**< Maximum size of a payload in bytes. */
+
+  size_t maxDepth{32}; /**< Maximum nesting depth of objects and arrays. */
+
+  size_t maxArraySize{100000}; /**< Maximum number of elements of an array. */
+
+  size_t maxStringLength{65536}; /**< Maximum length of a string in bytes, as written in JSON. */
+};
+
+/**
+ * Error of the JSON reader. Besides the message, it holds the reason, the offset in the payload
+ * and the path of the value that could not be decoded, e.g. nodes[3].actions[0].actionId.
+ */
+class DecodeError : public std::invalid_argument {
+ public:
+  enum Code {
+    PAYLOAD_TOO_LARGE,  /**< The payload exceeds maxPayloadSize. */
+    SYNTAX,             /**< The payload is no valid JSON. */
+    UNEXPECTED_TYPE,    /**< A value has not the type of the message field. */
+    TOO_DEEP,           /**< Objects and arrays are nested deeper than maxDepth. */
+    ARRAY_TOO_LARGE,    /**< An array has more than maxArraySize elements. */
+    STRING_TOO_LONG,    /**< A string is longer than maxStringLength. */
+    NUMBER_OUT_OF_RANGE /**< A number does not fit into the message field. */
+  };
+
+  DecodeError(Code code, size_t offset, const std::string& path, const std::string& reason);
+
+  Code code() const { return errorCode; }
+  size_t offset() const { return errorOffset; }
+  const std::string& path() const { return errorPath; }
+
+ private:
+  Code errorCode;        /**< Reason of the error. */
+  size_t errorOffset;    /**< Offset in the payload where decoding stopped. */
+  std::string errorPath; /**< Path of the value that could not be decoded. */
+};
+
+/**
+ * Streaming reader for JSON payloads. Unlike a DOM parser, the reader makes a single pass over the
+ * payload and hands out one value at a time, so the decoder can write each value straight into its
+ * message field. Values the decoder is not interested in are skipped without being stored.
+ *
+ * The reader keeps its internal buffers across payloads, so a reader that is reused does not
+ * allocate after the first payloads. All methods throw DecodeError.
+ */
+class JsonReader {
+ public:
+  /**
+   * Characters of a key. Points into the payload or into a buffer of the reader and is valid until
+   * the next key is read.
+   */
+  struct Key {
+    const char* data{nullptr};
+    size_t size{0};
+
+    template <size_t N>
+    bool operator==(const char (&literal)[N]) const {
+      return size == N - 1 && std::char_traits<char>::compare(data, literal, N - 1) == 0;
+    }
+  };
+
+  explicit JsonReader(const DecodeLimits& limits = DecodeLimits());
+
+  /**
+   * Starts reading a payload. The payload has to outlive the reading.
+   *
+   * @param payload  JSON payload.
+   */
+  void Reset(const std::string& payload);
+
+  /**
+   * Checks that nothing but whitespace follows the read value.
+   */
+  void Finish();
+
+  void BeginObject();
+
+  /**
+   * Reads the key of the next member of the current object.
+   *
+   * @param key  Key to fill.
+   *
+   * @return     False if the object ended.
+   */
+  bool NextMember(Key& key);
+
+  void BeginArray();
+
+  /**
+   * Advances to the next element of the current array.
+   *
+   * @return  False if the array ended.
+   */
+  bool NextElement();
+
+  /**
+   * Reads a null value if the next value is null.
+   *
+   * @return  True if a null value was read.
+   */
+  bool ReadNull();
+
+  /**
+   * Reads a string. The string keeps its capacity, so reused strings do not allocate as long as
+   * they are large enough.
+   *
+   * @param value  String to fill.
+   */
+  void ReadString(std::string& value);
+
+  double ReadDouble();
+
+  /**
+   * Reads an integer. Numbers with fraction or exponent are accepted if their value is integral.
+   *
+   * @param min  Smallest accepted value.
+   * @param max  Largest accepted value.
+   */
+  int64_t ReadInt(int64_t min, int64_t max);
+
+  /**
+   * Reads a boolean. The numbers 0 and 1 are accepted as well.
+   */
+  bool ReadBool();
+
+  /**
+   * Skips the next value of any type and returns its JSON text.
+   *
+   * @param text  String to fill with the text of the value.
+   */
+  void ReadRaw(std::string& text);
+
+  /**
+   * Skips the next value of any type.
+   */
+  void Skip();
+
+  /**
+   * Returns true if the next value is a string.
+   */
+  bool PeekString();
+
+  /**
+   * Returns true if the next value is true or false.
+   */
+  bool PeekBool();
+
+  /**
+   * Throws a DecodeError for the current position.
+   *
+   * @param code    Reason of the error.
+   * @param reason  Description of the error.
+   */
+  [[noreturn]] void Fail(DecodeError::Code code, const std::string& reason) const;
+
+ private:
+  /**
+   * Open object or array.
+   */
+  struct Frame {
+    bool array;      /**< True for arrays. */
+    bool first;      /**< True if no member or element was read yet. */
+    size_t index;    /**< Number of read elements of an array. */
+    const char* key; /**< Key of the current member of an object, as written in the payload. */
+    size_t keySize;  /**< Length of the key. */
+  };
+
+  DecodeLimits limits; /**< Limits of the payloads. */
+
+  const char* begin{nullptr}; /**< Begin of the payload. */
+  const char* pos{nullptr};   /**< Current position in the payload. */
+  const char* end{nullptr};   /**< End of the payload. */
+
+  std::vector<Frame> frames; /**< Open objects and arrays, innermost last. */
+
+  std::string keyBuffer; /**< Unescaped key, for keys with escape sequences. */
+
+  /**
+   * Skips whitespace and returns the next character, or 0 at the end of the payload.
+   */
+  char Peek();
+
+  void Expect(char c, const char* what);
+
+  void ExpectLiteral(const char* literal, size_t size);
+
+  void Push(bool array);
+
+  /**
+   * Reads a string whose opening quote was consumed.
+   *
+   * @param value  String to append the unescaped characters to, or nullptr to only skip them.
+   *
+   * @return       True if the string contains escape sequences.
+   */
+  bool ScanString(std::string* value);
+
+  /**
+   * Reads the escape sequence following a backslash and appends its UTF-8 characters.
+   */
+  void ReadEscape(std::string* value);
+
+  /**
+   * Validates the number at the current position and moves behind it.
+   *
+   * @param integral  Set to true if the number has neither fraction nor exponent.
+   *
+   * @return          Begin of the number.
+   */
+  const char* ScanNumber(bool* integral);
+
+  std::string Path() const;
+};
+
+}  // namespace mqtt_bridge
+
+#endif
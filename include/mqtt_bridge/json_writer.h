@@ -0,0 +1,106 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mqtt_bridge {
+
+/**
+ * Writes compact JSON straight into an output buffer. The buffer keeps its capacity across
+ * messages, so a writer that is reused for the same message type stops allocating after the
+ * first messages.
+ *
+ * The writer does not validate the structure, the caller has to begin and end objects and arrays
+ * in the right order. Numbers are formatted with the C locale conventions of snprintf.
+ */
+class JsonWriter {
+ public:
+  /**
+   * Clears the buffer while keeping its capacity.
+   */
+  void Clear();
+
+  void BeginObject();
+  void EndObject();
+
+  /**
+   * Begins an array.
+   *
+   * @param size  Number of elements. Not needed for JSON, but for other encodings.
+   */
+  void BeginArray(size_t size);
+  void EndArray();
+
+  /**
+   * Writes the key of an object member. Keys are string literals, their length is known at compile
+   * time and they are copied without escaping.
+   *
+   * @param key  Key literal.
+   */
+  template <size_t N>
+  void Key(const char (&key)[N]) {
+    Separate();
+    buffer += '"';
+    buffer.append(key, N - 1);
+    buffer.append("\":", 2);
+    afterKey = true;
+  }
+
+  /**
+   * Writes a key that is only known at runtime, e.g. when converting from another encoding. The key
+   * is escaped like a string.
+   *
+   * @param key  Key of the member.
+   */
+  void DynamicKey(const std::string& key);
+
+  void String(const std::string& value);
+  void Double(double value);
+  void Int(int64_t value);
+  void Uint(uint64_t value);
+  void Bool(bool value);
+  void Null();
+
+  /**
+   * Get the written JSON.
+   */
+  inline const std::string& str() const { return buffer; }
+
+ private:
+  std::string buffer; /**< Output buffer. */
+
+  bool first{true}; /**< True if no element was written to the current object or array yet. */
+
+  bool afterKey{false}; /**< True if the last written element is a key. */
+
+  /**
+   * Writes the comma before an element if needed.
+   */
+  inline void Separate() {
+    if (afterKey)
+      afterKey = false;
+    else if (!first)
+      buffer += ',';
+    first = false;
+  }
+
+  /**
+   * Appends the digits of an unsigned integer.
+   */
+  void AppendDigits(uint64_t value);
+};
+
+}  // namespace mqtt_bridge
+
+#endif
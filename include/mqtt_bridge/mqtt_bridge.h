@@ -0,0 +1,349 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef MQTT_BRIDGE_H
+#define MQTT_BRIDGE_H
+
+#include <ros/ros.h>
+#include <boost/function.hpp>
+#include <boost/make_shared.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "diagnostic_msgs/DiagnosticArray.h"
+#include "mqtt_bridge/bandwidth_governor.h"
+#include "mqtt_bridge/cbor_writer.h"
+#include "mqtt_bridge/mqtt_client.h"
+#include "mqtt_bridge/outbound_scheduler.h"
+#include "mqtt_bridge/vda5050_json.h"
+#include "std_msgs/Bool.h"
+#include "std_msgs/String.h"
+#include "std_msgs/UInt8.h"
+#include "utils/param_tree.h"
+
+namespace mqtt_bridge {
+
+class MqttBridge;
+
+/**
+ * Converts the MQTT payloads of a MQTT to ROS bridge and publishes them to ROS.
+ */
+typedef boost::function<void(const std::string& payload)> MqttToRosRoute;
+
+/**
+ * Encoding of the payloads sent to MQTT.
+ */
+enum class PayloadEncoding {
+  JSON,       /**< Standard VDA 5050 JSON. */
+  CBOR,       /**< CBOR with the data model of the JSON, converted back e.g. by a CborTranscoder. */
+  CBOR_PACKED /**< CBOR with the keys written as indexes of the packed key table. */
+};
+
+/**
+ * Binding of a msg_type of the bridge configuration to the typed conversion functions. The QoS
+ * and retain flag of the MQTT messages follow the VDA 5050 topic definitions, the priority and
+ * drop policy are the defaults of the outbound parameters.
+ */
+struct MessageBinding {
+  const char* msgType; /**< Type as written in the configuration, e.g. vda5050_msgs.msg:State. */
+
+  int qos; /**< QoS of the MQTT messages of this type. */
+
+  bool retain; /**< True if the broker retains the MQTT messages of this type. */
+
+  int priority; /**< Priority of outbound messages of this type. */
+
+  DropPolicy dropPolicy; /**< Policy for outbound messages of this type waiting for the uplink. */
+
+  bool spool; /**< True if outbound messages of this type are spooled while the uplink is down. */
+
+  ros::Subscriber (*subscribe)(MqttBridge*, ros::NodeHandle*, const std::string& rosTopic,
+      size_t outboundTopic, PayloadEncoding encoding); /**< Links a ROS to MQTT bridge. */
+
+  MqttToRosRoute (*advertise)(ros::NodeHandle*, const std::string& rosTopic,
+      const DecodeLimits& limits); /**< Links a MQTT to ROS bridge. */
+};
+
+/**
+ * Vehicle of a bridge that links the topics of several vehicles over one connection.
+ */
+struct BridgedVehicle {
+  std::string serialNumber; /**< Serial number, replaces {serial_number} in the MQTT topics. */
+
+  std::string ns; /**< Namespace the ROS topics of the vehicle are resolved in. */
+};
+
+/**
+ * Bridge between the ROS topics of the connector and the MQTT topics of the master control. The
+ * bridge reads the configuration of the Python mqtt_bridge (config/mqtt_bridge.yaml) and converts
+ * the VDA 5050 messages directly to and from JSON.
+ *
+ * If a Connection message is bridged to MQTT, a CONNECTIONBROKEN message is registered as last
+ * will on its MQTT topic.
+ *
+ * Messages to MQTT pass an OutboundScheduler, so state messages are not delayed by visualization
+ * messages when the uplink is slow. Queue depths and drop counts are published on /diagnostics.
+ *
+ * If a spool directory is configured, state messages produced while the broker is unreachable are
+ * kept in a ring file and replayed at a limited rate after the reconnect, so the master control
+ * receives them without gaps. The state of the link is published as std_msgs/Bool, so the
+ * connector only reports ONLINE while the messages reach the broker.
+ *
+ * Messages to MQTT can be encoded as CBOR instead of JSON per message type, e.g. for vehicles on
+ * metered links. The receiver has to know the encoding of the topic, MQTT 3.1.1 cannot tell it.
+ *
+ * A BandwidthGovernor measures the bytes sent per topic. If an uplink budget is configured, its
+ * throttle level is published as latched std_msgs/UInt8, so the connector can send less while the
+ * uplink is over budget. Rates and level are part of the diagnostics.
+ *
+ * A bridge may serve several vehicles, e.g. in a VehicleHost. Each bridge of the configuration is
+ * then linked once per vehicle, and no last will is registered, as it would apply to all of them.
+ */
+class MqttBridge {
+ public:
+  /**
+   * Constructs the bridge from the parameters of the private namespace and connects to the broker.
+   */
+  MqttBridge();
+
+  /**
+   * Constructs a bridge running with given node handles, e.g. inside a nodelet.
+   *
+   * @param nh          Node handle used for topics.
+   * @param private_nh  Node handle of the private namespace that holds the bridge configuration.
+   */
+  MqttBridge(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh);
+
+  /**
+   * Constructs a bridge of several vehicles over one connection.
+   *
+   * @param nh          Node handle used for topics.
+   * @param private_nh  Node handle of the private namespace that holds the bridge configuration.
+   * @param vehicles    Vehicles to link the bridges of the configuration for. If empty, they are
+   *                    linked once with the topics as configured.
+   */
+  MqttBridge(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh,
+      const std::vector<BridgedVehicle>& vehicles);
+
+  /**
+   * Disconnects from the broker before the members are destroyed, as the network loop calls back
+   * into the bridge until it is stopped.
+   */
+  ~MqttBridge();
+
+  /**
+   * Publishes a message to MQTT. The message waits in the outbound scheduler until the uplink has
+   * capacity.
+   *
+   * @param outboundTopic  Id of the MQTT topic in the outbound scheduler.
+   * @param payload        Payload of the message.
+   */
+  void PublishToMqtt(size_t outboundTopic, const std::string& payload);
+
+  /**
+   * Callback for messages from the broker. Converts the message and publishes it to ROS.
+   *
+   * @param topic    MQTT topic.
+   * @param payload  Payload of the message.
+   */
+  void MqttMessageCallback(const std::string& topic, const std::string& payload);
+
+ private:
+  ros::NodeHandle nh; /**< Node handle used for topics. */
+
+  ros::NodeHandle privateNh; /**< Node handle of the private namespace. */
+
+  connector_utils::ParamTree
+      params; /**< Configuration of the private namespace, fetched once at construction. */
+
+  std::unique_ptr<MqttClient> client; /**< Client connected to the broker. */
+
+  std::unique_ptr<OutboundScheduler> scheduler; /**< Scheduler of the messages to MQTT. */
+
+  ros::Publisher diagnosticsPub; /**< Publisher of the outbound queue diagnostics. */
+
+  ros::Timer diagnosticsTimer; /**< Timer used to publish the diagnostics regularly. */
+
+  ros::Publisher linkStatePub; /**< Publisher of the state of the link to the broker. */
+
+  ros::Timer replayTimer; /**< Timer used to replay the spooled messages at a limited rate. */
+
+  std::unique_ptr<BandwidthGovernor> governor; /**< Governor of the uplink bandwidth. */
+
+  ros::Publisher throttlePub; /**< Publisher of the throttle level of the governor. */
+
+  ros::Timer governorTimer; /**< Timer used to sample the sent bytes. */
+
+  std::string spoolDirectory; /**< Directory of the spool files, spooling is off if empty. */
+
+  size_t spoolCapacity; /**< Capacity of each spool file in bytes. */
+
+  DecodeLimits decodeLimits; /**< Limits of the payloads received from MQTT. */
+
+  std::vector<BridgedVehicle> vehicles; /**< Vehicles of the bridge, empty for a single vehicle. */
+
+  std::vector<ros::Subscriber> subscribers; /**< Subscribers of the ROS to MQTT bridges. */
+
+  std::unordered_map<std::string, MqttToRosRoute>
+      mqttToRosRoutes; /**< MQTT to ROS bridges by MQTT topic. */
+
+  static const MessageBinding messageBindings[]; /**< Supported message types. */
+
+  /**
+   * Reads the broker options from the mqtt parameters.
+   */
+  MqttOptions ReadMqttOptions();
+
+  /**
+   * Reads the limits of the received payloads from the decoder parameters.
+   */
+  void ReadDecodeLimits();
+
+  /**
+   * Reads the outbound scheduling policy of a message type. The parameters
+   * outbound/<type>/priority, drop_policy and queue_depth override the defaults of the binding.
+   *
+   * @param binding  Binding of the message type.
+   */
+  OutboundPolicy ReadOutboundPolicy(const MessageBinding& binding);
+
+  /**
+   * Reads the payload encoding of a message type from the parameter outbound/<type>/encoding,
+   * json, cbor or cbor_packed. Defaults to json.
+   *
+   * @param binding  Binding of the message type.
+   */
+  PayloadEncoding ReadPayloadEncoding(const MessageBinding& binding);
+
+  /**
+   * Opens the spool of an outbound topic in the spool directory. Errors are reported and leave the
+   * topic without spool.
+   *
+   * @param outboundTopic  Id of the MQTT topic in the outbound scheduler.
+   * @param mqttTopic      MQTT topic, names the spool file.
+   */
+  void OpenSpool(size_t outboundTopic, const std::string& mqttTopic);
+
+  /**
+   * Reads the budget and reaction times of the bandwidth governor from the governor parameters.
+   */
+  GovernorOptions ReadGovernorOptions();
+
+  /**
+   * Samples the sent bytes and publishes the throttle level if the governor changed it.
+   */
+  void UpdateGovernor(const ros::TimerEvent& event);
+
+  /**
+   * Publishes the queue depths and counters of the outbound topics and the state of the governor.
+   */
+  void PublishDiagnostics(const ros::TimerEvent& event);
+
+  /**
+   * Links all bridges of the bridge parameter. Sets the last will if a Connection message is
+   * bridged to MQTT.
+   *
+   * @param options  Broker options to set the last will in.
+   */
+  void LinkBridges(MqttOptions* options);
+
+  /**
+   * Links a bridge of the configuration for one vehicle.
+   *
+   * @param binding    Binding of the message type.
+   * @param rosToMqtt  True to bridge from ROS to MQTT.
+   * @param rosTopic   ROS topic.
+   * @param mqttTopic  MQTT topic.
+   * @param options    Broker options to set the last will in, nullptr if no will may be set.
+   */
+  void LinkBridge(const MessageBinding& binding, bool rosToMqtt, const std::string& rosTopic,
+      const std::string& mqttTopic, MqttOptions* options);
+
+  /**
+   * Creates the payload of the last will, a CONNECTIONBROKEN connection message.
+   *
+   * @param encoding  Encoding of the connection topic.
+   */
+  std::string CreateWillPayload(PayloadEncoding encoding);
+
+  template <typename M>
+  static ros::Subscriber SubscribeRos(MqttBridge* bridge, ros::NodeHandle* nh,
+      const std::string& rosTopic, size_t outboundTopic, PayloadEncoding encoding) {
+    // Each subscription gets its own writer, as its callbacks are never called concurrently.
+    if (encoding == PayloadEncoding::JSON)
+      return SubscribeRosWith<M>(
+          bridge, nh, rosTopic, outboundTopic, std::make_shared<JsonWriter>());
+    return SubscribeRosWith<M>(bridge, nh, rosTopic, outboundTopic,
+        std::make_shared<CborWriter>(encoding == PayloadEncoding::CBOR_PACKED));
+  }
+
+  template <typename M, typename Writer>
+  static ros::Subscriber SubscribeRosWith(MqttBridge* bridge, ros::NodeHandle* nh,
+      const std::string& rosTopic, size_t outboundTopic, const std::shared_ptr<Writer>& writer) {
+    boost::function<void(const boost::shared_ptr<M const>&)> callback =
+        [bridge, outboundTopic, writer](const boost::shared_ptr<M const>& msg) {
+          writer->Clear();
+          Encode(*writer, *msg);
+          bridge->PublishToMqtt(outboundTopic, writer->str());
+        };
+    return nh->subscribe<M>(rosTopic, 100, callback);
+  }
+
+  /**
+   * Links a ROS to MQTT bridge for a message type without a ROS message, whose payloads are sent
+   * as they are published in the data of String messages.
+   */
+  static ros::Subscriber SubscribeRaw(MqttBridge* bridge, ros::NodeHandle* nh,
+      const std::string& rosTopic, size_t outboundTopic, PayloadEncoding encoding) {
+    boost::function<void(const std_msgs::String::ConstPtr&)> callback =
+        [bridge, outboundTopic](const std_msgs::String::ConstPtr& msg) {
+          bridge->PublishToMqtt(outboundTopic, msg->data);
+        };
+    return nh->subscribe<std_msgs::String>(rosTopic, 100, callback);
+  }
+
+  /**
+   * Links a MQTT to ROS bridge for a message type without a ROS message. The payloads are
+   * published unchanged in the data of String messages, to be decoded by the subscriber.
+   */
+  static MqttToRosRoute AdvertiseRaw(
+      ros::NodeHandle* nh, const std::string& rosTopic, const DecodeLimits& limits) {
+    ros::Publisher publisher = nh->advertise<std_msgs::String>(rosTopic, 10);
+    size_t maxPayloadSize = limits.maxPayloadSize;
+    return [publisher, maxPayloadSize](const std::string& payload) {
+      if (payload.size() > maxPayloadSize)
+        throw DecodeError(DecodeError::PAYLOAD_TOO_LARGE, 0, "",
+            "Payload of " + std::to_string(payload.size()) + " bytes exceeds " +
+                std::to_string(maxPayloadSize) + " bytes");
+      boost::shared_ptr<std_msgs::String> msg = boost::make_shared<std_msgs::String>();
+      msg->data = payload;
+      publisher.publish(msg);
+    };
+  }
+
+  template <typename M>
+  static MqttToRosRoute AdvertiseRos(
+      ros::NodeHandle* nh, const std::string& rosTopic, const DecodeLimits& limits) {
+    ros::Publisher publisher = nh->advertise<M>(rosTopic, 100);
+    // Payloads are decoded into the message of the previous payload, unless a subscriber still
+    // holds it.
+    std::shared_ptr<JsonReader> reader = std::make_shared<JsonReader>(limits);
+    std::shared_ptr<boost::shared_ptr<M>> msg = std::make_shared<boost::shared_ptr<M>>();
+    return [publisher, reader, msg](const std::string& payload) {
+      if (!*msg || !msg->unique()) *msg = boost::make_shared<M>();
+      Decode(*reader, payload, **msg);
+      publisher.publish(*msg);
+    };
+  }
+};
+
+}  // namespace mqtt_bridge
+
+#endif
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef MQTT_CLIENT_H
+#define MQTT_CLIENT_H
+
+#include <mosquitto.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mqtt_bridge {
+
+/**
+ * Options of the connection to the MQTT broker.
+ */
+struct MqttOptions {
+  std::string host{"localhost"}; /**< Hostname of the broker. */
+
+  int port{1883}; /**< Port of the broker. */
+
+  int keepalive{60}; /**< Keepalive interval in seconds. */
+
+  std::string clientId; /**< Client ID. A random ID is used if empty. */
+
+  std::string username; /**< User name. No credentials are sent if empty. */
+
+  std::string password; /**< Password of the user. */
+
+  std::string caCerts; /**< Path of the root certificate. TLS is used if set. */
+
+  std::string certFile; /**< Path of the client certificate. Optional for TLS. */
+
+  std::string keyFile; /**< Path of the private key of the client certificate. */
+
+  std::string willTopic; /**< Topic of the last will. No last will is set if empty. */
+
+  std::string willPayload; /**< Payload of the last will. */
+
+  int willQos{1}; /**< QoS of the last will. */
+
+  bool willRetain{true}; /**< True if the broker retains the last will. */
+};
+
+/**
+ * Thin wrapper around a libmosquitto client. The network loop runs in a background thread that
+ * reconnects automatically and renews the subscriptions after each reconnect. Callbacks are
+ * called from that thread.
+ */
+class MqttClient {
+ public:
+  using MessageCallback = std::function<void(const std::string& topic, const std::string& payload)>;
+
+  using ConnectionCallback = std::function<void(bool connected)>;
+
+  using PublishedCallback = std::function<void()>;
+
+  /**
+   * Creates a client. The connection is established by Connect().
+   *
+   * @param options  Options of the connection.
+   */
+  explicit MqttClient(const MqttOptions& options);
+
+  MqttClient(const MqttClient&) = delete;
+  MqttClient& operator=(const MqttClient&) = delete;
+
+  /**
+   * Disconnects from the broker and stops the network loop.
+   */
+  ~MqttClient();
+
+  /**
+   * Starts the network loop and connects to the broker. Callbacks and subscriptions should be set
+   * up before, as the loop runs in its own thread afterwards. If the broker is not reachable, the
+   * loop keeps trying to connect.
+   *
+   * @throws std::runtime_error if the options are invalid, e.g. TLS certificates are missing.
+   */
+  void Connect();
+
+  /**
+   * Disconnects gracefully from the broker, so the last will is not sent.
+   */
+  void Disconnect();
+
+  /**
+   * Publishes a message.
+   *
+   * @param topic    Topic to publish to.
+   * @param payload  Payload of the message.
+   * @param qos      Quality of service level.
+   * @param retain   True if the broker retains the message.
+   *
+   * @return         true if the message was queued for sending.
+   */
+  bool Publish(const std::string& topic, const std::string& payload, int qos, bool retain);
+
+  /**
+   * Subscribes to a topic. The subscription is renewed on each reconnect.
+   *
+   * @param topic  Topic to subscribe to.
+   * @param qos    Quality of service level.
+   */
+  void Subscribe(const std::string& topic, int qos);
+
+  /**
+   * Sets the callback for incoming messages.
+   */
+  void SetMessageCallback(const MessageCallback& callback);
+
+  /**
+   * Sets the callback for changes of the connection to the broker.
+   */
+  void SetConnectionCallback(const ConnectionCallback& callback);
+
+  /**
+   * Sets the callback for published messages. It is called once a message of QoS 0 was written to
+   * the network or a message of QoS 1 or 2 was acknowledged by the broker.
+   */
+  void SetPublishedCallback(const PublishedCallback& callback);
+
+  /**
+   * Checks if the client is connected to the broker.
+   */
+  inline bool IsConnected() const { return connected; }
+
+ private:
+  struct mosquitto* mosq; /**< libmosquitto client handle. */
+
+  MqttOptions options; /**< Options of the connection. */
+
+  std::vector<std::pair<std::string, int>>
+      subscriptions; /**< Subscribed topics and their QoS, renewed on each reconnect. */
+
+  std::mutex subscriptionsMutex; /**< Guards subscriptions against the network loop thread. */
+
+  MessageCallback messageCallback; /**< Callback for incoming messages. */
+
+  ConnectionCallback connectionCallback; /**< Callback for changes of the connection. */
+
+  PublishedCallback publishedCallback; /**< Callback for published messages. */
+
+  std::atomic<bool> connected; /**< True if the client is connected to the broker. */
+
+  bool loopRunning; /**< True if the network loop thread runs. */
+
+  static void OnConnect(struct mosquitto* mosq, void* obj, int rc);
+
+  static void OnDisconnect(struct mosquitto* mosq, void* obj, int rc);
+
+  static void OnPublish(struct mosquitto* mosq, void* obj, int mid);
+
+  static void OnMessage(struct mosquitto* mosq, void* obj, const struct mosquitto_message* msg);
+};
+
+}  // namespace mqtt_bridge
+
+#endif
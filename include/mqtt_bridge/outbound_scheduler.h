@@ -0,0 +1,237 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef OUTBOUND_SCHEDULER_H
+#define OUTBOUND_SCHEDULER_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "mqtt_bridge/spool.h"
+
+namespace mqtt_bridge {
+
+/**
+ * Policy for messages that wait for the transport.
+ */
+enum class DropPolicy {
+  NEVER_DROP,  /**< All messages are sent in order, the queue is unbounded. */
+  DROP_OLDEST, /**< The oldest message is dropped if the queue is full. */
+  LATEST_ONLY  /**< Only the latest message is kept, older ones are replaced. */
+};
+
+/**
+ * Parses a drop policy from its configuration name: never_drop, drop_oldest or latest_only.
+ *
+ * @param name    Name of the policy.
+ * @param policy  Policy to set.
+ *
+ * @return        False if the name is unknown.
+ */
+bool ParseDropPolicy(const std::string& name, DropPolicy* policy);
+
+/**
+ * Returns the configuration name of a drop policy.
+ */
+const char* DropPolicyName(DropPolicy policy);
+
+/**
+ * Scheduling policy of an outbound topic.
+ */
+struct OutboundPolicy {
+  int priority{0}; /**< Messages of higher priorities are sent first. */
+
+  DropPolicy dropPolicy{DropPolicy::DROP_OLDEST}; /**< Policy for waiting messages. */
+
+  size_t queueDepth{10}; /**< Maximum number of waiting messages for DROP_OLDEST. */
+};
+
+/**
+ * Queue depth and counters of an outbound topic.
+ */
+struct OutboundStats {
+  std::string topic; /**< MQTT topic. */
+
+  OutboundPolicy policy; /**< Scheduling policy of the topic. */
+
+  size_t depth; /**< Number of waiting messages. */
+
+  uint64_t sent; /**< Number of messages handed to the transport. */
+
+  uint64_t sentBytes; /**< Number of payload bytes handed to the transport. */
+
+  uint64_t dropped; /**< Number of messages dropped by the drop policy or the spool. */
+
+  size_t spooled; /**< Number of messages in the spool. */
+};
+
+/**
+ * Scheduler between the outbound messages of the bridge and the MQTT transport. Only a limited
+ * number of messages is handed to the transport at once. The others wait in one queue per topic,
+ * where the drop policy of the topic applies, until the transport reports a message as published.
+ * The next message is taken from the queue of the highest priority, messages of equal priorities
+ * are sent in the order they arrived.
+ *
+ * A topic may have a spool that keeps its messages while the transport is disconnected, instead of
+ * the queue. After the reconnect, the spooled messages are sent in order before any newer message
+ * of the topic, but only as many per ReplaySpools call as its budget allows, so the backlog does
+ * not flood the uplink. A spooled message is removed once the transport took it.
+ *
+ * Topics are added before messages are enqueued. All other methods may be called from any thread,
+ * the send function is never called with the internal lock held.
+ */
+class OutboundScheduler {
+ public:
+  /**
+   * Hands a message to the transport.
+   *
+   * @return  False if the transport could not take the message, e.g. because it is disconnected.
+   */
+  using SendFunction = std::function<bool(
+      const std::string& topic, const std::string& payload, int qos, bool retain)>;
+
+  /**
+   * Constructor for the scheduler.
+   *
+   * @param send         Function handing messages to the transport.
+   * @param maxInFlight  Maximum number of messages handed to the transport and not yet published.
+   */
+  OutboundScheduler(const SendFunction& send, size_t maxInFlight);
+
+  /**
+   * Adds an outbound topic.
+   *
+   * @param topic   MQTT topic.
+   * @param qos     QoS of the messages.
+   * @param retain  True if the broker retains the messages.
+   * @param policy  Scheduling policy of the topic.
+   *
+   * @return        Id of the topic for Enqueue.
+   */
+  size_t AddTopic(const std::string& topic, int qos, bool retain, const OutboundPolicy& policy);
+
+  /**
+   * Attaches a spool to a topic. Messages the spool still holds, e.g. from before a restart, are
+   * sent after the next connect.
+   *
+   * @param topicId  Id of the topic as returned by AddTopic.
+   * @param spool    Spool of the topic.
+   */
+  void AttachSpool(size_t topicId, std::unique_ptr<Spool> spool);
+
+  /**
+   * Enqueues a message and sends it if the transport has capacity.
+   *
+   * @param topicId  Id of the topic as returned by AddTopic.
+   * @param payload  Payload of the message.
+   */
+  void Enqueue(size_t topicId, const std::string& payload);
+
+  /**
+   * Reports that the transport published a message and sends the next ones.
+   */
+  void OnPublished();
+
+  /**
+   * Sets the state of the connection. Messages are only sent while connected, messages the
+   * transport did not take are sent again with the next event, e.g. the reconnect. On a
+   * disconnect, the waiting messages of topics with a spool are moved into the spool.
+   *
+   * @param connected  True if the transport is connected.
+   */
+  void SetConnected(bool connected);
+
+  /**
+   * Allows each spool to send the given number of messages and sends them if the transport has
+   * capacity. Unused budget does not accumulate. Spools with new messages are synced to the disk.
+   *
+   * @param budget  Number of spooled messages each topic may send until the next call.
+   */
+  void ReplaySpools(size_t budget);
+
+  /**
+   * Get the queue depths and counters of all topics.
+   */
+  std::vector<OutboundStats> GetStats() const;
+
+  /**
+   * Get the number of messages handed to the transport and not yet published.
+   */
+  size_t GetInFlight() const;
+
+ private:
+  /**
+   * Waiting message.
+   */
+  struct Message {
+    uint64_t sequence;   /**< Arrival number, orders messages of equal priorities. */
+    std::string payload; /**< Payload of the message. */
+  };
+
+  /**
+   * Queue of an outbound topic.
+   */
+  struct TopicQueue {
+    std::string topic;            /**< MQTT topic. */
+    int qos;                      /**< QoS of the messages. */
+    bool retain;                  /**< True if the broker retains the messages. */
+    OutboundPolicy policy;        /**< Scheduling policy. */
+    std::deque<Message> messages; /**< Waiting messages, oldest first. */
+    uint64_t sent;                /**< Number of messages handed to the transport. */
+    uint64_t sentBytes;           /**< Number of payload bytes handed to the transport. */
+    uint64_t dropped;             /**< Number of dropped messages. */
+    std::unique_ptr<Spool> spool; /**< Spool used while disconnected, or nullptr. */
+    size_t replayBudget;          /**< Number of spooled messages that may still be sent. */
+  };
+
+  SendFunction send; /**< Function handing messages to the transport. */
+
+  size_t maxInFlight; /**< Maximum number of messages in flight. */
+
+  size_t inFlight{0}; /**< Number of messages handed to the transport and not yet published. */
+
+  bool connected{false}; /**< True if the transport is connected. */
+
+  bool dispatching{false}; /**< True while a thread hands messages to the transport. */
+
+  bool retryPending{false}; /**< True if an event arrived while a thread was dispatching. */
+
+  uint64_t nextSequence{0}; /**< Arrival number of the next message. */
+
+  std::vector<TopicQueue> queues; /**< Queues of all topics by id. */
+
+  std::string replayPayload; /**< Buffer of the spooled message being sent. */
+
+  mutable std::mutex mutex; /**< Guards all members against concurrent access. */
+
+  /**
+   * Hands messages to the transport as long as it has capacity. Only one thread dispatches at a
+   * time, so messages of a topic keep their order.
+   */
+  void Dispatch();
+
+  /**
+   * Appends a message to the spool of a topic and counts the messages dropped by the spool.
+   */
+  void AppendToSpool(TopicQueue& queue, const std::string& payload);
+
+  /**
+   * Get the queue to send from next, or nullptr if all queues are empty. The waiting messages of a
+   * topic are sent before its spooled ones.
+   */
+  TopicQueue* NextQueue();
+};
+
+}  // namespace mqtt_bridge
+
+#endif
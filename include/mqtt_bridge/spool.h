@@ -0,0 +1,132 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef SPOOL_H
+#define SPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "utils/mapped_file.h"
+
+namespace mqtt_bridge {
+
+/**
+ * Bounded first-in first-out store of payloads in a memory-mapped ring file. Payloads are written
+ * into the mapped memory, so the spool survives a restart of the bridge; Sync() also makes it
+ * survive a power loss. If the spool is full, the oldest payloads are dropped.
+ *
+ * The file starts with a header holding the positions of the oldest and the next payload, followed
+ * by the ring of records. Each record consists of the payload size, a checksum and the payload.
+ * Records that are incomplete or damaged when the file is opened are discarded together with all
+ * following ones.
+ *
+ * The spool is not thread-safe. The constructor throws std::runtime_error if the file cannot be
+ * mapped or the capacity cannot hold a record.
+ */
+class Spool {
+ public:
+  /**
+   * Opens the spool of a file or creates it. A file created with another capacity is cleared.
+   *
+   * @param path      Path of the ring file.
+   * @param capacity  Capacity of the ring in bytes, including 8 bytes per record.
+   */
+  Spool(const std::string& path, size_t capacity);
+
+  /**
+   * Appends a payload. The oldest payloads are dropped until the payload fits.
+   *
+   * @param payload  Payload to append.
+   * @param dropped  Set to the number of dropped payloads.
+   *
+   * @return         False if the payload is larger than the capacity and was not appended.
+   */
+  bool Append(const std::string& payload, size_t* dropped);
+
+  /**
+   * Reads the oldest payload without removing it.
+   *
+   * @param payload  String to fill, keeps its capacity.
+   *
+   * @return         False if the spool is empty.
+   */
+  bool Front(std::string* payload) const;
+
+  /**
+   * Removes the oldest payload.
+   */
+  void Pop();
+
+  /**
+   * Get the position of the oldest payload. The position changes whenever the oldest payload is
+   * removed or dropped.
+   */
+  uint64_t Head() const;
+
+  bool Empty() const;
+
+  /**
+   * Get the number of stored payloads.
+   */
+  size_t Size() const;
+
+  /**
+   * Writes all appended payloads to the disk, if any were appended since the last call.
+   */
+  void Sync();
+
+ private:
+  /**
+   * Header at the begin of the file. Positions count bytes since the ring was created and are
+   * taken modulo the capacity.
+   */
+  struct Header {
+    uint32_t magic;    /**< Identifies spool files. */
+    uint32_t version;  /**< Version of the file layout. */
+    uint64_t capacity; /**< Capacity of the ring in bytes. */
+    uint64_t head;     /**< Position of the oldest record. */
+    uint64_t tail;     /**< Position behind the newest record. */
+    uint64_t count;    /**< Number of stored records. */
+  };
+
+  connector_utils::MappedFile file; /**< Mapped ring file. */
+
+  Header* header; /**< Header in the mapped file. */
+
+  char* ring; /**< Ring of records in the mapped file. */
+
+  uint64_t capacity; /**< Capacity of the ring in bytes. */
+
+  bool dirty{false}; /**< True if payloads were appended since the last sync. */
+
+  /**
+   * Validates the records of an opened file, or initializes the header of a new file.
+   */
+  void Recover();
+
+  /**
+   * Copies bytes out of the ring, wrapping around its end.
+   */
+  void Read(uint64_t position, void* data, size_t size) const;
+
+  /**
+   * Copies bytes into the ring, wrapping around its end.
+   */
+  void Write(uint64_t position, const void* data, size_t size);
+
+  /**
+   * Reads the payload size of the record at a position.
+   */
+  uint32_t RecordSize(uint64_t position) const;
+};
+
+}  // namespace mqtt_bridge
+
+#endif
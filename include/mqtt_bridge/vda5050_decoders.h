@@ -0,0 +1,58 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef VDA5050_DECODERS_H
+#define VDA5050_DECODERS_H
+
+#include <string>
+#include "mqtt_bridge/json_reader.h"
+#include "utils/zone_index.h"
+#include "vda5050_msgs/Connection.h"
+#include "vda5050_msgs/InstantAction.h"
+#include "vda5050_msgs/Order.h"
+#include "vda5050_msgs/State.h"
+#include "vda5050_msgs/Visualization.h"
+
+/**
+ * Streaming decoders of the VDA 5050 messages. The decoders read a payload in one pass and write
+ * each value straight into the field of the same name, unknown keys are skipped.
+ *
+ * The message is overwritten in place: strings and vectors keep their capacity and the elements of
+ * vectors are decoded into the existing elements. Decoding into the same message again therefore
+ * does not allocate as long as the payloads do not grow. Fields whose key is missing or null are
+ * reset to their default value.
+ */
+namespace mqtt_bridge {
+
+/**
+ * Decodes a JSON payload into a message.
+ *
+ * @param reader   Reader used for the payload, holds the limits.
+ * @param payload  JSON payload.
+ * @param msg      Message to overwrite.
+ *
+ * @throws DecodeError if the payload is no valid JSON, exceeds the limits of the reader or a value
+ *         does not fit into its message field. The message is left partially decoded then.
+ */
+void Decode(JsonReader& reader, const std::string& payload, vda5050_msgs::State& msg);
+void Decode(JsonReader& reader, const std::string& payload, vda5050_msgs::Visualization& msg);
+void Decode(JsonReader& reader, const std::string& payload, vda5050_msgs::Connection& msg);
+void Decode(JsonReader& reader, const std::string& payload, vda5050_msgs::Order& msg);
+void Decode(JsonReader& reader, const std::string& payload, vda5050_msgs::InstantAction& msg);
+
+/**
+ * Decodes the JSON payload of the zones topic, which has no ROS message, e.g.
+ * {"zoneSetId": "hall_1", "mapId": "map_1", "zones": [{"zoneId": "dock", "zoneType": "INTERACTION",
+ * "vertices": [{"x": 0.0, "y": 0.0}, {"x": 4.0, "y": 0.0}, {"x": 4.0, "y": 4.0}]}]}.
+ */
+void Decode(JsonReader& reader, const std::string& payload, connector_utils::ZoneSet& msg);
+
+}  // namespace mqtt_bridge
+
+#endif
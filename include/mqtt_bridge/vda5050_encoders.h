@@ -0,0 +1,496 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef VDA5050_ENCODERS_H
+#define VDA5050_ENCODERS_H
+
+#include <string>
+#include <vector>
+#include "vda5050_msgs/Connection.h"
+#include "vda5050_msgs/InstantAction.h"
+#include "vda5050_msgs/Order.h"
+#include "vda5050_msgs/State.h"
+#include "vda5050_msgs/Visualization.h"
+
+/**
+ * Encoders of the VDA 5050 messages. Each message type has its own specialization that writes the
+ * fields in schema order with literal keys, so no reflection and no intermediate DOM is involved.
+ * The encoders are generic over the writer, which has to provide BeginObject, EndObject,
+ * BeginArray, EndArray, Key, String, Double, Int, Uint and Bool (see JsonWriter).
+ *
+ * Bool fields of ROS messages are stored as uint8_t, so they are cast to bool explicitly.
+ */
+namespace mqtt_bridge {
+
+template <typename M>
+struct Encoder;
+
+template <typename Writer, typename M>
+void Write(Writer& w, const M& msg) {
+  Encoder<M>::Encode(w, msg);
+}
+
+template <typename Writer>
+void Write(Writer& w, const std::string& value) {
+  w.String(value);
+}
+
+template <typename Writer>
+void Write(Writer& w, double value) {
+  w.Double(value);
+}
+
+template <typename Writer>
+void Write(Writer& w, bool value) {
+  w.Bool(value);
+}
+
+template <typename Writer>
+void Write(Writer& w, uint32_t value) {
+  w.Uint(value);
+}
+
+template <typename Writer>
+void Write(Writer& w, uint8_t value) {
+  w.Uint(value);
+}
+
+template <typename Writer>
+void Write(Writer& w, int8_t value) {
+  w.Int(value);
+}
+
+template <typename Writer, typename T>
+void Write(Writer& w, const std::vector<T>& values) {
+  w.BeginArray(values.size());
+  for (const auto& value : values) Write(w, value);
+  w.EndArray();
+}
+
+template <typename Writer, typename T, size_t N>
+void Field(Writer& w, const char (&key)[N], const T& value) {
+  w.Key(key);
+  Write(w, value);
+}
+
+template <>
+struct Encoder<vda5050_msgs::ActionParameter> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::ActionParameter& msg) {
+    w.BeginObject();
+    Field(w, "key", msg.key);
+    Field(w, "value", msg.value);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::Action> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::Action& msg) {
+    w.BeginObject();
+    Field(w, "actionType", msg.actionType);
+    Field(w, "actionId", msg.actionId);
+    Field(w, "actionDescription", msg.actionDescription);
+    Field(w, "blockingType", msg.blockingType);
+    Field(w, "actionParameters", msg.actionParameters);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::ActionState> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::ActionState& msg) {
+    w.BeginObject();
+    Field(w, "actionId", msg.actionId);
+    Field(w, "actionType", msg.actionType);
+    Field(w, "actionDescription", msg.actionDescription);
+    Field(w, "actionStatus", msg.actionStatus);
+    Field(w, "resultDescription", msg.resultDescription);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::ControlPoint> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::ControlPoint& msg) {
+    w.BeginObject();
+    Field(w, "x", msg.x);
+    Field(w, "y", msg.y);
+    Field(w, "weight", msg.weight);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::Trajectory> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::Trajectory& msg) {
+    w.BeginObject();
+    Field(w, "degree", msg.degree);
+    Field(w, "knotVector", msg.knotVector);
+    Field(w, "controlPoints", msg.controlPoints);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::NodePosition> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::NodePosition& msg) {
+    w.BeginObject();
+    Field(w, "x", msg.x);
+    Field(w, "y", msg.y);
+    Field(w, "theta", msg.theta);
+    Field(w, "allowedDeviationXY", msg.allowedDeviationXY);
+    Field(w, "allowedDeviationTheta", msg.allowedDeviationTheta);
+    Field(w, "mapId", msg.mapId);
+    Field(w, "mapDescription", msg.mapDescription);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::Node> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::Node& msg) {
+    w.BeginObject();
+    Field(w, "nodeId", msg.nodeId);
+    Field(w, "sequenceId", msg.sequenceId);
+    Field(w, "nodeDescription", msg.nodeDescription);
+    Field(w, "released", static_cast<bool>(msg.released));
+    Field(w, "nodePosition", msg.nodePosition);
+    Field(w, "actions", msg.actions);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::Edge> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::Edge& msg) {
+    w.BeginObject();
+    Field(w, "edgeId", msg.edgeId);
+    Field(w, "sequenceId", msg.sequenceId);
+    Field(w, "edgeDescription", msg.edgeDescription);
+    Field(w, "released", static_cast<bool>(msg.released));
+    Field(w, "startNodeId", msg.startNodeId);
+    Field(w, "endNodeId", msg.endNodeId);
+    Field(w, "maxSpeed", msg.maxSpeed);
+    Field(w, "maxHeight", msg.maxHeight);
+    Field(w, "minHeight", msg.minHeight);
+    Field(w, "orientation", msg.orientation);
+    Field(w, "orientationType", msg.orientationType);
+    Field(w, "direction", msg.direction);
+    Field(w, "rotationAllowed", static_cast<bool>(msg.rotationAllowed));
+    Field(w, "maxRotationSpeed", msg.maxRotationSpeed);
+    Field(w, "trajectory", msg.trajectory);
+    Field(w, "length", msg.length);
+    Field(w, "actions", msg.actions);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::NodeState> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::NodeState& msg) {
+    w.BeginObject();
+    Field(w, "nodeId", msg.nodeId);
+    Field(w, "sequenceId", msg.sequenceId);
+    Field(w, "nodeDescription", msg.nodeDescription);
+    Field(w, "nodePosition", msg.nodePosition);
+    Field(w, "released", static_cast<bool>(msg.released));
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::EdgeState> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::EdgeState& msg) {
+    w.BeginObject();
+    Field(w, "edgeId", msg.edgeId);
+    Field(w, "sequenceId", msg.sequenceId);
+    Field(w, "edgeDescription", msg.edgeDescription);
+    Field(w, "released", static_cast<bool>(msg.released));
+    Field(w, "trajectory", msg.trajectory);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::AGVPosition> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::AGVPosition& msg) {
+    w.BeginObject();
+    Field(w, "x", msg.x);
+    Field(w, "y", msg.y);
+    Field(w, "theta", msg.theta);
+    Field(w, "mapId", msg.mapId);
+    Field(w, "mapDescription", msg.mapDescription);
+    Field(w, "positionInitialized", static_cast<bool>(msg.positionInitialized));
+    Field(w, "localizationScore", msg.localizationScore);
+    Field(w, "deviationRange", msg.deviationRange);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::Velocity> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::Velocity& msg) {
+    w.BeginObject();
+    Field(w, "vx", msg.vx);
+    Field(w, "vy", msg.vy);
+    Field(w, "omega", msg.omega);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::BoundingBoxReference> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::BoundingBoxReference& msg) {
+    w.BeginObject();
+    Field(w, "x", msg.x);
+    Field(w, "y", msg.y);
+    Field(w, "z", msg.z);
+    Field(w, "theta", msg.theta);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::LoadDimensions> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::LoadDimensions& msg) {
+    w.BeginObject();
+    Field(w, "length", msg.length);
+    Field(w, "width", msg.width);
+    Field(w, "height", msg.height);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::Load> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::Load& msg) {
+    w.BeginObject();
+    Field(w, "loadId", msg.loadId);
+    Field(w, "loadType", msg.loadType);
+    Field(w, "loadPosition", msg.loadPosition);
+    Field(w, "boundingBoxReference", msg.boundingBoxReference);
+    Field(w, "loadDimensions", msg.loadDimensions);
+    Field(w, "weight", msg.weight);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::BatteryState> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::BatteryState& msg) {
+    w.BeginObject();
+    Field(w, "batteryCharge", msg.batteryCharge);
+    Field(w, "batteryVoltage", msg.batteryVoltage);
+    Field(w, "batteryHealth", msg.batteryHealth);
+    Field(w, "charging", static_cast<bool>(msg.charging));
+    Field(w, "reach", msg.reach);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::ErrorReference> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::ErrorReference& msg) {
+    w.BeginObject();
+    Field(w, "referenceKey", msg.referenceKey);
+    Field(w, "referenceValue", msg.referenceValue);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::Error> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::Error& msg) {
+    w.BeginObject();
+    Field(w, "errorType", msg.errorType);
+    Field(w, "errorReferences", msg.errorReferences);
+    Field(w, "errorDescription", msg.errorDescription);
+    Field(w, "errorLevel", msg.errorLevel);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::InfoReference> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::InfoReference& msg) {
+    w.BeginObject();
+    Field(w, "referenceKey", msg.referenceKey);
+    Field(w, "referenceValue", msg.referenceValue);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::Info> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::Info& msg) {
+    w.BeginObject();
+    Field(w, "infoType", msg.infoType);
+    Field(w, "infoReferences", msg.infoReferences);
+    Field(w, "infoDescription", msg.infoDescription);
+    Field(w, "infoLevel", msg.infoLevel);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::SafetyState> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::SafetyState& msg) {
+    w.BeginObject();
+    Field(w, "eStop", msg.eStop);
+    Field(w, "fieldViolation", static_cast<bool>(msg.fieldViolation));
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::InteractionZoneState> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::InteractionZoneState& msg) {
+    w.BeginObject();
+    Field(w, "zoneId", msg.zoneId);
+    Field(w, "zoneStatus", msg.zoneStatus);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::State> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::State& msg) {
+    w.BeginObject();
+    Field(w, "headerId", msg.headerId);
+    Field(w, "timestamp", msg.timestamp);
+    Field(w, "version", msg.version);
+    Field(w, "manufacturer", msg.manufacturer);
+    Field(w, "serialNumber", msg.serialNumber);
+    Field(w, "orderId", msg.orderId);
+    Field(w, "orderUpdateId", msg.orderUpdateId);
+    Field(w, "zoneSetId", msg.zoneSetId);
+    Field(w, "lastNodeId", msg.lastNodeId);
+    Field(w, "lastNodeSequenceId", msg.lastNodeSequenceId);
+    Field(w, "driving", static_cast<bool>(msg.driving));
+    Field(w, "paused", static_cast<bool>(msg.paused));
+    Field(w, "newBaseRequest", static_cast<bool>(msg.newBaseRequest));
+    Field(w, "distanceSinceLastNode", msg.distanceSinceLastNode);
+    Field(w, "operatingMode", msg.operatingMode);
+    Field(w, "nodeStates", msg.nodeStates);
+    Field(w, "edgeStates", msg.edgeStates);
+    Field(w, "agvPosition", msg.agvPosition);
+    Field(w, "velocity", msg.velocity);
+    Field(w, "loads", msg.loads);
+    Field(w, "actionStates", msg.actionStates);
+    Field(w, "batteryState", msg.batteryState);
+    Field(w, "errors", msg.errors);
+    Field(w, "information", msg.information);
+    Field(w, "safetyState", msg.safetyState);
+    Field(w, "interactionZones", msg.interactionZones);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::Visualization> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::Visualization& msg) {
+    w.BeginObject();
+    Field(w, "headerId", msg.headerId);
+    Field(w, "timestamp", msg.timestamp);
+    Field(w, "version", msg.version);
+    Field(w, "manufacturer", msg.manufacturer);
+    Field(w, "serialNumber", msg.serialNumber);
+    Field(w, "agvPosition", msg.agvPosition);
+    Field(w, "velocity", msg.velocity);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::Connection> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::Connection& msg) {
+    w.BeginObject();
+    Field(w, "headerId", msg.headerId);
+    Field(w, "timestamp", msg.timestamp);
+    Field(w, "version", msg.version);
+    Field(w, "manufacturer", msg.manufacturer);
+    Field(w, "serialNumber", msg.serialNumber);
+    Field(w, "connectionState", msg.connectionState);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::Order> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::Order& msg) {
+    w.BeginObject();
+    Field(w, "headerId", msg.headerId);
+    Field(w, "timestamp", msg.timestamp);
+    Field(w, "version", msg.version);
+    Field(w, "manufacturer", msg.manufacturer);
+    Field(w, "serialNumber", msg.serialNumber);
+    Field(w, "orderId", msg.orderId);
+    Field(w, "orderUpdateId", msg.orderUpdateId);
+    Field(w, "nodes", msg.nodes);
+    Field(w, "edges", msg.edges);
+    Field(w, "zoneSetId", msg.zoneSetId);
+    w.EndObject();
+  }
+};
+
+template <>
+struct Encoder<vda5050_msgs::InstantAction> {
+  template <typename Writer>
+  static void Encode(Writer& w, const vda5050_msgs::InstantAction& msg) {
+    w.BeginObject();
+    Field(w, "headerId", msg.headerId);
+    Field(w, "timestamp", msg.timestamp);
+    Field(w, "version", msg.version);
+    Field(w, "manufacturer", msg.manufacturer);
+    Field(w, "serialNumber", msg.serialNumber);
+    Field(w, "actions", msg.actions);
+    w.EndObject();
+  }
+};
+
+/**
+ * Encodes a message with the given writer.
+ *
+ * @param w    Writer to encode with.
+ * @param msg  Message to encode.
+ */
+template <typename Writer, typename M>
+void Encode(Writer& w, const M& msg) {
+  Encoder<M>::Encode(w, msg);
+}
+
+}  // namespace mqtt_bridge
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef VDA5050_JSON_H
+#define VDA5050_JSON_H
+
+#include <string>
+#include "mqtt_bridge/json_reader.h"
+#include "mqtt_bridge/json_writer.h"
+#include "mqtt_bridge/vda5050_decoders.h"
+#include "mqtt_bridge/vda5050_encoders.h"
+
+/**
+ * Conversion of the VDA 5050 messages to and from JSON. The field names of vda5050_msgs equal the
+ * keys of the VDA 5050 JSON schemas, so every field is mapped to the key of the same name. Like the
+ * generic ROS to dict conversion of the Python bridge, all fields are written, and missing keys
+ * leave the fields at their default value.
+ *
+ * Messages are written by the encoders of vda5050_encoders.h and read by the decoders of
+ * vda5050_decoders.h.
+ */
+namespace mqtt_bridge {
+
+/**
+ * Serializes a message to a compact JSON string. Hot paths should reuse a JsonWriter with Encode
+ * instead, to keep the capacity of its buffer.
+ *
+ * @param msg  Message to serialize.
+ *
+ * @return     JSON string.
+ */
+template <typename M>
+std::string Serialize(const M& msg) {
+  JsonWriter writer;
+  Encode(writer, msg);
+  return writer.str();
+}
+
+/**
+ * Parses a JSON string into a message. Hot paths should reuse a JsonReader and the message with
+ * Decode instead, to keep their capacity.
+ *
+ * @param payload  JSON string.
+ * @param msg      Message to fill.
+ *
+ * @throws DecodeError, a std::invalid_argument, if the payload is no valid JSON or a value has the
+ *         wrong type.
+ */
+template <typename M>
+void Deserialize(const std::string& payload, M& msg) {
+  JsonReader reader;
+  Decode(reader, payload, msg);
+}
+
+}  // namespace mqtt_bridge
+
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <ros/ros.h>
+#include <boost/optional.hpp>
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace connector_utils {
+
+/**
+ * Timer heap for deadlines identified by a key, e.g. an action ID. Arming and disarming a deadline
+ * takes O(log n), and expired deadlines are popped in the order they expire. Nothing is scanned
+ * periodically: the owner only needs to wake up at NextDeadline().
+ *
+ * Disarmed or re-armed deadlines stay in the heap until they reach its top, where they are
+ * skipped. The heap is rebuilt once stale entries dominate it.
+ */
+class DeadlineScheduler {
+ public:
+  /**
+   * Arms the deadline of a key. An already armed deadline of the key is replaced.
+   *
+   * @param key       Key of the deadline.
+   * @param deadline  Time at which the deadline expires.
+   */
+  void Arm(const std::string& key, const ros::Time& deadline);
+
+  /**
+   * Disarms the deadline of a key.
+   *
+   * @param key  Key of the deadline.
+   *
+   * @return     true if a deadline was armed for the key.
+   */
+  bool Disarm(const std::string& key);
+
+  /**
+   * Checks if a deadline is armed for a key.
+   *
+   * @param key  Key of the deadline.
+   */
+  bool IsArmed(const std::string& key) const;
+
+  /**
+   * Get the earliest armed deadline.
+   *
+   * @return  Earliest deadline, or none if no deadline is armed.
+   */
+  boost::optional<ros::Time> NextDeadline();
+
+  /**
+   * Removes all deadlines that expired at the given time.
+   *
+   * @param now  Current time.
+   *
+   * @return     Keys of the expired deadlines, ordered by their deadline.
+   */
+  std::vector<std::string> PopExpired(const ros::Time& now);
+
+  /**
+   * Get the number of armed deadlines.
+   */
+  inline size_t Size() const { return armed.size(); }
+
+ private:
+  struct Entry {
+    ros::Time deadline;  /**< Time at which the deadline expires. */
+    uint64_t generation; /**< Arm call that created the entry, used to detect stale entries. */
+    std::string key;     /**< Key of the deadline. */
+
+    bool operator>(const Entry& other) const {
+      return deadline != other.deadline ? deadline > other.deadline
+                                        : generation > other.generation;
+    }
+  };
+
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>
+      heap; /**< Min-heap of all entries, including stale ones. */
+
+  std::unordered_map<std::string, uint64_t>
+      armed; /**< Generation of the valid entry of each armed key. */
+
+  uint64_t nextGeneration{0}; /**< Generation of the next armed entry. */
+
+  /**
+   * Pops stale entries from the top of the heap.
+   */
+  void DropStaleEntries();
+
+  /**
+   * Checks if an entry belongs to a disarmed or re-armed deadline.
+   */
+  bool IsStale(const Entry& entry) const;
+};
+
+}  // namespace connector_utils
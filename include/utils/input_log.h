@@ -0,0 +1,249 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace connector_utils {
+
+/**
+ * Topic of an input log, with everything needed to publish its messages again without knowing
+ * their type at compile time.
+ */
+struct LoggedTopic {
+  std::string key;        /**< Topic key of the connector configuration, e.g. "order_from_mc". */
+  std::string name;       /**< Name of the topic the messages were recorded from. */
+  std::string datatype;   /**< ROS message type, e.g. "vda5050_msgs/Order". */
+  std::string md5sum;     /**< MD5 sum of the message type. */
+  std::string definition; /**< Full message definition. */
+};
+
+/**
+ * Message of an input log.
+ */
+struct LoggedMessage {
+  uint16_t topic;            /**< Index of the topic in the topic list of the log. */
+  int64_t time;              /**< Receipt time in nanoseconds. */
+  std::vector<uint8_t> data; /**< Message in the ROS serialization format. */
+};
+
+/**
+ * Writes messages to an input log. The log is a sequence of records: topic records define a topic
+ * the first time it is used, message records hold a receipt time, the topic index and the
+ * serialized message, protected by a checksum. Close() appends an index of the topics and of the
+ * message positions at every index interval of receipt time, so a reader neither has to scan the
+ * log to list its topics nor to seek to a time.
+ *
+ * The writer is not thread-safe. All methods throw std::runtime_error if the file cannot be
+ * written.
+ */
+class InputLogWriter {
+ public:
+  /**
+   * Creates a log, replacing an existing file.
+   *
+   * @param path           Path of the log.
+   * @param indexInterval  Receipt time in nanoseconds between two index entries.
+   */
+  explicit InputLogWriter(const std::string& path, int64_t indexInterval = 1000000000);
+
+  /**
+   * Closes the log if it was not closed yet, errors are ignored.
+   */
+  ~InputLogWriter();
+
+  InputLogWriter(const InputLogWriter&) = delete;
+  InputLogWriter& operator=(const InputLogWriter&) = delete;
+
+  /**
+   * Adds a topic.
+   *
+   * @param topic  Topic to add.
+   *
+   * @return       Index of the topic, used to write its messages.
+   */
+  uint16_t AddTopic(const LoggedTopic& topic);
+
+  /**
+   * Writes a message. Receipt times are expected to grow, the index only points to messages that
+   * are not older than their predecessors.
+   *
+   * @param topic  Index of the topic, as returned by AddTopic.
+   * @param time   Receipt time in nanoseconds.
+   * @param data   Serialized message.
+   * @param size   Size of the serialized message in bytes.
+   */
+  void Write(uint16_t topic, int64_t time, const uint8_t* data, uint32_t size);
+
+  /**
+   * Writes the index and closes the log.
+   */
+  void Close();
+
+  /**
+   * Get the number of written messages.
+   */
+  inline uint64_t GetMessageCount() const { return messageCount; }
+
+ private:
+  struct IndexEntry {
+    int64_t time;    /**< Receipt time of the message. */
+    uint64_t offset; /**< Position of the message record in the file. */
+  };
+
+  std::string path; /**< Path of the log. */
+
+  FILE* file{nullptr}; /**< Opened log, nullptr once closed. */
+
+  int64_t indexInterval; /**< Receipt time between two index entries. */
+
+  uint64_t offset{0}; /**< Position of the next record in the file. */
+
+  std::vector<LoggedTopic> topics; /**< Topics added so far. */
+
+  std::vector<IndexEntry> index; /**< Index entries written so far. */
+
+  std::vector<uint64_t> topicCounts; /**< Number of messages per topic. */
+
+  uint64_t messageCount{0}; /**< Number of messages. */
+
+  int64_t startTime{0}, endTime{0}; /**< Receipt times of the first and the last message. */
+
+  std::vector<uint8_t> body; /**< Body of the record being written. */
+
+  /**
+   * Writes bytes at the end of the file.
+   */
+  void Put(const void* data, size_t size);
+
+  /**
+   * Writes a record with the current body.
+   *
+   * @param kind  Kind of the record.
+   */
+  void PutRecord(uint8_t kind);
+};
+
+/**
+ * Reads the messages of an input log in the order they were written. The index of the log is used
+ * if it exists. A log without index, e.g. of a recorder that crashed, is scanned once when it is
+ * opened; its messages up to the first incomplete or damaged record are read.
+ *
+ * The reader is not thread-safe. The constructor throws std::runtime_error if the file cannot be
+ * opened or is not an input log.
+ */
+class InputLogReader {
+ public:
+  /**
+   * Opens a log.
+   *
+   * @param path  Path of the log.
+   */
+  explicit InputLogReader(const std::string& path);
+
+  ~InputLogReader();
+
+  InputLogReader(const InputLogReader&) = delete;
+  InputLogReader& operator=(const InputLogReader&) = delete;
+
+  /**
+   * Get the topics of the log.
+   */
+  inline const std::vector<LoggedTopic>& GetTopics() const { return topics; }
+
+  /**
+   * Get the number of messages of each topic.
+   */
+  inline const std::vector<uint64_t>& GetTopicCounts() const { return topicCounts; }
+
+  /**
+   * Get the number of messages.
+   */
+  inline uint64_t GetMessageCount() const { return messageCount; }
+
+  /**
+   * Get the receipt time of the first message in nanoseconds, 0 if the log is empty.
+   */
+  inline int64_t GetStartTime() const { return startTime; }
+
+  /**
+   * Get the receipt time of the last message in nanoseconds, 0 if the log is empty.
+   */
+  inline int64_t GetEndTime() const { return endTime; }
+
+  /**
+   * Checks if the log was closed properly and has an index.
+   */
+  inline bool IsIndexed() const { return indexed; }
+
+  /**
+   * Moves to the first message received at or after the given time.
+   *
+   * @param time  Receipt time in nanoseconds.
+   */
+  void Seek(int64_t time);
+
+  /**
+   * Reads the next message.
+   *
+   * @param message  Message to fill, keeps the capacity of its data.
+   *
+   * @return         False at the end of the log.
+   */
+  bool Next(LoggedMessage* message);
+
+ private:
+  struct IndexEntry {
+    int64_t time;    /**< Receipt time of the message. */
+    uint64_t offset; /**< Position of the message record in the file. */
+  };
+
+  FILE* file{nullptr}; /**< Opened log. */
+
+  bool indexed{false}; /**< True if the log has an index. */
+
+  uint64_t position{0}; /**< Position of the next record in the file. */
+
+  uint64_t end{0}; /**< End of the records, the start of the index. */
+
+  std::vector<LoggedTopic> topics; /**< Topics of the log. */
+
+  std::vector<IndexEntry> index; /**< Message positions, from the index or the scan. */
+
+  std::vector<uint64_t> topicCounts; /**< Number of messages per topic. */
+
+  uint64_t messageCount{0}; /**< Number of messages. */
+
+  int64_t startTime{0}, endTime{0}; /**< Receipt times of the first and the last message. */
+
+  std::vector<uint8_t> record; /**< Body of the last read record. */
+
+  /**
+   * Reads the index at the end of the file.
+   *
+   * @return  False if the log has no valid index.
+   */
+  bool ReadIndex();
+
+  /**
+   * Reads all records to find the topics and message positions of a log without index.
+   */
+  void Scan();
+
+  /**
+   * Reads the record at the current position into record.
+   *
+   * @param kind  Set to the kind of the record.
+   *
+   * @return      False at the end of the records or at an incomplete or damaged record.
+   */
+  bool ReadRecord(uint8_t* kind);
+
+  /**
+   * Reads bytes at the current file position.
+   */
+  bool Get(void* data, size_t size);
+};
+
+}  // namespace connector_utils
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "utils/mapped_file.h"
+
+namespace connector_utils {
+
+/**
+ * Record of a journal: its kind, defined by the user of the journal, and its data.
+ */
+struct JournalRecord {
+  uint8_t kind;     /**< Kind of the record. */
+  std::string data; /**< Data of the record, e.g. a serialized message. */
+};
+
+/**
+ * Append-only journal in a memory-mapped file of a fixed capacity. Appended records are written
+ * into the mapped memory, so they survive a crash of the process without a system call; Sync()
+ * also makes them survive a power loss.
+ *
+ * The file starts with a header holding the end of the appended records, followed by the records.
+ * Each record consists of its size, a checksum, its kind and its data. A record counts once the end
+ * in the header is moved past it. Records that are damaged when the file is opened are discarded
+ * together with all following ones.
+ *
+ * Compact() replaces all records by a snapshot. The snapshot is written to a new file that is
+ * renamed over the journal, so a crash during compaction leaves either the old or the new journal.
+ *
+ * The journal is not thread-safe. All methods throw std::runtime_error if the file cannot be
+ * mapped or renamed.
+ */
+class Journal {
+ public:
+  /**
+   * Opens the journal of a file or creates it. A file created with another capacity is cleared.
+   *
+   * @param path      Path of the journal file.
+   * @param capacity  Capacity of the file in bytes, including the header and 9 bytes per record.
+   */
+  Journal(const std::string& path, size_t capacity);
+
+  /**
+   * Appends a record.
+   *
+   * @param kind  Kind of the record.
+   * @param data  Data of the record.
+   * @param size  Size of the data in bytes.
+   *
+   * @return      False if the journal is full and the record was not appended.
+   */
+  bool Append(uint8_t kind, const void* data, size_t size);
+
+  /**
+   * Get all records in the order they were appended.
+   */
+  std::vector<JournalRecord> Read() const;
+
+  /**
+   * Replaces all records by a snapshot.
+   *
+   * @param snapshot  Records that hold the same information as the current records.
+   *
+   * @return          False if the snapshot does not fit, the journal is unchanged then.
+   */
+  bool Compact(const std::vector<JournalRecord>& snapshot);
+
+  /**
+   * Writes the journal to the disk and waits until it is written.
+   */
+  void Sync();
+
+  /**
+   * Get the number of records.
+   */
+  size_t GetRecordCount() const { return records; }
+
+  /**
+   * Get the number of bytes used by the header and the records.
+   */
+  size_t GetUsed() const;
+
+  /**
+   * Get the capacity of the file in bytes.
+   */
+  size_t GetCapacity() const { return capacity; }
+
+ private:
+  std::string path; /**< Path of the journal file. */
+
+  size_t capacity; /**< Capacity of the file in bytes. */
+
+  std::unique_ptr<MappedFile> file; /**< Mapped journal file. */
+
+  size_t records{0}; /**< Number of records. */
+
+  /**
+   * Writes the header of an empty journal.
+   *
+   * @param file  File to initialize.
+   */
+  static void Clear(MappedFile* file);
+
+  /**
+   * Writes a record behind the end of a file and moves the end past it.
+   *
+   * @return  False if the record does not fit.
+   */
+  static bool Write(MappedFile* file, uint8_t kind, const void* data, size_t size);
+
+  /**
+   * Checks the records of the opened file and discards the damaged ones.
+   */
+  void Recover();
+};
+
+}  // namespace connector_utils
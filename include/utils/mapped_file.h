@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace connector_utils {
+
+/**
+ * File of a fixed size that is mapped into memory. Changes to the memory are written to the file
+ * by the kernel, so they survive a crash of the process. Sync() forces them to the disk.
+ *
+ * All methods throw std::runtime_error if the file cannot be opened, resized or mapped.
+ */
+class MappedFile {
+ public:
+  /**
+   * Opens or creates a file and maps it into memory. A smaller file is extended with zeros.
+   *
+   * @param path  Path of the file.
+   * @param size  Size of the file in bytes.
+   */
+  MappedFile(const std::string& path, size_t size);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * Get the mapped memory.
+   */
+  char* Data() { return data; }
+  const char* Data() const { return data; }
+
+  /**
+   * Get the size of the file in bytes.
+   */
+  size_t Size() const { return size; }
+
+  /**
+   * Get the path of the file.
+   */
+  const std::string& Path() const { return path; }
+
+  /**
+   * Writes all changes of the mapped memory to the disk and waits until they are written.
+   */
+  void Sync();
+
+ private:
+  std::string path; /**< Path of the file. */
+
+  size_t size; /**< Size of the file in bytes. */
+
+  int fd{-1}; /**< Descriptor of the opened file. */
+
+  char* data{nullptr}; /**< Mapped memory. */
+};
+
+}  // namespace connector_utils
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <ros/callback_queue_interface.h>
+#include <ros/ros.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace connector_utils {
+
+/**
+ * Counters of a node, e.g. callback invocations or published messages. Every thread adds to its
+ * own copy of the counters, which only that thread writes, so adding is a plain load and store
+ * without locks or contention. Read() sums the copies of all threads.
+ *
+ * Counters can be added at any time, also while other threads count. Counts of threads that ended
+ * are kept.
+ */
+class Metrics {
+ public:
+  static constexpr size_t MAX_COUNTERS = 128; /**< Counters per instance. */
+
+  Metrics();
+
+  Metrics(const Metrics&) = delete;
+  Metrics& operator=(const Metrics&) = delete;
+
+  /**
+   * Adds a counter.
+   *
+   * @param name  Name of the counter.
+   *
+   * @return      ID of the counter, or of the existing counter of the same name. MAX_COUNTERS - 1,
+   *              which is shared, if all counters are taken.
+   */
+  size_t AddCounter(const std::string& name);
+
+  /**
+   * Adds to a counter on the calling thread.
+   *
+   * @param counter  ID of the counter.
+   * @param value    Value to add.
+   */
+  inline void Add(size_t counter, uint64_t value = 1) {
+    std::atomic<uint64_t>& count = Local()[counter];
+    count.store(count.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  /**
+   * Get the names of all counters, in the order of their IDs.
+   */
+  std::vector<std::string> GetNames() const;
+
+  /**
+   * Get the values of all counters, summed over all threads, in the order of their IDs.
+   */
+  std::vector<uint64_t> Read() const;
+
+ private:
+  using Shard = std::unique_ptr<std::atomic<uint64_t>[]>;
+
+  const size_t id; /**< Unique ID of the instance, indexes the shards of each thread. */
+
+  mutable std::mutex mutex; /**< Guards the names and the shards. */
+
+  std::vector<std::string> names; /**< Names of the counters. */
+
+  std::vector<Shard> shards; /**< Counters of each thread that counted. */
+
+  /**
+   * Get the counters of the calling thread, created on its first call.
+   */
+  std::atomic<uint64_t>* Local();
+
+  /**
+   * Creates the counters of the calling thread.
+   */
+  std::atomic<uint64_t>* CreateShard();
+};
+
+/**
+ * Measures the wall and CPU time of a scope, e.g. of a callback, and adds them to three counters
+ * of a Metrics instance created by AddTimed: the calls, the wall time and the CPU time of the
+ * thread in nanoseconds.
+ */
+class MeteredScope {
+ public:
+  /**
+   * Adds the counters of a timed scope.
+   *
+   * @param metrics  Metrics to add the counters to.
+   * @param name     Name of the scope, e.g. "UpdateActions".
+   *
+   * @return         ID of the first of the three counters.
+   */
+  static size_t AddTimed(Metrics* metrics, const std::string& name);
+
+  /**
+   * Starts measuring.
+   *
+   * @param metrics  Metrics holding the counters.
+   * @param timed    ID of the first counter, as returned by AddTimed.
+   */
+  MeteredScope(Metrics* metrics, size_t timed);
+
+  /**
+   * Adds the call and the times since the construction.
+   */
+  ~MeteredScope();
+
+ private:
+  Metrics* metrics; /**< Metrics holding the counters. */
+
+  size_t timed; /**< ID of the first counter. */
+
+  int64_t wallStart; /**< Wall time at the start in nanoseconds. */
+
+  int64_t cpuStart; /**< CPU time of the thread at the start in nanoseconds. */
+};
+
+/**
+ * Callback queue of a single subscription that tracks its depth. Callbacks are passed on to the
+ * queue the node is spinning, so the subscription is handled as before.
+ *
+ * ROS keeps a subscriber queue of the configured size per subscription and adds one callback per
+ * queued message. When the subscriber queue is full, ROS discards its oldest message without
+ * adding a callback, so the discarded messages cannot be counted; instead the times a message
+ * filled the queue are counted.
+ */
+class MeteredQueue : public ros::CallbackQueueInterface {
+ public:
+  /**
+   * Constructor for the queue.
+   *
+   * @param target     Queue that calls the callbacks.
+   * @param queueSize  Size of the subscriber queue, 0 if it is unbounded.
+   */
+  MeteredQueue(ros::CallbackQueueInterface* target, uint32_t queueSize);
+
+  void addCallback(const ros::CallbackInterfacePtr& callback, uint64_t ownerId) override;
+
+  void removeByID(uint64_t ownerId) override;
+
+  /**
+   * Get the number of queued messages.
+   */
+  inline int64_t GetDepth() const { return depth.load(std::memory_order_relaxed); }
+
+  /**
+   * Get the largest number of queued messages since the last call.
+   */
+  int64_t TakeMaxDepth();
+
+  /**
+   * Get the number of times a message filled the queue.
+   */
+  inline uint64_t GetFull() const { return full.load(std::memory_order_relaxed); }
+
+ private:
+  class Callback;
+
+  ros::CallbackQueueInterface* target; /**< Queue that calls the callbacks. */
+
+  uint32_t queueSize; /**< Size of the subscriber queue, 0 if it is unbounded. */
+
+  std::atomic<int64_t> depth{0}; /**< Number of queued messages. */
+
+  std::atomic<int64_t> maxDepth{0}; /**< Largest number of queued messages since TakeMaxDepth. */
+
+  std::atomic<uint64_t> full{0}; /**< Number of times a message filled the queue. */
+
+  std::mutex callbackMutex; /**< Guards the wrapped callback. */
+
+  ros::CallbackInterfacePtr wrapped; /**< Last callback added by ROS, the subscriber queue. */
+
+  ros::CallbackInterfacePtr wrapper; /**< Callback that counts the calls of the wrapped one. */
+};
+
+}  // namespace connector_utils
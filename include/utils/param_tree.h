@@ -0,0 +1,104 @@
+#pragma once
+
+#include <ros/ros.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace connector_utils {
+
+/**
+ * Parameters of a namespace, fetched from the parameter server in a single call. Reading single
+ * parameters with ros::param costs one XML-RPC round trip each, which adds up to seconds at startup
+ * on a parameter server with thousands of parameters.
+ *
+ * Parameters are addressed by their path below the namespace, e.g. "publish_periods/state_msg".
+ * Like ros::param, integers are also read as doubles.
+ */
+class ParamTree {
+ public:
+  /**
+   * Constructor for an empty tree, which has no parameters.
+   */
+  ParamTree() = default;
+
+  /**
+   * Constructor for a tree of already fetched parameters.
+   *
+   * @param root  Struct holding the parameters of the namespace.
+   */
+  explicit ParamTree(const XmlRpc::XmlRpcValue& root);
+
+  /**
+   * Fetches all parameters of a namespace.
+   *
+   * @param ns  Absolute namespace, e.g. the one of a private node handle.
+   *
+   * @return    Parameters of the namespace, empty if it has none.
+   */
+  static ParamTree Fetch(const std::string& ns);
+
+  /**
+   * Check whether a parameter or namespace exists.
+   *
+   * @param path  Path below the namespace of the tree.
+   */
+  bool Has(const std::string& path) const;
+
+  /**
+   * Reads a parameter, like ros::NodeHandle::getParam.
+   *
+   * @param path   Path below the namespace of the tree.
+   * @param value  Value of the parameter, unchanged if it does not exist or has another type.
+   *
+   * @return       True if the value was read.
+   */
+  bool Get(const std::string& path, bool& value) const;
+  bool Get(const std::string& path, int& value) const;
+  bool Get(const std::string& path, double& value) const;
+  bool Get(const std::string& path, std::string& value) const;
+  bool Get(const std::string& path, std::vector<std::string>& value) const;
+  bool Get(const std::string& path, std::map<std::string, double>& value) const;
+  bool Get(const std::string& path, XmlRpc::XmlRpcValue& value) const;
+
+  /**
+   * Reads a parameter with a default, like ros::NodeHandle::param.
+   *
+   * @param path          Path below the namespace of the tree.
+   * @param value         Value of the parameter, or the default.
+   * @param defaultValue  Value used if the parameter does not exist or has another type.
+   *
+   * @return              True if the parameter was read.
+   */
+  template <typename T>
+  bool Param(const std::string& path, T& value, const T& defaultValue) const {
+    if (Get(path, value)) return true;
+    value = defaultValue;
+    return false;
+  }
+
+  /**
+   * Get all string parameters below a namespace of the tree, e.g. the topics of a param family.
+   *
+   * @param path  Path of the namespace below the namespace of the tree.
+   *
+   * @return      Map from the paths of the parameters, e.g. "subscribe_topics/pose", to their
+   *              values.
+   */
+  std::map<std::string, std::string> GetStrings(const std::string& path) const;
+
+ private:
+  // XmlRpcValue offers most of its accessors only non-const.
+  mutable XmlRpc::XmlRpcValue root; /**< Struct holding the parameters of the namespace. */
+
+  /**
+   * Finds a parameter or namespace.
+   *
+   * @param path  Path below the namespace of the tree, empty for the whole tree.
+   *
+   * @return      The parameter, nullptr if it does not exist.
+   */
+  XmlRpc::XmlRpcValue* Find(const std::string& path) const;
+};
+
+}  // namespace connector_utils
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <ros/callback_queue.h>
+#include <ros/ros.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace connector_utils {
+
+/**
+ * Callback queue that passes its callbacks on to a target queue, which calls them while holding a
+ * mutex. Callbacks of queues that share the mutex are never called at the same time, even if their
+ * target queues are called by different threads.
+ */
+class LockingQueue : public ros::CallbackQueueInterface {
+ public:
+  /**
+   * Constructor for the queue.
+   *
+   * @param target  Queue that calls the callbacks.
+   * @param mutex   Mutex held while a callback is called.
+   */
+  LockingQueue(ros::CallbackQueueInterface* target, std::mutex* mutex)
+      : target(target), mutex(mutex) {}
+
+  void addCallback(const ros::CallbackInterfacePtr& callback, uint64_t ownerId) override;
+
+  void removeByID(uint64_t ownerId) override;
+
+ private:
+  class Callback;
+
+  ros::CallbackQueueInterface* target; /**< Queue that calls the callbacks. */
+
+  std::mutex* mutex; /**< Mutex held while a callback is called. */
+};
+
+/**
+ * Lane for the callbacks of a node that must not wait behind its regular callbacks, e.g. instant
+ * actions behind the poses of the vehicle. A thread of the lane calls the priority callbacks as
+ * soon as they arrive. The regular and the priority callbacks hold one mutex while they are called,
+ * so a priority callback only waits for the regular callback that is running, not for the queued
+ * ones, and the node is never called from two threads at once.
+ */
+class PriorityLane {
+ public:
+  /**
+   * Constructor for the lane. The thread is started right away.
+   *
+   * @param target  Queue that calls the regular callbacks, e.g. the global callback queue.
+   */
+  explicit PriorityLane(ros::CallbackQueueInterface* target);
+
+  /**
+   * Stops the thread.
+   */
+  ~PriorityLane();
+
+  /**
+   * Stops the thread after the callback it is calling. Waiting priority callbacks are not called
+   * anymore.
+   */
+  void Stop();
+
+  /**
+   * Get the queue for the regular callbacks, which passes them on to the target queue.
+   */
+  inline ros::CallbackQueueInterface* GetRegularQueue() { return &regular; }
+
+  /**
+   * Get the queue for the priority callbacks.
+   */
+  inline ros::CallbackQueueInterface* GetPriorityQueue() { return &priority; }
+
+ private:
+  std::mutex mutex; /**< Held while a regular or a priority callback is called. */
+
+  LockingQueue regular; /**< Queue of the regular callbacks. */
+
+  ros::CallbackQueue queue; /**< Priority callbacks waiting for the thread. */
+
+  LockingQueue priority; /**< Queue of the priority callbacks, passes them on to queue. */
+
+  std::atomic<bool> stopping{false}; /**< True once the lane is stopped. */
+
+  std::thread thread; /**< Thread calling the priority callbacks, started last. */
+
+  /**
+   * Loop of the thread.
+   */
+  void Run();
+};
+
+}  // namespace connector_utils
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <ros/callback_queue.h>
+#include <ros/ros.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace connector_utils {
+
+class StrandPool;
+
+/**
+ * Callback queue whose callbacks are called by the threads of a StrandPool. The callbacks of a
+ * strand are called one at a time and in the order they were added, like with a single-threaded
+ * spinner, so the node handles of a node that is not thread-safe can use it. Callbacks of different
+ * strands are called in parallel.
+ *
+ * The strand has to outlive the threads of its pool.
+ */
+class CallbackStrand : public ros::CallbackQueueInterface {
+ public:
+  /**
+   * Constructor for the strand.
+   *
+   * @param pool  Pool whose threads call the callbacks.
+   */
+  explicit CallbackStrand(StrandPool* pool) : pool(pool) {}
+
+  void addCallback(const ros::CallbackInterfacePtr& callback, uint64_t owner_id = 0) override;
+
+  void removeByID(uint64_t owner_id) override;
+
+  /**
+   * Calls the waiting callbacks, and those they add, on the calling thread. Only call it once the
+   * pool is stopped, e.g. to forward the last messages on shutdown.
+   */
+  void Drain();
+
+ private:
+  friend class StrandPool;
+
+  StrandPool* pool; /**< Pool whose threads call the callbacks. */
+
+  ros::CallbackQueue queue; /**< Callbacks waiting to be called. */
+
+  bool scheduled{false}; /**< True while the strand waits for or runs on a thread of the pool. */
+};
+
+/**
+ * Fixed set of threads calling the callbacks of many strands, e.g. of the vehicles of a
+ * VehicleHost. A strand with waiting callbacks is run by the next free thread, which calls all of
+ * its available callbacks and moves on, so one busy strand cannot starve the others. Idle threads
+ * sleep until a callback arrives.
+ */
+class StrandPool {
+ public:
+  /**
+   * Constructor for the pool. The threads are started right away.
+   *
+   * @param threads  Number of threads, at least one.
+   */
+  explicit StrandPool(size_t threads);
+
+  /**
+   * Stops the threads.
+   */
+  ~StrandPool();
+
+  /**
+   * Stops the threads after the callbacks they are calling. Waiting callbacks are not called
+   * anymore.
+   */
+  void Stop();
+
+  /**
+   * Get the number of threads.
+   */
+  inline size_t GetThreadCount() const { return threads.size(); }
+
+ private:
+  friend class CallbackStrand;
+
+  std::vector<std::thread> threads; /**< Threads of the pool. */
+
+  std::deque<CallbackStrand*> ready; /**< Strands with waiting callbacks, in the order to run. */
+
+  bool stopping{false}; /**< True once the pool is stopped. */
+
+  std::mutex mutex; /**< Guards the ready strands and the scheduled flags of the strands. */
+
+  std::condition_variable readyChanged; /**< Wakes idle threads on ready strands and the stop. */
+
+  /**
+   * Queues a strand that received a callback, unless it is already queued or running.
+   */
+  void Schedule(CallbackStrand* strand);
+
+  /**
+   * Loop of each thread.
+   */
+  void Run();
+};
+
+}  // namespace connector_utils
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <ros/ros.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace connector_utils {
+
+/**
+ * Histogram of latencies in nanoseconds. Each power of two is split into four buckets, so a
+ * percentile is off by at most a quarter of its value. Recording takes a few relaxed atomic
+ * increments and can be done from any thread.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr int SUB_BUCKETS = 4; /**< Buckets per power of two. */
+
+  static constexpr int BUCKETS = SUB_BUCKETS * 63; /**< Buckets covering all 64 bit latencies. */
+
+  /**
+   * Records a latency.
+   *
+   * @param nanoseconds  Latency in nanoseconds.
+   */
+  void Record(uint64_t nanoseconds);
+
+  /**
+   * Snapshot of a histogram.
+   */
+  struct Snapshot {
+    uint64_t counts[BUCKETS]; /**< Number of latencies per bucket. */
+    uint64_t count;           /**< Number of latencies. */
+    uint64_t sum;             /**< Sum of all latencies in nanoseconds. */
+    uint64_t max;             /**< Largest latency in nanoseconds. */
+
+    /**
+     * Get the latency below which the given fraction of the latencies fall, as the upper bound of
+     * its bucket.
+     *
+     * @param fraction  Fraction between 0 and 1, e.g. 0.99.
+     *
+     * @return          Latency in nanoseconds, 0 if the snapshot is empty.
+     */
+    uint64_t Percentile(double fraction) const;
+  };
+
+  /**
+   * Takes the recorded latencies out of the histogram. Latencies recorded meanwhile end up in this
+   * or the next snapshot.
+   */
+  Snapshot Take();
+
+  /**
+   * Get the bucket of a latency.
+   */
+  static int BucketOf(uint64_t nanoseconds);
+
+  /**
+   * Get the smallest latency of a bucket.
+   */
+  static uint64_t LowerBound(int bucket);
+
+ private:
+  std::atomic<uint64_t> counts[BUCKETS]{}; /**< Number of latencies per bucket. */
+
+  std::atomic<uint64_t> sum{0}; /**< Sum of all latencies in nanoseconds. */
+
+  std::atomic<uint64_t> max{0}; /**< Largest latency in nanoseconds. */
+};
+
+/**
+ * Lightweight tracing of messages through the stages of a node. Every stage, e.g. the validation
+ * of an order, has a LatencyHistogram. A TraceSpan follows one message and records the time since
+ * the previous stage whenever the message reaches the next one. While the tracer is disabled,
+ * spans neither read the clock nor record anything.
+ *
+ * Optionally, the stages of the latest messages are kept as events and written in the Chrome trace
+ * format, to be viewed in chrome://tracing or Perfetto.
+ */
+class Tracer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Latency statistics of one stage.
+   */
+  struct StageStats {
+    std::string name;           /**< Name of the stage. */
+    uint64_t count;             /**< Number of recorded latencies. */
+    double mean, p50, p90, p99; /**< Mean and percentiles in microseconds. */
+    double max;                 /**< Largest latency in microseconds. */
+  };
+
+  Tracer();
+
+  /**
+   * Enables or disables the tracing.
+   */
+  inline void SetEnabled(bool enabled) { this->enabled = enabled; }
+
+  /**
+   * Checks if the tracing is enabled.
+   */
+  inline bool IsEnabled() const { return enabled; }
+
+  /**
+   * Keeps the events of the stages for WriteChromeTrace, up to the given number of events. Later
+   * events are dropped.
+   *
+   * @param maxEvents  Number of kept events, 0 to keep none.
+   */
+  void KeepEvents(size_t maxEvents);
+
+  /**
+   * Adds a stage. Stages have to be added before the first message is traced.
+   *
+   * @param name  Name of the stage, e.g. "order validate".
+   *
+   * @return      ID of the stage, or the ID of the existing stage of the same name.
+   */
+  size_t AddStage(const std::string& name);
+
+  /**
+   * Records the latency of a stage.
+   *
+   * @param stage    ID of the stage.
+   * @param traceId  ID of the traced message, only used for the events.
+   * @param start    Time the message entered the stage.
+   * @param end      Time the message left the stage.
+   */
+  void Record(size_t stage, uint64_t traceId, Clock::time_point start, Clock::time_point end);
+
+  /**
+   * Get a new ID for a traced message.
+   */
+  inline uint64_t NewTraceId() { return nextTraceId++; }
+
+  /**
+   * Takes the statistics of all stages that recorded latencies since the last call.
+   */
+  std::vector<StageStats> TakeStats();
+
+  /**
+   * Writes the kept events to a file in the Chrome trace format, if events were added since the
+   * last call.
+   *
+   * @param path  Path of the file, which is replaced.
+   *
+   * @return      false if the file could not be written.
+   */
+  bool WriteChromeTrace(const std::string& path);
+
+ private:
+  struct Stage {
+    std::string name;             /**< Name of the stage. */
+    LatencyHistogram histogram;   /**< Latencies of the stage. */
+  };
+
+  struct Event {
+    size_t stage;     /**< ID of the stage. */
+    uint64_t traceId; /**< ID of the traced message. */
+    int64_t start;    /**< Start in microseconds since the creation of the tracer. */
+    int64_t end;      /**< End in microseconds since the creation of the tracer. */
+  };
+
+  bool enabled{false}; /**< True while messages are traced. */
+
+  Clock::time_point epoch; /**< Creation of the tracer, the origin of the event times. */
+
+  std::deque<Stage> stages; /**< Stages, a deque as the histograms cannot be moved. */
+
+  std::atomic<uint64_t> nextTraceId{1}; /**< ID of the next traced message. */
+
+  std::mutex eventsMutex; /**< Guards the events. */
+
+  std::vector<Event> events; /**< Kept events, in the order they were recorded. */
+
+  size_t maxEvents{0}; /**< Number of kept events. */
+
+  bool eventsChanged{false}; /**< True if events were added since the last write. */
+};
+
+/**
+ * Follows one message through the stages of a node.
+ */
+class TraceSpan {
+ public:
+  /**
+   * Starts a trace at the current time.
+   *
+   * @param tracer      Tracer recording the stages.
+   * @param totalStage  Stage that records the time from the start to End.
+   */
+  TraceSpan(Tracer* tracer, size_t totalStage);
+
+  /**
+   * Starts a trace at the time the message was received by ROS, so the time the message waited in
+   * the subscriber queue is part of the first stage.
+   *
+   * @param tracer       Tracer recording the stages.
+   * @param totalStage   Stage that records the time from the start to End.
+   * @param receiptTime  Receipt time of the message, as given by a ros::MessageEvent.
+   */
+  TraceSpan(Tracer* tracer, size_t totalStage, const ros::Time& receiptTime);
+
+  /**
+   * Records the time since the previous stage, or since the start, into a stage.
+   *
+   * @param stage  Stage that was just completed.
+   */
+  void Mark(size_t stage);
+
+  /**
+   * Records the time since the start into the total stage.
+   */
+  void End();
+
+ private:
+  Tracer* tracer; /**< Tracer recording the stages. */
+
+  size_t totalStage; /**< Stage that records the time from the start to End. */
+
+  uint64_t traceId{0}; /**< ID of the traced message, 0 while the tracer is disabled. */
+
+  Tracer::Clock::time_point start; /**< Start of the trace. */
+
+  Tracer::Clock::time_point last; /**< End of the previous stage. */
+};
+
+}  // namespace connector_utils
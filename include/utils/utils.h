@@ -3,6 +3,7 @@
 #include <ros/ros.h>
 #include <string>
 #include "boost/date_time/posix_time/posix_time.hpp"
+#include "vda5050_msgs/AGVPosition.h"
 #include "vda5050_msgs/Error.h"
 
 namespace connector_utils {
@@ -32,12 +33,38 @@ bool CheckRange(double lowerRange, double upperRange, double value);
 bool CheckParamIncludes(std::string str1, std::string str2);
 
 /**
- * Create a timestamp string of the current instant.
+ * Create a timestamp string of the current instant. The string is formatted once per millisecond
+ * and shared by all callers of the process, e.g. the vehicles of a VehicleHost.
  *
  * @return	ISO 8601 Formatted timestamp.
  */
 std::string GetISOCurrentTimestamp();
 
+/**
+ * Resolves a topic in the namespace of a vehicle. Absolute and relative topics both end up below
+ * the namespace, e.g. /state and state become /agv_1/state.
+ *
+ * @param ns     Namespace of the vehicle, without leading slash.
+ * @param topic  Topic as configured for a single vehicle.
+ *
+ * @return       Absolute topic in the namespace.
+ */
+std::string NamespacedTopic(const std::string& ns, const std::string& topic);
+
+/**
+ * Checks if a position is within the deadband around the last sent position.
+ *
+ * @param last      Last sent position.
+ * @param position  Current position.
+ * @param distance  Distance the position has to move to leave the deadband, 0 to have no deadband.
+ * @param angle     Angle the position has to turn to leave the deadband, 0 to ignore the heading.
+ *
+ * @return          True if the position moved less than the distance and turned less than the
+ *                  angle.
+ */
+bool InPositionDeadband(const vda5050_msgs::AGVPosition& last,
+    const vda5050_msgs::AGVPosition& position, double distance, double angle);
+
 vda5050_msgs::Error CreateVDAError(const std::string& error_type, const std::string& error_desc,
     const std::string& error_level,
     const std::vector<std::pair<std::string, std::string>>& error_refs = {});
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace connector_utils {
+
+/**
+ * Vertex of a zone polygon in map coordinates.
+ */
+struct ZoneVertex {
+  double x; /**< X coordinate in m. */
+  double y; /**< Y coordinate in m. */
+};
+
+/**
+ * Zone of a zone set, a polygon with an id and a type, e.g. an interaction zone.
+ */
+struct Zone {
+  std::string zoneId;               /**< Unique id of the zone in its zone set. */
+  std::string zoneType;             /**< Type of the zone as sent by the master control. */
+  std::vector<ZoneVertex> vertices; /**< Vertices of the polygon, in order. */
+};
+
+/**
+ * Zones of a map, as sent by the master control on the zones topic.
+ */
+struct ZoneSet {
+  std::string zoneSetId;   /**< Id of the zone set, reported as zoneSetId in the state. */
+  std::string mapId;       /**< Map the zones belong to. */
+  std::vector<Zone> zones; /**< Zones of the set. */
+};
+
+/**
+ * Grid index of the zones of a zone set. The bounding box of the zones is divided into square
+ * cells, each listing the zones whose bounding box overlaps it. Locating a point only tests the
+ * polygons of its cell, so a pose is located in constant time regardless of the number of zones.
+ *
+ * The cell size is raised if the grid would exceed MAX_CELLS cells.
+ */
+class ZoneIndex {
+ public:
+  static constexpr size_t MAX_CELLS = 1 << 20; /**< Largest number of grid cells. */
+
+  /**
+   * Constructor for an empty index, which contains no zones.
+   */
+  ZoneIndex() = default;
+
+  /**
+   * Builds the index of a zone set. Zones with less than three vertices are left out.
+   *
+   * @param zoneSet   Zone set to index.
+   * @param cellSize  Edge length of the grid cells in m.
+   */
+  ZoneIndex(ZoneSet zoneSet, double cellSize);
+
+  /**
+   * Get the indexed zone set.
+   */
+  const ZoneSet& GetZoneSet() const { return zoneSet; }
+
+  /**
+   * Finds the zones that contain a point. Points on the border of a zone may be reported as either
+   * inside or outside of it.
+   *
+   * @param x      X coordinate in m.
+   * @param y      Y coordinate in m.
+   * @param zones  Filled with the indexes of the zones in the zone set, in ascending order.
+   */
+  void Locate(double x, double y, std::vector<size_t>* zones) const;
+
+ private:
+  ZoneSet zoneSet; /**< Indexed zone set. */
+
+  double cellSize{1.0}; /**< Edge length of the grid cells in m. */
+
+  double originX{0.0}; /**< X coordinate of the lower left corner of the grid. */
+  double originY{0.0}; /**< Y coordinate of the lower left corner of the grid. */
+
+  size_t columns{0}; /**< Number of cells along x. */
+  size_t rows{0};    /**< Number of cells along y. */
+
+  std::vector<uint32_t> cellBegin; /**< Offset of the zones of each cell in cellZones, row-major,
+                                        followed by the end offset of the last cell. */
+
+  std::vector<uint32_t> cellZones; /**< Zones of all cells, concatenated. */
+
+  /**
+   * Tests if a point is inside of a polygon with the even-odd rule.
+   */
+  static bool Contains(const std::vector<ZoneVertex>& vertices, double x, double y);
+};
+
+}  // namespace connector_utils
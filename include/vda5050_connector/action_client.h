@@ -10,17 +10,23 @@
 #ifndef ACTION_CLIENT_H
 #define ACTION_CLIENT_H
 #include <ros/ros.h>
+#include <boost/make_shared.hpp>
 #include <deque>
 #include <iostream>
 #include <list>
+#include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "std_msgs/Bool.h"
 #include "std_msgs/String.h"
+#include "utils/deadline_scheduler.h"
 #include "vda5050_msgs/Action.h"
 #include "vda5050_msgs/ActionState.h"
+#include "vda5050_msgs/Errors.h"
 #include "vda5050_msgs/InstantAction.h"
+#include "vda5050_msgs/State.h"
 #include "vda5050node.h"
 
 using namespace std;
@@ -45,6 +51,8 @@ struct ActionElement {
 
   bool sentToAgv; /**< True if the action was sent to the AGV after being triggered. */
 
+  bool cancelRequested; /**< True if the AGV was asked to cancel the action. */
+
   bool operator==(const ActionElement& s) const { return actionId == s.actionId; }
   bool operator!=(const ActionElement& s) const { return !operator==(s); }
 
@@ -90,14 +98,17 @@ struct ActionElement {
 };
 
 /**
- * Struct to connect actions to cancel with their respective order ID.
+ * Tracks the cancellation of a single order. Instead of observing the cancelled actions, the
+ * tracker counts the actions that still have to stop on the AGV. The counter is decremented on
+ * each FINISHED or FAILED action state, so the cancellation completes as soon as the last action
+ * stops.
  */
-struct orderToCancel {
-  string orderIdToCancel; /**< Order (order ID) which should be deleted. */
+struct OrderCancellation {
+  shared_ptr<ActionElement> cancelAction; /**< Instant action that contains the cancel action. */
 
-  string iActionId; /**< ID of the instant action that contains the cancel action. */
+  size_t outstandingActions; /**< Number of cancelled actions that did not stop yet. */
 
-  vector<weak_ptr<ActionElement>> actionsToCancel; /**< List of active actions to cancel. */
+  bool orderCancelled; /**< True if the order daemon confirmed the cancellation of the order. */
 
   bool allActionsCancelledSent; /**< Flag to ensure that the "all actions cancelled" message is sent
                                    only once. */
@@ -108,15 +119,17 @@ struct orderToCancel {
  */
 class ActionClient : public VDA5050Node {
  private:
-  std::map<std::string, std::shared_ptr<ros::Publisher>>
-      messagePublisher; /**< All publishers the node uses. Map from topic keys to ROS Publisher
-                           objects. */
+  static const TopicBinding<ActionClient>
+      publishBindings[]; /**< Bindings of the publish_topics keys to the publishers. */
+
+  static const TopicBinding<ActionClient>
+      subscribeBindings[]; /**< Bindings of the subscribe_topics keys to the callbacks. */
 
   vector<shared_ptr<ActionElement>>
       activeActionsList; /**< List of actions to track all active actions. */
 
-  vector<orderToCancel>
-      orderCancellations; /**< List of all orders to cancel and their respective order ID. */
+  unordered_map<string, OrderCancellation>
+      orderCancellations; /**< Pending order cancellations. Map from order IDs to trackers. */
 
   /**
    * Declare all ROS subscriber and publisher topics for internal
@@ -125,27 +138,76 @@ class ActionClient : public VDA5050Node {
 
   ros::Subscriber orderActionSub; /**<  Ordinary order actions from order_daemon to action_daemon.*/
 
-  ros::Subscriber orderTriggerSub; /**< Order daemon triggers actions. */
+  MeteredPublisher actionToAgvPub; /**< Actions sent to the AGV for execution. */
+
+  MeteredPublisher agvActionCancelPub; /**< Cancel requests for actions running on the AGV. */
+
+  MeteredPublisher prActionsPub; /**< Pause/resume requests for the actions running on the AGV. */
+
+  MeteredPublisher prDrivingPub; /**< Pause/resume requests for the driving AGV. */
+
+  MeteredPublisher
+      actionStatesPub; /**< Batches of action states from action_daemon to state_daemon. Only the
+                          actionStates field of the state message is used. */
+
+  ros::Timer actionStatesTimer; /**< Timer used to publish the batched action states regularly. */
+
+  double actionStatesPeriod; /**< Period of the batched action states. */
+
+  double updatePeriod; /**< Period of the main event loop (UpdateActions). */
+
+  ros::Timer updateTimer; /**< Timer running the main event loop (UpdateActions). */
+
+  MeteredPublisher actionErrorsPub; /**< VDA 5050 errors of actions that missed their deadline. */
 
-  ros::Subscriber orderCancelSub; /**< Order daemon sends response to order cancel request. */
+  connector_utils::DeadlineScheduler
+      actionDeadlines; /**< Deadlines of the actions sent to the AGV, keyed by action ID. */
 
-  ros::Publisher actionStatesPub; /**< States of actions from action_daemon to state_daemon. */
+  ros::Timer deadlineTimer; /**< One-shot timer that fires at the earliest action deadline. */
 
-  ros::Publisher orderCancelPub; /**< Cancelled actions from action_daemon to order_daemon. */
+  ros::Time scheduledDeadline; /**< Deadline the timer is started for, zero if it is stopped. */
 
-  ros::Publisher allActionsCancelledPub; /**< All actions of one order to cancel cancelled from
+  double defaultActionDeadline; /**< Deadline of actions without a more specific one in seconds.
+                                   Non-positive values disable the deadline. */
+
+  map<string, double> actionTypeDeadlines; /**< Deadlines per action type in seconds. */
+
+  vector<vda5050_msgs::ActionState>
+      pendingActionStates; /**< Action state changes that were not published yet. */
+
+  unordered_map<string, string>
+      reportedActionStatus; /**< Last reported status of each action, used to drop duplicates. */
+
+  MeteredPublisher orderCancelPub; /**< Cancelled actions from action_daemon to order_daemon. */
+
+  MeteredPublisher allActionsCancelledPub; /**< All actions of one order to cancel cancelled from
                                             action_daemon to order_daemon. */
 
   bool isDriving; /**< True, if the vehicle is driving. */
 
+  /**
+   * Traced stages of an instant action, from its receipt on instantAction to its publishing on
+   * actionToAgv.
+   */
+  struct InstantActionStages {
+    size_t total;   /**< Receipt to publish. */
+    size_t receipt; /**< Wait in the subscriber queue. */
+    size_t enqueue; /**< Handling until the action is queued. */
+    size_t queued;  /**< Wait in the instant action queue. */
+    size_t publish; /**< Publishing on the actionToAgv topic. */
+  } iaStages;
+
+  size_t updateActionsMetric; /**< Counters of the UpdateActions calls, see MeteredScope. */
+
+  unordered_map<string, connector_utils::TraceSpan>
+      instantActionTraces; /**< Traces of the queued instant actions, keyed by action ID. */
+
  protected:
   deque<vda5050_msgs::Action> orderActionQueue; /**< Queue for keeping track of order actions. */
 
   deque<vda5050_msgs::Action>
       instantActionQueue; /**< Queue for keeping track of instant actions. */
 
-  vector<string> ordersSucCancelled; /**< List of all orders cancelled by order daemon. */
-
  public:
   /**
    * @brief Construct a new Action Client object
@@ -153,19 +215,49 @@ class ActionClient : public VDA5050Node {
    */
   ActionClient();
 
+  /**
+   * @brief Construct a new Action Client object running with given node handles, e.g. inside a
+   * nodelet.
+   *
+   * @param nh          Node handle used for topics and timers.
+   * @param private_nh  Node handle of the private namespace that holds the node configuration.
+   */
+  ActionClient(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh);
+
+  /**
+   * Stops the priority lane before the members are destroyed.
+   */
+  ~ActionClient() override;
+
   /**
    * Links all external publishing topics.
    *
    * @param nh  ROS node handle for action daemon.
+   *
+   * @return    Number of topics that were bound anew.
    */
-  void LinkPublishTopics(ros::NodeHandle* nh);
+  size_t LinkPublishTopics(ros::NodeHandle* nh);
 
   /**
    * Links all external subscribing topics
    *
    * @param nh  ROS node handle for action daemon.
+   *
+   * @return    Number of topics that were bound anew.
    */
-  void LinkSubscriptionTopics(ros::NodeHandle* nh);
+  size_t LinkSubscriptionTopics(ros::NodeHandle* nh);
+
+  /**
+   * Reads the publish and update periods and the action deadlines.
+   */
+  void ReadConfiguration();
+
+  /**
+   * Applies the reloaded periods and deadlines and rebinds changed topics.
+   *
+   * @return  Number of topics that were bound anew.
+   */
+  size_t Reconfigure() override;
 
   /**
    * Callback for order trigger topic from order daemon. This callback is
@@ -175,7 +267,7 @@ class ActionClient : public VDA5050Node {
    *
    * @param msg  Message including the action ID to trigger.
    */
-  void OrderTriggerCallback(const std_msgs::String& msg);
+  void OrderTriggerCallback(const std_msgs::String::ConstPtr& msg);
 
   /**
    * Callback to process response to order cancel request from order daemon.
@@ -187,13 +279,14 @@ class ActionClient : public VDA5050Node {
    *
    * @param msg  Message including the ID of the cancelled order.
    */
-  void OrderCancelCallback(const std_msgs::String& msg);
+  void OrderCancelCallback(const std_msgs::String::ConstPtr& msg);
 
   /**
    * Callback for instant Actions topic from the fleet controller. This
    * callback is called when a new message arrives at the /instantActions
-   * topic. Actions are queued into a FIFO queue. The first element of that
-   * queue is sent to the AGV for execution.
+   * topic. Actions are queued into a FIFO queue, which is drained right away
+   * as far as the blocking types of the running actions allow. startPause and
+   * stopPause are sent to the AGV without queueing. Runs on the priority lane.
    *
    * @param msg  Message including the incoming instant action.
    */
@@ -222,6 +315,77 @@ class ActionClient : public VDA5050Node {
    */
   void DrivingCallback(const std_msgs::Bool::ConstPtr& msg);
 
+  /**
+   * Queues an action state change for the next batch. Changes to the status that was reported
+   * last are dropped, and only the latest state of each action is kept in a batch. Terminal states
+   * (FINISHED, FAILED) flush the batch immediately.
+   *
+   * @param actionState  New state of the action.
+   */
+  void ReportActionState(const vda5050_msgs::ActionState& actionState);
+
+  /**
+   * Publishes all pending action state changes as one message.
+   */
+  void FlushActionStates();
+
+  /**
+   * Sends an action to the AGV and arms its deadline.
+   *
+   * @param action  Action to send.
+   */
+  void SendActionToAgv(const vda5050_msgs::Action& action);
+
+  /**
+   * Get the deadline of an action. The "deadline" action parameter takes precedence over the
+   * deadline configured for the action type, which takes precedence over the default deadline.
+   *
+   * @param action  Action to get the deadline for.
+   *
+   * @return        Time the AGV has for the action in seconds. Non-positive if the action has no
+   *                deadline.
+   */
+  double GetActionDeadline(const ActionElement& action) const;
+
+  /**
+   * Arms the deadline of an action sent to the AGV. The deadline is disarmed by the first state the
+   * AGV reports for the action, so it bounds the time until the AGV takes the action over, not the
+   * time the action runs.
+   *
+   * @param action  Action to arm the deadline for.
+   */
+  void ArmDeadline(const ActionElement& action);
+
+  /**
+   * Starts the deadline timer for the earliest armed deadline, or stops it if none is armed.
+   */
+  void ScheduleDeadlineTimer();
+
+  /**
+   * Callback of the deadline timer. Handles all expired deadlines.
+   *
+   * @param event  Timer event.
+   */
+  void DeadlineTimerCallback(const ros::TimerEvent& event);
+
+  /**
+   * Handles an action the AGV did not report a state for in time. The action is cancelled on the
+   * AGV, reported as FAILED and released like a failed action. A VDA 5050 error is published for
+   * the state message.
+   *
+   * @param action  Action that missed its deadline.
+   */
+  void ActionDeadlineExpired(const shared_ptr<ActionElement>& action);
+
+  /**
+   * Releases an action that stopped on the AGV. Resumes driving for blocking actions, removes the
+   * action from the active actions and disarms its deadline.
+   *
+   * @param action  Action that stopped.
+   * @param failed  True if the action failed.
+   */
+  void ReleaseAction(const shared_ptr<ActionElement>& action, bool failed);
+
   /**
    * Adds a new action to the activeActionsList list.
    *
@@ -271,12 +435,35 @@ class ActionClient : public VDA5050Node {
    */
   shared_ptr<ActionElement> FindAction(string actionId);
 
+  /**
+   * Counts down the cancellation of the order the given action belongs to. Called once a
+   * cancelled action reached FINISHED or FAILED.
+   *
+   * @param action  Cancelled action that stopped.
+   */
+  void CountDownCancellation(const shared_ptr<ActionElement>& action);
+
+  /**
+   * Completes an order cancellation if possible. Sends the "all actions cancelled" message as soon
+   * as no cancelled action is running anymore. Once the order daemon also confirmed the
+   * cancellation, the cancel instant action is reported as FINISHED and the tracker is removed.
+   *
+   * @param orderId  ID of the order to cancel.
+   */
+  void CompleteCancellation(const string& orderId);
+
   /**
    * Processes actions based on their type. This method represents the main event loop. Based on the
    * order and instan action queues, the method processes incoming actions and pauses driving state
    * and pauses/resumes other actions.
    */
   void UpdateActions();
+
+  /**
+   * Runs UpdateActions until the instant action queue is empty or its first action has to wait,
+   * instead of sending one instant action per update period.
+   */
+  void DrainInstantActions();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef ORDER_INTAKE_H
+#define ORDER_INTAKE_H
+
+#include <cstddef>
+#include <set>
+#include <string>
+#include "models/Order.h"
+#include "models/State.h"
+#include "utils/metrics.h"
+#include "utils/tracer.h"
+
+/**
+ * Capabilities of the vehicle that incoming orders are checked against, e.g. from its factsheet.
+ * Limits of 0 are not checked.
+ */
+struct OrderCapabilities {
+  size_t maxNodes{0};                /**< Most nodes of an order. */
+  size_t maxEdges{0};                /**< Most edges of an order. */
+  size_t maxActions{0};              /**< Most actions of a node or an edge. */
+  size_t maxIdLength{0};             /**< Longest order, node, edge or action ID. */
+  bool trajectories{true};           /**< The vehicle follows the trajectories of edges. */
+  std::set<std::string> actionTypes; /**< Supported action types, empty to allow all. */
+};
+
+/**
+ * Pipeline that received orders pass before they are accepted: duplicate filter, structural
+ * validation, capability validation, base stitching, state update and publish. The first four
+ * stages only check the order and are run by Check(), the state update and the publish are run by
+ * the node through RunStage(). Each stage can also be called on its own.
+ *
+ * Every stage is timed with a MeteredScope and traced, and every rejection is counted by its
+ * reason. The intake keeps no state of its own besides the capabilities, so the intakes of
+ * different vehicles pass their orders through the stages at the same time.
+ */
+class OrderIntake {
+ public:
+  /**
+   * Stages of the pipeline, in the order they are run.
+   */
+  enum Stage {
+    DUPLICATE_FILTER,
+    STRUCTURE_VALIDATION,
+    CAPABILITY_VALIDATION,
+    BASE_STITCHING,
+    STATE_UPDATE,
+    PUBLISH,
+    STAGE_COUNT
+  };
+
+  /**
+   * Reasons to reject an order.
+   */
+  enum Rejection {
+    DUPLICATE,              /**< Same order update as the current one. */
+    STALE_UPDATE,           /**< Lower order update ID than the current one. */
+    INVALID_STRUCTURE,      /**< Nodes and edges do not form a valid sequence. */
+    EXCEEDS_CAPABILITIES,   /**< The vehicle cannot execute the order. */
+    BASE_MISMATCH,          /**< Update does not start at the last node of the base. */
+    ORDER_ACTIVE,           /**< New order while another order is active. */
+    OUT_OF_DEVIATION_RANGE, /**< Vehicle is not at the first node of a new order. */
+    REJECTION_COUNT
+  };
+
+  /**
+   * Outcome of the checking stages.
+   */
+  struct Verdict {
+    bool accepted{true};   /**< The order passed all stages so far. */
+    bool update{false};    /**< The order updates the current order. */
+    Rejection rejection{}; /**< Reason of the rejection, only set if not accepted. */
+    std::string reason;    /**< Description of the rejection. */
+
+    /**
+     * Rejects the order.
+     */
+    bool Reject(Rejection rejection, const std::string& reason);
+  };
+
+  /**
+   * Constructor for the intake. Adds the counters and the traced stages.
+   *
+   * @param metrics       Metrics to add the stage times and the rejections to.
+   * @param tracer        Tracer to add the stages to.
+   * @param capabilities  Capabilities of the vehicle.
+   */
+  OrderIntake(connector_utils::Metrics* metrics, connector_utils::Tracer* tracer,
+      const OrderCapabilities& capabilities = OrderCapabilities());
+
+  /**
+   * Set the capabilities of the vehicle.
+   */
+  inline void SetCapabilities(const OrderCapabilities& capabilities) {
+    this->capabilities = capabilities;
+  }
+
+  /**
+   * Get the name of a rejection reason, e.g. "stale update".
+   */
+  static const char* GetRejectionName(Rejection rejection);
+
+  /**
+   * Drops resent order updates and updates older than the current one, and tells updates of the
+   * current order apart from new orders.
+   *
+   * @param order    Received order.
+   * @param state    State of the vehicle.
+   * @param verdict  Verdict, update is set for updates of the current order.
+   *
+   * @return         True if the order passed.
+   */
+  bool FilterDuplicate(const Order& order, State& state, Verdict* verdict) const;
+
+  /**
+   * Checks that the nodes and edges of the order form a valid sequence, see Order::Validate.
+   */
+  bool ValidateStructure(const Order& order, Verdict* verdict) const;
+
+  /**
+   * Checks the order against the capabilities of the vehicle.
+   */
+  bool ValidateCapabilities(const Order& order, Verdict* verdict) const;
+
+  /**
+   * Checks that an update continues at the last node of the base, or that the vehicle is idle and
+   * at the first node of a new order.
+   *
+   * @param order    Received order.
+   * @param state    State of the vehicle.
+   * @param current  Order the vehicle executes.
+   * @param verdict  Verdict of the earlier stages.
+   *
+   * @return         True if the order passed.
+   */
+  bool StitchBase(const Order& order, State& state, const Order& current, Verdict* verdict) const;
+
+  /**
+   * Runs the checking stages until one rejects the order. Times the stages, counts the rejection
+   * and marks the stages in the trace.
+   *
+   * @param order    Received order.
+   * @param state    State of the vehicle.
+   * @param current  Order the vehicle executes.
+   * @param trace    Trace of the order, nullptr to trace nothing.
+   *
+   * @return         Verdict on the order.
+   */
+  Verdict Check(const Order& order, State& state, const Order& current,
+      connector_utils::TraceSpan* trace = nullptr);
+
+  /**
+   * Runs one of the later stages of an accepted order, e.g. the state update, and times it.
+   *
+   * @param stage  Stage that is run.
+   * @param run    Function running the stage.
+   * @param trace  Trace of the order, nullptr to trace nothing.
+   */
+  template <typename F>
+  void RunStage(Stage stage, const F& run, connector_utils::TraceSpan* trace = nullptr) {
+    {
+      connector_utils::MeteredScope scope(metrics, stageMetrics[stage]);
+      run();
+    }
+    if (trace) trace->Mark(stageTraces[stage]);
+  }
+
+ private:
+  connector_utils::Metrics* metrics; /**< Metrics of the node. */
+
+  OrderCapabilities capabilities; /**< Capabilities of the vehicle. */
+
+  size_t stageMetrics[STAGE_COUNT]; /**< Counters of each stage, see MeteredScope. */
+
+  size_t stageTraces[STAGE_COUNT]; /**< Traced stage of each stage. */
+
+  size_t rejectionMetrics[REJECTION_COUNT]; /**< Counters of the rejections by reason. */
+
+  size_t acceptedMetric; /**< Counter of the accepted orders. */
+};
+
+#endif
@@ -14,6 +14,8 @@
 #include <std_msgs/UInt32.h>
 #include <chrono>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include "models/models.h"
@@ -22,6 +24,10 @@
 #include "std_msgs/Float64.h"
 #include "std_msgs/Int32.h"
 #include "std_msgs/String.h"
+#include "std_msgs/UInt8.h"
+#include "utils/journal.h"
+#include "utils/zone_index.h"
+#include "vda5050_connector/order_intake.h"
 #include "vda5050_msgs/AGVPosition.h"
 #include "vda5050_msgs/Action.h"
 #include "vda5050_msgs/ActionState.h"
@@ -69,26 +75,117 @@ class VDA5050Connector : public VDA5050Node {
    * communication.
    */
 
-  ros::Publisher orderPublisher; /**< Order message publisher. */
+  MeteredPublisher orderPublisher; /**< Order message publisher. */
 
-  ros::Publisher iaPublisher; /**< InstantAction message publisher. */
+  MeteredPublisher iaPublisher; /**< InstantAction message publisher. */
 
-  ros::Publisher
+  MeteredPublisher
       statePublisher; /**< Publisher object for state messages to the fleet controller. */
-  ros::Publisher
+  MeteredPublisher
       visPublisher; /**< Publisher object for visualization messages to the fleet controller. */
-  ros::Publisher connectionPublisher; /**< Publisher for connection messages. */
+  MeteredPublisher connectionPublisher; /**< Publisher for connection messages. */
 
   ros::Timer stateTimer; /**< Timer used to publish state messages regularly. */
   ros::Timer visTimer;   /**< Timer used to publish visualization messages regularly. */
   ros::Timer connTimer;  /**< Timer used to publish connection state messages regularly. */
+  ros::Timer updateTimer; /**< Timer running the main loop of the node (Update). */
 
   int stateHeaderId{0}; /**< Header Id used for state messages. */
   int visHeaderId{0};   /**< Header Id used for visualization messages. */
   int connHeaderId{0};  /**< Header Id used for connection state messages. */
 
-  std::vector<std::shared_ptr<ros::Subscriber>>
-      subscribers; /**< List of subsribers used by the StateAggregator to build the robot state. */
+  bool linkUp{true}; /**< State of the link of the MQTT bridge to the broker. */
+
+  double stateMsgPeriod; /**< Period of the state messages if nothing triggers them. */
+
+  double visMsgPeriod; /**< Configured period of the visualization messages. */
+
+  double connMsgPeriod; /**< Period of the connection messages. */
+
+  double updatePeriod; /**< Period of the main loop (Update). */
+
+  double visDeadbandDistance; /**< Distance the AGV has to move to send a visualization message
+                                   before the longest visualization period, 0 to always send. */
+
+  double visDeadbandAngle; /**< Angle the AGV has to turn to send a visualization message before
+                                the longest visualization period, 0 to ignore the heading. */
+
+  vda5050_msgs::AGVPosition lastVisPosition; /**< Position of the last visualization message. */
+
+  ros::Time lastVisTime; /**< Time of the last visualization message. */
+
+  double maxVisMsgPeriod; /**< Longest period of the visualization messages while throttled. */
+
+  int trimStateLevel; /**< Throttle level from which state messages are trimmed, 0 to never trim. */
+
+  int throttleLevel{0}; /**< Throttle level of the uplink, set by the bandwidth governor. */
+
+  /**
+   * Traced stages of an order, from its receipt on order_from_mc to its publishing on order. The
+   * stages in between are traced by the order intake.
+   */
+  struct OrderStages {
+    size_t total;   /**< Receipt to publish. */
+    size_t receipt; /**< Wait in the subscriber queue. */
+  } orderStages;
+
+  OrderIntake orderIntake; /**< Stages received orders pass before they are published. */
+
+  /**
+   * Traced stages of an instant action, from its receipt on ia_from_mc to its publishing.
+   */
+  struct InstantActionStages {
+    size_t total;   /**< Receipt to publish. */
+    size_t receipt; /**< Wait in the subscriber queue. */
+    size_t publish; /**< Publishing on the instant_action topic. */
+  } iaStages;
+
+  size_t publishStateMetric; /**< Counters of the PublishState calls, see MeteredScope. */
+
+  std::unique_ptr<connector_utils::Journal>
+      journal; /**< Journal of the order and state changes, nullptr if it is off. */
+
+  bool journalSync; /**< Write each journal record to the disk before going on. */
+
+  bool replaying{false}; /**< The journal is replayed, the replayed changes are not journaled. */
+
+  ros::Timer compactionTimer; /**< Timer used to compact the journal regularly. */
+
+  double zoneCellSize; /**< Edge length of the grid cells of the zone indexes in m. */
+
+  std::map<std::string, connector_utils::ZoneIndex>
+      zoneIndexes; /**< Index of the latest zone set of each map, by map id. */
+
+  const connector_utils::ZoneIndex*
+      activeZones{nullptr}; /**< Index of the zone set of the current map, nullptr if none. */
+
+  std::vector<size_t> zonesInside; /**< Zones of the active zone set containing the last pose. */
+
+  std::vector<size_t> locatedZones; /**< Zones containing the current pose, reused buffer. */
+
+  static const TopicBinding<VDA5050Connector>
+      publishBindings[]; /**< Bindings of the publish_topics keys to the publishers. */
+
+  static const TopicBinding<VDA5050Connector>
+      subscribeBindings[]; /**< Bindings of the subscribe_topics keys to the callbacks. */
+
+  /**
+   * Handler of a predefined instant action.
+   *
+   * @return  True if the action is forwarded to the vehicle.
+   */
+  typedef bool (VDA5050Connector::*InstantActionHandler)(const vda5050_msgs::Action& action);
+
+  /**
+   * Binds an instant action type to its handler.
+   */
+  struct InstantActionBinding {
+    const char* actionType;      /**< Action type, e.g. "stateRequest". */
+    InstantActionHandler handle; /**< Handler of the actions of the type. */
+  };
+
+  static const InstantActionBinding
+      instantActionBindings[]; /**< Handlers of predefined instant actions, others are forwarded. */
 
   bool newPublishTrigger{
       false}; /**< Trigger used to publish state messages on significant updates. */
@@ -102,19 +199,57 @@ class VDA5050Connector : public VDA5050Node {
    */
   VDA5050Connector();
 
+  /**
+   * Constructor for connector objects running with given node handles, e.g. inside a nodelet.
+   *
+   * @param nh          Node handle used for topics and timers.
+   * @param private_nh  Node handle of the private namespace that holds the node configuration.
+   */
+  VDA5050Connector(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh);
+
+  /**
+   * Constructor for connector objects of one of several vehicles in a process, e.g. of a
+   * VehicleHost. The serial number replaces the global /header/serial_number parameter.
+   *
+   * @param nh            Node handle used for topics and timers.
+   * @param private_nh    Node handle of the private namespace that holds the node configuration.
+   * @param serialNumber  Serial number of the vehicle.
+   */
+  VDA5050Connector(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh,
+      const std::string& serialNumber);
+
+  /**
+   * Stops the priority lane before the members are destroyed.
+   */
+  ~VDA5050Connector() override;
+
+  /**
+   * Get the state of the vehicle.
+   */
+  inline const State& GetState() const { return state; }
+
+  /**
+   * Get the current order.
+   */
+  inline const Order& GetOrder() const { return order; }
+
   /**
    * Links all external publishing topics.
    *
    * @param nh  ROS node handle for order manager.
+   *
+   * @return    Number of topics that were bound anew.
    */
-  void LinkPublishTopics(ros::NodeHandle* nh);
+  size_t LinkPublishTopics(ros::NodeHandle* nh);
 
   /**
    * Links all external subscribing topics
    *
    * @param nh  ROS node handle for order manager.
+   *
+   * @return    Number of topics that were bound anew.
    */
-  void LinkSubscriptionTopics(ros::NodeHandle* nh);
+  size_t LinkSubscriptionTopics(ros::NodeHandle* nh);
 
   /**
    * Creates a new order element if no order exists.
@@ -144,6 +279,12 @@ class VDA5050Connector : public VDA5050Node {
    */
   void UpdateExistingOrder(const Order& order_update);
 
+  /**
+   * Runs one iteration of the main loop: monitors the order, clears expired internal errors and
+   * publishes the state message if an update was triggered.
+   */
+  void Update();
+
   /**
    * Main loop of the node. Consists of the following steps:
    * - get order actions
@@ -167,7 +308,7 @@ class VDA5050Connector : public VDA5050Node {
 
   /**
    * Sets the header timestamp and publishes the state message. Updates the headerId after
-   * publishing
+   * publishing. The optional content is left out while the uplink is throttled to the trim level.
    */
   void PublishState();
 
@@ -177,9 +318,54 @@ class VDA5050Connector : public VDA5050Node {
    */
   void PublishVisualization();
 
+  /**
+   * Reads the publish periods, the uplink throttle and the visualization deadband.
+   */
+  void ReadPublishConfiguration();
+
+  /**
+   * Sets the period of the visualization timer from the configured period and the throttle level.
+   */
+  void UpdateVisualizationPeriod();
+
+  /**
+   * Applies the reloaded publish configuration and rebinds changed topics.
+   *
+   * @return  Number of topics that were bound anew.
+   */
+  size_t Reconfigure() override;
+
+  /**
+   * Opens the journal if a file is configured and restores the order and the order state from it.
+   */
+  void SetupJournal();
+
+  /**
+   * Restores the order and the order state by replaying the journal.
+   *
+   * @return  Number of replayed records.
+   */
+  size_t ReplayJournal();
+
+  /**
+   * Replaces the records of the journal by a snapshot of the order and the order state.
+   */
+  void CompactJournal();
+
+  /**
+   * Appends a message to the journal, compacting it first if it is full. Does nothing while the
+   * journal is off or replayed.
+   *
+   * @param kind  Kind of the record.
+   * @param msg   Message to store.
+   */
+  template <typename M>
+  void AppendToJournal(uint8_t kind, const M& msg);
+
   /**
    * Sets the header timestamp and publishes the connection state message. Updates the headerId
-   * after publishing.
+   * after publishing. ONLINE messages are skipped while the MQTT bridge has no link to the broker,
+   * as they could only arrive after the broker published the last will.
    *
    * @param connected State of the connection.
    */
@@ -194,13 +380,27 @@ class VDA5050Connector : public VDA5050Node {
   // -------- All order callbacks --------
 
   /**
-   * Callback for incoming orders. Decides if the incoming order should be
-   * appended or rejected according to the flowchart in VDA 5050.
+   * Callback for incoming orders. Passes the order through the stages of the order intake, which
+   * decide if the incoming order should be appended or rejected according to the flowchart in VDA
+   * 5050.
    *
    * @param msg  Incoming order message.
    */
   void OrderCallback(const vda5050_msgs::Order::ConstPtr& msg);
 
+  /**
+   * Reports a rejected order by adding the error of its rejection reason to the state.
+   *
+   * @param new_order  Rejected order.
+   * @param verdict    Verdict of the order intake.
+   */
+  void RejectOrder(const Order& new_order, const OrderIntake::Verdict& verdict);
+
+  /**
+   * Reads the capabilities of the vehicle that orders are checked against.
+   */
+  void ReadCapabilities();
+
   /**
    * Callback for state messages relating to orders. Adds received information to the state message.
    *
@@ -208,6 +408,22 @@ class VDA5050Connector : public VDA5050Node {
    */
   void OrderStateCallback(const vda5050_msgs::State::ConstPtr& msg);
 
+  /**
+   * Callback for batched action states from the action client. Only the actionStates field of the
+   * message is used.
+   *
+   * @param msg  Incoming state message.
+   */
+  void ActionStatesCallback(const vda5050_msgs::State::ConstPtr& msg);
+
+  /**
+   * Callback for errors raised by the action client, e.g. for actions that missed their deadline.
+   * The errors are added as internal errors to the state message.
+   *
+   * @param msg  Incoming errors message.
+   */
+  void ActionErrorsCallback(const vda5050_msgs::Errors::ConstPtr& msg);
+
   /**
    * Callback for incoming cancel requests. When an instantAction message with
    * a cancel request arrives at the action node, the request is transferred
@@ -219,8 +435,32 @@ class VDA5050Connector : public VDA5050Node {
 
   // -------- All InstantAction callbacks --------
 
+  /**
+   * Callback for incoming instant actions, runs on the priority lane. Predefined actions are
+   * handled according to instantActionBindings, the others are forwarded to the vehicle.
+   *
+   * @param msg  Instant actions of the master control.
+   */
   void InstantActionCallback(const vda5050_msgs::InstantAction::ConstPtr& msg);
 
+  /**
+   * Answers a stateRequest with a state message right away.
+   *
+   * @param action  stateRequest action.
+   *
+   * @return        False, the vehicle is not involved.
+   */
+  bool HandleStateRequest(const vda5050_msgs::Action& action);
+
+  /**
+   * Fails a cancelOrder without an order to cancel, as the vehicle has nothing to stop.
+   *
+   * @param action  cancelOrder action.
+   *
+   * @return        True if there is an order, which the vehicle has to cancel.
+   */
+  bool HandleCancelOrder(const vda5050_msgs::Action& action);
+
   // -------- All state callbacks --------
 
   /**
@@ -272,12 +512,34 @@ class VDA5050Connector : public VDA5050Node {
    */
   void AGVPositionMapIdCallback(const std_msgs::String::ConstPtr& msg);
 
+  /**
+   * Callback for zone sets of the master control, as JSON payload of the zones topic. The zone set
+   * replaces the previous one of its map.
+   *
+   * @param msg  Incoming message.
+   */
+  void ZoneSetCallback(const std_msgs::String::ConstPtr& msg);
+
+  /**
+   * Selects the zone set of the current map. While a zone set is selected, the zone set id and the
+   * interaction zones of the state are computed from it.
+   */
+  void ActivateZones();
+
+  /**
+   * Updates the interaction zones of the state if the zones containing the position changed.
+   *
+   * @param x  X coordinate of the vehicle on the map.
+   * @param y  Y coordinate of the vehicle on the map.
+   */
+  void UpdateZones(double x, double y);
+
   /**
    * Callback function for incoming AGV positions.
    *
    * @param msg  Incoming message.
    */
-  void AGVPositionCallback(const geometry_msgs::Pose& msg);
+  void AGVPositionCallback(const geometry_msgs::Pose::ConstPtr& msg);
 
   /**
    * Callback function for incoming localization score messages.
@@ -291,7 +553,7 @@ class VDA5050Connector : public VDA5050Node {
    *
    * @param msg  Incoming message.
    */
-  void AGVVelocityCallback(const geometry_msgs::Twist& msg);
+  void AGVVelocityCallback(const geometry_msgs::Twist::ConstPtr& msg);
 
   /**
    * Callback function for incoming Load messages.
@@ -366,6 +628,27 @@ class VDA5050Connector : public VDA5050Node {
    * @param msg  Incoming message.
    */
   void InteractionZoneCallback(const vda5050_msgs::InteractionZoneStates::ConstPtr& msg);
+
+  /**
+   * Callback for the state of the link of the MQTT bridge to the broker. Publishes an ONLINE
+   * connection message as soon as the link is back, replacing the retained last will.
+   *
+   * @param msg  Incoming message, true if the bridge is connected.
+   */
+  void LinkStateCallback(const std_msgs::Bool::ConstPtr& msg);
+
+  /**
+   * Callback for the throttle level of the uplink. Each level doubles the visualization period up
+   * to its maximum, from the trim level on state messages are sent without optional content.
+   *
+   * @param msg  Incoming message, 0 while the uplink is within its budget.
+   */
+  void UplinkThrottleCallback(const std_msgs::UInt8::ConstPtr& msg);
+
+  /**
+   * Returns true if state messages are sent without optional content at the current throttle level.
+   */
+  inline bool TrimState() const { return trimStateLevel > 0 && throttleLevel >= trimStateLevel; }
 };
 
 #endif
\ No newline at end of file
@@ -12,14 +12,65 @@
 #include <ros/console.h>
 #include <ros/ros.h>
 #include <tf/tf.h>
+#include <functional>
 #include <iostream>
+#include <list>
+#include <map>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "std_msgs/String.h"
+#include "std_srvs/Trigger.h"
+#include "utils/metrics.h"
+#include "utils/param_tree.h"
+#include "utils/priority_lane.h"
+#include "utils/tracer.h"
 #include "utils/utils.h"
 
+/**
+ * Binds a topic key of the node configuration to a ROS publisher or subscriber. Every node defines
+ * its bindings as a constant table, which is resolved at startup and on each reload by
+ * VDA5050Node::LinkTopics.
+ * The link function is a template instance that knows the message type and the target member, so
+ * publishers are stored as typed members and no lookup by name is needed when publishing.
+ */
+template <typename Node>
+struct TopicBinding {
+  const char* key; /**< Topic key used in the configuration, e.g. "state". */
+
+  uint32_t queueSize; /**< Queue size of the publisher or subscriber. */
+
+  void (*link)(Node* node, ros::NodeHandle* nh, const std::string& param, const std::string& topic,
+      uint32_t queueSize); /**< Creates the publisher or subscriber for the topic. */
+};
+
+/**
+ * Publisher that counts the published messages in the metrics of its node. Publisher bindings
+ * store their publishers as MeteredPublisher, which is used like a ros::Publisher.
+ */
+class MeteredPublisher {
+ public:
+  ros::Publisher publisher; /**< Advertised publisher. */
+
+  connector_utils::Metrics* metrics{nullptr}; /**< Metrics of the node. */
+
+  size_t counter{0}; /**< Counter of the published messages. */
+
+  /**
+   * Publishes a message and counts it.
+   *
+   * @param message  Message or shared pointer to the message.
+   */
+  template <typename M>
+  void publish(const M& message) const {
+    if (metrics) metrics->Add(counter);
+    publisher.publish(message);
+  }
+};
+
 /**
  * Model for all nodes. Every node provides some functionality to translate
  * messages between the robot's internal communication and the VDA-5050-based
@@ -30,12 +81,347 @@ class VDA5050Node {
 
   ros::NodeHandle nh; /**< ROS node handle, needed to call ROS functions. */
 
+  ros::NodeHandle privateNh; /**< Private ROS node handle, used to read the node configuration. */
+
+  connector_utils::ParamTree
+      params; /**< Configuration of the private namespace, fetched once at construction. */
+
+  ros::WallTime startTime; /**< Start of the construction, to log the startup time. */
+
+  ros::WallDuration paramsFetchTime; /**< Time taken to fetch the configuration. */
+
+  connector_utils::Metrics metrics; /**< Counters of the callbacks and publishers of the node. */
+
+  std::unique_ptr<connector_utils::PriorityLane>
+      priorityLane; /**< Lane of the priority subscriptions, null if it is disabled. */
+
+  ros::NodeHandle priorityNh; /**< Node handle of the priority subscriptions. */
+
+  /**
+   * Subscription created from a topic binding, with the queue that tracks its depth.
+   */
+  struct MeteredSubscription {
+    std::string topic;                   /**< Subscribed topic. */
+    connector_utils::MeteredQueue queue; /**< Queue between ROS and the spinner of the node. */
+    uint64_t reportedFull;               /**< Times the queue was full at the last report. */
+
+    MeteredSubscription(const std::string& topic, ros::CallbackQueueInterface* target,
+        uint32_t queueSize)
+        : topic(topic), queue(target, queueSize), reportedFull(0) {}
+  };
+
+  std::list<MeteredSubscription>
+      meteredSubscriptions; /**< Declared before the subscribers, which use their queues. A list,
+                                 as the queues of released subscribers are removed. */
+
+  /**
+   * Subscriber created from a topic binding.
+   */
+  struct LinkedSubscriber {
+    ros::Subscriber subscriber;                 /**< Subscriber of the topic. */
+    const connector_utils::MeteredQueue* queue; /**< Queue of the subscription. */
+  };
+
+  std::map<std::string, LinkedSubscriber>
+      subscribers; /**< Subscribers created from the topic bindings, by topic parameter. */
+
+  std::map<std::string, std::string> linkedTopics; /**< Linked topics by topic parameter. */
+
+  std::vector<LinkedSubscriber>
+      retiredSubscribers; /**< Rebound subscribers, kept until their queued messages are handled. */
+
+  std::vector<ros::Publisher>
+      retiredPublishers; /**< Rebound publishers, kept until their sent messages are delivered. */
+
+  ros::Timer retireTimer; /**< Timer used to release the rebound publishers and subscribers. */
+
+  ros::ServiceServer reloadService; /**< Service that reloads the configuration. */
+
+  std::vector<std::pair<std::string, std::function<double()>>>
+      gauges; /**< Current values reported with the metrics, e.g. queue sizes. */
+
+  ros::Publisher metricsPub; /**< Publisher of the metrics. */
+
+  ros::Publisher metricsDiagnosticsPub; /**< Publisher of the metrics as diagnostics. */
+
+  ros::Timer metricsTimer; /**< Timer used to publish the metrics regularly. */
+
+  connector_utils::Tracer tracer; /**< Latencies of the stages messages pass in the node. */
+
+  ros::Time receiptTime; /**< Receipt time of the message handled by a traced callback. */
+
+  ros::Publisher tracePub; /**< Publisher of the stage latencies as diagnostics. */
+
+  ros::Timer traceTimer; /**< Timer used to publish the stage latencies regularly. */
+
+  std::string chromeTraceFile; /**< File the Chrome trace is written to, empty to write none. */
+
+  /**
+   * Link function for publisher bindings. Advertises the topic and stores the publisher in the
+   * given member of the node. A publisher of a previous topic is retired, see RetirePublisher.
+   *
+   * @tparam Node       Type of the node.
+   * @tparam M          Message type of the topic.
+   * @tparam Publisher  Member of the node that stores the publisher.
+   */
+  template <typename Node, typename M, MeteredPublisher Node::*Publisher>
+  static void Advertise(Node* node, ros::NodeHandle* nh, const std::string& param,
+      const std::string& topic, uint32_t queueSize) {
+    MeteredPublisher& publisher = node->*Publisher;
+    if (publisher.publisher) node->RetirePublisher(publisher.publisher);
+    publisher.publisher = nh->advertise<M>(topic, queueSize);
+    publisher.metrics = &node->metrics;
+    publisher.counter = node->metrics.AddCounter("published " + topic);
+  }
+
+  /**
+   * Link function for subscriber bindings. Subscribes the given callback of the node to the topic.
+   * The calls and the time spent in the callback are counted, and the depth of its queue tracked.
+   *
+   * @tparam Node      Type of the node.
+   * @tparam M         Message type of the topic.
+   * @tparam Callback  Member function of the node that is called for incoming messages.
+   */
+  template <typename Node, typename M, void (Node::*Callback)(const boost::shared_ptr<M const>&)>
+  static void Subscribe(Node* node, ros::NodeHandle* nh, const std::string& param,
+      const std::string& topic, uint32_t queueSize) {
+    size_t timed = connector_utils::MeteredScope::AddTimed(&node->metrics, topic);
+    ros::SubscribeOptions options;
+    options.template init<M>(topic, queueSize,
+        boost::function<void(const boost::shared_ptr<M const>&)>(
+            [node, timed](const boost::shared_ptr<M const>& message) {
+              connector_utils::MeteredScope scope(&node->metrics, timed);
+              (node->*Callback)(message);
+            }));
+    connector_utils::MeteredQueue* queue = node->MeterSubscription(nh, topic, queueSize);
+    options.callback_queue = queue;
+    node->LinkSubscriber(param, {nh->subscribe(options), queue});
+  }
+
+  /**
+   * Link function for subscriber bindings of traced callbacks. Like Subscribe, but the receipt
+   * time of each message is stored in receiptTime before the callback is called, so the callback
+   * can start a TraceSpan that includes the time the message waited in the subscriber queue.
+   *
+   * @tparam Node      Type of the node.
+   * @tparam M         Message type of the topic.
+   * @tparam Callback  Member function of the node that is called for incoming messages.
+   */
+  template <typename Node, typename M, void (Node::*Callback)(const boost::shared_ptr<M const>&)>
+  static void SubscribeTraced(Node* node, ros::NodeHandle* nh, const std::string& param,
+      const std::string& topic, uint32_t queueSize) {
+    size_t timed = connector_utils::MeteredScope::AddTimed(&node->metrics, topic);
+    ros::SubscribeOptions options;
+    options.template initByFullCallbackType<const ros::MessageEvent<M const>&>(topic, queueSize,
+        boost::function<void(const ros::MessageEvent<M const>&)>(
+            [node, timed](const ros::MessageEvent<M const>& event) {
+              connector_utils::MeteredScope scope(&node->metrics, timed);
+              node->receiptTime = event.getReceiptTime();
+              (node->*Callback)(event.getMessage());
+            }));
+    connector_utils::MeteredQueue* queue = node->MeterSubscription(nh, topic, queueSize);
+    options.callback_queue = queue;
+    node->LinkSubscriber(param, {nh->subscribe(options), queue});
+  }
+
+  /**
+   * Link function for subscriber bindings of callbacks that must not wait behind the other
+   * callbacks of the node. Like SubscribeTraced, but the callback is called on the priority lane
+   * of the node if it is enabled, see SetupPriorityLane.
+   *
+   * @tparam Node      Type of the node.
+   * @tparam M         Message type of the topic.
+   * @tparam Callback  Member function of the node that is called for incoming messages.
+   */
+  template <typename Node, typename M, void (Node::*Callback)(const boost::shared_ptr<M const>&)>
+  static void SubscribePriority(Node* node, ros::NodeHandle* nh, const std::string& param,
+      const std::string& topic, uint32_t queueSize) {
+    SubscribeTraced<Node, M, Callback>(
+        node, node->priorityLane ? &node->priorityNh : nh, param, topic, queueSize);
+  }
+
+  /**
+   * Creates the queue that tracks the depth of a subscription. Its callbacks are passed on to the
+   * callback queue of the node handle.
+   *
+   * @param nh         ROS node handle the subscription is created with.
+   * @param topic      Subscribed topic.
+   * @param queueSize  Size of the subscriber queue.
+   *
+   * @return           Queue to create the subscription with.
+   */
+  connector_utils::MeteredQueue* MeterSubscription(
+      ros::NodeHandle* nh, const std::string& topic, uint32_t queueSize);
+
+  /**
+   * Stores the subscriber of a topic parameter. A subscriber of a previous topic of the parameter
+   * is retired, it is shut down once the messages in its queue are handled.
+   *
+   * @param param       Topic parameter, e.g. "subscribe_topics/pose".
+   * @param subscriber  Subscriber of the current topic.
+   */
+  void LinkSubscriber(const std::string& param, const LinkedSubscriber& subscriber);
+
+  /**
+   * Keeps a publisher of a previous topic for a while, so the messages it sent last are still
+   * delivered to its subscribers.
+   *
+   * @param publisher  Publisher of the previous topic.
+   */
+  void RetirePublisher(const ros::Publisher& publisher);
+
+  /**
+   * Releases the retired publishers and the retired subscribers without queued messages, together
+   * with the queues of the subscribers.
+   */
+  void ReleaseRetired(const ros::TimerEvent& event);
+
+  /**
+   * Advertises the reload service of the node, e.g. /vda5050_connector/reload, or
+   * /agv_1/connector/reload for a vehicle of a VehicleHost.
+   */
+  void SetupReload();
+
+  /**
+   * Applies the reloaded configuration of the private namespace, e.g. publish periods and topics.
+   * Nodes override it for their own configuration.
+   *
+   * @return  Number of topics that were bound anew.
+   */
+  virtual size_t Reconfigure();
+
+  /**
+   * Service callback that reloads the configuration and applies it with Reconfigure. Runs on the
+   * callback queue of the node, so no other callback of the node sees a partial configuration.
+   */
+  bool ReloadCallback(std_srvs::Trigger::Request& request, std_srvs::Trigger::Response& response);
+
+  /**
+   * Adds a value that is reported with the metrics, e.g. the size of a queue of the node. The
+   * value is read on the thread of the node's timers.
+   *
+   * @param name   Name of the value.
+   * @param value  Function that returns the current value.
+   */
+  void AddGauge(const std::string& name, const std::function<double()>& value);
+
+  /**
+   * Reads the metrics configuration and starts publishing the metrics if it is enabled.
+   */
+  void SetupMetrics();
+
+  /**
+   * Publishes the counters, the subscriber queue depths and the gauges of the node.
+   */
+  void PublishMetrics(const ros::TimerEvent& event);
+
+  /**
+   * Fetches the configuration of the private namespace.
+   */
+  void FetchParams();
+
+  /**
+   * Starts the priority lane if the configuration enables it. The callbacks of the node handle,
+   * e.g. of its timers and subscriptions, are then called under the lock of the lane, so the node
+   * needs no further locking for its priority callbacks. Called before anything is created with
+   * the node handle.
+   */
+  void SetupPriorityLane();
+
+  /**
+   * Stops the thread of the priority lane. Nodes that subscribe with SubscribePriority call it
+   * first in their destructor, so no priority callback runs while their members are destroyed.
+   */
+  void StopPriorityLane();
+
+  /**
+   * Logs the time since the start of the construction. Called at the end of the constructor of
+   * the node.
+   */
+  void LogStartupTime();
+
+  /**
+   * Reads the tracing configuration and starts publishing the stage latencies if it is enabled.
+   */
+  void SetupTracing();
+
+  /**
+   * Get the name of a file of this node. The vehicles of a VehicleHost share the configuration, so
+   * the namespace of the node handle is added to the name, e.g. trace_agv_1.json for trace.json.
+   *
+   * @param file  Configured file name.
+   */
+  std::string GetNamespacedFile(const std::string& file) const;
+
+  /**
+   * Publishes the latencies of all stages that were passed since the last call and writes the
+   * Chrome trace.
+   */
+  void PublishTraces(const ros::TimerEvent& event);
+
+  /**
+   * Links all topics of a param family, e.g. "publish_topics", according to a binding table. Keys
+   * without a binding are reported and ignored. Topics that are already linked are kept, so on a
+   * reload only changed topics are bound anew. A new topic is linked before the previous one is
+   * retired, so no message is lost.
+   *
+   * @param node         Node that owns the publishers and callbacks.
+   * @param nh           ROS node handle used to create the publishers and subscribers.
+   * @param paramFamily  Name of the param family below the private namespace of the node.
+   * @param bindings     Binding table of the node.
+   *
+   * @return             Number of topics that were bound anew.
+   */
+  template <typename Node, std::size_t N>
+  size_t LinkTopics(Node* node, ros::NodeHandle* nh, const std::string& paramFamily,
+      const TopicBinding<Node> (&bindings)[N]) {
+    std::map<std::string, std::string> topicList = params.GetStrings(paramFamily);
+
+    size_t rebound = 0;
+    for (const auto& elem : topicList) {
+      auto linked = linkedTopics.find(elem.first);
+      if (linked != linkedTopics.end() && linked->second == elem.second) continue;
+
+      const TopicBinding<Node>* binding = nullptr;
+      for (const auto& candidate : bindings) {
+        if (connector_utils::CheckParamIncludes(elem.first, candidate.key)) {
+          binding = &candidate;
+          break;
+        }
+      }
+
+      if (!binding) {
+        ROS_WARN_STREAM("No topic binding found for parameter " << elem.first);
+        continue;
+      }
+      binding->link(node, nh, elem.first, elem.second, binding->queueSize);
+      if (linked != linkedTopics.end()) {
+        ROS_INFO("Rebound %s from %s to %s", elem.first.c_str(), linked->second.c_str(),
+            elem.second.c_str());
+        rebound++;
+      }
+      linkedTopics[elem.first] = elem.second;
+    }
+    return rebound;
+  }
+
  public:
   /**
-   * @brief Default constructor for node objects.
+   * @brief Default constructor for node objects. Uses the global and the private namespace of the
+   * ROS node.
+   *
+   */
+  VDA5050Node();
+
+  /**
+   * @brief Constructor for node objects running with given node handles, e.g. inside a nodelet.
    *
+   * @param nh          Node handle used for topics and timers.
+   * @param private_nh  Node handle of the private namespace that holds the node configuration.
    */
-  VDA5050Node() = default;
+  VDA5050Node(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh);
+
+  virtual ~VDA5050Node() = default;
 
   /**
    * Get names of all topics as a map of strings.
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef VEHICLE_HOST_H
+#define VEHICLE_HOST_H
+
+#include <ros/ros.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "mqtt_bridge/mqtt_bridge.h"
+#include "utils/param_tree.h"
+#include "utils/strand_pool.h"
+#include "vda5050_connector/action_client.h"
+#include "vda5050_connector/vda5050_connector.h"
+
+/**
+ * Runs the connector and the action client of many vehicles in one process, e.g. for simulations
+ * or gateways. The vehicles are read from the vehicles parameter, a list of serial numbers. Each
+ * vehicle gets its own namespace, named after its serial number, and the topics of its nodes are
+ * resolved in it, configured absolute names included. Topics of the shared_topics parameter, by
+ * default the link state and the throttle level of the bridge, are shared by all vehicles.
+ *
+ * All vehicles use the configuration of the connector, action_client and mqtt_bridge namespaces
+ * below the private namespace of the host. The callbacks of all vehicles are called by one
+ * StrandPool, the callbacks of a vehicle one at a time. The timestamps of all messages come from
+ * one cached source. If a bridge configuration is present, one MqttBridge links the topics of all
+ * vehicles over one connection to the broker.
+ */
+class VehicleHost {
+ public:
+  /**
+   * Constructs the host from the parameters of the private namespace.
+   */
+  VehicleHost();
+
+  /**
+   * Constructs a host running with given node handles.
+   *
+   * @param nh          Node handle the namespaces of the vehicles are created in.
+   * @param private_nh  Node handle of the private namespace that holds the host configuration.
+   */
+  VehicleHost(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh);
+
+  /**
+   * Sends OFFLINE messages for all vehicles and stops the threads before the vehicles are removed.
+   * The bridge forwards the OFFLINE messages before it is removed.
+   */
+  ~VehicleHost();
+
+  /**
+   * Get the number of hosted vehicles.
+   */
+  inline size_t GetVehicleCount() const { return vehicles.size(); }
+
+  /**
+   * Get the namespace of a vehicle: its serial number, with characters that are not allowed in ROS
+   * names replaced by underscores.
+   *
+   * @param serialNumber  Serial number of the vehicle.
+   */
+  static std::string VehicleNamespace(const std::string& serialNumber);
+
+ private:
+  /**
+   * Nodes of a hosted vehicle.
+   */
+  struct Vehicle {
+    std::string serialNumber; /**< Serial number of the vehicle. */
+
+    std::unique_ptr<connector_utils::CallbackStrand> strand; /**< Strand of all callbacks. */
+
+    std::unique_ptr<VDA5050Connector> connector; /**< Connector of the vehicle. */
+
+    std::unique_ptr<ActionClient> actionClient; /**< Action client of the vehicle. */
+  };
+
+  ros::NodeHandle nh; /**< Node handle the namespaces of the vehicles are created in. */
+
+  ros::NodeHandle privateNh; /**< Node handle of the private namespace. */
+
+  std::unique_ptr<connector_utils::StrandPool> pool; /**< Threads calling all callbacks. */
+
+  std::unique_ptr<connector_utils::CallbackStrand> bridgeStrand; /**< Strand of the bridge. */
+
+  std::unique_ptr<mqtt_bridge::MqttBridge> bridge; /**< Bridge of all vehicles, or nullptr. */
+
+  std::vector<Vehicle> vehicles; /**< Hosted vehicles. */
+
+  /**
+   * Reads the absolute topics of the connector and action client configuration that have to be
+   * moved into the namespaces of the vehicles.
+   *
+   * @param params  Configuration of the private namespace of the host.
+   */
+  std::vector<std::string> ReadVehicleTopics(const connector_utils::ParamTree& params);
+};
+
+#endif
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+/**
+ * Benchmark of the JSON encoder for state messages of a 1000 node order. Compares a fresh writer
+ * per message, a reused writer and writing an already built jsoncpp DOM of the same message. The
+ * CBOR encodings are measured against it, by their size and encoding time, as well as the
+ * conversion of the packed CBOR back to JSON as done by a gateway.
+ *
+ * Usage: json_encoder_benchmark [iterations]
+ */
+
+#include <json/json.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include "mqtt_bridge/cbor_transcoder.h"
+#include "mqtt_bridge/cbor_writer.h"
+#include "mqtt_bridge/json_writer.h"
+#include "mqtt_bridge/vda5050_encoders.h"
+#include "mqtt_bridge/vda5050_json.h"
+
+using namespace mqtt_bridge;
+
+vda5050_msgs::State CreateOrderState(uint32_t nodes) {
+  vda5050_msgs::State state;
+  state.headerId = 1;
+  state.timestamp = "2022-06-01T12:00:00.00Z";
+  state.version = "2.0.0";
+  state.manufacturer = "fml";
+  state.serialNumber = "agv_1";
+  state.orderId = "order_1";
+  state.lastNodeId = "node_0";
+  state.driving = true;
+  state.operatingMode = "AUTOMATIC";
+
+  for (uint32_t i = 0; i < nodes; i++) {
+    vda5050_msgs::NodeState nodeState;
+    nodeState.nodeId = "node_" + std::to_string(i);
+    nodeState.sequenceId = 2 * i;
+    nodeState.released = i < nodes / 2;
+    nodeState.nodePosition.x = 0.37 * i;
+    nodeState.nodePosition.y = 12.125 - 0.013 * i;
+    nodeState.nodePosition.theta = 1.5707963267948966;
+    nodeState.nodePosition.mapId = "hall_1";
+    state.nodeStates.push_back(nodeState);
+
+    if (i + 1 == nodes) break;
+    vda5050_msgs::EdgeState edgeState;
+    edgeState.edgeId = "edge_" + std::to_string(i);
+    edgeState.sequenceId = 2 * i + 1;
+    edgeState.released = nodeState.released;
+    state.edgeStates.push_back(edgeState);
+  }
+
+  for (uint32_t i = 0; i < nodes / 20; i++) {
+    vda5050_msgs::ActionState actionState;
+    actionState.actionId = "action_" + std::to_string(i);
+    actionState.actionType = "pick";
+    actionState.actionStatus = "WAITING";
+    state.actionStates.push_back(actionState);
+  }
+
+  state.agvPosition.x = 3.25;
+  state.agvPosition.y = 7.5;
+  state.agvPosition.mapId = "hall_1";
+  state.agvPosition.positionInitialized = true;
+  state.batteryState.batteryCharge = 87.5;
+  state.safetyState.eStop = "NONE";
+  return state;
+}
+
+/**
+ * Runs the given encoding function and prints the throughput.
+ *
+ * @param name        Name of the variant.
+ * @param iterations  Number of runs.
+ * @param encode      Function encoding one message, returns the number of written bytes.
+ */
+void Run(const char* name, int iterations, const std::function<size_t()>& encode) {
+  // Warm up, e.g. for the buffer capacity of a reused writer.
+  size_t bytes = encode();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) bytes = encode();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  double perMessage = elapsed.count() / iterations;
+  std::printf("%-16s %8zu bytes %10.1f us/msg %10.1f MB/s\n", name, bytes, perMessage * 1e6,
+      bytes / perMessage / 1e6);
+}
+
+int main(int argc, char** argv) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 1000;
+  vda5050_msgs::State state = CreateOrderState(1000);
+
+  Run("fresh writer", iterations, [&]() { return Serialize(state).size(); });
+
+  JsonWriter writer;
+  Run("reused writer", iterations, [&]() {
+    writer.Clear();
+    Encode(writer, state);
+    return writer.str().size();
+  });
+
+  // Only the dump of a finished DOM, building the DOM comes on top for a DOM based encoder.
+  Json::Value dom;
+  Json::Reader().parse(Serialize(state), dom);
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  Run("jsoncpp dump", iterations, [&]() { return Json::writeString(builder, dom).size(); });
+
+  CborWriter cbor;
+  Run("cbor writer", iterations, [&]() {
+    cbor.Clear();
+    Encode(cbor, state);
+    return cbor.str().size();
+  });
+
+  CborWriter packed(true);
+  Run("cbor packed", iterations, [&]() {
+    packed.Clear();
+    Encode(packed, state);
+    return packed.str().size();
+  });
+
+  // Bytes are the ones of the written JSON.
+  CborTranscoder transcoder;
+  Run("cbor to json", iterations, [&]() {
+    writer.Clear();
+    transcoder.ToJson(packed.str(), writer);
+    return writer.str().size();
+  });
+
+  return 0;
+}
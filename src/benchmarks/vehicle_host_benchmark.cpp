@@ -0,0 +1,92 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+/**
+ * Benchmark of the VehicleHost. Hosts an increasing number of vehicles and measures the resident
+ * memory and the CPU time per vehicle while their timers publish state, visualization and action
+ * state messages. Needs a running roscore and the configuration of the connector and the action
+ * client in the private namespace of the benchmark, e.g.
+ *
+ *   rosparam load config/vda5050_connector.yaml /vehicle_host_benchmark/connector
+ *   rosparam load config/action_client.yaml /vehicle_host_benchmark/action_client
+ *
+ * Usage: vehicle_host_benchmark [seconds] [vehicles...]
+ */
+
+#include <ros/ros.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "vda5050_connector/vehicle_host.h"
+
+/**
+ * Resident memory of the process in bytes.
+ */
+size_t ResidentBytes() {
+  size_t pages = 0, resident = 0;
+  FILE* statm = std::fopen("/proc/self/statm", "r");
+  if (statm) {
+    if (std::fscanf(statm, "%zu %zu", &pages, &resident) != 2) resident = 0;
+    std::fclose(statm);
+  }
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * CPU time of all threads of the process in seconds.
+ */
+double CpuSeconds() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "vehicle_host_benchmark");
+  double seconds = argc > 1 ? std::atof(argv[1]) : 10.0;
+  std::vector<int> counts;
+  for (int i = 2; i < argc; i++) counts.push_back(std::atoi(argv[i]));
+  if (counts.empty()) counts = {1, 10, 50, 100};
+
+  ros::NodeHandle privateNh("~");
+  std::printf("%8s %12s %12s %14s\n", "vehicles", "KB/vehicle", "setup ms", "% core/vehicle");
+  for (int count : counts) {
+    std::vector<std::string> serialNumbers;
+    for (int i = 0; i < count; i++) serialNumbers.push_back("bench_" + std::to_string(i));
+    privateNh.setParam("vehicles", serialNumbers);
+
+    size_t residentBefore = ResidentBytes();
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<VehicleHost> host(new VehicleHost(ros::NodeHandle(), privateNh));
+    std::chrono::duration<double> setup = std::chrono::steady_clock::now() - start;
+    size_t residentAfter = ResidentBytes();
+
+    // Leaves the connections between the nodes some time to settle before the CPU is measured.
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    double cpuBefore = CpuSeconds();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    double cpu = CpuSeconds() - cpuBefore;
+    host.reset();
+
+    std::printf("%8d %12.1f %12.1f %14.3f\n", count,
+        (residentAfter - static_cast<double>(residentBefore)) / 1024.0 / count,
+        setup.count() * 1e3, cpu / seconds * 100.0 / count);
+    if (!ros::ok()) break;
+  }
+  privateNh.deleteParam("vehicles");
+
+  return 0;
+}
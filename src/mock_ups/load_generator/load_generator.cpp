@@ -0,0 +1,256 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+/**
+ * Load generator for the connector. Simulates a fleet of vehicles that publish pose, velocity,
+ * battery and error streams, and a master control that sends orders, order updates and instant
+ * actions to them. All rates, burst sizes and message sizes are read from the private namespace,
+ * see config/load_generator.yaml. The content is seeded, so runs with the same configuration are
+ * repeatable.
+ *
+ * The achieved rate of each stream, the ticks the generator skipped because it could not keep up,
+ * and the messages the connectors sent back are reported periodically and at the end. Orders and
+ * instant actions that were sent but not forwarded by the connectors are reported as drops.
+ */
+
+#include <ros/ros.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include "load_profile.h"
+#include "vda5050_connector/vehicle_host.h"
+#include "vda5050_msgs/State.h"
+#include "vda5050_msgs/Visualization.h"
+
+/**
+ * Streams sent by each vehicle, in the order of STREAMS.
+ */
+enum Stream { POSE, VELOCITY, BATTERY, ERRORS, ORDER, ORDER_UPDATE, INSTANT_ACTION, STREAM_COUNT };
+
+/**
+ * Default load and input topic of each stream.
+ */
+const struct {
+  StreamProfile profile;
+  const char* topic;
+} STREAMS[STREAM_COUNT] = {
+    {{"pose", 10.0, 1, 1}, "pose"},
+    {{"velocity", 10.0, 1, 1}, "velocity"},
+    {{"battery", 1.0, 1, 1}, "battery_state"},
+    {{"errors", 0.2, 1, 2}, "errors"},
+    {{"order", 0.05, 1, 10}, "order_from_mc"},
+    {{"order_update", 0.2, 1, 4}, "order_from_mc"},
+    {{"instant_action", 0.5, 5, 2}, "ia_from_mc"},
+};
+
+/**
+ * Topics the connectors send to, counted to see what made it through.
+ */
+enum Output { STATE, VISUALIZATION, FORWARDED_ORDER, FORWARDED_INSTANT_ACTION, OUTPUT_COUNT };
+
+const char* OUTPUT_TOPICS[OUTPUT_COUNT] = {"state", "visualization", "order", "instant_action"};
+
+/**
+ * A simulated vehicle.
+ */
+struct SimulatedVehicle {
+  VehicleLoad load;
+  std::vector<ros::Publisher> publishers;
+  std::vector<ros::Subscriber> subscribers;
+};
+
+/**
+ * Counts of one report period, or of the whole run.
+ */
+struct Counts {
+  uint64_t sent[STREAM_COUNT]{};
+  uint64_t skipped[STREAM_COUNT]{};
+  uint64_t received[OUTPUT_COUNT]{};
+};
+
+double SteadySeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename M>
+ros::Subscriber Count(ros::NodeHandle& nh, const std::string& topic, std::atomic<uint64_t>* count) {
+  return nh.subscribe<M>(topic, 1000,
+      boost::function<void(const boost::shared_ptr<M const>&)>(
+          [count](const boost::shared_ptr<M const>&) { (*count)++; }));
+}
+
+void Send(SimulatedVehicle& vehicle, int stream, const StreamProfile& profile) {
+  const ros::Publisher& publisher = vehicle.publishers[stream];
+  switch (stream) {
+    case POSE: publisher.publish(vehicle.load.CreatePose()); break;
+    case VELOCITY: publisher.publish(vehicle.load.CreateVelocity()); break;
+    case BATTERY: publisher.publish(vehicle.load.CreateBattery()); break;
+    case ERRORS: publisher.publish(vehicle.load.CreateErrors(profile.size)); break;
+    case ORDER: publisher.publish(vehicle.load.CreateOrder(profile.size)); break;
+    case ORDER_UPDATE: publisher.publish(vehicle.load.CreateOrderUpdate(profile.size)); break;
+    case INSTANT_ACTION: publisher.publish(vehicle.load.CreateInstantAction(profile.size)); break;
+  }
+}
+
+/**
+ * Updates the skipped ticks and received messages of the total counts.
+ */
+void Collect(Counts& total, const std::vector<StreamSchedule>& schedules,
+    const std::atomic<uint64_t>* received) {
+  for (int s = 0; s < STREAM_COUNT; s++) {
+    total.skipped[s] = 0;
+    for (size_t i = s; i < schedules.size(); i += STREAM_COUNT)
+      total.skipped[s] += schedules[i].GetSkipped();
+  }
+  for (int o = 0; o < OUTPUT_COUNT; o++) total.received[o] = received[o];
+}
+
+void Print(const char* title, const Counts& counts, double seconds, const StreamProfile* profiles,
+    size_t vehicles) {
+  std::printf("--- %s, %.1f s, %zu vehicles\n", title, seconds, vehicles);
+  std::printf("%-16s %10s %10s %10s\n", "stream", "target/s", "sent/s", "skipped");
+  for (int s = 0; s < STREAM_COUNT; s++) {
+    std::printf("%-16s %10.1f %10.1f %10llu\n", profiles[s].name.c_str(),
+        profiles[s].rate * vehicles, counts.sent[s] / seconds,
+        static_cast<unsigned long long>(counts.skipped[s]));
+  }
+  for (int o = 0; o < OUTPUT_COUNT; o++) {
+    std::printf("%-16s %10s %10.1f\n", (std::string("<- ") + OUTPUT_TOPICS[o]).c_str(), "",
+        counts.received[o] / seconds);
+  }
+  std::fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "load_generator");
+  ros::NodeHandle privateNh("~");
+
+  int seed, vehicleCount;
+  double duration, reportPeriod;
+  std::vector<std::string> serialNumbers;
+  privateNh.param<int>("seed", seed, 1);
+  privateNh.param<double>("duration", duration, 0.0);
+  privateNh.param<double>("report_period", reportPeriod, 5.0);
+  if (!privateNh.getParam("vehicles", serialNumbers)) {
+    privateNh.param<int>("vehicle_count", vehicleCount, 1);
+    for (int i = 1; i <= vehicleCount; i++) serialNumbers.push_back("agv_" + std::to_string(i));
+  }
+
+  StreamProfile profiles[STREAM_COUNT];
+  for (int s = 0; s < STREAM_COUNT; s++) {
+    profiles[s] = STREAMS[s].profile;
+    const std::string prefix = "streams/" + profiles[s].name + "/";
+    privateNh.param<double>(prefix + "rate", profiles[s].rate, profiles[s].rate);
+    privateNh.param<int>(prefix + "burst_size", profiles[s].burstSize, profiles[s].burstSize);
+    privateNh.param<int>(prefix + "size", profiles[s].size, profiles[s].size);
+  }
+
+  // A single vehicle talks to a connector on the global topics, several vehicles to the
+  // namespaces of a VehicleHost.
+  std::atomic<uint64_t> received[OUTPUT_COUNT]{};
+  std::vector<SimulatedVehicle> vehicles;
+  for (size_t v = 0; v < serialNumbers.size(); v++) {
+    ros::NodeHandle nh(
+        serialNumbers.size() > 1 ? VehicleHost::VehicleNamespace(serialNumbers[v]) : "");
+    vehicles.push_back({VehicleLoad(serialNumbers[v], seed + v), {}, {}});
+    SimulatedVehicle& vehicle = vehicles.back();
+    vehicle.publishers = {nh.advertise<geometry_msgs::Pose>(STREAMS[POSE].topic, 1000),
+        nh.advertise<geometry_msgs::Twist>(STREAMS[VELOCITY].topic, 1000),
+        nh.advertise<sensor_msgs::BatteryState>(STREAMS[BATTERY].topic, 1000),
+        nh.advertise<vda5050_msgs::Errors>(STREAMS[ERRORS].topic, 1000),
+        nh.advertise<vda5050_msgs::Order>(STREAMS[ORDER].topic, 1000),
+        nh.advertise<vda5050_msgs::Order>(STREAMS[ORDER_UPDATE].topic, 1000),
+        nh.advertise<vda5050_msgs::InstantAction>(STREAMS[INSTANT_ACTION].topic, 1000)};
+    vehicle.subscribers = {
+        Count<vda5050_msgs::State>(nh, OUTPUT_TOPICS[STATE], &received[STATE]),
+        Count<vda5050_msgs::Visualization>(
+            nh, OUTPUT_TOPICS[VISUALIZATION], &received[VISUALIZATION]),
+        Count<vda5050_msgs::Order>(nh, OUTPUT_TOPICS[FORWARDED_ORDER], &received[FORWARDED_ORDER]),
+        Count<vda5050_msgs::InstantAction>(
+            nh, OUTPUT_TOPICS[FORWARDED_INSTANT_ACTION], &received[FORWARDED_INSTANT_ACTION])};
+  }
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  // Leaves the connectors some time to connect before the first messages are sent. The streams
+  // of the vehicles start at seeded random offsets, so they do not all tick at once.
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  const double start = SteadySeconds();
+  std::mt19937 phases(seed);
+  std::vector<StreamSchedule> schedules;
+  using Tick = std::pair<double, size_t>;
+  std::priority_queue<Tick, std::vector<Tick>, std::greater<Tick>> ticks;
+  for (size_t v = 0; v < vehicles.size(); v++) {
+    for (int s = 0; s < STREAM_COUNT; s++) {
+      double interval = profiles[s].rate > 0.0 ? profiles[s].burstSize / profiles[s].rate : 0.0;
+      std::uniform_real_distribution<double> phase(0.0, std::min(interval, 60.0));
+      schedules.emplace_back(profiles[s], start + phase(phases));
+      ticks.push({schedules.back().GetNextTick(), schedules.size() - 1});
+    }
+  }
+
+  Counts total, reported;
+  double lastReport = start;
+  while (ros::ok() && !ticks.empty()) {
+    double now = SteadySeconds();
+    if (duration > 0.0 && now - start >= duration) break;
+
+    if (now - lastReport >= reportPeriod) {
+      Collect(total, schedules, received);
+      Counts period;
+      for (int s = 0; s < STREAM_COUNT; s++) {
+        period.sent[s] = total.sent[s] - reported.sent[s];
+        period.skipped[s] = total.skipped[s] - reported.skipped[s];
+      }
+      for (int o = 0; o < OUTPUT_COUNT; o++)
+        period.received[o] = total.received[o] - reported.received[o];
+      Print("report", period, now - lastReport, profiles, vehicles.size());
+      reported = total;
+      lastReport = now;
+    }
+
+    Tick tick = ticks.top();
+    if (tick.first > now) {
+      double wake = std::min(tick.first, lastReport + reportPeriod);
+      if (duration > 0.0) wake = std::min(wake, start + duration);
+      std::this_thread::sleep_for(std::chrono::duration<double>(wake - now));
+      continue;
+    }
+    ticks.pop();
+    StreamSchedule& schedule = schedules[tick.second];
+    int s = tick.second % STREAM_COUNT;
+    int due = schedule.Due(now);
+    for (int i = 0; i < due; i++) Send(vehicles[tick.second / STREAM_COUNT], s, profiles[s]);
+    total.sent[s] += due;
+    ticks.push({schedule.GetNextTick(), tick.second});
+  }
+
+  // Messages still on their way through the connectors are waited for.
+  double end = SteadySeconds();
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  Collect(total, schedules, received);
+  Print("total", total, end - start, profiles, vehicles.size());
+
+  uint64_t orders = total.sent[ORDER] + total.sent[ORDER_UPDATE];
+  uint64_t instantActions = total.sent[INSTANT_ACTION];
+  std::printf("dropped orders %llu of %llu, dropped instant actions %llu of %llu\n",
+      static_cast<unsigned long long>(orders - std::min(orders, total.received[FORWARDED_ORDER])),
+      static_cast<unsigned long long>(orders),
+      static_cast<unsigned long long>(
+          instantActions - std::min(instantActions, total.received[FORWARDED_INSTANT_ACTION])),
+      static_cast<unsigned long long>(instantActions));
+
+  spinner.stop();
+  return 0;
+}
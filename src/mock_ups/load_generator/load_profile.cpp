@@ -0,0 +1,192 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "load_profile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+#include "utils/utils.h"
+
+StreamSchedule::StreamSchedule(const StreamProfile& profile, double start)
+    : burstSize(std::max(profile.burstSize, 1)),
+      interval(profile.rate > 0.0 ? burstSize / profile.rate
+                                  : std::numeric_limits<double>::infinity()),
+      nextTick(profile.rate > 0.0 ? start : std::numeric_limits<double>::infinity()) {}
+
+int StreamSchedule::Due(double now) {
+  if (now < nextTick) return 0;
+
+  // Ticks that are already over when the next one is due are skipped, the current one is sent.
+  auto late = static_cast<uint64_t>(std::floor((now - nextTick) / interval));
+  skipped += late;
+  nextTick += (late + 1) * interval;
+  return burstSize;
+}
+
+VehicleLoad::VehicleLoad(const std::string& serialNumber, uint32_t seed)
+    : serialNumber(serialNumber), generator(seed) {
+  std::uniform_real_distribution<double> position(0.0, 400.0);
+  std::uniform_real_distribution<double> rotation(-M_PI, M_PI);
+  x = position(generator);
+  y = position(generator);
+  theta = rotation(generator);
+}
+
+geometry_msgs::Pose VehicleLoad::CreatePose() {
+  std::normal_distribution<double> step(0.0, 0.05);
+  x += step(generator);
+  y += step(generator);
+  theta = std::remainder(theta + step(generator), 2 * M_PI);
+
+  geometry_msgs::Pose pose;
+  pose.position.x = x;
+  pose.position.y = y;
+  pose.orientation.z = std::sin(theta / 2);
+  pose.orientation.w = std::cos(theta / 2);
+  return pose;
+}
+
+geometry_msgs::Twist VehicleLoad::CreateVelocity() {
+  std::uniform_real_distribution<double> linear(0.0, 2.5);
+  std::uniform_real_distribution<double> angular(-2.0, 2.0);
+
+  geometry_msgs::Twist twist;
+  twist.linear.x = linear(generator);
+  twist.linear.y = linear(generator);
+  twist.angular.z = angular(generator);
+  return twist;
+}
+
+sensor_msgs::BatteryState VehicleLoad::CreateBattery() {
+  std::uniform_real_distribution<double> percentage(0.0, 1.0);
+  std::uniform_real_distribution<double> voltage(30.0, 50.0);
+  std::uniform_int_distribution<int> powerSupply(0, 4);
+
+  sensor_msgs::BatteryState battery;
+  battery.percentage = percentage(generator);
+  battery.voltage = voltage(generator);
+  battery.power_supply_status = powerSupply(generator);
+  return battery;
+}
+
+vda5050_msgs::Errors VehicleLoad::CreateErrors(int count) {
+  std::uniform_int_distribution<int> level(0, 1);
+
+  vda5050_msgs::Errors errors;
+  for (int i = 0; i < count; i++) {
+    vda5050_msgs::Error error;
+    error.errorType = "loadTest" + std::to_string(i);
+    error.errorDescription = "Generated error " + CreateId();
+    error.errorLevel = level(generator) ? vda5050_msgs::Error::FATAL : vda5050_msgs::Error::WARNING;
+    errors.errors.push_back(error);
+  }
+  return errors;
+}
+
+vda5050_msgs::Order VehicleLoad::CreateOrder(int nodes) {
+  lastOrder = vda5050_msgs::Order();
+  lastOrder.headerId = ++headerId;
+  lastOrder.timestamp = connector_utils::GetISOCurrentTimestamp();
+  lastOrder.version = "2.0.0";
+  lastOrder.serialNumber = serialNumber;
+  lastOrder.orderId = serialNumber + "_order_" + std::to_string(++orderCount);
+  lastOrder.orderUpdateId = 0;
+  FillOrder(lastOrder, "node_" + CreateId(), 0, nodes);
+
+  // The connector only accepts new orders that start where the vehicle is.
+  auto& first = lastOrder.nodes.front().nodePosition;
+  first.x = x;
+  first.y = y;
+  first.theta = theta;
+  first.allowedDeviationXY = 1.0;
+  first.allowedDeviationTheta = M_PI;
+  return lastOrder;
+}
+
+vda5050_msgs::Order VehicleLoad::CreateOrderUpdate(int nodes) {
+  if (lastOrder.nodes.empty()) return CreateOrder(nodes);
+
+  auto lastBase = std::find_if(lastOrder.nodes.rbegin(), lastOrder.nodes.rend(),
+      [](const vda5050_msgs::Node& node) { return node.released; });
+  vda5050_msgs::Node first =
+      lastBase != lastOrder.nodes.rend() ? *lastBase : lastOrder.nodes.back();
+
+  lastOrder.headerId = ++headerId;
+  lastOrder.timestamp = connector_utils::GetISOCurrentTimestamp();
+  lastOrder.orderUpdateId++;
+  lastOrder.nodes.clear();
+  lastOrder.edges.clear();
+  FillOrder(lastOrder, first.nodeId, first.sequenceId, nodes);
+  lastOrder.nodes.front().nodePosition = first.nodePosition;
+  return lastOrder;
+}
+
+vda5050_msgs::InstantAction VehicleLoad::CreateInstantAction(int actions) {
+  static const std::vector<std::string> types{"startPause", "stopPause", "stateRequest",
+      "cancelOrder", "factsheetRequest"};
+  std::uniform_int_distribution<size_t> type(0, types.size() - 1);
+
+  vda5050_msgs::InstantAction instantAction;
+  instantAction.headerId = ++headerId;
+  instantAction.timestamp = connector_utils::GetISOCurrentTimestamp();
+  instantAction.version = "2.0.0";
+  instantAction.serialNumber = serialNumber;
+  for (int i = 0; i < actions; i++) {
+    vda5050_msgs::Action action;
+    action.actionId = CreateId();
+    action.actionType = types[type(generator)];
+    action.blockingType = "NONE";
+    instantAction.actions.push_back(action);
+  }
+  return instantAction;
+}
+
+std::string VehicleLoad::CreateId() {
+  // The words are drawn before the call, as the order arguments are evaluated in is unspecified.
+  std::uniform_int_distribution<uint32_t> word;
+  uint32_t words[4];
+  for (uint32_t& w : words) w = word(generator);
+  char id[37];
+  std::snprintf(id, sizeof(id), "%08x-%04x-4%03x-%04x-%04x%08x", words[0], words[1] >> 16,
+      words[1] & 0xfff, (words[2] >> 16 & 0x3fff) | 0x8000, words[2] & 0xffff, words[3]);
+  return id;
+}
+
+void VehicleLoad::FillOrder(vda5050_msgs::Order& order, const std::string& firstNodeId,
+    uint32_t firstSequenceId, int nodes) {
+  std::uniform_real_distribution<double> step(0.5, 2.0);
+  nodes = std::max(nodes, 1);
+  int released = (nodes + 1) / 2;
+
+  double nodeX = x, nodeY = y;
+  for (int i = 0; i < nodes; i++) {
+    vda5050_msgs::Node node;
+    node.nodeId = i == 0 ? firstNodeId : "node_" + CreateId();
+    node.sequenceId = firstSequenceId + 2 * i;
+    node.released = i < released;
+    node.nodePosition.x = nodeX;
+    node.nodePosition.y = nodeY;
+    node.nodePosition.allowedDeviationXY = 0.1;
+    node.nodePosition.mapId = "load_test";
+    order.nodes.push_back(node);
+    nodeX += step(generator);
+    nodeY += step(generator);
+
+    if (i == 0) continue;
+    vda5050_msgs::Edge edge;
+    edge.edgeId = "edge_" + CreateId();
+    edge.sequenceId = node.sequenceId - 1;
+    edge.released = node.released;
+    edge.startNodeId = order.nodes[i - 1].nodeId;
+    edge.endNodeId = node.nodeId;
+    order.edges.push_back(edge);
+  }
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#ifndef LOAD_PROFILE_H
+#define LOAD_PROFILE_H
+
+#include <geometry_msgs/Pose.h>
+#include <geometry_msgs/Twist.h>
+#include <sensor_msgs/BatteryState.h>
+#include <cstdint>
+#include <random>
+#include <string>
+#include "vda5050_msgs/Errors.h"
+#include "vda5050_msgs/InstantAction.h"
+#include "vda5050_msgs/Order.h"
+
+/**
+ * Load of one message stream of a vehicle.
+ */
+struct StreamProfile {
+  std::string name; /**< Name of the stream, also the name of its parameter namespace. */
+
+  double rate; /**< Average messages per second, 0 disables the stream. */
+
+  int burstSize; /**< Messages sent back to back per tick, the ticks are burstSize/rate apart. */
+
+  int size; /**< Size of each message, e.g. nodes of an order or actions of an instant action. */
+};
+
+/**
+ * Ticks of a stream. A tick that is more than one interval late is skipped and counted, so a
+ * saturated generator shows up in the report instead of silently lowering the rate.
+ */
+class StreamSchedule {
+ public:
+  /**
+   * Constructor for the schedule.
+   *
+   * @param profile  Load of the stream.
+   * @param start    Time of the first tick in seconds.
+   */
+  StreamSchedule(const StreamProfile& profile, double start);
+
+  /**
+   * Advances the schedule to the current time.
+   *
+   * @param now  Current time in seconds.
+   *
+   * @return Number of messages to send now.
+   */
+  int Due(double now);
+
+  /**
+   * Get the time of the next tick in seconds.
+   */
+  inline double GetNextTick() const { return nextTick; }
+
+  /**
+   * Get the interval between two ticks in seconds.
+   */
+  inline double GetInterval() const { return interval; }
+
+  /**
+   * Get the number of skipped ticks.
+   */
+  inline uint64_t GetSkipped() const { return skipped; }
+
+ private:
+  int burstSize; /**< Messages per tick. */
+
+  double interval; /**< Seconds between two ticks. */
+
+  double nextTick; /**< Time of the next tick in seconds. */
+
+  uint64_t skipped{0}; /**< Number of ticks skipped for being late. */
+};
+
+/**
+ * Creates the messages of one simulated vehicle. All content is drawn from a generator seeded with
+ * the given seed, so two runs with the same seed send the same messages, timestamps aside.
+ */
+class VehicleLoad {
+ public:
+  /**
+   * Constructor for the vehicle.
+   *
+   * @param serialNumber  Serial number written into the headers.
+   * @param seed          Seed of the random content.
+   */
+  VehicleLoad(const std::string& serialNumber, uint32_t seed);
+
+  /**
+   * Moves the vehicle by a random step and returns its pose.
+   */
+  geometry_msgs::Pose CreatePose();
+
+  /**
+   * Creates a random velocity.
+   */
+  geometry_msgs::Twist CreateVelocity();
+
+  /**
+   * Creates a random battery state.
+   */
+  sensor_msgs::BatteryState CreateBattery();
+
+  /**
+   * Creates a list of random errors.
+   *
+   * @param count  Number of errors.
+   */
+  vda5050_msgs::Errors CreateErrors(int count);
+
+  /**
+   * Creates a new order that starts at the current pose of the vehicle, so the connector accepts it.
+   * The first half of the nodes is released.
+   *
+   * @param nodes  Number of nodes, at least one.
+   */
+  vda5050_msgs::Order CreateOrder(int nodes);
+
+  /**
+   * Creates an update of the last order that starts at its last released node. Creates a new order
+   * if there is none yet.
+   *
+   * @param nodes  Number of nodes, at least one.
+   */
+  vda5050_msgs::Order CreateOrderUpdate(int nodes);
+
+  /**
+   * Creates an instant action with random actions.
+   *
+   * @param actions  Number of actions.
+   */
+  vda5050_msgs::InstantAction CreateInstantAction(int actions);
+
+ private:
+  std::string serialNumber; /**< Serial number written into the headers. */
+
+  std::mt19937 generator; /**< Source of all random content. */
+
+  double x, y, theta; /**< Current pose of the vehicle. */
+
+  uint32_t headerId{0}; /**< Header ID of the last order or instant action. */
+
+  uint32_t orderCount{0}; /**< Number of created orders, used for the order IDs. */
+
+  vda5050_msgs::Order lastOrder; /**< Last created order or order update. */
+
+  /**
+   * Creates a random ID in the format of a version 4 UUID.
+   */
+  std::string CreateId();
+
+  /**
+   * Fills the nodes and edges of an order, starting with the given node.
+   */
+  void FillOrder(vda5050_msgs::Order& order, const std::string& firstNodeId,
+      uint32_t firstSequenceId, int nodes);
+};
+
+#endif
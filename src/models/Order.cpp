@@ -1,9 +1,104 @@
 #include "models/Order.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/** Number of chords each knot span of a NURBS trajectory is approximated with. */
+constexpr int NURBS_SAMPLES = 16;
+
+/**
+ * Checks if a trajectory is a NURBS curve that can be evaluated.
+ */
+bool IsValidTrajectory(const vda5050_msgs::Trajectory& trajectory) {
+  const auto& knots = trajectory.knotVector;
+  size_t degree = static_cast<size_t>(trajectory.degree);
+  return degree >= 1 && trajectory.controlPoints.size() > degree &&
+         knots.size() == trajectory.controlPoints.size() + degree + 1 &&
+         std::is_sorted(knots.begin(), knots.end());
+}
+
+/**
+ * Evaluates a NURBS curve with de Boor's algorithm on homogeneous coordinates.
+ *
+ * @param trajectory  Valid trajectory.
+ * @param span        Knot span of the parameter, degree <= span < number of control points.
+ * @param u           Parameter in the knot span.
+ * @param points      Buffer for degree + 1 homogeneous points.
+ * @param x           X coordinate of the point on the curve.
+ * @param y           Y coordinate of the point on the curve.
+ */
+void EvaluateNurbs(const vda5050_msgs::Trajectory& trajectory, size_t span, double u,
+    std::vector<vda5050_msgs::ControlPoint>* points, double* x, double* y) {
+  const auto& knots = trajectory.knotVector;
+  size_t degree = static_cast<size_t>(trajectory.degree);
+  for (size_t j = 0; j <= degree; j++) {
+    const auto& point = trajectory.controlPoints[span - degree + j];
+    // Weights are optional and default to 1.
+    double weight = point.weight > 0.0 ? point.weight : 1.0;
+    (*points)[j].x = point.x * weight;
+    (*points)[j].y = point.y * weight;
+    (*points)[j].weight = weight;
+  }
+  for (size_t r = 1; r <= degree; r++) {
+    for (size_t j = degree; j >= r; j--) {
+      double begin = knots[span - degree + j];
+      double end = knots[span + 1 + j - r];
+      double alpha = end > begin ? (u - begin) / (end - begin) : 0.0;
+      auto& point = (*points)[j];
+      const auto& previous = (*points)[j - 1];
+      point.x = (1.0 - alpha) * previous.x + alpha * point.x;
+      point.y = (1.0 - alpha) * previous.y + alpha * point.y;
+      point.weight = (1.0 - alpha) * previous.weight + alpha * point.weight;
+    }
+  }
+  *x = (*points)[degree].x / (*points)[degree].weight;
+  *y = (*points)[degree].y / (*points)[degree].weight;
+}
+
+/**
+ * Approximates the length of a NURBS curve by chords.
+ */
+double NurbsLength(const vda5050_msgs::Trajectory& trajectory) {
+  const auto& knots = trajectory.knotVector;
+  size_t degree = static_cast<size_t>(trajectory.degree);
+  std::vector<vda5050_msgs::ControlPoint> points(degree + 1);
+  double length = 0.0;
+  double lastX = 0.0, lastY = 0.0;
+  bool first = true;
+  for (size_t span = degree; span < trajectory.controlPoints.size(); span++) {
+    if (knots[span + 1] <= knots[span]) continue;
+    for (int sample = first ? 0 : 1; sample <= NURBS_SAMPLES; sample++) {
+      double u = knots[span] + (knots[span + 1] - knots[span]) * sample / NURBS_SAMPLES;
+      double x, y;
+      EvaluateNurbs(trajectory, span, u, &points, &x, &y);
+      if (!first) length += std::hypot(x - lastX, y - lastY);
+      lastX = x;
+      lastY = y;
+      first = false;
+    }
+  }
+  return length;
+}
+
+/**
+ * Get the length of an edge from its trajectory, its length field or the positions of its nodes.
+ */
+double EdgeLength(const vda5050_msgs::Edge& edge, const vda5050_msgs::Node& start,
+    const vda5050_msgs::Node& end) {
+  if (IsValidTrajectory(edge.trajectory)) return NurbsLength(edge.trajectory);
+  if (edge.length > 0.0) return edge.length;
+  return std::hypot(end.nodePosition.x - start.nodePosition.x,
+      end.nodePosition.y - start.nodePosition.y);
+}
+
+}  // namespace
 
 Order::Order() { this->order = vda5050_msgs::Order(); }
 Order::Order(const vda5050_msgs::Order::ConstPtr& order) { this->order = *order; }
 
-void Order::Validate() {
+void Order::Validate() const {
   // TODO: Add validation based on AGV's capabilities (e.g. track planning etc.). Using FactSheet
   // messages
 
@@ -48,6 +143,8 @@ void Order::AcceptNewOrder(const Order& new_order) {
   order.nodes = new_order.GetNodes();
   order.edges = new_order.GetEdges();
   order.zoneSetId = new_order.GetZoneSetId();
+
+  ComputeGeometry(0);
 }
 
 void Order::UpdateOrder(const Order& order_update) {
@@ -64,8 +161,41 @@ void Order::UpdateOrder(const Order& order_update) {
   updated_nodes.erase(updated_nodes.begin());
 
   // Append new nodes and edges to the order.
-  for (auto const& newNode : order_update.GetNodes()) order.nodes.push_back(newNode);
+  size_t first_new_edge = order.edges.size();
+  for (auto const& newNode : updated_nodes) order.nodes.push_back(newNode);
   for (auto const& newEdge : order_update.GetEdges()) order.edges.push_back(newEdge);
 
   order.orderUpdateId = order_update.GetOrderUpdateId();
+
+  // The geometry of the base is kept, only the appended edges are computed.
+  ComputeGeometry(first_new_edge);
+}
+
+boost::optional<size_t> Order::GetNodeIndex(uint32_t sequence_id) const {
+  // Validated orders alternate nodes and edges with consecutive sequence ids.
+  if (order.nodes.empty() || sequence_id < order.nodes.front().sequenceId) return boost::none;
+  size_t index = (sequence_id - order.nodes.front().sequenceId) / 2;
+  if (index >= order.nodes.size() || order.nodes[index].sequenceId != sequence_id)
+    return boost::none;
+  return index;
+}
+
+void Order::ComputeGeometry(size_t first_edge) {
+  // Edges without both nodes, e.g. of an order that is not valid, are left out.
+  size_t edges = order.nodes.empty() ? 0 : std::min(order.edges.size(), order.nodes.size() - 1);
+  first_edge = std::min(first_edge, std::min(edgeLengths.size(), edges));
+
+  edgeLengths.resize(first_edge);
+  nodeDistances.resize(order.nodes.empty() ? 0 : first_edge + 1, 0.0);
+  nodeEtas.resize(nodeDistances.size(), 0.0);
+
+  for (size_t i = first_edge; i < edges; i++) {
+    const auto& edge = order.edges[i];
+    double length = EdgeLength(edge, order.nodes[i], order.nodes[i + 1]);
+    double speed = edge.maxSpeed > 0.0 ? std::min(edge.maxSpeed, maxSpeed) : maxSpeed;
+    edgeLengths.push_back(length);
+    nodeDistances.push_back(nodeDistances.back() + length);
+    nodeEtas.push_back(nodeEtas.back() +
+                       (speed > 0.0 ? length / speed : std::numeric_limits<double>::infinity()));
+  }
 }
\ No newline at end of file
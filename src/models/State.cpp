@@ -1,4 +1,5 @@
 #include "models/State.h"
+#include <cmath>
 
 State::State() {
   this->state = vda5050_msgs::State();
@@ -36,7 +37,40 @@ vda5050_msgs::ActionState State::ActionToActionState(const vda5050_msgs::Action&
   return as;
 }
 
+void State::ComposeOrderState() {
+  if (!orderState) return;
+
+  state.nodeStates = orderState->nodeStates;
+  state.edgeStates = orderState->edgeStates;
+  state.actionStates = orderState->actionStates;
+  orderState.reset();
+}
+
+const vda5050_msgs::State& State::GetState() {
+  ComposeOrderState();
+
+  if (loads) {
+    state.loads = loads->loads;
+    loads.reset();
+  }
+  if (information) {
+    state.information = information->information;
+    information.reset();
+  }
+  if (interactionZones) {
+    state.interactionZones = interactionZones->interactionZones;
+    for (auto& zone : state.interactionZones) {
+      if (zone.zoneStatus != 0) zone.zoneStatus = 1;
+    }
+    interactionZones.reset();
+  }
+
+  return state;
+}
+
 bool State::HasActiveOrder(const Order& current_order) {
+  ComposeOrderState();
+
   // Check if there are any base nodes in the order.
 
   auto base_nodes = std::count_if(state.nodeStates.begin(), state.nodeStates.end(),
@@ -81,6 +115,20 @@ void State::ClearErrorWithType(const std::string& error_type) {
   if (it != state.errors.end()) state.errors.erase(it);
 }
 
+void State::UpdateActionStates(const std::vector<vda5050_msgs::ActionState>& action_states) {
+  ComposeOrderState();
+
+  for (const auto& action_state : action_states) {
+    auto it = find_if(state.actionStates.begin(), state.actionStates.end(),
+        [&](const vda5050_msgs::ActionState& as) { return as.actionId == action_state.actionId; });
+
+    if (it != state.actionStates.end())
+      *it = action_state;
+    else
+      state.actionStates.push_back(action_state);
+  }
+}
+
 vda5050_msgs::Visualization State::CreateVisualizationMsg() {
   vda5050_msgs::Visualization vis;
 
@@ -93,7 +141,26 @@ vda5050_msgs::Visualization State::CreateVisualizationMsg() {
   return vis;
 }
 
+vda5050_msgs::State State::CreateTrimmedStateMsg() {
+  vda5050_msgs::State trimmed = GetState();
+
+  for (auto& ns : trimmed.nodeStates) ns.nodeDescription.clear();
+  for (auto& es : trimmed.edgeStates) {
+    es.edgeDescription.clear();
+    es.trajectory = vda5050_msgs::Trajectory();
+  }
+  for (auto& as : trimmed.actionStates) {
+    as.actionDescription.clear();
+    as.resultDescription.clear();
+  }
+  trimmed.information.clear();
+
+  return trimmed;
+}
+
 boost::optional<vda5050_msgs::NodeState> State::GetLastNodeInBase() {
+  ComposeOrderState();
+
   // find last element which is released to find end of base.
   auto it = find_if(state.nodeStates.rbegin(), state.nodeStates.rend(),
       [](const vda5050_msgs::NodeState& ns) { return ns.released; });
@@ -105,8 +172,8 @@ boost::optional<vda5050_msgs::NodeState> State::GetLastNodeInBase() {
 }
 
 bool State::InDeviationRange(vda5050_msgs::Node node) {
-  auto vehicle_to_node_dist = sqrt(pow(state.agvPosition.x - node.nodePosition.x, 2) +
-                                   pow(state.agvPosition.y - node.nodePosition.y, 2));
+  auto vehicle_to_node_dist = std::hypot(state.agvPosition.x - node.nodePosition.x,
+      state.agvPosition.y - node.nodePosition.y);
 
   return (vehicle_to_node_dist <= node.nodePosition.allowedDeviationXY) &&
          (abs(state.agvPosition.theta - node.nodePosition.theta) <=
@@ -114,6 +181,9 @@ bool State::InDeviationRange(vda5050_msgs::Node node) {
 }
 
 void State::AcceptNewOrder(const Order& new_order) {
+  // The node, edge and action states of the new order replace the ones of a kept order state.
+  orderState.reset();
+
   state.orderId = new_order.GetOrderId();
   state.orderUpdateId = new_order.GetOrderUpdateId();
 
@@ -141,6 +211,8 @@ void State::AcceptNewOrder(const Order& new_order) {
 }
 
 void State::ValidateUpdateBase(const Order& order_update) {
+  ComposeOrderState();
+
   // Check if the first node of the update matches the last release base node.
 
   auto last_base_node = find_if(state.nodeStates.rbegin(), state.nodeStates.rend(),
@@ -172,6 +244,8 @@ void State::ValidateUpdateBase(const Order& order_update) {
 }
 
 void State::UpdateOrder(const Order& current_order, const Order& order_update) {
+  ComposeOrderState();
+
   // Clear horizon.
   state.edgeStates.erase(remove_if(state.edgeStates.begin(), state.edgeStates.end(),
       [](vda5050_msgs::EdgeState es) { return !es.released; }));
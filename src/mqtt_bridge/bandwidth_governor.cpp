@@ -0,0 +1,79 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "mqtt_bridge/bandwidth_governor.h"
+#include <algorithm>
+
+namespace mqtt_bridge {
+
+BandwidthGovernor::BandwidthGovernor(const GovernorOptions& options) : options(options) {
+  this->options.smoothing = std::min(std::max(options.smoothing, 0.01), 1.0);
+  this->options.maxLevel = std::max(options.maxLevel, 0);
+}
+
+bool BandwidthGovernor::Update(double now, const std::vector<OutboundStats>& stats) {
+  // Topics added since the last sample are measured from the next one.
+  for (size_t i = sentBytes.size(); i < stats.size(); i++) {
+    sentBytes.push_back(stats[i].sentBytes);
+    rates.push_back({stats[i].topic, 0.0});
+  }
+
+  if (!sampled) {
+    sampled = true;
+    lastSample = now;
+    lastChange = now;
+    return false;
+  }
+  double elapsed = now - lastSample;
+  if (elapsed <= 0.0) return false;
+
+  for (size_t i = 0; i < stats.size(); i++) {
+    double rate = (stats[i].sentBytes - sentBytes[i]) / elapsed;
+    rates[i].bytesPerSecond += options.smoothing * (rate - rates[i].bytesPerSecond);
+    sentBytes[i] = stats[i].sentBytes;
+  }
+  lastSample = now;
+  return Govern(now);
+}
+
+double BandwidthGovernor::GetRate() const {
+  double rate = 0.0;
+  for (const TopicRate& topicRate : rates) rate += topicRate.bytesPerSecond;
+  return rate;
+}
+
+bool BandwidthGovernor::Govern(double now) {
+  if (options.budget <= 0.0) return false;
+
+  double rate = GetRate();
+  if (rate > options.budget) {
+    lowSince = -1.0;
+    if (level >= options.maxLevel || now - lastChange < options.raiseDelay) return false;
+    level++;
+    raises++;
+    lastChange = now;
+    return true;
+  }
+
+  if (rate >= options.recoverFraction * options.budget || level == 0) {
+    lowSince = -1.0;
+    return false;
+  }
+  if (lowSince < 0.0) lowSince = now;
+  if (now - lowSince < options.recoverDelay) return false;
+
+  // Each lower level has to prove itself for another recover delay.
+  level--;
+  recoveries++;
+  lastChange = now;
+  lowSince = now;
+  return true;
+}
+
+}  // namespace mqtt_bridge
@@ -0,0 +1,245 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "mqtt_bridge/cbor_transcoder.h"
+#include "mqtt_bridge/cbor_writer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace mqtt_bridge {
+
+namespace {
+
+enum MajorType {
+  UNSIGNED_INT = 0,
+  NEGATIVE_INT = 1,
+  BYTE_STRING = 2,
+  TEXT_STRING = 3,
+  ARRAY = 4,
+  MAP = 5,
+  TAG = 6,
+  SIMPLE = 7
+};
+
+constexpr int INDEFINITE = 31;
+
+double HalfToDouble(uint16_t half) {
+  int exponent = (half >> 10) & 0x1f;
+  int mantissa = half & 0x3ff;
+  double value;
+  if (exponent == 0)
+    value = std::ldexp(mantissa, -24);
+  else if (exponent != 31)
+    value = std::ldexp(mantissa + 1024, exponent - 25);
+  else
+    value = mantissa == 0 ? std::numeric_limits<double>::infinity()
+                          : std::numeric_limits<double>::quiet_NaN();
+  return half & 0x8000 ? -value : value;
+}
+
+}  // namespace
+
+CborTranscoder::CborTranscoder(const DecodeLimits& limits) : limits(limits) {}
+
+void CborTranscoder::ToJson(const std::string& cbor, JsonWriter& json) {
+  begin = reinterpret_cast<const unsigned char*>(cbor.data());
+  pos = begin;
+  end = begin + cbor.size();
+  frames.clear();
+
+  if (cbor.size() > limits.maxPayloadSize)
+    Fail(DecodeError::PAYLOAD_TOO_LARGE, "Payload of " + std::to_string(cbor.size()) +
+                                             " bytes exceeds " +
+                                             std::to_string(limits.maxPayloadSize) + " bytes");
+  Item(json);
+  if (pos != end) Fail(DecodeError::SYNTAX, "Unexpected bytes after the data item");
+}
+
+void CborTranscoder::Item(JsonWriter& json) {
+  // Tags only give a meaning to the following item, its value is converted as is.
+  int major, info;
+  uint64_t argument;
+  do {
+    argument = Head(&major, &info);
+  } while (major == TAG);
+
+  switch (major) {
+    case UNSIGNED_INT:
+      json.Uint(argument);
+      break;
+    case NEGATIVE_INT:
+      if (argument > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+        Fail(DecodeError::NUMBER_OUT_OF_RANGE, "Negative integer does not fit into 64 bit");
+      json.Int(-1 - static_cast<int64_t>(argument));
+      break;
+    case BYTE_STRING:
+      Fail(DecodeError::UNEXPECTED_TYPE, "Byte strings have no JSON representation");
+    case TEXT_STRING:
+      Text(argument, info == INDEFINITE);
+      json.String(text);
+      break;
+    case ARRAY: {
+      bool indefinite = info == INDEFINITE;
+      if (!indefinite && argument > limits.maxArraySize)
+        Fail(DecodeError::ARRAY_TOO_LARGE,
+            "Array has more than " + std::to_string(limits.maxArraySize) + " elements");
+      Push(true);
+      json.BeginArray(indefinite ? 0 : argument);
+      while (indefinite ? !Break() : frames.back().index < argument) {
+        if (++frames.back().index > limits.maxArraySize)
+          Fail(DecodeError::ARRAY_TOO_LARGE,
+              "Array has more than " + std::to_string(limits.maxArraySize) + " elements");
+        Item(json);
+      }
+      json.EndArray();
+      frames.pop_back();
+      break;
+    }
+    case MAP: {
+      bool indefinite = info == INDEFINITE;
+      Push(false);
+      json.BeginObject();
+      for (uint64_t i = 0; indefinite ? !Break() : i < argument; i++) {
+        KeyText();
+        frames.back().key = text;
+        json.DynamicKey(text);
+        Item(json);
+      }
+      json.EndObject();
+      frames.pop_back();
+      break;
+    }
+    default:
+      switch (info) {
+        case 20:
+          json.Bool(false);
+          break;
+        case 21:
+          json.Bool(true);
+          break;
+        case 22:
+        case 23:
+          json.Null();
+          break;
+        case 25:
+          json.Double(HalfToDouble(static_cast<uint16_t>(argument)));
+          break;
+        case 26: {
+          uint32_t bits = static_cast<uint32_t>(argument);
+          float value;
+          std::memcpy(&value, &bits, sizeof(value));
+          json.Double(value);
+          break;
+        }
+        case 27: {
+          double value;
+          std::memcpy(&value, &argument, sizeof(value));
+          json.Double(value);
+          break;
+        }
+        case INDEFINITE:
+          Fail(DecodeError::SYNTAX, "Unexpected break");
+        default:
+          Fail(DecodeError::UNEXPECTED_TYPE, "Simple value has no JSON representation");
+      }
+  }
+}
+
+uint64_t CborTranscoder::Head(int* major, int* info) {
+  if (pos == end) Fail(DecodeError::SYNTAX, "Unexpected end of the payload");
+  *major = *pos >> 5;
+  *info = *pos & 0x1f;
+  pos++;
+
+  if (*info < 24) return *info;
+  if (*info <= 27) return BigEndian(1 << (*info - 24));
+  bool mayBeIndefinite = *major == BYTE_STRING || *major == TEXT_STRING || *major == ARRAY ||
+                         *major == MAP || *major == SIMPLE;
+  if (*info != INDEFINITE || !mayBeIndefinite)
+    Fail(DecodeError::SYNTAX, "Invalid additional information " + std::to_string(*info));
+  return 0;
+}
+
+void CborTranscoder::Text(uint64_t length, bool indefinite) {
+  text.clear();
+  while (true) {
+    if (indefinite) {
+      if (Break()) return;
+      int major, info;
+      length = Head(&major, &info);
+      if (major != TEXT_STRING || info == INDEFINITE)
+        Fail(DecodeError::SYNTAX, "Chunks of a text string have to be definite text strings");
+    }
+
+    if (length > limits.maxStringLength - std::min<size_t>(text.size(), limits.maxStringLength))
+      Fail(DecodeError::STRING_TOO_LONG,
+          "String is longer than " + std::to_string(limits.maxStringLength) + " bytes");
+    if (length > static_cast<uint64_t>(end - pos))
+      Fail(DecodeError::SYNTAX, "Unexpected end of the payload");
+    text.append(reinterpret_cast<const char*>(pos), length);
+    pos += length;
+
+    if (!indefinite) return;
+  }
+}
+
+void CborTranscoder::KeyText() {
+  int major, info;
+  uint64_t argument = Head(&major, &info);
+  if (major == TEXT_STRING) {
+    Text(argument, info == INDEFINITE);
+    return;
+  }
+
+  const char* key = major == UNSIGNED_INT ? PackedKey(argument) : nullptr;
+  if (!key)
+    Fail(DecodeError::UNEXPECTED_TYPE, "Map keys have to be text strings or packed keys");
+  text.assign(key);
+}
+
+bool CborTranscoder::Break() {
+  if (pos == end || *pos != 0xff) return false;
+  pos++;
+  return true;
+}
+
+uint64_t CborTranscoder::BigEndian(int bytes) {
+  if (end - pos < bytes) Fail(DecodeError::SYNTAX, "Unexpected end of the payload");
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++) value = (value << 8) | *pos++;
+  return value;
+}
+
+void CborTranscoder::Push(bool array) {
+  if (frames.size() == limits.maxDepth)
+    Fail(DecodeError::TOO_DEEP,
+        "Value is nested deeper than " + std::to_string(limits.maxDepth) + " levels");
+  frames.push_back({array, 0, std::string()});
+}
+
+std::string CborTranscoder::Path() const {
+  std::string path;
+  for (const Frame& frame : frames) {
+    if (frame.array) {
+      if (frame.index > 0) path += "[" + std::to_string(frame.index - 1) + "]";
+    } else if (!frame.key.empty()) {
+      if (!path.empty()) path += '.';
+      path += frame.key;
+    }
+  }
+  return path;
+}
+
+void CborTranscoder::Fail(DecodeError::Code code, const std::string& reason) const {
+  throw DecodeError(code, pos - begin, Path(), reason);
+}
+
+}  // namespace mqtt_bridge
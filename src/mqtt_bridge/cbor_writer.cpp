@@ -0,0 +1,179 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "mqtt_bridge/cbor_writer.h"
+#include <cmath>
+#include <cstring>
+
+namespace mqtt_bridge {
+
+namespace {
+
+constexpr uint8_t NEGATIVE_INT = 1;
+constexpr uint8_t ARRAY = 4;
+
+constexpr char MAP_INDEFINITE = '\xbf';
+constexpr char BREAK = '\xff';
+constexpr char SIMPLE_FALSE = '\xf4';
+constexpr char SIMPLE_TRUE = '\xf5';
+constexpr char SIMPLE_NULL = '\xf6';
+constexpr char FLOAT32 = '\xfa';
+constexpr char FLOAT64 = '\xfb';
+
+// The keys of nodeStates, edgeStates and actionStates come first, so they get one byte indexes.
+const char* const PACKED_KEYS[] = {
+    "nodeId", "sequenceId", "released", "nodePosition", "x", "y", "theta", "mapId",
+    "nodeDescription", "edgeId", "edgeDescription", "trajectory", "degree", "knotVector",
+    "controlPoints", "weight", "actionId", "actionType", "actionDescription", "actionStatus",
+    "resultDescription", "allowedDeviationXY", "allowedDeviationTheta", "mapDescription", "key",
+    "value", "blockingType", "actionParameters", "actions", "startNodeId", "endNodeId", "maxSpeed",
+    "maxHeight", "minHeight", "orientation", "orientationType", "direction", "rotationAllowed",
+    "maxRotationSpeed", "length", "positionInitialized", "localizationScore", "deviationRange",
+    "vx", "vy", "omega", "z", "width", "height", "loadId", "loadType", "loadPosition",
+    "boundingBoxReference", "loadDimensions", "batteryCharge", "batteryVoltage", "batteryHealth",
+    "charging", "reach", "referenceKey", "referenceValue", "errorType", "errorReferences",
+    "errorDescription", "errorLevel", "infoType", "infoReferences", "infoDescription", "infoLevel",
+    "eStop", "fieldViolation", "zoneId", "zoneStatus", "headerId", "timestamp", "version",
+    "manufacturer", "serialNumber", "orderId", "orderUpdateId", "zoneSetId", "lastNodeId",
+    "lastNodeSequenceId", "driving", "paused", "newBaseRequest", "distanceSinceLastNode",
+    "operatingMode", "nodeStates", "edgeStates", "agvPosition", "velocity", "loads", "actionStates",
+    "batteryState", "errors", "information", "safetyState", "interactionZones", "connectionState",
+    "nodes", "edges",
+};
+
+constexpr size_t PACKED_KEY_COUNT = sizeof(PACKED_KEYS) / sizeof(PACKED_KEYS[0]);
+
+/**
+ * Open addressing hash table from the packed keys to their indexes.
+ */
+class PackedKeyTable {
+ public:
+  PackedKeyTable() {
+    for (int& slot : slots) slot = -1;
+    for (size_t i = 0; i < PACKED_KEY_COUNT; i++) {
+      size_t slot = Hash(PACKED_KEYS[i], std::strlen(PACKED_KEYS[i]));
+      while (slots[slot] >= 0) slot = (slot + 1) % SLOTS;
+      slots[slot] = static_cast<int>(i);
+    }
+  }
+
+  int Find(const char* key, size_t size) const {
+    for (size_t slot = Hash(key, size); slots[slot] >= 0; slot = (slot + 1) % SLOTS) {
+      const char* candidate = PACKED_KEYS[slots[slot]];
+      if (std::strncmp(candidate, key, size) == 0 && candidate[size] == 0) return slots[slot];
+    }
+    return -1;
+  }
+
+ private:
+  static constexpr size_t SLOTS = 512; /**< Number of slots, a power of two. */
+
+  int slots[SLOTS]; /**< Index of the key in each slot, -1 for empty slots. */
+
+  static size_t Hash(const char* key, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+      hash ^= static_cast<unsigned char>(key[i]);
+      hash *= 16777619u;
+    }
+    return hash % SLOTS;
+  }
+};
+
+constexpr size_t PackedKeyTable::SLOTS;
+
+}  // namespace
+
+constexpr uint8_t CborWriter::UNSIGNED_INT;
+constexpr uint8_t CborWriter::TEXT_STRING;
+
+int PackedKeyIndex(const char* key, size_t size) {
+  static const PackedKeyTable table;
+  return table.Find(key, size);
+}
+
+const char* PackedKey(uint64_t index) {
+  return index < PACKED_KEY_COUNT ? PACKED_KEYS[index] : nullptr;
+}
+
+void CborWriter::Clear() { buffer.clear(); }
+
+void CborWriter::BeginObject() { buffer += MAP_INDEFINITE; }
+
+void CborWriter::EndObject() { buffer += BREAK; }
+
+void CborWriter::BeginArray(size_t size) { AppendHead(ARRAY, size); }
+
+void CborWriter::String(const std::string& value) {
+  AppendHead(TEXT_STRING, value.size());
+  buffer += value;
+}
+
+void CborWriter::Double(double value) {
+  // Integral values, e.g. IDs, counters and most control point weights, are written as integers,
+  // just like the JSON writer does.
+  if (std::fabs(value) < 1e15 && value == std::trunc(value)) {
+    Int(static_cast<int64_t>(value));
+    return;
+  }
+
+  // Positions with few binary decimals, e.g. 12.125, fit into single precision.
+  float single = static_cast<float>(value);
+  if (static_cast<double>(single) == value || std::isnan(value)) {
+    uint32_t bits;
+    std::memcpy(&bits, &single, sizeof(bits));
+    buffer += FLOAT32;
+    AppendBigEndian(bits, 4);
+    return;
+  }
+
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  buffer += FLOAT64;
+  AppendBigEndian(bits, 8);
+}
+
+void CborWriter::Int(int64_t value) {
+  if (value < 0)
+    AppendHead(NEGATIVE_INT, static_cast<uint64_t>(-(value + 1)));
+  else
+    AppendHead(UNSIGNED_INT, static_cast<uint64_t>(value));
+}
+
+void CborWriter::Uint(uint64_t value) { AppendHead(UNSIGNED_INT, value); }
+
+void CborWriter::Bool(bool value) { buffer += value ? SIMPLE_TRUE : SIMPLE_FALSE; }
+
+void CborWriter::Null() { buffer += SIMPLE_NULL; }
+
+void CborWriter::AppendHead(uint8_t major, uint64_t value) {
+  char initial = static_cast<char>(major << 5);
+  if (value < 24) {
+    buffer += static_cast<char>(initial | value);
+  } else if (value <= 0xff) {
+    buffer += static_cast<char>(initial | 24);
+    AppendBigEndian(value, 1);
+  } else if (value <= 0xffff) {
+    buffer += static_cast<char>(initial | 25);
+    AppendBigEndian(value, 2);
+  } else if (value <= 0xffffffff) {
+    buffer += static_cast<char>(initial | 26);
+    AppendBigEndian(value, 4);
+  } else {
+    buffer += static_cast<char>(initial | 27);
+    AppendBigEndian(value, 8);
+  }
+}
+
+void CborWriter::AppendBigEndian(uint64_t value, int bytes) {
+  for (int shift = 8 * (bytes - 1); shift >= 0; shift -= 8)
+    buffer += static_cast<char>((value >> shift) & 0xff);
+}
+
+}  // namespace mqtt_bridge
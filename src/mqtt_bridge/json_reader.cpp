@@ -0,0 +1,404 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "mqtt_bridge/json_reader.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace mqtt_bridge {
+
+namespace {
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+void AppendUtf8(uint32_t codePoint, std::string* value) {
+  if (codePoint < 0x80) {
+    *value += static_cast<char>(codePoint);
+  } else if (codePoint < 0x800) {
+    *value += static_cast<char>(0xc0 | (codePoint >> 6));
+    *value += static_cast<char>(0x80 | (codePoint & 0x3f));
+  } else if (codePoint < 0x10000) {
+    *value += static_cast<char>(0xe0 | (codePoint >> 12));
+    *value += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+    *value += static_cast<char>(0x80 | (codePoint & 0x3f));
+  } else {
+    *value += static_cast<char>(0xf0 | (codePoint >> 18));
+    *value += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+    *value += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+    *value += static_cast<char>(0x80 | (codePoint & 0x3f));
+  }
+}
+
+}  // namespace
+
+DecodeError::DecodeError(
+    Code code, size_t offset, const std::string& path, const std::string& reason)
+    : std::invalid_argument(reason + (path.empty() ? "" : " at " + path) + " (offset " +
+                            std::to_string(offset) + ")"),
+      errorCode(code),
+      errorOffset(offset),
+      errorPath(path) {}
+
+JsonReader::JsonReader(const DecodeLimits& limits) : limits(limits) {
+  frames.reserve(limits.maxDepth);
+}
+
+void JsonReader::Reset(const std::string& payload) {
+  begin = payload.data();
+  pos = begin;
+  end = begin + payload.size();
+  frames.clear();
+  if (payload.size() > limits.maxPayloadSize)
+    Fail(DecodeError::PAYLOAD_TOO_LARGE, "Payload of " + std::to_string(payload.size()) +
+                                             " bytes exceeds " +
+                                             std::to_string(limits.maxPayloadSize) + " bytes");
+}
+
+void JsonReader::Finish() {
+  if (Peek() != 0) Fail(DecodeError::SYNTAX, "Unexpected characters after the value");
+}
+
+void JsonReader::BeginObject() {
+  Expect('{', "an object");
+  Push(false);
+}
+
+bool JsonReader::NextMember(Key& key) {
+  Frame& frame = frames.back();
+  char c = Peek();
+  if (c == '}') {
+    pos++;
+    frames.pop_back();
+    return false;
+  }
+  if (!frame.first) {
+    Expect(',', "',' or '}'");
+    c = Peek();
+  }
+  frame.first = false;
+  if (c != '"') Fail(DecodeError::SYNTAX, "Expected a key");
+  pos++;
+
+  const char* keyBegin = pos;
+  keyBuffer.clear();
+  bool escaped = ScanString(&keyBuffer);
+  frame.key = keyBegin;
+  frame.keySize = pos - 1 - keyBegin;
+  if (escaped) {
+    key.data = keyBuffer.data();
+    key.size = keyBuffer.size();
+  } else {
+    key.data = frame.key;
+    key.size = frame.keySize;
+  }
+
+  Expect(':', "':'");
+  return true;
+}
+
+void JsonReader::BeginArray() {
+  Expect('[', "an array");
+  Push(true);
+}
+
+bool JsonReader::NextElement() {
+  Frame& frame = frames.back();
+  if (Peek() == ']') {
+    pos++;
+    frames.pop_back();
+    return false;
+  }
+  if (!frame.first) Expect(',', "',' or ']'");
+  frame.first = false;
+  if (frame.index == limits.maxArraySize)
+    Fail(DecodeError::ARRAY_TOO_LARGE,
+        "Array has more than " + std::to_string(limits.maxArraySize) + " elements");
+  frame.index++;
+  return true;
+}
+
+bool JsonReader::ReadNull() {
+  if (Peek() != 'n') return false;
+  ExpectLiteral("null", 4);
+  return true;
+}
+
+void JsonReader::ReadString(std::string& value) {
+  Expect('"', "a string");
+  value.clear();
+  ScanString(&value);
+}
+
+double JsonReader::ReadDouble() {
+  if (Peek() != '-' && !IsDigit(Peek())) Fail(DecodeError::UNEXPECTED_TYPE, "Expected a number");
+
+  bool integral;
+  const char* number = ScanNumber(&integral);
+  // strtod needs a terminated string, the payload is not necessarily terminated behind the number.
+  char digits[64];
+  size_t length = pos - number;
+  if (length >= sizeof(digits)) Fail(DecodeError::NUMBER_OUT_OF_RANGE, "Number is too long");
+  std::memcpy(digits, number, length);
+  digits[length] = 0;
+
+  double value = std::strtod(digits, nullptr);
+  if (std::isinf(value)) Fail(DecodeError::NUMBER_OUT_OF_RANGE, "Number is out of range");
+  return value;
+}
+
+int64_t JsonReader::ReadInt(int64_t min, int64_t max) {
+  if (Peek() != '-' && !IsDigit(Peek())) Fail(DecodeError::UNEXPECTED_TYPE, "Expected an integer");
+
+  const char* start = pos;
+  bool integral;
+  const char* number = ScanNumber(&integral);
+  if (!integral) {
+    // Some serializers write integers as floats, e.g. 3.0.
+    pos = start;
+    double value = ReadDouble();
+    if (value != std::trunc(value)) Fail(DecodeError::UNEXPECTED_TYPE, "Expected an integer");
+    if (value < static_cast<double>(min) || value > static_cast<double>(max))
+      Fail(DecodeError::NUMBER_OUT_OF_RANGE, "Integer is out of range");
+    return static_cast<int64_t>(value);
+  }
+
+  bool negative = *number == '-';
+  uint64_t magnitude = 0;
+  for (const char* c = number + (negative ? 1 : 0); c != pos; c++) {
+    uint64_t digit = *c - '0';
+    if (magnitude > (UINT64_MAX - digit) / 10)
+      Fail(DecodeError::NUMBER_OUT_OF_RANGE, "Integer is out of range");
+    magnitude = magnitude * 10 + digit;
+  }
+  if (negative ? magnitude > 0 - static_cast<uint64_t>(min)
+               : max < 0 || magnitude > static_cast<uint64_t>(max))
+    Fail(DecodeError::NUMBER_OUT_OF_RANGE, "Integer is out of range");
+  return negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+}
+
+bool JsonReader::ReadBool() {
+  switch (Peek()) {
+    case 't':
+      ExpectLiteral("true", 4);
+      return true;
+    case 'f':
+      ExpectLiteral("false", 5);
+      return false;
+    case '0':
+    case '1':
+      return ReadInt(0, 1) != 0;
+    default:
+      Fail(DecodeError::UNEXPECTED_TYPE, "Expected a boolean");
+  }
+}
+
+void JsonReader::ReadRaw(std::string& text) {
+  Peek();
+  const char* start = pos;
+  Skip();
+  text.assign(start, pos - start);
+}
+
+void JsonReader::Skip() {
+  Key key;
+  bool integral;
+  switch (Peek()) {
+    case '{':
+      BeginObject();
+      while (NextMember(key)) Skip();
+      break;
+    case '[':
+      BeginArray();
+      while (NextElement()) Skip();
+      break;
+    case '"':
+      pos++;
+      ScanString(nullptr);
+      break;
+    case 't':
+      ExpectLiteral("true", 4);
+      break;
+    case 'f':
+      ExpectLiteral("false", 5);
+      break;
+    case 'n':
+      ExpectLiteral("null", 4);
+      break;
+    default:
+      if (Peek() != '-' && !IsDigit(Peek())) Fail(DecodeError::SYNTAX, "Expected a value");
+      ScanNumber(&integral);
+  }
+}
+
+bool JsonReader::PeekString() { return Peek() == '"'; }
+
+bool JsonReader::PeekBool() { return Peek() == 't' || Peek() == 'f'; }
+
+void JsonReader::Fail(DecodeError::Code code, const std::string& reason) const {
+  throw DecodeError(code, pos - begin, Path(), reason);
+}
+
+char JsonReader::Peek() {
+  while (pos != end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) pos++;
+  return pos == end ? 0 : *pos;
+}
+
+void JsonReader::Expect(char c, const char* what) {
+  if (Peek() != c)
+    Fail(pos == end || c == ',' || c == ':' ? DecodeError::SYNTAX : DecodeError::UNEXPECTED_TYPE,
+        std::string("Expected ") + what);
+  pos++;
+}
+
+void JsonReader::ExpectLiteral(const char* literal, size_t size) {
+  if (static_cast<size_t>(end - pos) < size || std::memcmp(pos, literal, size) != 0)
+    Fail(DecodeError::SYNTAX, std::string("Expected ") + literal);
+  pos += size;
+}
+
+void JsonReader::Push(bool array) {
+  if (frames.size() == limits.maxDepth)
+    Fail(DecodeError::TOO_DEEP,
+        "Value is nested deeper than " + std::to_string(limits.maxDepth) + " levels");
+  frames.push_back({array, true, 0, nullptr, 0});
+}
+
+bool JsonReader::ScanString(std::string* value) {
+  const char* start = pos;
+  bool escaped = false;
+  // Characters without escape sequences are copied in chunks.
+  const char* chunk = pos;
+  while (true) {
+    if (pos == end) Fail(DecodeError::SYNTAX, "Unterminated string");
+    unsigned char c = static_cast<unsigned char>(*pos);
+    if (c == '"') break;
+    if (c < 0x20) Fail(DecodeError::SYNTAX, "Control character in string");
+    if (c != '\\') {
+      pos++;
+      continue;
+    }
+    if (value) value->append(chunk, pos - chunk);
+    pos++;
+    ReadEscape(value);
+    chunk = pos;
+    escaped = true;
+  }
+  if (value) value->append(chunk, pos - chunk);
+  if (static_cast<size_t>(pos - start) > limits.maxStringLength)
+    Fail(DecodeError::STRING_TOO_LONG,
+        "String is longer than " + std::to_string(limits.maxStringLength) + " bytes");
+  pos++;
+  return escaped;
+}
+
+void JsonReader::ReadEscape(std::string* value) {
+  if (pos == end) Fail(DecodeError::SYNTAX, "Unterminated string");
+  char c = *pos++;
+  char unescaped;
+  switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      unescaped = c;
+      break;
+    case 'b':
+      unescaped = '\b';
+      break;
+    case 'f':
+      unescaped = '\f';
+      break;
+    case 'n':
+      unescaped = '\n';
+      break;
+    case 'r':
+      unescaped = '\r';
+      break;
+    case 't':
+      unescaped = '\t';
+      break;
+    case 'u': {
+      auto readHex = [this]() {
+        if (end - pos < 4) Fail(DecodeError::SYNTAX, "Invalid unicode escape");
+        uint32_t codeUnit = 0;
+        for (int i = 0; i < 4; i++) {
+          int digit = HexValue(*pos++);
+          if (digit < 0) Fail(DecodeError::SYNTAX, "Invalid unicode escape");
+          codeUnit = codeUnit << 4 | digit;
+        }
+        return codeUnit;
+      };
+      uint32_t codePoint = readHex();
+      if (codePoint >= 0xd800 && codePoint < 0xdc00) {
+        // High surrogate, has to be followed by the escaped low surrogate.
+        if (end - pos < 2 || pos[0] != '\\' || pos[1] != 'u')
+          Fail(DecodeError::SYNTAX, "Invalid unicode surrogate pair");
+        pos += 2;
+        uint32_t low = readHex();
+        if (low < 0xdc00 || low >= 0xe000) Fail(DecodeError::SYNTAX, "Invalid unicode surrogate");
+        codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+      } else if (codePoint >= 0xdc00 && codePoint < 0xe000) {
+        Fail(DecodeError::SYNTAX, "Invalid unicode surrogate");
+      }
+      if (value) AppendUtf8(codePoint, value);
+      return;
+    }
+    default:
+      Fail(DecodeError::SYNTAX, "Invalid escape sequence");
+  }
+  if (value) *value += unescaped;
+}
+
+const char* JsonReader::ScanNumber(bool* integral) {
+  const char* start = pos;
+  *integral = true;
+  if (pos != end && *pos == '-') pos++;
+  if (pos == end || !IsDigit(*pos)) Fail(DecodeError::SYNTAX, "Invalid number");
+  if (*pos == '0')
+    pos++;
+  else
+    while (pos != end && IsDigit(*pos)) pos++;
+
+  if (pos != end && *pos == '.') {
+    *integral = false;
+    pos++;
+    if (pos == end || !IsDigit(*pos)) Fail(DecodeError::SYNTAX, "Invalid number");
+    while (pos != end && IsDigit(*pos)) pos++;
+  }
+  if (pos != end && (*pos == 'e' || *pos == 'E')) {
+    *integral = false;
+    pos++;
+    if (pos != end && (*pos == '+' || *pos == '-')) pos++;
+    if (pos == end || !IsDigit(*pos)) Fail(DecodeError::SYNTAX, "Invalid number");
+    while (pos != end && IsDigit(*pos)) pos++;
+  }
+  return start;
+}
+
+std::string JsonReader::Path() const {
+  std::string path;
+  for (const Frame& frame : frames) {
+    if (frame.array) {
+      if (frame.index > 0) path += "[" + std::to_string(frame.index - 1) + "]";
+    } else if (frame.key) {
+      if (!path.empty()) path += '.';
+      path.append(frame.key, frame.keySize);
+    }
+  }
+  return path;
+}
+
+}  // namespace mqtt_bridge
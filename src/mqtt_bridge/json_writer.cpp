@@ -0,0 +1,169 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "mqtt_bridge/json_writer.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace mqtt_bridge {
+
+void JsonWriter::Clear() {
+  buffer.clear();
+  first = true;
+  afterKey = false;
+}
+
+void JsonWriter::BeginObject() {
+  Separate();
+  buffer += '{';
+  first = true;
+}
+
+void JsonWriter::EndObject() {
+  buffer += '}';
+  first = false;
+}
+
+void JsonWriter::BeginArray(size_t /* size */) {
+  Separate();
+  buffer += '[';
+  first = true;
+}
+
+void JsonWriter::EndArray() {
+  buffer += ']';
+  first = false;
+}
+
+void JsonWriter::DynamicKey(const std::string& key) {
+  String(key);
+  buffer += ':';
+  afterKey = true;
+}
+
+void JsonWriter::String(const std::string& value) {
+  Separate();
+  buffer += '"';
+
+  // Most strings are IDs without characters to escape, they are copied in larger chunks.
+  static const char hex[] = "0123456789abcdef";
+  size_t chunkStart = 0;
+  for (size_t i = 0; i < value.size(); i++) {
+    unsigned char c = static_cast<unsigned char>(value[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+    buffer.append(value, chunkStart, i - chunkStart);
+    chunkStart = i + 1;
+    switch (c) {
+      case '"':
+        buffer.append("\\\"", 2);
+        break;
+      case '\\':
+        buffer.append("\\\\", 2);
+        break;
+      case '\n':
+        buffer.append("\\n", 2);
+        break;
+      case '\r':
+        buffer.append("\\r", 2);
+        break;
+      case '\t':
+        buffer.append("\\t", 2);
+        break;
+      default:
+        buffer.append("\\u00", 4);
+        buffer += hex[c >> 4];
+        buffer += hex[c & 0xf];
+    }
+  }
+  buffer.append(value, chunkStart, value.size() - chunkStart);
+
+  buffer += '"';
+}
+
+void JsonWriter::Double(double value) {
+  // JSON has no representation of NaN and infinity.
+  if (!std::isfinite(value)) {
+    Null();
+    return;
+  }
+
+  // Integral values, e.g. IDs, counters and most control point weights, skip the float formatting.
+  if (std::fabs(value) < 1e15 && value == std::trunc(value)) {
+    Int(static_cast<int64_t>(value));
+    return;
+  }
+
+  Separate();
+  // Values with few decimals, e.g. battery charges or configured positions, are written as scaled
+  // integers. Division of two exact integers is correctly rounded, just like reading the decimal.
+  static const double scales[] = {10.0, 100.0, 1e3, 1e4, 1e5, 1e6};
+  for (int decimals = 1; decimals <= 6; decimals++) {
+    double scale = scales[decimals - 1];
+    double scaled = std::fabs(value) * scale;
+    if (scaled >= 9007199254740992.0 || scaled != std::trunc(scaled)) continue;
+    if (scaled / scale != std::fabs(value)) continue;
+
+    uint64_t mantissa = static_cast<uint64_t>(scaled);
+    uint64_t divisor = static_cast<uint64_t>(scale);
+    if (value < 0) buffer += '-';
+    AppendDigits(mantissa / divisor);
+    buffer += '.';
+    for (uint64_t rest = mantissa % divisor; divisor > 1; divisor /= 10)
+      buffer += static_cast<char>('0' + rest / (divisor / 10) % 10);
+    return;
+  }
+
+  // Use the shortest of both precisions that reads back as the same value.
+  char digits[32];
+  int length = snprintf(digits, sizeof(digits), "%.15g", value);
+  if (strtod(digits, nullptr) != value) length = snprintf(digits, sizeof(digits), "%.17g", value);
+  buffer.append(digits, length);
+}
+
+void JsonWriter::Int(int64_t value) {
+  Separate();
+  if (value < 0) {
+    buffer += '-';
+    AppendDigits(0 - static_cast<uint64_t>(value));
+  } else {
+    AppendDigits(static_cast<uint64_t>(value));
+  }
+}
+
+void JsonWriter::Uint(uint64_t value) {
+  Separate();
+  AppendDigits(value);
+}
+
+void JsonWriter::Bool(bool value) {
+  Separate();
+  if (value)
+    buffer.append("true", 4);
+  else
+    buffer.append("false", 5);
+}
+
+void JsonWriter::Null() {
+  Separate();
+  buffer.append("null", 4);
+}
+
+void JsonWriter::AppendDigits(uint64_t value) {
+  char digits[20];
+  int length = 0;
+  do {
+    digits[sizeof(digits) - 1 - length++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  buffer.append(digits + sizeof(digits) - length, length);
+}
+
+}  // namespace mqtt_bridge
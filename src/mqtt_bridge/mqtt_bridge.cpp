@@ -0,0 +1,429 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "mqtt_bridge/mqtt_bridge.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include "utils/utils.h"
+
+namespace mqtt_bridge {
+
+constexpr char ROS_TO_MQTT_FACTORY[] = "RosToMqttBridge";
+constexpr char MQTT_TO_ROS_FACTORY[] = "MqttToRosBridge";
+constexpr char CONNECTION_MSG_TYPE[] = "vda5050_msgs.msg:Connection";
+constexpr double REPLAY_PERIOD = 0.1;
+constexpr char SERIAL_NUMBER_PLACEHOLDER[] = "{serial_number}";
+
+namespace {
+
+bool EndsWith(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void AddValue(
+    diagnostic_msgs::DiagnosticStatus* status, const std::string& key, const std::string& value) {
+  diagnostic_msgs::KeyValue keyValue;
+  keyValue.key = key;
+  keyValue.value = value;
+  status->values.push_back(keyValue);
+}
+
+double SteadySeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+const MessageBinding MqttBridge::messageBindings[] = {
+    {"vda5050_msgs.msg:State", 0, false, 2, DropPolicy::NEVER_DROP, true,
+        &SubscribeRos<vda5050_msgs::State>, &AdvertiseRos<vda5050_msgs::State>},
+    {"vda5050_msgs.msg:Visualization", 0, false, 0, DropPolicy::LATEST_ONLY, false,
+        &SubscribeRos<vda5050_msgs::Visualization>, &AdvertiseRos<vda5050_msgs::Visualization>},
+    {CONNECTION_MSG_TYPE, 1, true, 3, DropPolicy::LATEST_ONLY, false,
+        &SubscribeRos<vda5050_msgs::Connection>, &AdvertiseRos<vda5050_msgs::Connection>},
+    {"vda5050_msgs.msg:Order", 0, false, 1, DropPolicy::NEVER_DROP, false,
+        &SubscribeRos<vda5050_msgs::Order>, &AdvertiseRos<vda5050_msgs::Order>},
+    {"vda5050_msgs.msg:InstantAction", 0, false, 1, DropPolicy::NEVER_DROP, false,
+        &SubscribeRos<vda5050_msgs::InstantAction>, &AdvertiseRos<vda5050_msgs::InstantAction>},
+    // Zone sets have no ROS message, the connector decodes their JSON itself.
+    {"vda5050_msgs.msg:ZoneUpdate", 0, false, 0, DropPolicy::LATEST_ONLY, false, &SubscribeRaw,
+        &AdvertiseRaw},
+};
+
+MqttBridge::MqttBridge() : MqttBridge(ros::NodeHandle(), ros::NodeHandle("~")) {}
+
+MqttBridge::MqttBridge(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh)
+    : MqttBridge(nh, private_nh, std::vector<BridgedVehicle>()) {}
+
+MqttBridge::MqttBridge(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh,
+    const std::vector<BridgedVehicle>& vehicles)
+    : nh(nh),
+      privateNh(private_nh),
+      params(connector_utils::ParamTree::Fetch(privateNh.getNamespace())),
+      vehicles(vehicles) {
+  MqttOptions options = ReadMqttOptions();
+  ReadDecodeLimits();
+
+  // Messages are only sent once the client is connected, so the client may be created later.
+  int maxInFlight;
+  params.Param<int>("outbound/max_in_flight", maxInFlight, 10);
+  scheduler.reset(new OutboundScheduler(
+      [this](const std::string& topic, const std::string& payload, int qos, bool retain) {
+        return client->Publish(topic, payload, qos, retain);
+      },
+      std::max(maxInFlight, 1)));
+
+  int capacity;
+  params.Param<std::string>("spool/directory", spoolDirectory, "");
+  params.Param<int>("spool/capacity", capacity, 16 * 1024 * 1024);
+  spoolCapacity = std::max(capacity, 1024);
+
+  LinkBridges(&options);
+
+  // The link state is latched, so the connector also gets it if it starts after the bridge.
+  std::string linkStateTopic;
+  params.Param<std::string>("link_state_topic", linkStateTopic, "/mqtt_link_state");
+  linkStatePub = this->nh.advertise<std_msgs::Bool>(linkStateTopic, 1, true);
+  std_msgs::Bool linkState;
+  linkState.data = false;
+  linkStatePub.publish(linkState);
+
+  client.reset(new MqttClient(options));
+  client->SetMessageCallback(std::bind(&MqttBridge::MqttMessageCallback, this,
+      std::placeholders::_1, std::placeholders::_2));
+  client->SetPublishedCallback([this]() { scheduler->OnPublished(); });
+  client->SetConnectionCallback([this, options](bool connected) {
+    if (connected)
+      ROS_INFO("Connected to MQTT broker %s:%d", options.host.c_str(), options.port);
+    else
+      ROS_WARN("Lost connection to MQTT broker %s:%d", options.host.c_str(), options.port);
+    scheduler->SetConnected(connected);
+
+    std_msgs::Bool linkState;
+    linkState.data = connected;
+    linkStatePub.publish(linkState);
+  });
+
+  double replayRate;
+  params.Param<double>("spool/replay_rate", replayRate, 50.0);
+  size_t replayBudget = std::max(1.0, std::round(replayRate * REPLAY_PERIOD));
+  replayTimer = this->nh.createTimer(ros::Duration(REPLAY_PERIOD),
+      [this, replayBudget](const ros::TimerEvent&) { scheduler->ReplaySpools(replayBudget); });
+
+  // Rates are measured even without budget, they show which budget a site needs.
+  governor.reset(new BandwidthGovernor(ReadGovernorOptions()));
+  double governorPeriod;
+  std::string throttleTopic;
+  params.Param<double>("governor/period", governorPeriod, 1.0);
+  params.Param<std::string>("governor/throttle_topic", throttleTopic, "/uplink_throttle");
+  throttlePub = this->nh.advertise<std_msgs::UInt8>(throttleTopic, 1, true);
+  std_msgs::UInt8 throttle;
+  throttle.data = 0;
+  throttlePub.publish(throttle);
+  governorTimer = this->nh.createTimer(
+      ros::Duration(std::max(governorPeriod, 0.1)), &MqttBridge::UpdateGovernor, this);
+
+  double diagnosticsPeriod;
+  params.Param<double>("outbound/diagnostics_period", diagnosticsPeriod, 1.0);
+  if (diagnosticsPeriod > 0.0) {
+    diagnosticsPub = this->nh.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 10);
+    diagnosticsTimer = this->nh.createTimer(
+        ros::Duration(diagnosticsPeriod), &MqttBridge::PublishDiagnostics, this);
+  }
+  for (const auto& route : mqttToRosRoutes) client->Subscribe(route.first, 0);
+  client->Connect();
+}
+
+MqttBridge::~MqttBridge() {
+  diagnosticsTimer.stop();
+  replayTimer.stop();
+  governorTimer.stop();
+
+  // The loop reports the disconnect to the scheduler and the link state publisher, so it is stopped
+  // while they exist.
+  if (client) client->Disconnect();
+}
+
+void MqttBridge::PublishToMqtt(size_t outboundTopic, const std::string& payload) {
+  scheduler->Enqueue(outboundTopic, payload);
+}
+
+void MqttBridge::MqttMessageCallback(const std::string& topic, const std::string& payload) {
+  auto route = mqttToRosRoutes.find(topic);
+  if (route == mqttToRosRoutes.end()) return;
+
+  try {
+    route->second(payload);
+  } catch (const std::exception& e) {
+    ROS_ERROR("Dropped message from MQTT topic %s: %s", topic.c_str(), e.what());
+  }
+}
+
+MqttOptions MqttBridge::ReadMqttOptions() {
+  MqttOptions options;
+  params.Param<std::string>("mqtt/connection/host", options.host, options.host);
+  params.Param<int>("mqtt/connection/port", options.port, options.port);
+  params.Param<int>("mqtt/connection/keepalive", options.keepalive, options.keepalive);
+  params.Param<std::string>("mqtt/client/client_id", options.clientId, "");
+  params.Param<std::string>("mqtt/account/username", options.username, "");
+  params.Param<std::string>("mqtt/account/password", options.password, "");
+  params.Param<std::string>("mqtt/tls/ca_certs", options.caCerts, "");
+  params.Param<std::string>("mqtt/tls/certfile", options.certFile, "");
+  params.Param<std::string>("mqtt/tls/keyfile", options.keyFile, "");
+  return options;
+}
+
+void MqttBridge::ReadDecodeLimits() {
+  int maxPayloadSize, maxDepth, maxArraySize, maxStringLength;
+  params.Param<int>(
+      "decoder/max_payload_size", maxPayloadSize, static_cast<int>(decodeLimits.maxPayloadSize));
+  params.Param<int>("decoder/max_depth", maxDepth, static_cast<int>(decodeLimits.maxDepth));
+  params.Param<int>(
+      "decoder/max_array_size", maxArraySize, static_cast<int>(decodeLimits.maxArraySize));
+  params.Param<int>(
+      "decoder/max_string_length", maxStringLength, static_cast<int>(decodeLimits.maxStringLength));
+  decodeLimits.maxPayloadSize = std::max(maxPayloadSize, 0);
+  decodeLimits.maxDepth = std::max(maxDepth, 0);
+  decodeLimits.maxArraySize = std::max(maxArraySize, 0);
+  decodeLimits.maxStringLength = std::max(maxStringLength, 0);
+}
+
+void MqttBridge::LinkBridges(MqttOptions* options) {
+  XmlRpc::XmlRpcValue bridges;
+  if (!params.Get("bridge", bridges) ||
+      bridges.getType() != XmlRpc::XmlRpcValue::TypeArray) {
+    ROS_ERROR("%s/bridge not found in the configuration!", privateNh.getNamespace().c_str());
+    return;
+  }
+
+  for (int i = 0; i < bridges.size(); i++) {
+    XmlRpc::XmlRpcValue& bridge = bridges[i];
+    if (bridge.getType() != XmlRpc::XmlRpcValue::TypeStruct || !bridge.hasMember("factory") ||
+        !bridge.hasMember("msg_type") || !bridge.hasMember("topic_from") ||
+        !bridge.hasMember("topic_to")) {
+      ROS_ERROR("Bridge %d is incomplete, it needs factory, msg_type, topic_from and topic_to", i);
+      continue;
+    }
+    std::string factory = static_cast<std::string>(bridge["factory"]);
+    std::string msgType = static_cast<std::string>(bridge["msg_type"]);
+    std::string topicFrom = static_cast<std::string>(bridge["topic_from"]);
+    std::string topicTo = static_cast<std::string>(bridge["topic_to"]);
+
+    const MessageBinding* binding = nullptr;
+    for (const auto& candidate : messageBindings) {
+      if (msgType == candidate.msgType) {
+        binding = &candidate;
+        break;
+      }
+    }
+    if (!binding) {
+      ROS_WARN("Message type %s is not supported, bridge %s -> %s skipped", msgType.c_str(),
+          topicFrom.c_str(), topicTo.c_str());
+      continue;
+    }
+
+    bool rosToMqtt = EndsWith(factory, ROS_TO_MQTT_FACTORY);
+    if (!rosToMqtt && !EndsWith(factory, MQTT_TO_ROS_FACTORY)) {
+      ROS_WARN("Unknown bridge factory %s, bridge %s -> %s skipped", factory.c_str(),
+          topicFrom.c_str(), topicTo.c_str());
+      continue;
+    }
+    const std::string& rosTopic = rosToMqtt ? topicFrom : topicTo;
+    const std::string& mqttTopic = rosToMqtt ? topicTo : topicFrom;
+    if (vehicles.empty()) {
+      LinkBridge(*binding, rosToMqtt, rosTopic, mqttTopic, options);
+      continue;
+    }
+
+    if (mqttTopic.find(SERIAL_NUMBER_PLACEHOLDER) == std::string::npos)
+      ROS_WARN("MQTT topic %s of bridge %d has no %s, all vehicles share it", mqttTopic.c_str(), i,
+          SERIAL_NUMBER_PLACEHOLDER);
+    for (const BridgedVehicle& vehicle : vehicles) {
+      std::string vehicleMqttTopic = mqttTopic;
+      size_t placeholder = vehicleMqttTopic.find(SERIAL_NUMBER_PLACEHOLDER);
+      if (placeholder != std::string::npos)
+        vehicleMqttTopic.replace(
+            placeholder, std::strlen(SERIAL_NUMBER_PLACEHOLDER), vehicle.serialNumber);
+      LinkBridge(*binding, rosToMqtt, connector_utils::NamespacedTopic(vehicle.ns, rosTopic),
+          vehicleMqttTopic, nullptr);
+    }
+  }
+}
+
+void MqttBridge::LinkBridge(const MessageBinding& binding, bool rosToMqtt,
+    const std::string& rosTopic, const std::string& mqttTopic, MqttOptions* options) {
+  if (!rosToMqtt) {
+    mqttToRosRoutes[mqttTopic] = binding.advertise(&nh, rosTopic, decodeLimits);
+    return;
+  }
+
+  size_t outboundTopic =
+      scheduler->AddTopic(mqttTopic, binding.qos, binding.retain, ReadOutboundPolicy(binding));
+  PayloadEncoding encoding = ReadPayloadEncoding(binding);
+  subscribers.push_back(binding.subscribe(this, &nh, rosTopic, outboundTopic, encoding));
+  if (binding.spool) OpenSpool(outboundTopic, mqttTopic);
+
+  if (options && std::strcmp(binding.msgType, CONNECTION_MSG_TYPE) == 0) {
+    options->willTopic = mqttTopic;
+    options->willPayload = CreateWillPayload(encoding);
+    options->willQos = binding.qos;
+    options->willRetain = binding.retain;
+  }
+}
+
+OutboundPolicy MqttBridge::ReadOutboundPolicy(const MessageBinding& binding) {
+  std::string msgType = binding.msgType;
+  std::string ns = "outbound/" + msgType.substr(msgType.find(':') + 1) + "/";
+
+  OutboundPolicy policy;
+  policy.priority = binding.priority;
+  policy.dropPolicy = binding.dropPolicy;
+  params.Param<int>(ns + "priority", policy.priority, policy.priority);
+
+  std::string dropPolicy;
+  if (params.Get(ns + "drop_policy", dropPolicy) &&
+      !ParseDropPolicy(dropPolicy, &policy.dropPolicy))
+    ROS_WARN("Unknown drop policy %s for %s, using %s", dropPolicy.c_str(), binding.msgType,
+        DropPolicyName(policy.dropPolicy));
+
+  int queueDepth;
+  params.Param<int>(ns + "queue_depth", queueDepth, static_cast<int>(policy.queueDepth));
+  policy.queueDepth = std::max(queueDepth, 1);
+  return policy;
+}
+
+PayloadEncoding MqttBridge::ReadPayloadEncoding(const MessageBinding& binding) {
+  std::string msgType = binding.msgType;
+  std::string param = "outbound/" + msgType.substr(msgType.find(':') + 1) + "/encoding";
+
+  std::string encoding;
+  if (!params.Get(param, encoding) || encoding == "json") return PayloadEncoding::JSON;
+  if (encoding == "cbor") return PayloadEncoding::CBOR;
+  if (encoding == "cbor_packed") return PayloadEncoding::CBOR_PACKED;
+  ROS_WARN("Unknown encoding %s for %s, using json", encoding.c_str(), binding.msgType);
+  return PayloadEncoding::JSON;
+}
+
+void MqttBridge::OpenSpool(size_t outboundTopic, const std::string& mqttTopic) {
+  if (spoolDirectory.empty()) return;
+
+  std::string name = mqttTopic;
+  std::replace(name.begin(), name.end(), '/', '_');
+  std::string path = spoolDirectory + "/" + name + ".spool";
+  try {
+    ::mkdir(spoolDirectory.c_str(), 0755);
+    std::unique_ptr<Spool> spool(new Spool(path, spoolCapacity));
+    if (!spool->Empty())
+      ROS_INFO("Spool %s holds %zu messages, they are sent after the connect", path.c_str(),
+          spool->Size());
+    scheduler->AttachSpool(outboundTopic, std::move(spool));
+  } catch (const std::exception& e) {
+    ROS_ERROR("Messages to %s are not spooled: %s", mqttTopic.c_str(), e.what());
+  }
+}
+
+GovernorOptions MqttBridge::ReadGovernorOptions() {
+  GovernorOptions options;
+  params.Param<double>("governor/budget", options.budget, options.budget);
+  params.Param<double>(
+      "governor/recover_fraction", options.recoverFraction, options.recoverFraction);
+  params.Param<double>("governor/raise_delay", options.raiseDelay, options.raiseDelay);
+  params.Param<double>("governor/recover_delay", options.recoverDelay, options.recoverDelay);
+  params.Param<double>("governor/smoothing", options.smoothing, options.smoothing);
+  params.Param<int>("governor/max_level", options.maxLevel, options.maxLevel);
+  return options;
+}
+
+void MqttBridge::UpdateGovernor(const ros::TimerEvent& event) {
+  if (!governor->Update(SteadySeconds(), scheduler->GetStats())) return;
+
+  ROS_INFO("Uplink at %.0f of %.0f bytes/s, throttle level %d", governor->GetRate(),
+      governor->GetOptions().budget, governor->GetLevel());
+  std_msgs::UInt8 throttle;
+  throttle.data = governor->GetLevel();
+  throttlePub.publish(throttle);
+}
+
+void MqttBridge::PublishDiagnostics(const ros::TimerEvent& event) {
+  diagnostic_msgs::DiagnosticArray diagnostics;
+  diagnostics.header.stamp = ros::Time::now();
+
+  bool connected = client->IsConnected();
+  std::string inFlight = std::to_string(scheduler->GetInFlight());
+  const std::vector<TopicRate>& rates = governor->GetTopicRates();
+  std::vector<OutboundStats> topicStats = scheduler->GetStats();
+  for (size_t i = 0; i < topicStats.size(); i++) {
+    const OutboundStats& stats = topicStats[i];
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = "mqtt_bridge: " + stats.topic;
+    status.hardware_id = privateNh.getNamespace();
+    status.level = connected ? diagnostic_msgs::DiagnosticStatus::OK
+                             : diagnostic_msgs::DiagnosticStatus::WARN;
+    status.message = connected ? "connected" : "disconnected";
+
+    AddValue(&status, "priority", std::to_string(stats.policy.priority));
+    AddValue(&status, "drop_policy", DropPolicyName(stats.policy.dropPolicy));
+    AddValue(&status, "queue_depth", std::to_string(stats.depth));
+    AddValue(&status, "sent", std::to_string(stats.sent));
+    AddValue(&status, "sent_bytes", std::to_string(stats.sentBytes));
+    AddValue(&status, "bytes_per_second",
+        std::to_string(i < rates.size() ? std::lround(rates[i].bytesPerSecond) : 0));
+    AddValue(&status, "dropped", std::to_string(stats.dropped));
+    AddValue(&status, "spooled", std::to_string(stats.spooled));
+    AddValue(&status, "in_flight", inFlight);
+    diagnostics.status.push_back(status);
+  }
+
+  // The level is a warning while it is raised, the budget should fit the normal traffic.
+  diagnostic_msgs::DiagnosticStatus status;
+  status.name = "mqtt_bridge: bandwidth governor";
+  status.hardware_id = privateNh.getNamespace();
+  const GovernorOptions& options = governor->GetOptions();
+  if (options.budget <= 0.0) {
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = "no budget";
+  } else if (governor->GetLevel() == 0) {
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = "within budget";
+  } else {
+    status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+    status.message = "throttled";
+  }
+  AddValue(&status, "budget", std::to_string(std::lround(options.budget)));
+  AddValue(&status, "bytes_per_second", std::to_string(std::lround(governor->GetRate())));
+  AddValue(&status, "level", std::to_string(governor->GetLevel()));
+  AddValue(&status, "raises", std::to_string(governor->GetRaises()));
+  AddValue(&status, "recoveries", std::to_string(governor->GetRecoveries()));
+  diagnostics.status.push_back(status);
+  diagnosticsPub.publish(diagnostics);
+}
+
+std::string MqttBridge::CreateWillPayload(PayloadEncoding encoding) {
+  vda5050_msgs::Connection will;
+  will.headerId = 0;
+  will.timestamp = connector_utils::GetISOCurrentTimestamp();
+  connector_utils::ParamTree header = connector_utils::ParamTree::Fetch("/header");
+  header.Get("version", will.version);
+  header.Get("manufacturer", will.manufacturer);
+  header.Get("serial_number", will.serialNumber);
+  will.connectionState = "CONNECTIONBROKEN";
+  if (encoding == PayloadEncoding::JSON) return Serialize(will);
+
+  CborWriter writer(encoding == PayloadEncoding::CBOR_PACKED);
+  Encode(writer, will);
+  return writer.str();
+}
+
+}  // namespace mqtt_bridge
@@ -0,0 +1,23 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "mqtt_bridge/mqtt_bridge.h"
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "mqtt_bridge");
+
+  try {
+    mqtt_bridge::MqttBridge bridge;
+    ros::spin();
+  } catch (const std::runtime_error& e) {
+    ROS_FATAL("MQTT bridge failed: %s", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "mqtt_bridge/mqtt_client.h"
+#include <stdexcept>
+
+namespace mqtt_bridge {
+
+namespace {
+
+/**
+ * Initializes libmosquitto once per process. The library is never cleaned up, as clients may
+ * exist until the process exits.
+ */
+void InitMosquittoLib() {
+  static std::once_flag initialized;
+  std::call_once(initialized, []() { mosquitto_lib_init(); });
+}
+
+void ThrowOnError(int rc, const std::string& what) {
+  if (rc != MOSQ_ERR_SUCCESS)
+    throw std::runtime_error(what + ": " + std::string(mosquitto_strerror(rc)));
+}
+
+}  // namespace
+
+MqttClient::MqttClient(const MqttOptions& options)
+    : mosq(nullptr), options(options), connected(false), loopRunning(false) {
+  InitMosquittoLib();
+
+  const char* clientId = options.clientId.empty() ? nullptr : options.clientId.c_str();
+  mosq = mosquitto_new(clientId, true, this);
+  if (!mosq) throw std::runtime_error("Could not create MQTT client");
+
+  mosquitto_connect_callback_set(mosq, &MqttClient::OnConnect);
+  mosquitto_disconnect_callback_set(mosq, &MqttClient::OnDisconnect);
+  mosquitto_publish_callback_set(mosq, &MqttClient::OnPublish);
+  mosquitto_message_callback_set(mosq, &MqttClient::OnMessage);
+}
+
+MqttClient::~MqttClient() {
+  Disconnect();
+  mosquitto_destroy(mosq);
+}
+
+void MqttClient::Connect() {
+  if (!options.username.empty()) {
+    ThrowOnError(
+        mosquitto_username_pw_set(mosq, options.username.c_str(), options.password.c_str()),
+        "Could not set MQTT credentials");
+  }
+
+  if (!options.caCerts.empty()) {
+    const char* certFile = options.certFile.empty() ? nullptr : options.certFile.c_str();
+    const char* keyFile = options.keyFile.empty() ? nullptr : options.keyFile.c_str();
+    ThrowOnError(
+        mosquitto_tls_set(mosq, options.caCerts.c_str(), nullptr, certFile, keyFile, nullptr),
+        "Could not set up TLS");
+  }
+
+  if (!options.willTopic.empty()) {
+    ThrowOnError(mosquitto_will_set(mosq, options.willTopic.c_str(),
+                     static_cast<int>(options.willPayload.size()), options.willPayload.data(),
+                     options.willQos, options.willRetain),
+        "Could not set the last will");
+  }
+
+  mosquitto_reconnect_delay_set(mosq, 1, 30, true);
+
+  // An unreachable broker is no error, the loop thread keeps trying to connect.
+  int rc = mosquitto_connect_async(mosq, options.host.c_str(), options.port, options.keepalive);
+  if (rc == MOSQ_ERR_INVAL)
+    ThrowOnError(rc, "Could not connect to " + options.host + ":" + std::to_string(options.port));
+  ThrowOnError(mosquitto_loop_start(mosq), "Could not start the MQTT network loop");
+  loopRunning = true;
+}
+
+void MqttClient::Disconnect() {
+  if (!loopRunning) return;
+
+  mosquitto_disconnect(mosq);
+  mosquitto_loop_stop(mosq, false);
+  loopRunning = false;
+  connected = false;
+}
+
+bool MqttClient::Publish(
+    const std::string& topic, const std::string& payload, int qos, bool retain) {
+  return mosquitto_publish(mosq, nullptr, topic.c_str(), static_cast<int>(payload.size()),
+             payload.data(), qos, retain) == MOSQ_ERR_SUCCESS;
+}
+
+void MqttClient::Subscribe(const std::string& topic, int qos) {
+  std::lock_guard<std::mutex> lock(subscriptionsMutex);
+  subscriptions.emplace_back(topic, qos);
+  if (connected) mosquitto_subscribe(mosq, nullptr, topic.c_str(), qos);
+}
+
+void MqttClient::SetMessageCallback(const MessageCallback& callback) { messageCallback = callback; }
+
+void MqttClient::SetConnectionCallback(const ConnectionCallback& callback) {
+  connectionCallback = callback;
+}
+
+void MqttClient::SetPublishedCallback(const PublishedCallback& callback) {
+  publishedCallback = callback;
+}
+
+void MqttClient::OnConnect(struct mosquitto* mosq, void* obj, int rc) {
+  MqttClient* client = static_cast<MqttClient*>(obj);
+  if (rc != 0) return;
+
+  // Clean sessions drop the subscriptions on the broker, so they are renewed on each connect.
+  {
+    std::lock_guard<std::mutex> lock(client->subscriptionsMutex);
+    client->connected = true;
+    for (const auto& subscription : client->subscriptions)
+      mosquitto_subscribe(mosq, nullptr, subscription.first.c_str(), subscription.second);
+  }
+
+  if (client->connectionCallback) client->connectionCallback(true);
+}
+
+void MqttClient::OnDisconnect(struct mosquitto* mosq, void* obj, int rc) {
+  MqttClient* client = static_cast<MqttClient*>(obj);
+  client->connected = false;
+  if (client->connectionCallback) client->connectionCallback(false);
+}
+
+void MqttClient::OnPublish(struct mosquitto* mosq, void* obj, int mid) {
+  MqttClient* client = static_cast<MqttClient*>(obj);
+  if (client->publishedCallback) client->publishedCallback();
+}
+
+void MqttClient::OnMessage(struct mosquitto* mosq, void* obj, const struct mosquitto_message* msg) {
+  MqttClient* client = static_cast<MqttClient*>(obj);
+  if (!client->messageCallback) return;
+
+  std::string payload;
+  if (msg->payloadlen > 0) payload.assign(static_cast<const char*>(msg->payload), msg->payloadlen);
+  client->messageCallback(msg->topic, payload);
+}
+
+}  // namespace mqtt_bridge
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "mqtt_bridge/outbound_scheduler.h"
+#include <utility>
+
+namespace mqtt_bridge {
+
+bool ParseDropPolicy(const std::string& name, DropPolicy* policy) {
+  if (name == "never_drop")
+    *policy = DropPolicy::NEVER_DROP;
+  else if (name == "drop_oldest")
+    *policy = DropPolicy::DROP_OLDEST;
+  else if (name == "latest_only")
+    *policy = DropPolicy::LATEST_ONLY;
+  else
+    return false;
+  return true;
+}
+
+const char* DropPolicyName(DropPolicy policy) {
+  switch (policy) {
+    case DropPolicy::NEVER_DROP:
+      return "never_drop";
+    case DropPolicy::DROP_OLDEST:
+      return "drop_oldest";
+    case DropPolicy::LATEST_ONLY:
+      return "latest_only";
+  }
+  return "unknown";
+}
+
+OutboundScheduler::OutboundScheduler(const SendFunction& send, size_t maxInFlight)
+    : send(send), maxInFlight(maxInFlight) {}
+
+size_t OutboundScheduler::AddTopic(
+    const std::string& topic, int qos, bool retain, const OutboundPolicy& policy) {
+  std::lock_guard<std::mutex> lock(mutex);
+  queues.push_back({topic, qos, retain, policy, {}, 0, 0, 0, nullptr, 0});
+  return queues.size() - 1;
+}
+
+void OutboundScheduler::AttachSpool(size_t topicId, std::unique_ptr<Spool> spool) {
+  std::lock_guard<std::mutex> lock(mutex);
+  queues[topicId].spool = std::move(spool);
+}
+
+void OutboundScheduler::Enqueue(size_t topicId, const std::string& payload) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    TopicQueue& queue = queues[topicId];
+    uint64_t sequence = nextSequence++;
+
+    // While spooled messages wait, newer ones go to the spool as well to keep their order.
+    if (queue.spool && (!connected || !queue.spool->Empty())) {
+      AppendToSpool(queue, payload);
+    } else if (queue.policy.dropPolicy == DropPolicy::LATEST_ONLY && !queue.messages.empty()) {
+      // Replace the waiting message, its buffer is reused for the new payload.
+      queue.messages.back().sequence = sequence;
+      queue.messages.back().payload = payload;
+      queue.dropped++;
+    } else {
+      if (queue.policy.dropPolicy == DropPolicy::DROP_OLDEST &&
+          queue.messages.size() >= queue.policy.queueDepth && !queue.messages.empty()) {
+        queue.messages.pop_front();
+        queue.dropped++;
+      }
+      queue.messages.push_back({sequence, payload});
+    }
+  }
+  Dispatch();
+}
+
+void OutboundScheduler::OnPublished() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (inFlight > 0) inFlight--;
+  }
+  Dispatch();
+}
+
+void OutboundScheduler::SetConnected(bool connected) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->connected = connected;
+    // Publish notifications of messages sent before a reconnect may never arrive.
+    if (connected) inFlight = 0;
+
+    // Waiting messages are older than the spooled ones only if the spool was empty.
+    for (TopicQueue& queue : queues) {
+      if (connected || !queue.spool || !queue.spool->Empty()) continue;
+      for (const Message& message : queue.messages) AppendToSpool(queue, message.payload);
+      queue.messages.clear();
+    }
+  }
+  Dispatch();
+}
+
+void OutboundScheduler::ReplaySpools(size_t budget) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (TopicQueue& queue : queues) {
+      if (!queue.spool) continue;
+      queue.replayBudget = budget;
+      queue.spool->Sync();
+    }
+  }
+  Dispatch();
+}
+
+std::vector<OutboundStats> OutboundScheduler::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<OutboundStats> stats;
+  stats.reserve(queues.size());
+  for (const TopicQueue& queue : queues)
+    stats.push_back({queue.topic, queue.policy, queue.messages.size(), queue.sent, queue.sentBytes,
+        queue.dropped, queue.spool ? queue.spool->Size() : 0});
+  return stats;
+}
+
+size_t OutboundScheduler::GetInFlight() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return inFlight;
+}
+
+void OutboundScheduler::Dispatch() {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (dispatching) {
+    retryPending = true;
+    return;
+  }
+  dispatching = true;
+  retryPending = false;
+
+  // Other threads only enqueue while this thread sends, the loop picks their messages up.
+  while (connected && inFlight < maxInFlight) {
+    TopicQueue* queue = NextQueue();
+    if (!queue) break;
+
+    // A spooled message stays in the spool until the transport took it. Only this thread removes
+    // spooled messages, but others may drop them when the spool is full.
+    bool spooled = queue->messages.empty();
+    Message message;
+    uint64_t spoolHead = 0;
+    if (spooled) {
+      spoolHead = queue->spool->Head();
+      queue->spool->Front(&replayPayload);
+      queue->replayBudget--;
+    } else {
+      message = std::move(queue->messages.front());
+      queue->messages.pop_front();
+    }
+    inFlight++;
+
+    lock.unlock();
+    bool sent = send(queue->topic, spooled ? replayPayload : message.payload, queue->qos,
+        queue->retain);
+    lock.lock();
+
+    if (sent) {
+      queue->sentBytes += spooled ? replayPayload.size() : message.payload.size();
+      if (spooled && queue->spool->Head() == spoolHead) queue->spool->Pop();
+      queue->sent++;
+      continue;
+    }
+
+    // The transport did not take the message, e.g. because the connection was just lost. It is
+    // sent again with the next event, unless a newer one replaced it.
+    if (inFlight > 0) inFlight--;
+    if (spooled)
+      queue->replayBudget++;
+    else if (queue->policy.dropPolicy == DropPolicy::LATEST_ONLY && !queue->messages.empty())
+      queue->dropped++;
+    else
+      queue->messages.push_front(std::move(message));
+    if (!retryPending) break;
+    retryPending = false;
+  }
+
+  dispatching = false;
+}
+
+void OutboundScheduler::AppendToSpool(TopicQueue& queue, const std::string& payload) {
+  size_t dropped;
+  if (!queue.spool->Append(payload, &dropped)) dropped++;
+  queue.dropped += dropped;
+}
+
+OutboundScheduler::TopicQueue* OutboundScheduler::NextQueue() {
+  TopicQueue* next = nullptr;
+  uint64_t nextQueueSequence = 0;
+  for (TopicQueue& queue : queues) {
+    // Spooled messages are older than all waiting messages of other topics.
+    uint64_t sequence;
+    if (!queue.messages.empty())
+      sequence = queue.messages.front().sequence;
+    else if (queue.spool && queue.replayBudget > 0 && !queue.spool->Empty())
+      sequence = 0;
+    else
+      continue;
+
+    if (!next || queue.policy.priority > next->policy.priority ||
+        (queue.policy.priority == next->policy.priority && sequence < nextQueueSequence)) {
+      next = &queue;
+      nextQueueSequence = sequence;
+    }
+  }
+  return next;
+}
+
+}  // namespace mqtt_bridge
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "mqtt_bridge/spool.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace mqtt_bridge {
+
+namespace {
+
+constexpr uint32_t SPOOL_MAGIC = 0x4c4f5053;  // "SPOL"
+constexpr uint32_t SPOOL_VERSION = 1;
+
+/** Size of the record header: payload size and checksum. */
+constexpr uint64_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+/**
+ * FNV-1a checksum of a payload, detects records that were only partly written.
+ */
+uint32_t Checksum(const char* data, size_t size) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+size_t CheckCapacity(size_t capacity) {
+  if (capacity <= RECORD_HEADER_SIZE)
+    throw std::runtime_error("Spool capacity must be larger than " +
+                             std::to_string(RECORD_HEADER_SIZE) + " bytes");
+  return capacity;
+}
+
+}  // namespace
+
+Spool::Spool(const std::string& path, size_t capacity)
+    : file(path, sizeof(Header) + CheckCapacity(capacity)),
+      header(reinterpret_cast<Header*>(file.Data())),
+      ring(file.Data() + sizeof(Header)),
+      capacity(capacity) {
+  Recover();
+}
+
+bool Spool::Append(const std::string& payload, size_t* dropped) {
+  *dropped = 0;
+  uint64_t recordSize = RECORD_HEADER_SIZE + payload.size();
+  if (recordSize > capacity) return false;
+
+  // The head moves before the dropped records are overwritten, so a crash never leaves the head
+  // on a partly overwritten record.
+  while (header->tail - header->head + recordSize > capacity) {
+    Pop();
+    (*dropped)++;
+  }
+
+  uint32_t record[2] = {
+      static_cast<uint32_t>(payload.size()), Checksum(payload.data(), payload.size())};
+  Write(header->tail, record, sizeof(record));
+  Write(header->tail + RECORD_HEADER_SIZE, payload.data(), payload.size());
+
+  // The record only becomes visible once it is written completely.
+  header->tail += recordSize;
+  header->count++;
+  dirty = true;
+  return true;
+}
+
+bool Spool::Front(std::string* payload) const {
+  if (Empty()) return false;
+  payload->resize(RecordSize(header->head));
+  if (!payload->empty())
+    Read(header->head + RECORD_HEADER_SIZE, &(*payload)[0], payload->size());
+  return true;
+}
+
+void Spool::Pop() {
+  if (Empty()) return;
+  header->head += RECORD_HEADER_SIZE + RecordSize(header->head);
+  header->count--;
+}
+
+uint64_t Spool::Head() const { return header->head; }
+
+bool Spool::Empty() const { return header->count == 0; }
+
+size_t Spool::Size() const { return header->count; }
+
+void Spool::Sync() {
+  if (!dirty) return;
+  file.Sync();
+  dirty = false;
+}
+
+void Spool::Recover() {
+  if (header->magic != SPOOL_MAGIC || header->version != SPOOL_VERSION ||
+      header->capacity != capacity || header->head > header->tail ||
+      header->tail - header->head > capacity) {
+    header->magic = SPOOL_MAGIC;
+    header->version = SPOOL_VERSION;
+    header->capacity = capacity;
+    header->head = 0;
+    header->tail = 0;
+    header->count = 0;
+    return;
+  }
+
+  // Walk the records and keep the ones before the first damaged one.
+  std::string payload;
+  uint64_t position = header->head;
+  uint64_t count = 0;
+  while (header->tail - position >= RECORD_HEADER_SIZE) {
+    uint32_t record[2];
+    Read(position, record, sizeof(record));
+    if (record[0] > header->tail - position - RECORD_HEADER_SIZE) break;
+
+    payload.resize(record[0]);
+    if (!payload.empty()) Read(position + RECORD_HEADER_SIZE, &payload[0], payload.size());
+    if (Checksum(payload.data(), payload.size()) != record[1]) break;
+
+    position += RECORD_HEADER_SIZE + record[0];
+    count++;
+  }
+  header->tail = position;
+  header->count = count;
+}
+
+void Spool::Read(uint64_t position, void* data, size_t size) const {
+  size_t offset = position % capacity;
+  size_t first = std::min<size_t>(size, capacity - offset);
+  std::memcpy(data, ring + offset, first);
+  std::memcpy(static_cast<char*>(data) + first, ring, size - first);
+}
+
+void Spool::Write(uint64_t position, const void* data, size_t size) {
+  size_t offset = position % capacity;
+  size_t first = std::min<size_t>(size, capacity - offset);
+  std::memcpy(ring + offset, data, first);
+  std::memcpy(ring, static_cast<const char*>(data) + first, size - first);
+}
+
+uint32_t Spool::RecordSize(uint64_t position) const {
+  uint32_t size;
+  Read(position, &size, sizeof(size));
+  return size;
+}
+
+}  // namespace mqtt_bridge
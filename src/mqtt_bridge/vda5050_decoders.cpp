@@ -0,0 +1,1086 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "mqtt_bridge/vda5050_decoders.h"
+#include <limits>
+#include <vector>
+
+namespace mqtt_bridge {
+
+namespace {
+
+template <typename M>
+struct Decoder;
+
+template <typename M>
+void Read(JsonReader& r, M& msg) {
+  Decoder<M>::Decode(r, msg);
+}
+
+void Read(JsonReader& r, std::string& value) {
+  if (!r.PeekString()) r.Fail(DecodeError::UNEXPECTED_TYPE, "Expected a string");
+  r.ReadString(value);
+}
+
+void Read(JsonReader& r, double& value) { value = r.ReadDouble(); }
+
+void Read(JsonReader& r, bool& value) { value = r.ReadBool(); }
+
+void Read(JsonReader& r, uint32_t& value) {
+  value = static_cast<uint32_t>(r.ReadInt(0, std::numeric_limits<uint32_t>::max()));
+}
+
+void Read(JsonReader& r, int8_t& value) {
+  value = static_cast<int8_t>(
+      r.ReadInt(std::numeric_limits<int8_t>::min(), std::numeric_limits<int8_t>::max()));
+}
+
+void Read(JsonReader& r, uint8_t& value) {
+  // Bool fields of ROS messages are stored as uint8_t.
+  if (r.PeekBool())
+    value = r.ReadBool();
+  else
+    value = static_cast<uint8_t>(r.ReadInt(0, std::numeric_limits<uint8_t>::max()));
+}
+
+template <typename T>
+void Read(JsonReader& r, std::vector<T>& values) {
+  // Elements are decoded into the existing ones, so they keep the capacity of their strings.
+  size_t size = 0;
+  r.BeginArray();
+  while (r.NextElement()) {
+    if (size == values.size()) values.emplace_back();
+    Read(r, values[size++]);
+  }
+  values.resize(size);
+}
+
+template <typename M>
+void Clear(M& msg) {
+  Decoder<M>::Reset(msg);
+}
+
+void Clear(std::string& value) { value.clear(); }
+void Clear(double& value) { value = 0.0; }
+void Clear(bool& value) { value = false; }
+void Clear(uint32_t& value) { value = 0; }
+void Clear(int8_t& value) { value = 0; }
+void Clear(uint8_t& value) { value = 0; }
+
+template <typename T>
+void Clear(std::vector<T>& values) {
+  values.clear();
+}
+
+/**
+ * Reads the value of a member if the key matches.
+ *
+ * @param r      Reader positioned at the value.
+ * @param key    Key of the member.
+ * @param name   Key of the field.
+ * @param value  Field to fill.
+ * @param seen   Bit mask of the filled fields, bit is set unless the value is null.
+ * @param bit    Bit of the field.
+ *
+ * @return       True if the key matches.
+ */
+template <size_t N, typename T>
+bool Member(JsonReader& r, const JsonReader::Key& key, const char (&name)[N], T& value,
+    uint32_t& seen, int bit) {
+  if (!(key == name)) return false;
+  if (!r.ReadNull()) {
+    Read(r, value);
+    seen |= 1u << bit;
+  }
+  return true;
+}
+
+template <>
+struct Decoder<vda5050_msgs::ActionParameter> {
+  static void Decode(JsonReader& r, vda5050_msgs::ActionParameter& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "key", msg.key, seen, 0)) continue;
+      if (key == "value") {
+        // Parameter values may be of any JSON type, but are strings in the ROS message.
+        if (r.PeekString())
+          r.ReadString(msg.value);
+        else
+          r.ReadRaw(msg.value);
+        seen |= 1u << 1;
+        continue;
+      }
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.key);
+    if (!(seen & 1u << 1)) Clear(msg.value);
+  }
+
+  static void Reset(vda5050_msgs::ActionParameter& msg) {
+    Clear(msg.key);
+    Clear(msg.value);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::Action> {
+  static void Decode(JsonReader& r, vda5050_msgs::Action& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "actionType", msg.actionType, seen, 0)) continue;
+      if (Member(r, key, "actionId", msg.actionId, seen, 1)) continue;
+      if (Member(r, key, "actionDescription", msg.actionDescription, seen, 2)) continue;
+      if (Member(r, key, "blockingType", msg.blockingType, seen, 3)) continue;
+      if (Member(r, key, "actionParameters", msg.actionParameters, seen, 4)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.actionType);
+    if (!(seen & 1u << 1)) Clear(msg.actionId);
+    if (!(seen & 1u << 2)) Clear(msg.actionDescription);
+    if (!(seen & 1u << 3)) Clear(msg.blockingType);
+    if (!(seen & 1u << 4)) Clear(msg.actionParameters);
+  }
+
+  static void Reset(vda5050_msgs::Action& msg) {
+    Clear(msg.actionType);
+    Clear(msg.actionId);
+    Clear(msg.actionDescription);
+    Clear(msg.blockingType);
+    Clear(msg.actionParameters);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::ActionState> {
+  static void Decode(JsonReader& r, vda5050_msgs::ActionState& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "actionId", msg.actionId, seen, 0)) continue;
+      if (Member(r, key, "actionType", msg.actionType, seen, 1)) continue;
+      if (Member(r, key, "actionDescription", msg.actionDescription, seen, 2)) continue;
+      if (Member(r, key, "actionStatus", msg.actionStatus, seen, 3)) continue;
+      if (Member(r, key, "resultDescription", msg.resultDescription, seen, 4)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.actionId);
+    if (!(seen & 1u << 1)) Clear(msg.actionType);
+    if (!(seen & 1u << 2)) Clear(msg.actionDescription);
+    if (!(seen & 1u << 3)) Clear(msg.actionStatus);
+    if (!(seen & 1u << 4)) Clear(msg.resultDescription);
+  }
+
+  static void Reset(vda5050_msgs::ActionState& msg) {
+    Clear(msg.actionId);
+    Clear(msg.actionType);
+    Clear(msg.actionDescription);
+    Clear(msg.actionStatus);
+    Clear(msg.resultDescription);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::ControlPoint> {
+  static void Decode(JsonReader& r, vda5050_msgs::ControlPoint& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "x", msg.x, seen, 0)) continue;
+      if (Member(r, key, "y", msg.y, seen, 1)) continue;
+      if (Member(r, key, "weight", msg.weight, seen, 2)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.x);
+    if (!(seen & 1u << 1)) Clear(msg.y);
+    if (!(seen & 1u << 2)) Clear(msg.weight);
+  }
+
+  static void Reset(vda5050_msgs::ControlPoint& msg) {
+    Clear(msg.x);
+    Clear(msg.y);
+    Clear(msg.weight);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::Trajectory> {
+  static void Decode(JsonReader& r, vda5050_msgs::Trajectory& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "degree", msg.degree, seen, 0)) continue;
+      if (Member(r, key, "knotVector", msg.knotVector, seen, 1)) continue;
+      if (Member(r, key, "controlPoints", msg.controlPoints, seen, 2)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.degree);
+    if (!(seen & 1u << 1)) Clear(msg.knotVector);
+    if (!(seen & 1u << 2)) Clear(msg.controlPoints);
+  }
+
+  static void Reset(vda5050_msgs::Trajectory& msg) {
+    Clear(msg.degree);
+    Clear(msg.knotVector);
+    Clear(msg.controlPoints);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::NodePosition> {
+  static void Decode(JsonReader& r, vda5050_msgs::NodePosition& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "x", msg.x, seen, 0)) continue;
+      if (Member(r, key, "y", msg.y, seen, 1)) continue;
+      if (Member(r, key, "theta", msg.theta, seen, 2)) continue;
+      if (Member(r, key, "allowedDeviationXY", msg.allowedDeviationXY, seen, 3)) continue;
+      if (Member(r, key, "allowedDeviationTheta", msg.allowedDeviationTheta, seen, 4)) continue;
+      if (Member(r, key, "mapId", msg.mapId, seen, 5)) continue;
+      if (Member(r, key, "mapDescription", msg.mapDescription, seen, 6)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.x);
+    if (!(seen & 1u << 1)) Clear(msg.y);
+    if (!(seen & 1u << 2)) Clear(msg.theta);
+    if (!(seen & 1u << 3)) Clear(msg.allowedDeviationXY);
+    if (!(seen & 1u << 4)) Clear(msg.allowedDeviationTheta);
+    if (!(seen & 1u << 5)) Clear(msg.mapId);
+    if (!(seen & 1u << 6)) Clear(msg.mapDescription);
+  }
+
+  static void Reset(vda5050_msgs::NodePosition& msg) {
+    Clear(msg.x);
+    Clear(msg.y);
+    Clear(msg.theta);
+    Clear(msg.allowedDeviationXY);
+    Clear(msg.allowedDeviationTheta);
+    Clear(msg.mapId);
+    Clear(msg.mapDescription);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::Node> {
+  static void Decode(JsonReader& r, vda5050_msgs::Node& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "nodeId", msg.nodeId, seen, 0)) continue;
+      if (Member(r, key, "sequenceId", msg.sequenceId, seen, 1)) continue;
+      if (Member(r, key, "nodeDescription", msg.nodeDescription, seen, 2)) continue;
+      if (Member(r, key, "released", msg.released, seen, 3)) continue;
+      if (Member(r, key, "nodePosition", msg.nodePosition, seen, 4)) continue;
+      if (Member(r, key, "actions", msg.actions, seen, 5)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.nodeId);
+    if (!(seen & 1u << 1)) Clear(msg.sequenceId);
+    if (!(seen & 1u << 2)) Clear(msg.nodeDescription);
+    if (!(seen & 1u << 3)) Clear(msg.released);
+    if (!(seen & 1u << 4)) Clear(msg.nodePosition);
+    if (!(seen & 1u << 5)) Clear(msg.actions);
+  }
+
+  static void Reset(vda5050_msgs::Node& msg) {
+    Clear(msg.nodeId);
+    Clear(msg.sequenceId);
+    Clear(msg.nodeDescription);
+    Clear(msg.released);
+    Clear(msg.nodePosition);
+    Clear(msg.actions);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::Edge> {
+  static void Decode(JsonReader& r, vda5050_msgs::Edge& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "edgeId", msg.edgeId, seen, 0)) continue;
+      if (Member(r, key, "sequenceId", msg.sequenceId, seen, 1)) continue;
+      if (Member(r, key, "edgeDescription", msg.edgeDescription, seen, 2)) continue;
+      if (Member(r, key, "released", msg.released, seen, 3)) continue;
+      if (Member(r, key, "startNodeId", msg.startNodeId, seen, 4)) continue;
+      if (Member(r, key, "endNodeId", msg.endNodeId, seen, 5)) continue;
+      if (Member(r, key, "maxSpeed", msg.maxSpeed, seen, 6)) continue;
+      if (Member(r, key, "maxHeight", msg.maxHeight, seen, 7)) continue;
+      if (Member(r, key, "minHeight", msg.minHeight, seen, 8)) continue;
+      if (Member(r, key, "orientation", msg.orientation, seen, 9)) continue;
+      if (Member(r, key, "orientationType", msg.orientationType, seen, 10)) continue;
+      if (Member(r, key, "direction", msg.direction, seen, 11)) continue;
+      if (Member(r, key, "rotationAllowed", msg.rotationAllowed, seen, 12)) continue;
+      if (Member(r, key, "maxRotationSpeed", msg.maxRotationSpeed, seen, 13)) continue;
+      if (Member(r, key, "trajectory", msg.trajectory, seen, 14)) continue;
+      if (Member(r, key, "length", msg.length, seen, 15)) continue;
+      if (Member(r, key, "actions", msg.actions, seen, 16)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.edgeId);
+    if (!(seen & 1u << 1)) Clear(msg.sequenceId);
+    if (!(seen & 1u << 2)) Clear(msg.edgeDescription);
+    if (!(seen & 1u << 3)) Clear(msg.released);
+    if (!(seen & 1u << 4)) Clear(msg.startNodeId);
+    if (!(seen & 1u << 5)) Clear(msg.endNodeId);
+    if (!(seen & 1u << 6)) Clear(msg.maxSpeed);
+    if (!(seen & 1u << 7)) Clear(msg.maxHeight);
+    if (!(seen & 1u << 8)) Clear(msg.minHeight);
+    if (!(seen & 1u << 9)) Clear(msg.orientation);
+    if (!(seen & 1u << 10)) Clear(msg.orientationType);
+    if (!(seen & 1u << 11)) Clear(msg.direction);
+    if (!(seen & 1u << 12)) Clear(msg.rotationAllowed);
+    if (!(seen & 1u << 13)) Clear(msg.maxRotationSpeed);
+    if (!(seen & 1u << 14)) Clear(msg.trajectory);
+    if (!(seen & 1u << 15)) Clear(msg.length);
+    if (!(seen & 1u << 16)) Clear(msg.actions);
+  }
+
+  static void Reset(vda5050_msgs::Edge& msg) {
+    Clear(msg.edgeId);
+    Clear(msg.sequenceId);
+    Clear(msg.edgeDescription);
+    Clear(msg.released);
+    Clear(msg.startNodeId);
+    Clear(msg.endNodeId);
+    Clear(msg.maxSpeed);
+    Clear(msg.maxHeight);
+    Clear(msg.minHeight);
+    Clear(msg.orientation);
+    Clear(msg.orientationType);
+    Clear(msg.direction);
+    Clear(msg.rotationAllowed);
+    Clear(msg.maxRotationSpeed);
+    Clear(msg.trajectory);
+    Clear(msg.length);
+    Clear(msg.actions);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::NodeState> {
+  static void Decode(JsonReader& r, vda5050_msgs::NodeState& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "nodeId", msg.nodeId, seen, 0)) continue;
+      if (Member(r, key, "sequenceId", msg.sequenceId, seen, 1)) continue;
+      if (Member(r, key, "nodeDescription", msg.nodeDescription, seen, 2)) continue;
+      if (Member(r, key, "nodePosition", msg.nodePosition, seen, 3)) continue;
+      if (Member(r, key, "released", msg.released, seen, 4)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.nodeId);
+    if (!(seen & 1u << 1)) Clear(msg.sequenceId);
+    if (!(seen & 1u << 2)) Clear(msg.nodeDescription);
+    if (!(seen & 1u << 3)) Clear(msg.nodePosition);
+    if (!(seen & 1u << 4)) Clear(msg.released);
+  }
+
+  static void Reset(vda5050_msgs::NodeState& msg) {
+    Clear(msg.nodeId);
+    Clear(msg.sequenceId);
+    Clear(msg.nodeDescription);
+    Clear(msg.nodePosition);
+    Clear(msg.released);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::EdgeState> {
+  static void Decode(JsonReader& r, vda5050_msgs::EdgeState& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "edgeId", msg.edgeId, seen, 0)) continue;
+      if (Member(r, key, "sequenceId", msg.sequenceId, seen, 1)) continue;
+      if (Member(r, key, "edgeDescription", msg.edgeDescription, seen, 2)) continue;
+      if (Member(r, key, "released", msg.released, seen, 3)) continue;
+      if (Member(r, key, "trajectory", msg.trajectory, seen, 4)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.edgeId);
+    if (!(seen & 1u << 1)) Clear(msg.sequenceId);
+    if (!(seen & 1u << 2)) Clear(msg.edgeDescription);
+    if (!(seen & 1u << 3)) Clear(msg.released);
+    if (!(seen & 1u << 4)) Clear(msg.trajectory);
+  }
+
+  static void Reset(vda5050_msgs::EdgeState& msg) {
+    Clear(msg.edgeId);
+    Clear(msg.sequenceId);
+    Clear(msg.edgeDescription);
+    Clear(msg.released);
+    Clear(msg.trajectory);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::AGVPosition> {
+  static void Decode(JsonReader& r, vda5050_msgs::AGVPosition& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "x", msg.x, seen, 0)) continue;
+      if (Member(r, key, "y", msg.y, seen, 1)) continue;
+      if (Member(r, key, "theta", msg.theta, seen, 2)) continue;
+      if (Member(r, key, "mapId", msg.mapId, seen, 3)) continue;
+      if (Member(r, key, "mapDescription", msg.mapDescription, seen, 4)) continue;
+      if (Member(r, key, "positionInitialized", msg.positionInitialized, seen, 5)) continue;
+      if (Member(r, key, "localizationScore", msg.localizationScore, seen, 6)) continue;
+      if (Member(r, key, "deviationRange", msg.deviationRange, seen, 7)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.x);
+    if (!(seen & 1u << 1)) Clear(msg.y);
+    if (!(seen & 1u << 2)) Clear(msg.theta);
+    if (!(seen & 1u << 3)) Clear(msg.mapId);
+    if (!(seen & 1u << 4)) Clear(msg.mapDescription);
+    if (!(seen & 1u << 5)) Clear(msg.positionInitialized);
+    if (!(seen & 1u << 6)) Clear(msg.localizationScore);
+    if (!(seen & 1u << 7)) Clear(msg.deviationRange);
+  }
+
+  static void Reset(vda5050_msgs::AGVPosition& msg) {
+    Clear(msg.x);
+    Clear(msg.y);
+    Clear(msg.theta);
+    Clear(msg.mapId);
+    Clear(msg.mapDescription);
+    Clear(msg.positionInitialized);
+    Clear(msg.localizationScore);
+    Clear(msg.deviationRange);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::Velocity> {
+  static void Decode(JsonReader& r, vda5050_msgs::Velocity& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "vx", msg.vx, seen, 0)) continue;
+      if (Member(r, key, "vy", msg.vy, seen, 1)) continue;
+      if (Member(r, key, "omega", msg.omega, seen, 2)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.vx);
+    if (!(seen & 1u << 1)) Clear(msg.vy);
+    if (!(seen & 1u << 2)) Clear(msg.omega);
+  }
+
+  static void Reset(vda5050_msgs::Velocity& msg) {
+    Clear(msg.vx);
+    Clear(msg.vy);
+    Clear(msg.omega);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::BoundingBoxReference> {
+  static void Decode(JsonReader& r, vda5050_msgs::BoundingBoxReference& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "x", msg.x, seen, 0)) continue;
+      if (Member(r, key, "y", msg.y, seen, 1)) continue;
+      if (Member(r, key, "z", msg.z, seen, 2)) continue;
+      if (Member(r, key, "theta", msg.theta, seen, 3)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.x);
+    if (!(seen & 1u << 1)) Clear(msg.y);
+    if (!(seen & 1u << 2)) Clear(msg.z);
+    if (!(seen & 1u << 3)) Clear(msg.theta);
+  }
+
+  static void Reset(vda5050_msgs::BoundingBoxReference& msg) {
+    Clear(msg.x);
+    Clear(msg.y);
+    Clear(msg.z);
+    Clear(msg.theta);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::LoadDimensions> {
+  static void Decode(JsonReader& r, vda5050_msgs::LoadDimensions& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "length", msg.length, seen, 0)) continue;
+      if (Member(r, key, "width", msg.width, seen, 1)) continue;
+      if (Member(r, key, "height", msg.height, seen, 2)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.length);
+    if (!(seen & 1u << 1)) Clear(msg.width);
+    if (!(seen & 1u << 2)) Clear(msg.height);
+  }
+
+  static void Reset(vda5050_msgs::LoadDimensions& msg) {
+    Clear(msg.length);
+    Clear(msg.width);
+    Clear(msg.height);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::Load> {
+  static void Decode(JsonReader& r, vda5050_msgs::Load& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "loadId", msg.loadId, seen, 0)) continue;
+      if (Member(r, key, "loadType", msg.loadType, seen, 1)) continue;
+      if (Member(r, key, "loadPosition", msg.loadPosition, seen, 2)) continue;
+      if (Member(r, key, "boundingBoxReference", msg.boundingBoxReference, seen, 3)) continue;
+      if (Member(r, key, "loadDimensions", msg.loadDimensions, seen, 4)) continue;
+      if (Member(r, key, "weight", msg.weight, seen, 5)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.loadId);
+    if (!(seen & 1u << 1)) Clear(msg.loadType);
+    if (!(seen & 1u << 2)) Clear(msg.loadPosition);
+    if (!(seen & 1u << 3)) Clear(msg.boundingBoxReference);
+    if (!(seen & 1u << 4)) Clear(msg.loadDimensions);
+    if (!(seen & 1u << 5)) Clear(msg.weight);
+  }
+
+  static void Reset(vda5050_msgs::Load& msg) {
+    Clear(msg.loadId);
+    Clear(msg.loadType);
+    Clear(msg.loadPosition);
+    Clear(msg.boundingBoxReference);
+    Clear(msg.loadDimensions);
+    Clear(msg.weight);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::BatteryState> {
+  static void Decode(JsonReader& r, vda5050_msgs::BatteryState& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "batteryCharge", msg.batteryCharge, seen, 0)) continue;
+      if (Member(r, key, "batteryVoltage", msg.batteryVoltage, seen, 1)) continue;
+      if (Member(r, key, "batteryHealth", msg.batteryHealth, seen, 2)) continue;
+      if (Member(r, key, "charging", msg.charging, seen, 3)) continue;
+      if (Member(r, key, "reach", msg.reach, seen, 4)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.batteryCharge);
+    if (!(seen & 1u << 1)) Clear(msg.batteryVoltage);
+    if (!(seen & 1u << 2)) Clear(msg.batteryHealth);
+    if (!(seen & 1u << 3)) Clear(msg.charging);
+    if (!(seen & 1u << 4)) Clear(msg.reach);
+  }
+
+  static void Reset(vda5050_msgs::BatteryState& msg) {
+    Clear(msg.batteryCharge);
+    Clear(msg.batteryVoltage);
+    Clear(msg.batteryHealth);
+    Clear(msg.charging);
+    Clear(msg.reach);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::ErrorReference> {
+  static void Decode(JsonReader& r, vda5050_msgs::ErrorReference& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "referenceKey", msg.referenceKey, seen, 0)) continue;
+      if (Member(r, key, "referenceValue", msg.referenceValue, seen, 1)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.referenceKey);
+    if (!(seen & 1u << 1)) Clear(msg.referenceValue);
+  }
+
+  static void Reset(vda5050_msgs::ErrorReference& msg) {
+    Clear(msg.referenceKey);
+    Clear(msg.referenceValue);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::Error> {
+  static void Decode(JsonReader& r, vda5050_msgs::Error& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "errorType", msg.errorType, seen, 0)) continue;
+      if (Member(r, key, "errorReferences", msg.errorReferences, seen, 1)) continue;
+      if (Member(r, key, "errorDescription", msg.errorDescription, seen, 2)) continue;
+      if (Member(r, key, "errorLevel", msg.errorLevel, seen, 3)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.errorType);
+    if (!(seen & 1u << 1)) Clear(msg.errorReferences);
+    if (!(seen & 1u << 2)) Clear(msg.errorDescription);
+    if (!(seen & 1u << 3)) Clear(msg.errorLevel);
+  }
+
+  static void Reset(vda5050_msgs::Error& msg) {
+    Clear(msg.errorType);
+    Clear(msg.errorReferences);
+    Clear(msg.errorDescription);
+    Clear(msg.errorLevel);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::InfoReference> {
+  static void Decode(JsonReader& r, vda5050_msgs::InfoReference& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "referenceKey", msg.referenceKey, seen, 0)) continue;
+      if (Member(r, key, "referenceValue", msg.referenceValue, seen, 1)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.referenceKey);
+    if (!(seen & 1u << 1)) Clear(msg.referenceValue);
+  }
+
+  static void Reset(vda5050_msgs::InfoReference& msg) {
+    Clear(msg.referenceKey);
+    Clear(msg.referenceValue);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::Info> {
+  static void Decode(JsonReader& r, vda5050_msgs::Info& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "infoType", msg.infoType, seen, 0)) continue;
+      if (Member(r, key, "infoReferences", msg.infoReferences, seen, 1)) continue;
+      if (Member(r, key, "infoDescription", msg.infoDescription, seen, 2)) continue;
+      if (Member(r, key, "infoLevel", msg.infoLevel, seen, 3)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.infoType);
+    if (!(seen & 1u << 1)) Clear(msg.infoReferences);
+    if (!(seen & 1u << 2)) Clear(msg.infoDescription);
+    if (!(seen & 1u << 3)) Clear(msg.infoLevel);
+  }
+
+  static void Reset(vda5050_msgs::Info& msg) {
+    Clear(msg.infoType);
+    Clear(msg.infoReferences);
+    Clear(msg.infoDescription);
+    Clear(msg.infoLevel);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::SafetyState> {
+  static void Decode(JsonReader& r, vda5050_msgs::SafetyState& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "eStop", msg.eStop, seen, 0)) continue;
+      if (Member(r, key, "fieldViolation", msg.fieldViolation, seen, 1)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.eStop);
+    if (!(seen & 1u << 1)) Clear(msg.fieldViolation);
+  }
+
+  static void Reset(vda5050_msgs::SafetyState& msg) {
+    Clear(msg.eStop);
+    Clear(msg.fieldViolation);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::InteractionZoneState> {
+  static void Decode(JsonReader& r, vda5050_msgs::InteractionZoneState& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "zoneId", msg.zoneId, seen, 0)) continue;
+      if (Member(r, key, "zoneStatus", msg.zoneStatus, seen, 1)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.zoneId);
+    if (!(seen & 1u << 1)) Clear(msg.zoneStatus);
+  }
+
+  static void Reset(vda5050_msgs::InteractionZoneState& msg) {
+    Clear(msg.zoneId);
+    Clear(msg.zoneStatus);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::State> {
+  static void Decode(JsonReader& r, vda5050_msgs::State& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "headerId", msg.headerId, seen, 0)) continue;
+      if (Member(r, key, "timestamp", msg.timestamp, seen, 1)) continue;
+      if (Member(r, key, "version", msg.version, seen, 2)) continue;
+      if (Member(r, key, "manufacturer", msg.manufacturer, seen, 3)) continue;
+      if (Member(r, key, "serialNumber", msg.serialNumber, seen, 4)) continue;
+      if (Member(r, key, "orderId", msg.orderId, seen, 5)) continue;
+      if (Member(r, key, "orderUpdateId", msg.orderUpdateId, seen, 6)) continue;
+      if (Member(r, key, "zoneSetId", msg.zoneSetId, seen, 7)) continue;
+      if (Member(r, key, "lastNodeId", msg.lastNodeId, seen, 8)) continue;
+      if (Member(r, key, "lastNodeSequenceId", msg.lastNodeSequenceId, seen, 9)) continue;
+      if (Member(r, key, "driving", msg.driving, seen, 10)) continue;
+      if (Member(r, key, "paused", msg.paused, seen, 11)) continue;
+      if (Member(r, key, "newBaseRequest", msg.newBaseRequest, seen, 12)) continue;
+      if (Member(r, key, "distanceSinceLastNode", msg.distanceSinceLastNode, seen, 13)) continue;
+      if (Member(r, key, "operatingMode", msg.operatingMode, seen, 14)) continue;
+      if (Member(r, key, "nodeStates", msg.nodeStates, seen, 15)) continue;
+      if (Member(r, key, "edgeStates", msg.edgeStates, seen, 16)) continue;
+      if (Member(r, key, "agvPosition", msg.agvPosition, seen, 17)) continue;
+      if (Member(r, key, "velocity", msg.velocity, seen, 18)) continue;
+      if (Member(r, key, "loads", msg.loads, seen, 19)) continue;
+      if (Member(r, key, "actionStates", msg.actionStates, seen, 20)) continue;
+      if (Member(r, key, "batteryState", msg.batteryState, seen, 21)) continue;
+      if (Member(r, key, "errors", msg.errors, seen, 22)) continue;
+      if (Member(r, key, "information", msg.information, seen, 23)) continue;
+      if (Member(r, key, "safetyState", msg.safetyState, seen, 24)) continue;
+      if (Member(r, key, "interactionZones", msg.interactionZones, seen, 25)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.headerId);
+    if (!(seen & 1u << 1)) Clear(msg.timestamp);
+    if (!(seen & 1u << 2)) Clear(msg.version);
+    if (!(seen & 1u << 3)) Clear(msg.manufacturer);
+    if (!(seen & 1u << 4)) Clear(msg.serialNumber);
+    if (!(seen & 1u << 5)) Clear(msg.orderId);
+    if (!(seen & 1u << 6)) Clear(msg.orderUpdateId);
+    if (!(seen & 1u << 7)) Clear(msg.zoneSetId);
+    if (!(seen & 1u << 8)) Clear(msg.lastNodeId);
+    if (!(seen & 1u << 9)) Clear(msg.lastNodeSequenceId);
+    if (!(seen & 1u << 10)) Clear(msg.driving);
+    if (!(seen & 1u << 11)) Clear(msg.paused);
+    if (!(seen & 1u << 12)) Clear(msg.newBaseRequest);
+    if (!(seen & 1u << 13)) Clear(msg.distanceSinceLastNode);
+    if (!(seen & 1u << 14)) Clear(msg.operatingMode);
+    if (!(seen & 1u << 15)) Clear(msg.nodeStates);
+    if (!(seen & 1u << 16)) Clear(msg.edgeStates);
+    if (!(seen & 1u << 17)) Clear(msg.agvPosition);
+    if (!(seen & 1u << 18)) Clear(msg.velocity);
+    if (!(seen & 1u << 19)) Clear(msg.loads);
+    if (!(seen & 1u << 20)) Clear(msg.actionStates);
+    if (!(seen & 1u << 21)) Clear(msg.batteryState);
+    if (!(seen & 1u << 22)) Clear(msg.errors);
+    if (!(seen & 1u << 23)) Clear(msg.information);
+    if (!(seen & 1u << 24)) Clear(msg.safetyState);
+    if (!(seen & 1u << 25)) Clear(msg.interactionZones);
+  }
+
+  static void Reset(vda5050_msgs::State& msg) {
+    Clear(msg.headerId);
+    Clear(msg.timestamp);
+    Clear(msg.version);
+    Clear(msg.manufacturer);
+    Clear(msg.serialNumber);
+    Clear(msg.orderId);
+    Clear(msg.orderUpdateId);
+    Clear(msg.zoneSetId);
+    Clear(msg.lastNodeId);
+    Clear(msg.lastNodeSequenceId);
+    Clear(msg.driving);
+    Clear(msg.paused);
+    Clear(msg.newBaseRequest);
+    Clear(msg.distanceSinceLastNode);
+    Clear(msg.operatingMode);
+    Clear(msg.nodeStates);
+    Clear(msg.edgeStates);
+    Clear(msg.agvPosition);
+    Clear(msg.velocity);
+    Clear(msg.loads);
+    Clear(msg.actionStates);
+    Clear(msg.batteryState);
+    Clear(msg.errors);
+    Clear(msg.information);
+    Clear(msg.safetyState);
+    Clear(msg.interactionZones);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::Visualization> {
+  static void Decode(JsonReader& r, vda5050_msgs::Visualization& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "headerId", msg.headerId, seen, 0)) continue;
+      if (Member(r, key, "timestamp", msg.timestamp, seen, 1)) continue;
+      if (Member(r, key, "version", msg.version, seen, 2)) continue;
+      if (Member(r, key, "manufacturer", msg.manufacturer, seen, 3)) continue;
+      if (Member(r, key, "serialNumber", msg.serialNumber, seen, 4)) continue;
+      if (Member(r, key, "agvPosition", msg.agvPosition, seen, 5)) continue;
+      if (Member(r, key, "velocity", msg.velocity, seen, 6)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.headerId);
+    if (!(seen & 1u << 1)) Clear(msg.timestamp);
+    if (!(seen & 1u << 2)) Clear(msg.version);
+    if (!(seen & 1u << 3)) Clear(msg.manufacturer);
+    if (!(seen & 1u << 4)) Clear(msg.serialNumber);
+    if (!(seen & 1u << 5)) Clear(msg.agvPosition);
+    if (!(seen & 1u << 6)) Clear(msg.velocity);
+  }
+
+  static void Reset(vda5050_msgs::Visualization& msg) {
+    Clear(msg.headerId);
+    Clear(msg.timestamp);
+    Clear(msg.version);
+    Clear(msg.manufacturer);
+    Clear(msg.serialNumber);
+    Clear(msg.agvPosition);
+    Clear(msg.velocity);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::Connection> {
+  static void Decode(JsonReader& r, vda5050_msgs::Connection& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "headerId", msg.headerId, seen, 0)) continue;
+      if (Member(r, key, "timestamp", msg.timestamp, seen, 1)) continue;
+      if (Member(r, key, "version", msg.version, seen, 2)) continue;
+      if (Member(r, key, "manufacturer", msg.manufacturer, seen, 3)) continue;
+      if (Member(r, key, "serialNumber", msg.serialNumber, seen, 4)) continue;
+      if (Member(r, key, "connectionState", msg.connectionState, seen, 5)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.headerId);
+    if (!(seen & 1u << 1)) Clear(msg.timestamp);
+    if (!(seen & 1u << 2)) Clear(msg.version);
+    if (!(seen & 1u << 3)) Clear(msg.manufacturer);
+    if (!(seen & 1u << 4)) Clear(msg.serialNumber);
+    if (!(seen & 1u << 5)) Clear(msg.connectionState);
+  }
+
+  static void Reset(vda5050_msgs::Connection& msg) {
+    Clear(msg.headerId);
+    Clear(msg.timestamp);
+    Clear(msg.version);
+    Clear(msg.manufacturer);
+    Clear(msg.serialNumber);
+    Clear(msg.connectionState);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::Order> {
+  static void Decode(JsonReader& r, vda5050_msgs::Order& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "headerId", msg.headerId, seen, 0)) continue;
+      if (Member(r, key, "timestamp", msg.timestamp, seen, 1)) continue;
+      if (Member(r, key, "version", msg.version, seen, 2)) continue;
+      if (Member(r, key, "manufacturer", msg.manufacturer, seen, 3)) continue;
+      if (Member(r, key, "serialNumber", msg.serialNumber, seen, 4)) continue;
+      if (Member(r, key, "orderId", msg.orderId, seen, 5)) continue;
+      if (Member(r, key, "orderUpdateId", msg.orderUpdateId, seen, 6)) continue;
+      if (Member(r, key, "nodes", msg.nodes, seen, 7)) continue;
+      if (Member(r, key, "edges", msg.edges, seen, 8)) continue;
+      if (Member(r, key, "zoneSetId", msg.zoneSetId, seen, 9)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.headerId);
+    if (!(seen & 1u << 1)) Clear(msg.timestamp);
+    if (!(seen & 1u << 2)) Clear(msg.version);
+    if (!(seen & 1u << 3)) Clear(msg.manufacturer);
+    if (!(seen & 1u << 4)) Clear(msg.serialNumber);
+    if (!(seen & 1u << 5)) Clear(msg.orderId);
+    if (!(seen & 1u << 6)) Clear(msg.orderUpdateId);
+    if (!(seen & 1u << 7)) Clear(msg.nodes);
+    if (!(seen & 1u << 8)) Clear(msg.edges);
+    if (!(seen & 1u << 9)) Clear(msg.zoneSetId);
+  }
+
+  static void Reset(vda5050_msgs::Order& msg) {
+    Clear(msg.headerId);
+    Clear(msg.timestamp);
+    Clear(msg.version);
+    Clear(msg.manufacturer);
+    Clear(msg.serialNumber);
+    Clear(msg.orderId);
+    Clear(msg.orderUpdateId);
+    Clear(msg.nodes);
+    Clear(msg.edges);
+    Clear(msg.zoneSetId);
+  }
+};
+
+template <>
+struct Decoder<vda5050_msgs::InstantAction> {
+  static void Decode(JsonReader& r, vda5050_msgs::InstantAction& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "headerId", msg.headerId, seen, 0)) continue;
+      if (Member(r, key, "timestamp", msg.timestamp, seen, 1)) continue;
+      if (Member(r, key, "version", msg.version, seen, 2)) continue;
+      if (Member(r, key, "manufacturer", msg.manufacturer, seen, 3)) continue;
+      if (Member(r, key, "serialNumber", msg.serialNumber, seen, 4)) continue;
+      if (Member(r, key, "actions", msg.actions, seen, 5)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.headerId);
+    if (!(seen & 1u << 1)) Clear(msg.timestamp);
+    if (!(seen & 1u << 2)) Clear(msg.version);
+    if (!(seen & 1u << 3)) Clear(msg.manufacturer);
+    if (!(seen & 1u << 4)) Clear(msg.serialNumber);
+    if (!(seen & 1u << 5)) Clear(msg.actions);
+  }
+
+  static void Reset(vda5050_msgs::InstantAction& msg) {
+    Clear(msg.headerId);
+    Clear(msg.timestamp);
+    Clear(msg.version);
+    Clear(msg.manufacturer);
+    Clear(msg.serialNumber);
+    Clear(msg.actions);
+  }
+};
+template <>
+struct Decoder<connector_utils::ZoneVertex> {
+  static void Decode(JsonReader& r, connector_utils::ZoneVertex& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "x", msg.x, seen, 0)) continue;
+      if (Member(r, key, "y", msg.y, seen, 1)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.x);
+    if (!(seen & 1u << 1)) Clear(msg.y);
+  }
+
+  static void Reset(connector_utils::ZoneVertex& msg) {
+    Clear(msg.x);
+    Clear(msg.y);
+  }
+};
+
+template <>
+struct Decoder<connector_utils::Zone> {
+  static void Decode(JsonReader& r, connector_utils::Zone& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "zoneId", msg.zoneId, seen, 0)) continue;
+      if (Member(r, key, "zoneType", msg.zoneType, seen, 1)) continue;
+      if (Member(r, key, "vertices", msg.vertices, seen, 2)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.zoneId);
+    if (!(seen & 1u << 1)) Clear(msg.zoneType);
+    if (!(seen & 1u << 2)) Clear(msg.vertices);
+  }
+
+  static void Reset(connector_utils::Zone& msg) {
+    Clear(msg.zoneId);
+    Clear(msg.zoneType);
+    Clear(msg.vertices);
+  }
+};
+
+template <>
+struct Decoder<connector_utils::ZoneSet> {
+  static void Decode(JsonReader& r, connector_utils::ZoneSet& msg) {
+    uint32_t seen = 0;
+    JsonReader::Key key;
+    r.BeginObject();
+    while (r.NextMember(key)) {
+      if (Member(r, key, "zoneSetId", msg.zoneSetId, seen, 0)) continue;
+      if (Member(r, key, "mapId", msg.mapId, seen, 1)) continue;
+      if (Member(r, key, "zones", msg.zones, seen, 2)) continue;
+      r.Skip();
+    }
+    if (!(seen & 1u << 0)) Clear(msg.zoneSetId);
+    if (!(seen & 1u << 1)) Clear(msg.mapId);
+    if (!(seen & 1u << 2)) Clear(msg.zones);
+  }
+};
+
+template <typename M>
+void DecodePayload(JsonReader& reader, const std::string& payload, M& msg) {
+  reader.Reset(payload);
+  Decoder<M>::Decode(reader, msg);
+  reader.Finish();
+}
+
+}  // namespace
+
+void Decode(JsonReader& reader, const std::string& payload, vda5050_msgs::State& msg) {
+  DecodePayload(reader, payload, msg);
+}
+
+void Decode(JsonReader& reader, const std::string& payload, vda5050_msgs::Visualization& msg) {
+  DecodePayload(reader, payload, msg);
+}
+
+void Decode(JsonReader& reader, const std::string& payload, vda5050_msgs::Connection& msg) {
+  DecodePayload(reader, payload, msg);
+}
+
+void Decode(JsonReader& reader, const std::string& payload, vda5050_msgs::Order& msg) {
+  DecodePayload(reader, payload, msg);
+}
+
+void Decode(JsonReader& reader, const std::string& payload, vda5050_msgs::InstantAction& msg) {
+  DecodePayload(reader, payload, msg);
+}
+
+void Decode(JsonReader& reader, const std::string& payload, connector_utils::ZoneSet& msg) {
+  DecodePayload(reader, payload, msg);
+}
+
+}  // namespace mqtt_bridge
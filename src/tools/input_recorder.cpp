@@ -0,0 +1,106 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+/**
+ * Records the inputs of a connector into an input log, see utils/input_log.h. All topics of the
+ * subscribe_topics in the private namespace are recorded, e.g. of config/vda5050_connector.yaml,
+ * optionally limited to the keys listed in topics. Messages are stored serialized together with
+ * their receipt time, so the input_replayer can feed them into a connector again.
+ *
+ * The log is closed and its index written on shutdown, or after the given duration.
+ */
+
+#include <ros/ros.h>
+#include <ros/serialization.h>
+#include <topic_tools/shape_shifter.h>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+#include "utils/input_log.h"
+
+using namespace connector_utils;
+
+/**
+ * Recorded topic. Topics are added to the log with their first message, as the message type is
+ * only known then.
+ */
+struct RecordedTopic {
+  std::string key;            /**< Key of the topic in subscribe_topics. */
+  std::string name;           /**< Subscribed topic. */
+  int id{-1};                 /**< Index of the topic in the log, -1 before the first message. */
+  ros::Subscriber subscriber; /**< Subscriber of the topic. */
+};
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "input_recorder");
+  ros::NodeHandle nh;
+  ros::NodeHandle privateNh("~");
+
+  std::string path;
+  double duration;
+  std::map<std::string, std::string> subscribeTopics;
+  std::vector<std::string> keys;
+  privateNh.param<std::string>("file", path, "vda5050_inputs.log");
+  privateNh.param<double>("duration", duration, 0.0);
+  if (!privateNh.getParam("subscribe_topics", subscribeTopics) || subscribeTopics.empty()) {
+    ROS_ERROR("%s/subscribe_topics not found in the configuration!",
+        privateNh.getNamespace().c_str());
+    return 1;
+  }
+  privateNh.getParam("topics", keys);
+
+  InputLogWriter log(path);
+  std::vector<uint8_t> buffer;
+  std::vector<RecordedTopic> topics;
+  topics.reserve(subscribeTopics.size());
+  for (const auto& topic : subscribeTopics) {
+    if (!keys.empty() && std::find(keys.begin(), keys.end(), topic.first) == keys.end()) continue;
+    topics.emplace_back();
+    topics.back().key = topic.first;
+    topics.back().name = topic.second;
+  }
+
+  // Callbacks are called by ros::spin on this thread only, so the log needs no lock.
+  for (RecordedTopic& topic : topics) {
+    RecordedTopic* recorded = &topic;
+    topic.subscriber = nh.subscribe<topic_tools::ShapeShifter>(topic.name, 1000,
+        boost::function<void(const ros::MessageEvent<topic_tools::ShapeShifter const>&)>(
+            [recorded, &log, &buffer](
+                const ros::MessageEvent<topic_tools::ShapeShifter const>& event) {
+              const topic_tools::ShapeShifter& message = *event.getConstMessage();
+              if (recorded->id < 0) {
+                recorded->id = log.AddTopic({recorded->key, recorded->name, message.getDataType(),
+                    message.getMD5Sum(), message.getMessageDefinition()});
+              }
+              buffer.resize(message.size());
+              ros::serialization::OStream stream(buffer.data(), buffer.size());
+              message.write(stream);
+              log.Write(recorded->id, event.getReceiptTime().toNSec(), buffer.data(),
+                  buffer.size());
+            }));
+  }
+  ROS_INFO("Recording %zu topics to %s", topics.size(), path.c_str());
+
+  ros::Timer stopTimer;
+  if (duration > 0.0) {
+    stopTimer = nh.createTimer(ros::Duration(duration),
+        boost::function<void(const ros::TimerEvent&)>(
+            [](const ros::TimerEvent&) { ros::shutdown(); }),
+        true);
+  }
+  ros::spin();
+
+  for (RecordedTopic& topic : topics) topic.subscriber.shutdown();
+  log.Close();
+  std::printf("Recorded %llu messages to %s\n",
+      static_cast<unsigned long long>(log.GetMessageCount()), path.c_str());
+  return 0;
+}
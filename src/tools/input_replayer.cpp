@@ -0,0 +1,294 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+/**
+ * Replays an input log of the input_recorder into a connector running in this process, and
+ * reports the throughput, the messages the connector sent and the latency of forwarded orders and
+ * instant actions. The connector is configured by the connector namespace below the private
+ * namespace, e.g. with config/vda5050_connector.yaml. All its topics are moved into the private
+ * namespace of the replayer, so a replay does not disturb a running system.
+ *
+ * The replay runs on simulated time: the ROS time of the process follows the receipt times of the
+ * log, at the given speed, or jumps from message to message if the speed is 0. All callbacks and
+ * timers of the connector are called on the replay thread between two messages, so every run of a
+ * log handles its messages in the same order and state. Only the timers of the connector depend on
+ * the simulated time and may fire in other places between runs.
+ */
+
+#include <ros/callback_queue.h>
+#include <ros/ros.h>
+#include <ros/serialization.h>
+#include <topic_tools/shape_shifter.h>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "utils/input_log.h"
+#include "utils/tracer.h"
+#include "vda5050_connector/vda5050_connector.h"
+
+using namespace connector_utils;
+
+/**
+ * Topic of the log, published to the connector.
+ */
+struct ReplayedTopic {
+  std::string name;                  /**< Topic in the namespace of the replayer. */
+  topic_tools::ShapeShifter message; /**< Message of the type of the topic, refilled per message. */
+  ros::Publisher publisher;          /**< Publisher, invalid if the connector does not subscribe. */
+  uint64_t sent{0};                  /**< Number of replayed messages. */
+};
+
+/**
+ * Topics the connector publishes to, counted to see how it reacted.
+ */
+enum Output {
+  FORWARDED_ORDER,
+  FORWARDED_INSTANT_ACTION,
+  STATE,
+  VISUALIZATION,
+  CONNECTION,
+  OUTPUT_COUNT
+};
+
+const char* OUTPUT_KEYS[OUTPUT_COUNT] = {
+    "order", "instant_action", "state", "visualization", "connection"};
+
+/**
+ * Outputs of the connector and the latency of the forwarded messages. Orders and instant actions
+ * are recognized by their header ID and timestamp, which the connector does not change.
+ */
+struct Outputs {
+  uint64_t received[OUTPUT_COUNT]{}; /**< Number of received messages per output. */
+
+  std::unordered_map<std::string, double> sent; /**< Send times of orders and instant actions. */
+
+  LatencyHistogram latencies[2]; /**< Latencies of forwarded orders and instant actions. */
+
+  void Sent(const std::string& key, double time) { sent[key] = time; }
+
+  void Received(Output output, const std::string& key, double time) {
+    received[output]++;
+    auto message = sent.find(key);
+    if (message == sent.end()) return;
+    latencies[output].Record(static_cast<uint64_t>((time - message->second) * 1e9));
+    sent.erase(message);
+  }
+};
+
+double SteadySeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string HeaderKey(uint32_t headerId, const std::string& timestamp) {
+  return std::to_string(headerId) + "/" + timestamp;
+}
+
+void SetSimTime(int64_t nanoseconds) { ros::Time::setNow(ros::Time().fromNSec(nanoseconds)); }
+
+/**
+ * Calls the callbacks of the connector until all messages sent meanwhile are handled.
+ */
+void Drain(ros::CallbackQueue& queue) {
+  for (int round = 0; round < 100 && !queue.isEmpty(); round++) queue.callAvailable();
+}
+
+/**
+ * Reads the header of a serialized order or instant action.
+ */
+template <typename M>
+std::string LoggedHeaderKey(std::vector<uint8_t>& data) {
+  M message;
+  ros::serialization::IStream stream(data.data(), data.size());
+  ros::serialization::deserialize(stream, message);
+  return HeaderKey(message.headerId, message.timestamp);
+}
+
+template <typename M>
+ros::Subscriber Count(ros::NodeHandle& nh, const std::string& topic, Outputs* outputs,
+    Output output) {
+  return nh.subscribe<M>(topic, 1000,
+      boost::function<void(const boost::shared_ptr<M const>&)>(
+          [outputs, output](const boost::shared_ptr<M const>&) { outputs->received[output]++; }));
+}
+
+template <typename M>
+ros::Subscriber Match(ros::NodeHandle& nh, const std::string& topic, Outputs* outputs,
+    Output output) {
+  return nh.subscribe<M>(topic, 1000,
+      boost::function<void(const boost::shared_ptr<M const>&)>(
+          [outputs, output](const boost::shared_ptr<M const>& message) {
+            outputs->Received(
+                output, HeaderKey(message->headerId, message->timestamp), SteadySeconds());
+          }));
+}
+
+void PrintLatency(const char* name, LatencyHistogram& histogram) {
+  LatencyHistogram::Snapshot snapshot = histogram.Take();
+  if (snapshot.count == 0) return;
+  std::printf("%-16s %8llu %10.1f %10.1f %10.1f %10.1f\n", name,
+      static_cast<unsigned long long>(snapshot.count), snapshot.Percentile(0.5) / 1e3,
+      snapshot.Percentile(0.9) / 1e3, snapshot.Percentile(0.99) / 1e3, snapshot.max / 1e3);
+}
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "input_replayer");
+  ros::NodeHandle privateNh("~");
+
+  std::string path;
+  double speed, start, duration;
+  privateNh.param<std::string>("file", path, "vda5050_inputs.log");
+  privateNh.param<double>("speed", speed, 1.0);
+  privateNh.param<double>("start", start, 0.0);
+  privateNh.param<double>("duration", duration, 0.0);
+
+  InputLogReader log(path);
+  int64_t firstTime = log.GetStartTime() + static_cast<int64_t>(start * 1e9);
+  int64_t lastTime = duration > 0.0 ? firstTime + static_cast<int64_t>(duration * 1e9)
+                                    : std::numeric_limits<int64_t>::max();
+  log.Seek(firstTime);
+  std::printf("%s: %llu messages of %zu topics over %.1f s%s\n", path.c_str(),
+      static_cast<unsigned long long>(log.GetMessageCount()), log.GetTopics().size(),
+      (log.GetEndTime() - log.GetStartTime()) / 1e9, log.IsIndexed() ? "" : ", not indexed");
+
+  // All topics of the connector are moved into the namespace of the replayer.
+  ros::NodeHandle connectorPrivateNh(privateNh, "connector");
+  std::map<std::string, std::string> subscribeTopics, publishTopics;
+  connectorPrivateNh.getParam("subscribe_topics", subscribeTopics);
+  connectorPrivateNh.getParam("publish_topics", publishTopics);
+  ros::M_string remappings;
+  const std::string ns = ros::this_node::getName().substr(1);
+  for (const auto& topic : subscribeTopics)
+    remappings[topic.second] = NamespacedTopic(ns, topic.second);
+  for (const auto& topic : publishTopics)
+    remappings[topic.second] = NamespacedTopic(ns, topic.second);
+
+  // The connector starts at the simulated time of the first message, so its timers are aligned
+  // with the log.
+  SetSimTime(firstTime);
+  ros::CallbackQueue queue;
+  ros::NodeHandle nh("", remappings);
+  nh.setCallbackQueue(&queue);
+  VDA5050Connector connector(nh, connectorPrivateNh);
+
+  Outputs outputs;
+  std::vector<ros::Subscriber> subscribers;
+  for (int o = 0; o < OUTPUT_COUNT; o++) {
+    auto topic = publishTopics.find(OUTPUT_KEYS[o]);
+    if (topic == publishTopics.end()) continue;
+    switch (o) {
+      case FORWARDED_ORDER:
+        subscribers.push_back(
+            Match<vda5050_msgs::Order>(nh, topic->second, &outputs, FORWARDED_ORDER));
+        break;
+      case FORWARDED_INSTANT_ACTION:
+        subscribers.push_back(Match<vda5050_msgs::InstantAction>(
+            nh, topic->second, &outputs, FORWARDED_INSTANT_ACTION));
+        break;
+      case STATE:
+        subscribers.push_back(Count<vda5050_msgs::State>(nh, topic->second, &outputs, STATE));
+        break;
+      case VISUALIZATION:
+        subscribers.push_back(
+            Count<vda5050_msgs::Visualization>(nh, topic->second, &outputs, VISUALIZATION));
+        break;
+      case CONNECTION:
+        subscribers.push_back(
+            Count<vda5050_msgs::Connection>(nh, topic->second, &outputs, CONNECTION));
+        break;
+    }
+  }
+
+  // Logged topics are published on the topic the connector uses for their key, which may differ
+  // from the recorded one.
+  std::vector<ReplayedTopic> topics(log.GetTopics().size());
+  for (size_t t = 0; t < topics.size(); t++) {
+    const LoggedTopic& logged = log.GetTopics()[t];
+    auto topic = subscribeTopics.find(logged.key);
+    if (topic == subscribeTopics.end()) {
+      ROS_WARN("The connector does not subscribe %s, its messages are skipped", logged.key.c_str());
+      continue;
+    }
+    topics[t].name = topic->second;
+    topics[t].message.morph(logged.md5sum, logged.datatype, logged.definition, "false");
+    topics[t].publisher = topics[t].message.advertise(nh, topic->second, 1000);
+  }
+
+  // Subscriptions inside the process are connected by the master, which takes a moment.
+  double connectDeadline = SteadySeconds() + 5.0;
+  for (const ReplayedTopic& topic : topics) {
+    while (topic.publisher && topic.publisher.getNumSubscribers() == 0 &&
+           SteadySeconds() < connectDeadline && ros::ok())
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (topic.publisher && topic.publisher.getNumSubscribers() == 0)
+      ROS_WARN("The connector did not connect to %s", topic.name.c_str());
+  }
+
+  const double wallStart = SteadySeconds();
+  LoggedMessage message;
+  uint64_t replayed = 0;
+  int64_t simTime = firstTime;
+  while (ros::ok() && log.Next(&message) && message.time <= lastTime) {
+    // While waiting for the next message, the simulated time follows the wall clock, so the
+    // timers of the connector fire in between.
+    if (speed > 0.0) {
+      double due = wallStart + (message.time - firstTime) / 1e9 / speed;
+      for (double now = SteadySeconds(); now < due && ros::ok(); now = SteadySeconds()) {
+        auto elapsed = static_cast<int64_t>((now - wallStart) * speed * 1e9);
+        SetSimTime(std::max(simTime, firstTime + elapsed));
+        Drain(queue);
+        std::this_thread::sleep_for(std::chrono::duration<double>(std::min(due - now, 0.01)));
+      }
+    }
+    simTime = std::max(simTime, message.time);
+    SetSimTime(simTime);
+
+    ReplayedTopic& topic = topics[message.topic];
+    if (!topic.publisher) continue;
+    const std::string& key = log.GetTopics()[message.topic].key;
+    if (key == "order_from_mc")
+      outputs.Sent(LoggedHeaderKey<vda5050_msgs::Order>(message.data), SteadySeconds());
+    else if (key == "ia_from_mc")
+      outputs.Sent(LoggedHeaderKey<vda5050_msgs::InstantAction>(message.data), SteadySeconds());
+
+    ros::serialization::IStream stream(message.data.data(), message.data.size());
+    topic.message.read(stream);
+    topic.publisher.publish(topic.message);
+    topic.sent++;
+    replayed++;
+    Drain(queue);
+  }
+  double wallSeconds = SteadySeconds() - wallStart;
+  double simSeconds = (simTime - firstTime) / 1e9;
+
+  std::printf("--- replayed %llu messages in %.3f s, %.1f messages/s, %.1f s simulated (%.1fx)\n",
+      static_cast<unsigned long long>(replayed), wallSeconds, replayed / wallSeconds, simSeconds,
+      wallSeconds > 0.0 ? simSeconds / wallSeconds : 0.0);
+  std::printf("%-24s %10s\n", "input", "messages");
+  for (size_t t = 0; t < topics.size(); t++) {
+    std::printf("%-24s %10llu\n", log.GetTopics()[t].key.c_str(),
+        static_cast<unsigned long long>(topics[t].sent));
+  }
+  std::printf("%-24s %10s\n", "output", "messages");
+  for (int o = 0; o < OUTPUT_COUNT; o++) {
+    std::printf("%-24s %10llu\n", OUTPUT_KEYS[o],
+        static_cast<unsigned long long>(outputs.received[o]));
+  }
+  std::printf("%-16s %8s %10s %10s %10s %10s\n", "latency [us]", "count", "p50", "p90", "p99",
+      "max");
+  PrintLatency("order", outputs.latencies[FORWARDED_ORDER]);
+  PrintLatency("instant_action", outputs.latencies[FORWARDED_INSTANT_ACTION]);
+  std::printf("orders and instant actions not forwarded: %zu\n", outputs.sent.size());
+  std::fflush(stdout);
+  return 0;
+}
@@ -0,0 +1,55 @@
+#include "utils/deadline_scheduler.h"
+
+namespace connector_utils {
+
+void DeadlineScheduler::Arm(const std::string& key, const ros::Time& deadline) {
+  uint64_t generation = nextGeneration++;
+  armed[key] = generation;
+  heap.push({deadline, generation, key});
+
+  // Rebuild the heap if it mostly consists of stale entries.
+  if (heap.size() > 2 * armed.size() + 16) {
+    std::vector<Entry> valid;
+    valid.reserve(armed.size());
+    while (!heap.empty()) {
+      if (!IsStale(heap.top())) valid.push_back(heap.top());
+      heap.pop();
+    }
+    heap = std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>(
+        std::greater<Entry>(), std::move(valid));
+  }
+}
+
+bool DeadlineScheduler::Disarm(const std::string& key) { return armed.erase(key) > 0; }
+
+bool DeadlineScheduler::IsArmed(const std::string& key) const { return armed.count(key) > 0; }
+
+boost::optional<ros::Time> DeadlineScheduler::NextDeadline() {
+  DropStaleEntries();
+  if (heap.empty()) return boost::none;
+  return heap.top().deadline;
+}
+
+std::vector<std::string> DeadlineScheduler::PopExpired(const ros::Time& now) {
+  std::vector<std::string> expired;
+
+  DropStaleEntries();
+  while (!heap.empty() && heap.top().deadline <= now) {
+    expired.push_back(heap.top().key);
+    armed.erase(heap.top().key);
+    heap.pop();
+    DropStaleEntries();
+  }
+  return expired;
+}
+
+void DeadlineScheduler::DropStaleEntries() {
+  while (!heap.empty() && IsStale(heap.top())) heap.pop();
+}
+
+bool DeadlineScheduler::IsStale(const Entry& entry) const {
+  auto it = armed.find(entry.key);
+  return it == armed.end() || it->second != entry.generation;
+}
+
+}  // namespace connector_utils
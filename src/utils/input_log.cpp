@@ -0,0 +1,372 @@
+#include "utils/input_log.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace connector_utils {
+
+namespace {
+
+constexpr uint32_t LOG_MAGIC = 0x4c494456;    // "VDIL"
+constexpr uint32_t INDEX_MAGIC = 0x58494456;  // "VDIX"
+constexpr uint32_t LOG_VERSION = 1;
+
+/** Size of the file header: magic and version. */
+constexpr uint64_t FILE_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+/** Size of the record header: kind, body size and checksum. */
+constexpr uint64_t RECORD_HEADER_SIZE = sizeof(uint8_t) + 2 * sizeof(uint32_t);
+
+/** Size of the body of a message record before the message: topic and receipt time. */
+constexpr uint64_t MESSAGE_PREFIX_SIZE = sizeof(uint16_t) + sizeof(int64_t);
+
+/** Size of the trailer: position of the index record and magic. */
+constexpr uint64_t TRAILER_SIZE = sizeof(uint64_t) + sizeof(uint32_t);
+
+/** Receipt time between two positions found by scanning a log without index. */
+constexpr int64_t SCAN_INDEX_INTERVAL = 1000000000;
+
+enum RecordKind : uint8_t { TOPIC_RECORD = 1, MESSAGE_RECORD = 2, INDEX_RECORD = 3 };
+
+/**
+ * FNV-1a checksum, continued from the given hash, detects records that were only partly written.
+ */
+uint32_t Checksum(uint32_t hash, const void* data, size_t size) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+constexpr uint32_t CHECKSUM_SEED = 2166136261u;
+
+template <typename T>
+void Append(std::vector<uint8_t>* body, T value) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+  body->insert(body->end(), bytes, bytes + sizeof(value));
+}
+
+void AppendString(std::vector<uint8_t>* body, const std::string& value) {
+  Append<uint32_t>(body, value.size());
+  body->insert(body->end(), value.begin(), value.end());
+}
+
+/**
+ * Reads the values of a record body, throws std::runtime_error past its end.
+ */
+class BodyReader {
+ public:
+  explicit BodyReader(const std::vector<uint8_t>& body) : body(body) {}
+
+  template <typename T>
+  T Read() {
+    T value;
+    Take(&value, sizeof(value));
+    return value;
+  }
+
+  std::string ReadString() {
+    std::string value(Read<uint32_t>(), '\0');
+    if (!value.empty()) Take(&value[0], value.size());
+    return value;
+  }
+
+  LoggedTopic ReadTopic() {
+    LoggedTopic topic;
+    topic.key = ReadString();
+    topic.name = ReadString();
+    topic.datatype = ReadString();
+    topic.md5sum = ReadString();
+    topic.definition = ReadString();
+    return topic;
+  }
+
+ private:
+  const std::vector<uint8_t>& body;
+  size_t position{0};
+
+  void Take(void* data, size_t size) {
+    if (size > body.size() - position) throw std::runtime_error("Truncated input log record");
+    std::memcpy(data, body.data() + position, size);
+    position += size;
+  }
+};
+
+void AppendTopic(std::vector<uint8_t>* body, const LoggedTopic& topic) {
+  AppendString(body, topic.key);
+  AppendString(body, topic.name);
+  AppendString(body, topic.datatype);
+  AppendString(body, topic.md5sum);
+  AppendString(body, topic.definition);
+}
+
+[[noreturn]] void ThrowError(const std::string& what, const std::string& path) {
+  throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+InputLogWriter::InputLogWriter(const std::string& path, int64_t indexInterval)
+    : path(path), indexInterval(std::max<int64_t>(indexInterval, 1)) {
+  file = std::fopen(path.c_str(), "wb");
+  if (!file) ThrowError("Cannot create", path);
+  uint32_t header[2] = {LOG_MAGIC, LOG_VERSION};
+  Put(header, sizeof(header));
+}
+
+InputLogWriter::~InputLogWriter() {
+  try {
+    Close();
+  } catch (const std::runtime_error&) {
+    if (file) std::fclose(file);
+  }
+}
+
+uint16_t InputLogWriter::AddTopic(const LoggedTopic& topic) {
+  if (topics.size() > UINT16_MAX) throw std::runtime_error("Too many topics in " + path);
+  auto id = static_cast<uint16_t>(topics.size());
+  topics.push_back(topic);
+  topicCounts.push_back(0);
+
+  body.clear();
+  Append<uint16_t>(&body, id);
+  AppendTopic(&body, topic);
+  PutRecord(TOPIC_RECORD);
+  return id;
+}
+
+void InputLogWriter::Write(uint16_t topic, int64_t time, const uint8_t* data, uint32_t size) {
+  if (topic >= topics.size()) throw std::runtime_error("Unknown topic in " + path);
+
+  if (messageCount == 0 || (time >= endTime && time >= index.back().time + indexInterval))
+    index.push_back({time, offset});
+  if (messageCount == 0) startTime = time;
+  endTime = std::max(endTime, time);
+  topicCounts[topic]++;
+  messageCount++;
+
+  // The message is written behind its prefix without being copied into the body.
+  body.clear();
+  Append<uint16_t>(&body, topic);
+  Append<int64_t>(&body, time);
+  uint8_t kind = MESSAGE_RECORD;
+  uint32_t header[2] = {static_cast<uint32_t>(body.size() + size),
+      Checksum(Checksum(CHECKSUM_SEED, body.data(), body.size()), data, size)};
+  Put(&kind, sizeof(kind));
+  Put(header, sizeof(header));
+  Put(body.data(), body.size());
+  Put(data, size);
+}
+
+void InputLogWriter::Close() {
+  if (!file) return;
+
+  uint64_t indexOffset = offset;
+  body.clear();
+  Append<uint16_t>(&body, topics.size());
+  for (size_t i = 0; i < topics.size(); i++) {
+    AppendTopic(&body, topics[i]);
+    Append<uint64_t>(&body, topicCounts[i]);
+  }
+  Append<uint64_t>(&body, messageCount);
+  Append<int64_t>(&body, startTime);
+  Append<int64_t>(&body, endTime);
+  Append<uint32_t>(&body, index.size());
+  for (const IndexEntry& entry : index) {
+    Append<int64_t>(&body, entry.time);
+    Append<uint64_t>(&body, entry.offset);
+  }
+  PutRecord(INDEX_RECORD);
+  uint32_t magic = INDEX_MAGIC;
+  Put(&indexOffset, sizeof(indexOffset));
+  Put(&magic, sizeof(magic));
+
+  FILE* closed = file;
+  file = nullptr;
+  if (std::fclose(closed) != 0) ThrowError("Cannot close", path);
+}
+
+void InputLogWriter::Put(const void* data, size_t size) {
+  if (!file) throw std::runtime_error("Input log " + path + " is closed");
+  if (size > 0 && std::fwrite(data, size, 1, file) != 1) ThrowError("Cannot write", path);
+  offset += size;
+}
+
+void InputLogWriter::PutRecord(uint8_t kind) {
+  uint32_t header[2] = {
+      static_cast<uint32_t>(body.size()), Checksum(CHECKSUM_SEED, body.data(), body.size())};
+  Put(&kind, sizeof(kind));
+  Put(header, sizeof(header));
+  Put(body.data(), body.size());
+}
+
+InputLogReader::InputLogReader(const std::string& path) {
+  file = std::fopen(path.c_str(), "rb");
+  if (!file) ThrowError("Cannot open", path);
+
+  uint32_t header[2];
+  if (!Get(header, sizeof(header)) || header[0] != LOG_MAGIC) {
+    std::fclose(file);
+    throw std::runtime_error(path + " is not an input log");
+  }
+  if (header[1] != LOG_VERSION) {
+    std::fclose(file);
+    throw std::runtime_error(
+        path + " is an input log of the unsupported version " + std::to_string(header[1]));
+  }
+
+  std::fseek(file, 0, SEEK_END);
+  end = std::ftell(file);
+  indexed = ReadIndex();
+  if (!indexed) Scan();
+  Seek(startTime);
+}
+
+InputLogReader::~InputLogReader() { std::fclose(file); }
+
+void InputLogReader::Seek(int64_t time) {
+  // The last indexed message before the time is the closest known position to read on from.
+  auto entry = std::lower_bound(index.begin(), index.end(), time,
+      [](const IndexEntry& entry, int64_t time) { return entry.time < time; });
+  position = entry == index.begin() ? FILE_HEADER_SIZE : std::prev(entry)->offset;
+  std::fseek(file, position, SEEK_SET);
+
+  LoggedMessage message;
+  uint64_t before = position;
+  while (Next(&message)) {
+    if (message.time >= time) {
+      position = before;
+      std::fseek(file, position, SEEK_SET);
+      return;
+    }
+    before = position;
+  }
+}
+
+bool InputLogReader::Next(LoggedMessage* message) {
+  uint8_t kind;
+  while (position < end && ReadRecord(&kind)) {
+    if (kind != MESSAGE_RECORD || record.size() < MESSAGE_PREFIX_SIZE) continue;
+    std::memcpy(&message->topic, record.data(), sizeof(message->topic));
+    std::memcpy(&message->time, record.data() + sizeof(message->topic), sizeof(message->time));
+    message->data.assign(record.begin() + MESSAGE_PREFIX_SIZE, record.end());
+    return true;
+  }
+  return false;
+}
+
+bool InputLogReader::ReadIndex() {
+  uint64_t indexOffset;
+  uint32_t magic;
+  if (std::fseek(file, -static_cast<long>(TRAILER_SIZE), SEEK_END) != 0 ||
+      !Get(&indexOffset, sizeof(indexOffset)) || !Get(&magic, sizeof(magic)) ||
+      magic != INDEX_MAGIC)
+    return false;
+
+  uint8_t kind;
+  position = indexOffset;
+  if (indexOffset >= end || std::fseek(file, indexOffset, SEEK_SET) != 0 ||
+      !ReadRecord(&kind) || kind != INDEX_RECORD)
+    return false;
+
+  try {
+    BodyReader reader(record);
+    topics.resize(reader.Read<uint16_t>());
+    topicCounts.resize(topics.size());
+    for (size_t i = 0; i < topics.size(); i++) {
+      topics[i] = reader.ReadTopic();
+      topicCounts[i] = reader.Read<uint64_t>();
+    }
+    messageCount = reader.Read<uint64_t>();
+    startTime = reader.Read<int64_t>();
+    endTime = reader.Read<int64_t>();
+    index.resize(reader.Read<uint32_t>());
+    for (IndexEntry& entry : index) {
+      entry.time = reader.Read<int64_t>();
+      entry.offset = reader.Read<uint64_t>();
+    }
+  } catch (const std::runtime_error&) {
+    topics.clear();
+    topicCounts.clear();
+    index.clear();
+    messageCount = 0;
+    startTime = endTime = 0;
+    return false;
+  }
+  end = indexOffset;
+  return true;
+}
+
+void InputLogReader::Scan() {
+  position = FILE_HEADER_SIZE;
+  std::fseek(file, position, SEEK_SET);
+
+  uint8_t kind;
+  uint64_t recordStart = position;
+  while (ReadRecord(&kind)) {
+    if (kind == TOPIC_RECORD) {
+      try {
+        BodyReader reader(record);
+        if (reader.Read<uint16_t>() != topics.size()) break;
+        topics.push_back(reader.ReadTopic());
+        topicCounts.push_back(0);
+      } catch (const std::runtime_error&) {
+        break;
+      }
+    } else if (kind == MESSAGE_RECORD) {
+      uint16_t topic;
+      int64_t time;
+      if (record.size() < MESSAGE_PREFIX_SIZE) break;
+      std::memcpy(&topic, record.data(), sizeof(topic));
+      std::memcpy(&time, record.data() + sizeof(topic), sizeof(time));
+      if (topic >= topics.size()) break;
+
+      if (messageCount == 0 ||
+          (time >= endTime && time >= index.back().time + SCAN_INDEX_INTERVAL))
+        index.push_back({time, recordStart});
+      if (messageCount == 0) startTime = time;
+      endTime = std::max(endTime, time);
+      topicCounts[topic]++;
+      messageCount++;
+    } else {
+      break;
+    }
+    recordStart = position;
+  }
+  // Everything behind the last complete record is ignored.
+  end = recordStart;
+}
+
+bool InputLogReader::ReadRecord(uint8_t* kind) {
+  uint32_t header[2];
+  uint64_t start = position;
+  if (!Get(kind, sizeof(*kind)) || !Get(header, sizeof(header))) {
+    position = start;
+    return false;
+  }
+  if (position > end || header[0] > end - position) {
+    position = start;
+    std::fseek(file, position, SEEK_SET);
+    return false;
+  }
+  record.resize(header[0]);
+  if ((!record.empty() && !Get(record.data(), record.size())) ||
+      Checksum(CHECKSUM_SEED, record.data(), record.size()) != header[1]) {
+    position = start;
+    std::fseek(file, position, SEEK_SET);
+    return false;
+  }
+  return true;
+}
+
+bool InputLogReader::Get(void* data, size_t size) {
+  if (std::fread(data, size, 1, file) != 1) return false;
+  position += size;
+  return true;
+}
+
+}  // namespace connector_utils
@@ -0,0 +1,152 @@
+#include "utils/journal.h"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace connector_utils {
+
+namespace {
+
+constexpr uint32_t JOURNAL_MAGIC = 0x4a414456;  // "VDAJ"
+constexpr uint32_t JOURNAL_VERSION = 1;
+
+/**
+ * Header at the start of the journal file.
+ */
+struct Header {
+  uint32_t magic;    /**< JOURNAL_MAGIC, tells a journal from other files. */
+  uint32_t version;  /**< Version of the layout. */
+  uint64_t capacity; /**< Capacity the file was created with. */
+  uint64_t end;      /**< Offset behind the last record. */
+};
+
+/** Size of the record header: data size, checksum and kind. */
+constexpr size_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t) + 1;
+
+/**
+ * FNV-1a checksum of the kind and the data of a record, detects records that were only partly
+ * written.
+ */
+uint32_t Checksum(uint8_t kind, const char* data, size_t size) {
+  uint32_t hash = (2166136261u ^ kind) * 16777619u;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+Header* GetHeader(MappedFile* file) { return reinterpret_cast<Header*>(file->Data()); }
+
+}  // namespace
+
+Journal::Journal(const std::string& path, size_t capacity) : path(path), capacity(capacity) {
+  if (capacity <= sizeof(Header) + RECORD_HEADER_SIZE)
+    throw std::runtime_error("Journal capacity must be larger than " +
+                             std::to_string(sizeof(Header) + RECORD_HEADER_SIZE) + " bytes");
+  file.reset(new MappedFile(path, capacity));
+  Recover();
+}
+
+bool Journal::Append(uint8_t kind, const void* data, size_t size) {
+  if (!Write(file.get(), kind, data, size)) return false;
+  records++;
+  return true;
+}
+
+std::vector<JournalRecord> Journal::Read() const {
+  std::vector<JournalRecord> result;
+  result.reserve(records);
+  const char* data = file->Data();
+  size_t position = sizeof(Header);
+  size_t end = GetHeader(file.get())->end;
+  while (position < end) {
+    uint32_t size;
+    std::memcpy(&size, data + position, sizeof(size));
+    result.push_back({static_cast<uint8_t>(data[position + 2 * sizeof(uint32_t)]),
+        std::string(data + position + RECORD_HEADER_SIZE, size)});
+    position += RECORD_HEADER_SIZE + size;
+  }
+  return result;
+}
+
+bool Journal::Compact(const std::vector<JournalRecord>& snapshot) {
+  size_t size = sizeof(Header);
+  for (const JournalRecord& record : snapshot) size += RECORD_HEADER_SIZE + record.data.size();
+  if (size > capacity) return false;
+
+  // A compaction that crashed leaves its file behind, it is started over.
+  std::string compactPath = path + ".compact";
+  std::remove(compactPath.c_str());
+  {
+    MappedFile compacted(compactPath, capacity);
+    Clear(&compacted);
+    for (const JournalRecord& record : snapshot)
+      Write(&compacted, record.kind, record.data.data(), record.data.size());
+    compacted.Sync();
+  }
+  if (std::rename(compactPath.c_str(), path.c_str()) != 0)
+    throw std::runtime_error("Cannot rename " + compactPath + " to " + path);
+
+  file.reset(new MappedFile(path, capacity));
+  records = snapshot.size();
+  return true;
+}
+
+void Journal::Sync() { file->Sync(); }
+
+size_t Journal::GetUsed() const { return GetHeader(file.get())->end; }
+
+void Journal::Clear(MappedFile* file) {
+  Header* header = GetHeader(file);
+  header->magic = JOURNAL_MAGIC;
+  header->version = JOURNAL_VERSION;
+  header->capacity = file->Size();
+  header->end = sizeof(Header);
+}
+
+bool Journal::Write(MappedFile* file, uint8_t kind, const void* data, size_t size) {
+  Header* header = GetHeader(file);
+  if (size > file->Size() - header->end || file->Size() - header->end - size < RECORD_HEADER_SIZE)
+    return false;
+
+  char* record = file->Data() + header->end;
+  uint32_t fields[2] = {
+      static_cast<uint32_t>(size), Checksum(kind, static_cast<const char*>(data), size)};
+  std::memcpy(record, fields, sizeof(fields));
+  record[sizeof(fields)] = static_cast<char>(kind);
+  if (size > 0) std::memcpy(record + RECORD_HEADER_SIZE, data, size);
+
+  // The record only counts once it is written completely.
+  header->end += RECORD_HEADER_SIZE + size;
+  return true;
+}
+
+void Journal::Recover() {
+  Header* header = GetHeader(file.get());
+  if (header->magic != JOURNAL_MAGIC || header->version != JOURNAL_VERSION ||
+      header->capacity != capacity || header->end < sizeof(Header) || header->end > capacity) {
+    Clear(file.get());
+    records = 0;
+    return;
+  }
+
+  // Walk the records and keep the ones before the first damaged one.
+  const char* data = file->Data();
+  size_t position = sizeof(Header);
+  size_t count = 0;
+  while (header->end - position >= RECORD_HEADER_SIZE) {
+    uint32_t fields[2];
+    std::memcpy(fields, data + position, sizeof(fields));
+    if (fields[0] > header->end - position - RECORD_HEADER_SIZE) break;
+    uint8_t kind = static_cast<uint8_t>(data[position + sizeof(fields)]);
+    if (Checksum(kind, data + position + RECORD_HEADER_SIZE, fields[0]) != fields[1]) break;
+
+    position += RECORD_HEADER_SIZE + fields[0];
+    count++;
+  }
+  header->end = position;
+  records = count;
+}
+
+}  // namespace connector_utils
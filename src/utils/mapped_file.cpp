@@ -0,0 +1,54 @@
+#include "utils/mapped_file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace connector_utils {
+
+namespace {
+
+[[noreturn]] void ThrowError(const std::string& what, const std::string& path) {
+  throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+MappedFile::MappedFile(const std::string& path, size_t size) : path(path), size(size) {
+  if (size == 0) throw std::runtime_error("Cannot map empty file " + path);
+
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) ThrowError("Cannot open", path);
+
+  struct stat status;
+  if (::fstat(fd, &status) != 0 ||
+      (static_cast<size_t>(status.st_size) < size && ::ftruncate(fd, size) != 0)) {
+    int error = errno;
+    ::close(fd);
+    errno = error;
+    ThrowError("Cannot resize", path);
+  }
+
+  void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    int error = errno;
+    ::close(fd);
+    errno = error;
+    ThrowError("Cannot map", path);
+  }
+  data = static_cast<char*>(mapping);
+}
+
+MappedFile::~MappedFile() {
+  ::munmap(data, size);
+  ::close(fd);
+}
+
+void MappedFile::Sync() {
+  if (::msync(data, size, MS_SYNC) != 0) ThrowError("Cannot sync", path);
+}
+
+}  // namespace connector_utils
@@ -0,0 +1,147 @@
+#include "utils/metrics.h"
+#include <time.h>
+#include <algorithm>
+#include <boost/make_shared.hpp>
+
+namespace connector_utils {
+
+namespace {
+
+/** Source of the IDs of the Metrics instances, IDs are never reused. */
+std::atomic<size_t> nextMetricsId{0};
+
+/** Counters of the calling thread, indexed by the ID of their Metrics instance. */
+thread_local std::vector<std::atomic<uint64_t>*> localShards;
+
+int64_t Nanoseconds(clockid_t clock) {
+  timespec time;
+  clock_gettime(clock, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+}  // namespace
+
+constexpr size_t Metrics::MAX_COUNTERS;
+
+Metrics::Metrics() : id(nextMetricsId++) {}
+
+size_t Metrics::AddCounter(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto existing = std::find(names.begin(), names.end(), name);
+  if (existing != names.end()) return existing - names.begin();
+  if (names.size() == MAX_COUNTERS) {
+    ROS_WARN_ONCE("More than %zu counters, %s is counted as %s", MAX_COUNTERS, name.c_str(),
+        names.back().c_str());
+    return MAX_COUNTERS - 1;
+  }
+  names.push_back(name);
+  return names.size() - 1;
+}
+
+std::vector<std::string> Metrics::GetNames() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return names;
+}
+
+std::vector<uint64_t> Metrics::Read() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<uint64_t> values(names.size(), 0);
+  for (const Shard& shard : shards) {
+    for (size_t i = 0; i < values.size(); i++)
+      values[i] += shard[i].load(std::memory_order_relaxed);
+  }
+  return values;
+}
+
+std::atomic<uint64_t>* Metrics::Local() {
+  if (id < localShards.size() && localShards[id]) return localShards[id];
+  return CreateShard();
+}
+
+std::atomic<uint64_t>* Metrics::CreateShard() {
+  Shard shard(new std::atomic<uint64_t>[MAX_COUNTERS]);
+  for (size_t i = 0; i < MAX_COUNTERS; i++) shard[i].store(0, std::memory_order_relaxed);
+  std::atomic<uint64_t>* counters = shard.get();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    shards.push_back(std::move(shard));
+  }
+  if (localShards.size() <= id) localShards.resize(id + 1, nullptr);
+  localShards[id] = counters;
+  return counters;
+}
+
+size_t MeteredScope::AddTimed(Metrics* metrics, const std::string& name) {
+  size_t calls = metrics->AddCounter(name + " calls");
+  metrics->AddCounter(name + " wall_ns");
+  metrics->AddCounter(name + " cpu_ns");
+  return calls;
+}
+
+MeteredScope::MeteredScope(Metrics* metrics, size_t timed)
+    : metrics(metrics),
+      timed(timed),
+      wallStart(Nanoseconds(CLOCK_MONOTONIC)),
+      cpuStart(Nanoseconds(CLOCK_THREAD_CPUTIME_ID)) {}
+
+MeteredScope::~MeteredScope() {
+  metrics->Add(timed);
+  metrics->Add(timed + 1, Nanoseconds(CLOCK_MONOTONIC) - wallStart);
+  metrics->Add(timed + 2, Nanoseconds(CLOCK_THREAD_CPUTIME_ID) - cpuStart);
+}
+
+/**
+ * Passes a call on to the wrapped callback and counts it as a message taken from the queue.
+ */
+class MeteredQueue::Callback : public ros::CallbackInterface {
+ public:
+  Callback(MeteredQueue* queue, const ros::CallbackInterfacePtr& wrapped)
+      : queue(queue), wrapped(wrapped) {}
+
+  CallResult call() override {
+    CallResult result = wrapped->call();
+    if (result != TryAgain) queue->depth.fetch_sub(1, std::memory_order_relaxed);
+    return result;
+  }
+
+  bool ready() override { return wrapped->ready(); }
+
+ private:
+  MeteredQueue* queue;
+  ros::CallbackInterfacePtr wrapped;
+};
+
+MeteredQueue::MeteredQueue(ros::CallbackQueueInterface* target, uint32_t queueSize)
+    : target(target), queueSize(queueSize) {}
+
+void MeteredQueue::addCallback(const ros::CallbackInterfacePtr& callback, uint64_t ownerId) {
+  // ROS adds the same subscriber queue for every message, so its wrapper is reused.
+  ros::CallbackInterfacePtr counted;
+  {
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    if (callback != wrapped) {
+      wrapped = callback;
+      wrapper = boost::make_shared<Callback>(this, callback);
+    }
+    counted = wrapper;
+  }
+
+  int64_t queued = depth.fetch_add(1, std::memory_order_relaxed) + 1;
+  int64_t largest = maxDepth.load(std::memory_order_relaxed);
+  while (queued > largest &&
+         !maxDepth.compare_exchange_weak(largest, queued, std::memory_order_relaxed)) {
+  }
+  if (queueSize > 0 && queued >= queueSize) full.fetch_add(1, std::memory_order_relaxed);
+  target->addCallback(counted, ownerId);
+}
+
+void MeteredQueue::removeByID(uint64_t ownerId) {
+  depth.store(0, std::memory_order_relaxed);
+  target->removeByID(ownerId);
+}
+
+int64_t MeteredQueue::TakeMaxDepth() {
+  return maxDepth.exchange(depth.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+}  // namespace connector_utils
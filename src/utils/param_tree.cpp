@@ -0,0 +1,133 @@
+#include "utils/param_tree.h"
+
+namespace connector_utils {
+
+namespace {
+
+/**
+ * Adds all string parameters of a namespace to a map.
+ *
+ * @param value   Parameter or namespace.
+ * @param path    Path of the parameter or namespace.
+ * @param result  Map from the paths of the parameters to their values.
+ */
+void CollectStrings(XmlRpc::XmlRpcValue& value, const std::string& path,
+    std::map<std::string, std::string>* result) {
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeString) {
+    (*result)[path] = static_cast<std::string&>(value);
+  } else if (value.getType() == XmlRpc::XmlRpcValue::TypeStruct) {
+    for (auto& member : value) {
+      std::string memberPath = path.empty() ? member.first : path + "/" + member.first;
+      CollectStrings(member.second, memberPath, result);
+    }
+  }
+}
+
+}  // namespace
+
+ParamTree::ParamTree(const XmlRpc::XmlRpcValue& root) : root(root) {}
+
+ParamTree ParamTree::Fetch(const std::string& ns) {
+  XmlRpc::XmlRpcValue root;
+  if (!ros::param::get(ns, root) || root.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+    return ParamTree();
+  return ParamTree(root);
+}
+
+bool ParamTree::Has(const std::string& path) const { return Find(path) != nullptr; }
+
+bool ParamTree::Get(const std::string& path, bool& value) const {
+  XmlRpc::XmlRpcValue* param = Find(path);
+  if (!param || param->getType() != XmlRpc::XmlRpcValue::TypeBoolean) return false;
+  value = static_cast<bool&>(*param);
+  return true;
+}
+
+bool ParamTree::Get(const std::string& path, int& value) const {
+  XmlRpc::XmlRpcValue* param = Find(path);
+  if (!param || param->getType() != XmlRpc::XmlRpcValue::TypeInt) return false;
+  value = static_cast<int&>(*param);
+  return true;
+}
+
+bool ParamTree::Get(const std::string& path, double& value) const {
+  XmlRpc::XmlRpcValue* param = Find(path);
+  if (!param) return false;
+  if (param->getType() == XmlRpc::XmlRpcValue::TypeDouble) {
+    value = static_cast<double&>(*param);
+    return true;
+  }
+  if (param->getType() == XmlRpc::XmlRpcValue::TypeInt) {
+    value = static_cast<int&>(*param);
+    return true;
+  }
+  return false;
+}
+
+bool ParamTree::Get(const std::string& path, std::string& value) const {
+  XmlRpc::XmlRpcValue* param = Find(path);
+  if (!param || param->getType() != XmlRpc::XmlRpcValue::TypeString) return false;
+  value = static_cast<std::string&>(*param);
+  return true;
+}
+
+bool ParamTree::Get(const std::string& path, std::vector<std::string>& value) const {
+  XmlRpc::XmlRpcValue* param = Find(path);
+  if (!param || param->getType() != XmlRpc::XmlRpcValue::TypeArray) return false;
+  std::vector<std::string> result;
+  for (int i = 0; i < param->size(); i++) {
+    XmlRpc::XmlRpcValue& element = (*param)[i];
+    if (element.getType() != XmlRpc::XmlRpcValue::TypeString) return false;
+    result.push_back(static_cast<std::string&>(element));
+  }
+  value.swap(result);
+  return true;
+}
+
+bool ParamTree::Get(const std::string& path, std::map<std::string, double>& value) const {
+  XmlRpc::XmlRpcValue* param = Find(path);
+  if (!param || param->getType() != XmlRpc::XmlRpcValue::TypeStruct) return false;
+  std::map<std::string, double> result;
+  for (auto& member : *param) {
+    if (member.second.getType() == XmlRpc::XmlRpcValue::TypeDouble)
+      result[member.first] = static_cast<double&>(member.second);
+    else if (member.second.getType() == XmlRpc::XmlRpcValue::TypeInt)
+      result[member.first] = static_cast<int&>(member.second);
+    else
+      return false;
+  }
+  value.swap(result);
+  return true;
+}
+
+bool ParamTree::Get(const std::string& path, XmlRpc::XmlRpcValue& value) const {
+  XmlRpc::XmlRpcValue* param = Find(path);
+  if (!param) return false;
+  value = *param;
+  return true;
+}
+
+std::map<std::string, std::string> ParamTree::GetStrings(const std::string& path) const {
+  std::map<std::string, std::string> result;
+  XmlRpc::XmlRpcValue* param = Find(path);
+  if (param) CollectStrings(*param, path, &result);
+  return result;
+}
+
+XmlRpc::XmlRpcValue* ParamTree::Find(const std::string& path) const {
+  XmlRpc::XmlRpcValue* param = &root;
+  size_t start = 0;
+  while (start < path.size()) {
+    size_t end = path.find('/', start);
+    if (end == std::string::npos) end = path.size();
+    std::string name = path.substr(start, end - start);
+    start = end + 1;
+    if (name.empty()) continue;
+    if (param->getType() != XmlRpc::XmlRpcValue::TypeStruct || !param->hasMember(name))
+      return nullptr;
+    param = &(*param)[name];
+  }
+  return param->valid() ? param : nullptr;
+}
+
+}  // namespace connector_utils
@@ -0,0 +1,48 @@
+#include "utils/priority_lane.h"
+#include <boost/make_shared.hpp>
+
+namespace connector_utils {
+
+/**
+ * Callback that holds the mutex of its queue while the wrapped callback is called.
+ */
+class LockingQueue::Callback : public ros::CallbackInterface {
+ public:
+  Callback(std::mutex* mutex, const ros::CallbackInterfacePtr& wrapped)
+      : mutex(mutex), wrapped(wrapped) {}
+
+  CallResult call() override {
+    std::lock_guard<std::mutex> lock(*mutex);
+    return wrapped->call();
+  }
+
+  bool ready() override { return wrapped->ready(); }
+
+ private:
+  std::mutex* mutex;
+  ros::CallbackInterfacePtr wrapped;
+};
+
+void LockingQueue::addCallback(const ros::CallbackInterfacePtr& callback, uint64_t ownerId) {
+  target->addCallback(boost::make_shared<Callback>(mutex, callback), ownerId);
+}
+
+void LockingQueue::removeByID(uint64_t ownerId) { target->removeByID(ownerId); }
+
+PriorityLane::PriorityLane(ros::CallbackQueueInterface* target)
+    : regular(target, &mutex), priority(&queue, &mutex), thread(&PriorityLane::Run, this) {}
+
+PriorityLane::~PriorityLane() { Stop(); }
+
+void PriorityLane::Stop() {
+  if (stopping.exchange(true)) return;
+  // Wakes the thread if it waits for callbacks.
+  queue.disable();
+  thread.join();
+}
+
+void PriorityLane::Run() {
+  while (!stopping) queue.callAvailable(ros::WallDuration(0.1));
+}
+
+}  // namespace connector_utils
@@ -0,0 +1,68 @@
+#include "utils/strand_pool.h"
+#include <algorithm>
+
+namespace connector_utils {
+
+void CallbackStrand::addCallback(const ros::CallbackInterfacePtr& callback, uint64_t owner_id) {
+  // The callback has to be queued before the strand is scheduled, see StrandPool::Run.
+  queue.addCallback(callback, owner_id);
+  pool->Schedule(this);
+}
+
+void CallbackStrand::removeByID(uint64_t owner_id) { queue.removeByID(owner_id); }
+
+void CallbackStrand::Drain() {
+  while (!queue.isEmpty()) queue.callAvailable(ros::WallDuration());
+}
+
+StrandPool::StrandPool(size_t threads) {
+  for (size_t i = 0; i < std::max<size_t>(threads, 1); i++)
+    this->threads.emplace_back(&StrandPool::Run, this);
+}
+
+StrandPool::~StrandPool() { Stop(); }
+
+void StrandPool::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping) return;
+    stopping = true;
+  }
+  readyChanged.notify_all();
+  for (std::thread& thread : threads) thread.join();
+}
+
+void StrandPool::Schedule(CallbackStrand* strand) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (strand->scheduled || stopping) return;
+    strand->scheduled = true;
+    ready.push_back(strand);
+  }
+  readyChanged.notify_one();
+}
+
+void StrandPool::Run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    readyChanged.wait(lock, [this]() { return stopping || !ready.empty(); });
+    if (stopping) return;
+    CallbackStrand* strand = ready.front();
+    ready.pop_front();
+
+    lock.unlock();
+    strand->queue.callAvailable(ros::WallDuration());
+    lock.lock();
+
+    // Callbacks added while this thread was calling did not schedule the strand again, as it was
+    // still scheduled. They are checked here, under the lock they are scheduled with.
+    if (strand->queue.isEmpty()) {
+      strand->scheduled = false;
+    } else {
+      ready.push_back(strand);
+      readyChanged.notify_one();
+    }
+  }
+}
+
+}  // namespace connector_utils
@@ -0,0 +1,163 @@
+#include "utils/tracer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace connector_utils {
+
+constexpr int LatencyHistogram::SUB_BUCKETS;
+constexpr int LatencyHistogram::BUCKETS;
+
+int LatencyHistogram::BucketOf(uint64_t nanoseconds) {
+  if (nanoseconds < SUB_BUCKETS) return static_cast<int>(nanoseconds);
+  // The highest bit selects the power of two, the two bits below it the bucket within.
+  int exponent = 63 - __builtin_clzll(nanoseconds);
+  int sub = static_cast<int>(nanoseconds >> (exponent - 2)) & (SUB_BUCKETS - 1);
+  return SUB_BUCKETS + (exponent - 2) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::LowerBound(int bucket) {
+  if (bucket < SUB_BUCKETS) return bucket;
+  int exponent = (bucket - SUB_BUCKETS) / SUB_BUCKETS + 2;
+  uint64_t sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+  return (SUB_BUCKETS + sub) << (exponent - 2);
+}
+
+void LatencyHistogram::Record(uint64_t nanoseconds) {
+  counts[BucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+  sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+  uint64_t largest = max.load(std::memory_order_relaxed);
+  while (nanoseconds > largest &&
+         !max.compare_exchange_weak(largest, nanoseconds, std::memory_order_relaxed)) {
+  }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Take() {
+  Snapshot snapshot;
+  snapshot.count = 0;
+  for (int i = 0; i < BUCKETS; i++) {
+    snapshot.counts[i] = counts[i].exchange(0, std::memory_order_relaxed);
+    snapshot.count += snapshot.counts[i];
+  }
+  snapshot.sum = sum.exchange(0, std::memory_order_relaxed);
+  snapshot.max = max.exchange(0, std::memory_order_relaxed);
+  return snapshot;
+}
+
+uint64_t LatencyHistogram::Snapshot::Percentile(double fraction) const {
+  if (count == 0) return 0;
+  auto rank = static_cast<uint64_t>(std::ceil(fraction * count));
+  uint64_t seen = 0;
+  for (int i = 0; i < BUCKETS; i++) {
+    seen += counts[i];
+    if (seen >= std::max<uint64_t>(rank, 1))
+      return i + 1 < BUCKETS ? std::min(LowerBound(i + 1) - 1, max) : max;
+  }
+  return max;
+}
+
+Tracer::Tracer() : epoch(Clock::now()) {}
+
+void Tracer::KeepEvents(size_t maxEvents) {
+  std::lock_guard<std::mutex> lock(eventsMutex);
+  this->maxEvents = maxEvents;
+  events.reserve(std::min<size_t>(maxEvents, 65536));
+}
+
+size_t Tracer::AddStage(const std::string& name) {
+  for (size_t i = 0; i < stages.size(); i++) {
+    if (stages[i].name == name) return i;
+  }
+  stages.emplace_back();
+  stages.back().name = name;
+  return stages.size() - 1;
+}
+
+void Tracer::Record(
+    size_t stage, uint64_t traceId, Clock::time_point start, Clock::time_point end) {
+  auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  stages[stage].histogram.Record(static_cast<uint64_t>(std::max<int64_t>(nanoseconds, 0)));
+  if (maxEvents == 0) return;
+
+  std::lock_guard<std::mutex> lock(eventsMutex);
+  if (events.size() >= maxEvents) return;
+  events.push_back({stage, traceId,
+      std::chrono::duration_cast<std::chrono::microseconds>(start - epoch).count(),
+      std::chrono::duration_cast<std::chrono::microseconds>(end - epoch).count()});
+  eventsChanged = true;
+}
+
+std::vector<Tracer::StageStats> Tracer::TakeStats() {
+  std::vector<StageStats> stats;
+  for (Stage& stage : stages) {
+    LatencyHistogram::Snapshot snapshot = stage.histogram.Take();
+    if (snapshot.count == 0) continue;
+    stats.push_back({stage.name, snapshot.count, snapshot.sum / 1e3 / snapshot.count,
+        snapshot.Percentile(0.5) / 1e3, snapshot.Percentile(0.9) / 1e3,
+        snapshot.Percentile(0.99) / 1e3, snapshot.max / 1e3});
+  }
+  return stats;
+}
+
+bool Tracer::WriteChromeTrace(const std::string& path) {
+  std::lock_guard<std::mutex> lock(eventsMutex);
+  if (!eventsChanged) return true;
+
+  // Written to a temporary file first, so a viewer never sees a partial trace.
+  std::string temporary = path + ".tmp";
+  FILE* file = std::fopen(temporary.c_str(), "w");
+  if (!file) return false;
+
+  // Async events of the same message share an ID, so the stages of overlapping messages, e.g.
+  // instant actions waiting in a queue, are shown as separate tracks.
+  std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+  const char* separator = "";
+  for (const Event& event : events) {
+    const std::string& name = stages[event.stage].name;
+    std::fprintf(file,
+        "%s\n{\"name\":\"%s\",\"cat\":\"vda5050\",\"ph\":\"b\",\"id\":%llu,\"pid\":1,\"tid\":1,"
+        "\"ts\":%lld},\n{\"name\":\"%s\",\"cat\":\"vda5050\",\"ph\":\"e\",\"id\":%llu,\"pid\":1,"
+        "\"tid\":1,\"ts\":%lld}",
+        separator, name.c_str(), static_cast<unsigned long long>(event.traceId),
+        static_cast<long long>(event.start), name.c_str(),
+        static_cast<unsigned long long>(event.traceId), static_cast<long long>(event.end));
+    separator = ",";
+  }
+  std::fputs("\n]}\n", file);
+  bool written = std::fclose(file) == 0 && std::rename(temporary.c_str(), path.c_str()) == 0;
+  eventsChanged = !written;
+  return written;
+}
+
+TraceSpan::TraceSpan(Tracer* tracer, size_t totalStage) : tracer(tracer), totalStage(totalStage) {
+  if (!tracer->IsEnabled()) return;
+  traceId = tracer->NewTraceId();
+  start = last = Tracer::Clock::now();
+}
+
+TraceSpan::TraceSpan(Tracer* tracer, size_t totalStage, const ros::Time& receiptTime)
+    : tracer(tracer), totalStage(totalStage) {
+  if (!tracer->IsEnabled()) return;
+  traceId = tracer->NewTraceId();
+  last = Tracer::Clock::now();
+  // Receipt times are ROS times, only the time waited since then is moved to the steady clock.
+  ros::Duration waited = ros::Time::now() - receiptTime;
+  if (!receiptTime.isZero() && waited > ros::Duration(0))
+    last -= std::chrono::nanoseconds(waited.toNSec());
+  start = last;
+}
+
+void TraceSpan::Mark(size_t stage) {
+  if (traceId == 0) return;
+  Tracer::Clock::time_point now = Tracer::Clock::now();
+  tracer->Record(stage, traceId, last, now);
+  last = now;
+}
+
+void TraceSpan::End() {
+  if (traceId == 0) return;
+  tracer->Record(totalStage, traceId, start, Tracer::Clock::now());
+  traceId = 0;
+}
+
+}  // namespace connector_utils
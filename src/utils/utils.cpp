@@ -1,4 +1,7 @@
 #include "utils/utils.h"
+#include <cmath>
+#include <limits>
+#include <mutex>
 
 namespace connector_utils {
 
@@ -13,12 +16,36 @@ bool CheckParamIncludes(std::string full_param_name, std::string string_to_find)
 }
 
 std::string GetISOCurrentTimestamp() {
-  boost::posix_time::ptime posixTime = ros::Time::now().toBoost();
+  static std::mutex mutex;
+  static uint64_t cachedMillis = std::numeric_limits<uint64_t>::max();
+  static std::string cached;
+
+  ros::Time now = ros::Time::now();
+  uint64_t millis = now.toNSec() / 1000000;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (millis == cachedMillis) return cached;
+
+  boost::posix_time::ptime posixTime = now.toBoost();
   std::string isoTimeStr = boost::posix_time::to_iso_extended_string(posixTime);
 
   // Get first 23 characters to have a timestamp with 3 millisecond digits.
   // Append Z to match the ISO 8601 format.
-  return isoTimeStr.substr(0, 23).append("Z");
+  cached = isoTimeStr.substr(0, 23).append("Z");
+  cachedMillis = millis;
+  return cached;
+}
+
+std::string NamespacedTopic(const std::string& ns, const std::string& topic) {
+  std::string name = "/" + ns;
+  if (topic.empty() || topic[0] != '/') name += '/';
+  return name + topic;
+}
+
+bool InPositionDeadband(const vda5050_msgs::AGVPosition& last,
+    const vda5050_msgs::AGVPosition& position, double distance, double angle) {
+  if (distance <= 0.0) return false;
+  if (std::hypot(position.x - last.x, position.y - last.y) >= distance) return false;
+  return angle <= 0.0 || std::abs(std::remainder(position.theta - last.theta, 2.0 * M_PI)) < angle;
 }
 
 vda5050_msgs::Error CreateVDAError(const std::string& error_type, const std::string& error_desc,
@@ -0,0 +1,101 @@
+#include "utils/zone_index.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace connector_utils {
+
+constexpr size_t ZoneIndex::MAX_CELLS;
+
+ZoneIndex::ZoneIndex(ZoneSet zoneSet, double cellSize) : zoneSet(std::move(zoneSet)) {
+  std::vector<Zone>& zones = this->zoneSet.zones;
+  zones.erase(std::remove_if(zones.begin(), zones.end(),
+                  [](const Zone& zone) { return zone.vertices.size() < 3; }),
+      zones.end());
+  if (zones.empty()) return;
+
+  // Bounding boxes of the zones and of the grid.
+  struct Box {
+    double minX, minY, maxX, maxY;
+  };
+  std::vector<Box> boxes;
+  boxes.reserve(zones.size());
+  Box grid{std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+      std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+  for (const Zone& zone : zones) {
+    Box box = {zone.vertices[0].x, zone.vertices[0].y, zone.vertices[0].x, zone.vertices[0].y};
+    for (const ZoneVertex& vertex : zone.vertices) {
+      box.minX = std::min(box.minX, vertex.x);
+      box.minY = std::min(box.minY, vertex.y);
+      box.maxX = std::max(box.maxX, vertex.x);
+      box.maxY = std::max(box.maxY, vertex.y);
+    }
+    grid = {std::min(grid.minX, box.minX), std::min(grid.minY, box.minY),
+        std::max(grid.maxX, box.maxX), std::max(grid.maxY, box.maxY)};
+    boxes.push_back(box);
+  }
+
+  this->cellSize = cellSize > 0.0 ? cellSize : 1.0;
+  double width = grid.maxX - grid.minX;
+  double height = grid.maxY - grid.minY;
+  while ((std::floor(width / this->cellSize) + 1) * (std::floor(height / this->cellSize) + 1) >
+         MAX_CELLS)
+    this->cellSize *= 2.0;
+  originX = grid.minX;
+  originY = grid.minY;
+  columns = static_cast<size_t>(width / this->cellSize) + 1;
+  rows = static_cast<size_t>(height / this->cellSize) + 1;
+
+  // Count the zones of each cell, then fill the cells in the order of the zones.
+  cellBegin.assign(columns * rows + 1, 0);
+  std::vector<uint32_t> filled;
+  for (int pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      for (size_t cell = 1; cell < cellBegin.size(); cell++) cellBegin[cell] += cellBegin[cell - 1];
+      cellZones.resize(cellBegin.back());
+      filled.assign(cellBegin.begin(), cellBegin.end() - 1);
+    }
+    for (size_t zone = 0; zone < zones.size(); zone++) {
+      size_t firstColumn = static_cast<size_t>((boxes[zone].minX - originX) / this->cellSize);
+      size_t lastColumn = static_cast<size_t>((boxes[zone].maxX - originX) / this->cellSize);
+      size_t firstRow = static_cast<size_t>((boxes[zone].minY - originY) / this->cellSize);
+      size_t lastRow = static_cast<size_t>((boxes[zone].maxY - originY) / this->cellSize);
+      for (size_t row = firstRow; row <= std::min(lastRow, rows - 1); row++) {
+        for (size_t column = firstColumn; column <= std::min(lastColumn, columns - 1); column++) {
+          size_t cell = row * columns + column;
+          if (pass == 0)
+            cellBegin[cell + 1]++;
+          else
+            cellZones[filled[cell]++] = static_cast<uint32_t>(zone);
+        }
+      }
+    }
+  }
+}
+
+void ZoneIndex::Locate(double x, double y, std::vector<size_t>* zones) const {
+  zones->clear();
+  if (columns == 0 || !(x >= originX && y >= originY)) return;
+  double column = std::floor((x - originX) / cellSize);
+  double row = std::floor((y - originY) / cellSize);
+  if (column >= columns || row >= rows) return;
+
+  size_t cell = static_cast<size_t>(row) * columns + static_cast<size_t>(column);
+  for (uint32_t i = cellBegin[cell]; i < cellBegin[cell + 1]; i++) {
+    if (Contains(zoneSet.zones[cellZones[i]].vertices, x, y)) zones->push_back(cellZones[i]);
+  }
+}
+
+bool ZoneIndex::Contains(const std::vector<ZoneVertex>& vertices, double x, double y) {
+  bool inside = false;
+  for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++) {
+    const ZoneVertex& a = vertices[i];
+    const ZoneVertex& b = vertices[j];
+    if ((a.y > y) != (b.y > y) && x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x)
+      inside = !inside;
+  }
+  return inside;
+}
+
+}  // namespace connector_utils
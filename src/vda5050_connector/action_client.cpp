@@ -31,6 +31,8 @@ ActionElement::ActionElement(
   actionDescription = incomingAction->actionDescription;
   actionParameters = incomingAction->actionParameters;
   state = newState;
+  sentToAgv = false;
+  cancelRequested = false;
 }
 
 bool ActionElement::compareActionId(string actionId2comp) { return actionId == actionId2comp; }
@@ -52,47 +54,93 @@ vda5050_msgs::Action ActionElement::packAction() {
 
 /*--------------------------------ActionClient--------------------------------------------------------------*/
 
-ActionClient::ActionClient() {
+ActionClient::ActionClient() : ActionClient(ros::NodeHandle(), ros::NodeHandle("~")) {}
+
+ActionClient::ActionClient(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh)
+    : VDA5050Node(nh, private_nh), isDriving(false) {
+  iaStages = {tracer.AddStage("instant action total"), tracer.AddStage("instant action receipt"),
+      tracer.AddStage("instant action enqueue"), tracer.AddStage("instant action queued"),
+      tracer.AddStage("instant action publish")};
+  updateActionsMetric = connector_utils::MeteredScope::AddTimed(&metrics, "UpdateActions");
+
   LinkPublishTopics(&(this->nh));
   LinkSubscriptionTopics(&(this->nh));
+
+  ReadConfiguration();
+  actionStatesTimer = this->nh.createTimer(
+      ros::Duration(actionStatesPeriod), std::bind(&ActionClient::FlushActionStates, this));
+  updateTimer = this->nh.createTimer(
+      ros::Duration(updatePeriod), std::bind(&ActionClient::UpdateActions, this));
+
+  // Started on demand for the earliest deadline, see ScheduleDeadlineTimer.
+  deadlineTimer = this->nh.createTimer(
+      ros::Duration(1.0), &ActionClient::DeadlineTimerCallback, this, true, false);
+
+  AddGauge("activeActionsList size", [this] { return activeActionsList.size(); });
+  AddGauge("orderActionQueue size", [this] { return orderActionQueue.size(); });
+  AddGauge("instantActionQueue size", [this] { return instantActionQueue.size(); });
+  SetupMetrics();
+  LogStartupTime();
 }
 
-void ActionClient::LinkPublishTopics(ros::NodeHandle* nh) {
-  std::map<std::string, std::string> topicList =
-      GetTopicList(ros::this_node::getName() + "/publish_topics");
-
-  for (const auto& elem : topicList) {
-    // ROS_INFO("topic_index = %s",topic_index.c_str());
-    if (CheckParamIncludes(elem.first, "actionToAgv"))
-      messagePublisher[elem.first] =
-          make_shared<ros::Publisher>(nh->advertise<vda5050_msgs::Action>(elem.second, 1000));
-    if (CheckParamIncludes(elem.first, "agvActionCancel"))
-      messagePublisher[elem.first] =
-          make_shared<ros::Publisher>(nh->advertise<std_msgs::String>(elem.second, 1000));
-    if (CheckParamIncludes(elem.first, "prActions"))
-      messagePublisher[elem.first] =
-          make_shared<ros::Publisher>(nh->advertise<std_msgs::String>(elem.second, 1000));
-    if (CheckParamIncludes(elem.first, "prDriving"))
-      messagePublisher[elem.first] =
-          make_shared<ros::Publisher>(nh->advertise<std_msgs::String>(elem.second, 1000));
-  }
+ActionClient::~ActionClient() { StopPriorityLane(); }
+
+const TopicBinding<ActionClient> ActionClient::publishBindings[] = {
+    {"actionToAgv", 1000,
+        &Advertise<ActionClient, vda5050_msgs::Action, &ActionClient::actionToAgvPub>},
+    {"agvActionCancel", 1000,
+        &Advertise<ActionClient, std_msgs::String, &ActionClient::agvActionCancelPub>},
+    {"prActions", 1000, &Advertise<ActionClient, std_msgs::String, &ActionClient::prActionsPub>},
+    {"prDriving", 1000, &Advertise<ActionClient, std_msgs::String, &ActionClient::prDrivingPub>},
+    {"actionStates", 1000,
+        &Advertise<ActionClient, vda5050_msgs::State, &ActionClient::actionStatesPub>},
+    {"actionErrors", 1000,
+        &Advertise<ActionClient, vda5050_msgs::Errors, &ActionClient::actionErrorsPub>},
+    {"orderCancel", 1000,
+        &Advertise<ActionClient, std_msgs::String, &ActionClient::orderCancelPub>},
+    {"allActionsCancelled", 1000,
+        &Advertise<ActionClient, std_msgs::String, &ActionClient::allActionsCancelledPub>},
+};
+
+const TopicBinding<ActionClient> ActionClient::subscribeBindings[] = {
+    {"instantAction", 1000,
+        &SubscribePriority<ActionClient, vda5050_msgs::InstantAction,
+            &ActionClient::InstantActionsCallback>},
+    {"agvActionState", 1000,
+        &Subscribe<ActionClient, vda5050_msgs::ActionState, &ActionClient::AgvActionStateCallback>},
+    {"driving", 1000, &Subscribe<ActionClient, std_msgs::Bool, &ActionClient::DrivingCallback>},
+    {"orderTrigger", 1000,
+        &Subscribe<ActionClient, std_msgs::String, &ActionClient::OrderTriggerCallback>},
+    {"orderCancel", 1000,
+        &Subscribe<ActionClient, std_msgs::String, &ActionClient::OrderCancelCallback>},
+};
+
+size_t ActionClient::LinkPublishTopics(ros::NodeHandle* nh) {
+  return LinkTopics(this, nh, "publish_topics", publishBindings);
 }
 
-void ActionClient::LinkSubscriptionTopics(ros::NodeHandle* nh) {
-  std::map<std::string, std::string> topicList =
-      GetTopicList(ros::this_node::getName() + "/subscribe_topics");
-  for (const auto& elem : topicList) {
-    if (CheckParamIncludes(elem.first, "instantAction"))
-      nh->subscribe(elem.second, 1000, &ActionClient::InstantActionsCallback, this);
-    if (CheckParamIncludes(elem.first, "agvActionState"))
-      nh->subscribe(elem.second, 1000, &ActionClient::AgvActionStateCallback, this);
-    if (CheckParamIncludes(elem.first, "driving"))
-      nh->subscribe(elem.second, 1000, &ActionClient::DrivingCallback, this);
-  }
+size_t ActionClient::LinkSubscriptionTopics(ros::NodeHandle* nh) {
+  return LinkTopics(this, nh, "subscribe_topics", subscribeBindings);
 }
 
-void ActionClient::OrderTriggerCallback(const std_msgs::String& msg) {
-  shared_ptr<ActionElement> activeAction = FindAction(msg.data);
+void ActionClient::ReadConfiguration() {
+  params.Param<double>("publish_periods/action_states", actionStatesPeriod, 0.5);
+  params.Param<double>("update_period", updatePeriod, 20.0);
+  params.Param<double>("action_deadlines/default", defaultActionDeadline, 0.0);
+  actionTypeDeadlines.clear();
+  params.Get("action_deadlines/types", actionTypeDeadlines);
+}
+
+size_t ActionClient::Reconfigure() {
+  // Changed deadlines apply to the actions sent from now on.
+  ReadConfiguration();
+  actionStatesTimer.setPeriod(ros::Duration(actionStatesPeriod));
+  updateTimer.setPeriod(ros::Duration(updatePeriod));
+  return LinkPublishTopics(&nh) + LinkSubscriptionTopics(&nh);
+}
+
+void ActionClient::OrderTriggerCallback(const std_msgs::String::ConstPtr& msg) {
+  shared_ptr<ActionElement> activeAction = FindAction(msg->data);
 
   // Sort out duplicates?
 
@@ -100,16 +148,28 @@ void ActionClient::OrderTriggerCallback(const std_msgs::String& msg) {
     // Push action to queue
     vda5050_msgs::Action triggeredOrder = activeAction->packAction();
     orderActionQueue.push_back(triggeredOrder);
-    ROS_INFO("Found Action to trigger: %s", msg.data.c_str());
+    ROS_INFO("Found Action to trigger: %s", msg->data.c_str());
   } else
     ROS_WARN("Action to trigger not found!");
 }
 
-void ActionClient::OrderCancelCallback(const std_msgs::String& msg) {
-  ordersSucCancelled.push_back(msg.data);
+void ActionClient::OrderCancelCallback(const std_msgs::String::ConstPtr& msg) {
+  auto cancellation = orderCancellations.find(msg->data);
+  if (cancellation == orderCancellations.end()) {
+    ROS_WARN("Received cancel confirmation for unknown order %s", msg->data.c_str());
+    return;
+  }
+  cancellation->second.orderCancelled = true;
+  CompleteCancellation(msg->data);
+
+  // Instant actions that waited for the cancellation are sent right away.
+  DrainInstantActions();
 }
 
 void ActionClient::InstantActionsCallback(const vda5050_msgs::InstantAction::ConstPtr& msg) {
+  TraceSpan trace(&tracer, iaStages.total, receiptTime);
+  trace.Mark(iaStages.receipt);
+
   // Iterate over all actions in the instantActions msg
   for (auto& iaction : msg->actions) {
     // Add action to active actions list
@@ -119,9 +179,8 @@ void ActionClient::InstantActionsCallback(const vda5050_msgs::InstantAction::Con
 
     // Decide if the action contains an order cancel
     if (iaction.actionType == "cancelOrder") {
-      // New actions to cancel
+      // Get all actions to cancel
       vector<shared_ptr<ActionElement>> newActionsToCancel;
-      // Add orderId to orderCancellations list and get all actions to cancel
       for (auto const& param : iaction.actionParameters) {
         if (param.key == "orderId") {
           orderIdToCancel = param.value;
@@ -129,136 +188,124 @@ void ActionClient::InstantActionsCallback(const vda5050_msgs::InstantAction::Con
         }
       }
 
-      // Cancel actions from newActionsToCancel list
-      for (std::vector<std::shared_ptr<ActionElement>>::iterator cAction =
-               newActionsToCancel.begin();
-           cAction != newActionsToCancel.end();) {
-        // Wating actions can simply be removed as long as they have not been sent to the AGV
-        if (cAction->get()->state == "WAITING") {
-          // Check if Action has already been sent to AGV (in activeActionsList but not in queue)
-
-          // action already sent to AGV
-          if (cAction->get()->sentToAgv) {
-            // Send action cancel request to AGV
-            std_msgs::String cancel_msg;
-            cancel_msg.data = string(cAction->get()->getActionId());
-            messagePublisher["agvActionCancel"]->publish(cancel_msg);
-            cAction++;
-          }
+      // The running cancellation finishes its own cancel action only, so a second one fails.
+      if (orderCancellations.count(orderIdToCancel)) {
+        ROS_WARN("Order %s is already being cancelled", orderIdToCancel.c_str());
+        vda5050_msgs::ActionState state_msg;
+        state_msg.actionId = iaction.actionId;
+        state_msg.actionType = iaction.actionType;
+        state_msg.actionStatus = "FAILED";
+        state_msg.resultDescription = "order is already being cancelled";
+        ReportActionState(state_msg);
+
+        shared_ptr<ActionElement> duplicate = FindAction(iaction.actionId);
+        activeActionsList.erase(
+            remove(activeActionsList.begin(), activeActionsList.end(), duplicate),
+            activeActionsList.end());
+        continue;
+      }
 
-          // action not sent to AGV yet
-          else {
-            // action triggered and in queue (but still not sent to AGV)
-            auto queueAction = find_if(orderActionQueue.begin(), orderActionQueue.end(),
-                [cAction](vda5050_msgs::Action& orderAction) {
-                  return orderAction.actionId == cAction->get()->getActionId();
-                });
-            // delete action from queue
-            if (queueAction != orderActionQueue.end()) orderActionQueue.erase(queueAction);
-
-            // delete from newActionsToCancel
-            newActionsToCancel.erase(
-                remove(newActionsToCancel.begin(), newActionsToCancel.end(), *cAction));
-
-            // send failed state to state daemon
-            vda5050_msgs::ActionState state_msg;
-            state_msg.actionId = cAction->get()->getActionId();
-            state_msg.actionType = cAction->get()->getActionType();
-            state_msg.actionStatus = "FAILED";
-            state_msg.resultDescription = "order cancelled";  // Description necessary?
-            actionStatesPub.publish(state_msg);
-
-            // delete from activeActionsList
-            auto actAct_it = find_if(activeActionsList.begin(), activeActionsList.end(),
-                [cAction](shared_ptr<ActionElement>& activeAction) {
-                  return cAction->get()->compareActionId(cAction->get()->getActionId());
-                });
-
-            if (actAct_it != activeActionsList.end()) {
-              activeActionsList.erase(actAct_it);
-            }
-          }
+      // Count the actions the AGV has to stop. The counter is decremented in
+      // AgvActionStateCallback once they are FINISHED or FAILED.
+      size_t outstandingActions = 0;
+      for (auto const& cAction : newActionsToCancel) {
+        // Waiting actions can simply be removed as long as they have not been sent to the AGV
+        if (cAction->state == "WAITING" && !cAction->sentToAgv) {
+          // action triggered and in queue (but still not sent to AGV)
+          auto queueAction = find_if(orderActionQueue.begin(), orderActionQueue.end(),
+              [&cAction](vda5050_msgs::Action& orderAction) {
+                return orderAction.actionId == cAction->getActionId();
+              });
+          // delete action from queue
+          if (queueAction != orderActionQueue.end()) orderActionQueue.erase(queueAction);
+
+          // send failed state to state daemon
+          vda5050_msgs::ActionState state_msg;
+          state_msg.actionId = cAction->getActionId();
+          state_msg.actionType = cAction->getActionType();
+          state_msg.actionStatus = "FAILED";
+          state_msg.resultDescription = "order cancelled";  // Description necessary?
+          ReportActionState(state_msg);
+
+          // delete from activeActionsList
+          activeActionsList.erase(
+              remove(activeActionsList.begin(), activeActionsList.end(), cAction),
+              activeActionsList.end());
         }
-        // Running/Initializing/Paused actions must be stopped
+        // Actions sent to the AGV must be stopped
         else {
           // Send action cancel request to AGV
           std_msgs::String cancel_msg;
-          cancel_msg.data = string(cAction->get()->getActionId());
-          messagePublisher["agvActionCancel"]->publish(cancel_msg);
-          cAction++;
+          cancel_msg.data = string(cAction->getActionId());
+          agvActionCancelPub.publish(cancel_msg);
+
+          cAction->cancelRequested = true;
+          outstandingActions++;
         }
       }
 
-      // Create new order to cancel
-      orderToCancel newOrderToCancel;
-      newOrderToCancel.orderIdToCancel = orderIdToCancel;
-      newOrderToCancel.iActionId = iaction.actionId;
+      // Create new order to cancel. The cancel action was added to the list above.
+      OrderCancellation newOrderToCancel;
+      newOrderToCancel.cancelAction = FindAction(iaction.actionId);
+      newOrderToCancel.outstandingActions = outstandingActions;
+      newOrderToCancel.orderCancelled = false;
       newOrderToCancel.allActionsCancelledSent = false;
-
-      // Add all remaining new actions to cancel to the list
-      if (!newActionsToCancel.empty())
-        newOrderToCancel.actionsToCancel.insert(newOrderToCancel.actionsToCancel.end(),
-            newActionsToCancel.begin(), newActionsToCancel.end());
-      // If no action to cancel remains (i.e. no action has been sent to the AGV already)
-      // -> remove order ID from cancellation list in update loop
-
-      // Add new order to cancel to list
-      orderCancellations.push_back(newOrderToCancel);
+      orderCancellations[orderIdToCancel] = newOrderToCancel;
 
       // Send cancel request to order daemon
       std_msgs::String cancelOrderMsg;
       cancelOrderMsg.data = orderIdToCancel;
       orderCancelPub.publish(cancelOrderMsg);
+
+      // If no action has been sent to the AGV, all actions are cancelled already
+      CompleteCancellation(orderIdToCancel);
     }
 
     // if the action contains no order cancel
     else {
-      // Push to instant action queue
-      instantActionQueue.push_back(iaction);
+      if (tracer.IsEnabled()) {
+        TraceSpan actionTrace = trace;
+        actionTrace.Mark(iaStages.enqueue);
+        instantActionTraces.erase(iaction.actionId);
+        instantActionTraces.emplace(iaction.actionId, actionTrace);
+      }
       // Create and publish action state msg
       vda5050_msgs::ActionState state_msg;
       state_msg.actionId = iaction.actionId;
       state_msg.actionType = iaction.actionType;
       state_msg.actionStatus = "WAITING";
       state_msg.resultDescription = "";  // Description necessary?
-      actionStatesPub.publish(state_msg);
+      ReportActionState(state_msg);
+
+      // Pausing and resuming must not wait for the actions they pause.
+      if (iaction.actionType == "startPause" || iaction.actionType == "stopPause")
+        SendActionToAgv(iaction);
+      else
+        instantActionQueue.push_back(iaction);
     }
   }
+
+  DrainInstantActions();
 }
 
 void ActionClient::AgvActionStateCallback(const vda5050_msgs::ActionState::ConstPtr& msg) {
   shared_ptr<ActionElement> actionToUpdate = FindAction(msg->actionId);
-  actionStatesPub.publish(msg);
 
   if (actionToUpdate) {
-    actionStatesPub.publish(*msg);
+    ReportActionState(*msg);
     if ((msg->actionStatus == "WAITING") || (msg->actionStatus == "INITIALIZING") ||
         (msg->actionStatus == "RUNNING") || (msg->actionStatus == "PAUSED")) {
       actionToUpdate->state = msg->actionStatus;
-      // actionStatesPub.publish(msg);
+
+      // The AGV took the action over, so it may run and pause as long as it needs.
+      if (actionToUpdate->sentToAgv && actionDeadlines.Disarm(actionToUpdate->actionId))
+        ScheduleDeadlineTimer();
     } else if (msg->actionStatus == "FINISHED") {
-      if (actionToUpdate->blockingType != "NONE") {
-        std_msgs::String resumeMsg;
-        resumeMsg.data = "RESUME";
-        messagePublisher["prDriving"]->publish(resumeMsg);
-      }
-      // actionStatesPub.publish(msg);
-      activeActionsList.erase(
-          remove(activeActionsList.begin(), activeActionsList.end(), actionToUpdate));
+      ReleaseAction(actionToUpdate, false);
+      DrainInstantActions();
     } else if (msg->actionStatus == "FAILED") {
-      if (actionToUpdate->blockingType != "NONE") {
-        std_msgs::String resumeMsg;
-        resumeMsg.data = "RESUME";
-        messagePublisher["prDriving"]->publish(resumeMsg);
-      }
-      // actionStatesPub.publish(msg);
-
-      activeActionsList.erase(
-          remove(activeActionsList.begin(), activeActionsList.end(), actionToUpdate));
-
-      std_msgs::String cancelMsg;
-      cancelMsg.data = "CANCEL ORDER";
-      orderCancelPub.publish(cancelMsg);
+      ReleaseAction(actionToUpdate, true);
+      DrainInstantActions();
     }
   } else
     ROS_WARN("Action to update not found!");
@@ -266,6 +313,166 @@ void ActionClient::AgvActionStateCallback(const vda5050_msgs::ActionState::Const
 
 void ActionClient::DrivingCallback(const std_msgs::Bool::ConstPtr& msg) { isDriving = msg->data; }
 
+void ActionClient::ReportActionState(const vda5050_msgs::ActionState& actionState) {
+  // Drop transitions to the status that was reported last.
+  auto lastStatus = reportedActionStatus.find(actionState.actionId);
+  if (lastStatus != reportedActionStatus.end() && lastStatus->second == actionState.actionStatus)
+    return;
+  reportedActionStatus[actionState.actionId] = actionState.actionStatus;
+
+  // Only the latest state of an action is kept in a batch.
+  auto pending = find_if(pendingActionStates.begin(), pendingActionStates.end(),
+      [&actionState](const vda5050_msgs::ActionState& as) {
+        return as.actionId == actionState.actionId;
+      });
+  if (pending != pendingActionStates.end())
+    *pending = actionState;
+  else
+    pendingActionStates.push_back(actionState);
+
+  // Terminal states are reported immediately.
+  if (actionState.actionStatus == "FINISHED" || actionState.actionStatus == "FAILED")
+    FlushActionStates();
+}
+
+void ActionClient::FlushActionStates() {
+  if (pendingActionStates.empty()) return;
+
+  // Publish as shared pointer, so subscribers in the same process receive it without a copy.
+  vda5050_msgs::State::Ptr actionStatesMsg = boost::make_shared<vda5050_msgs::State>();
+  actionStatesMsg->actionStates.swap(pendingActionStates);
+  actionStatesPub.publish(actionStatesMsg);
+
+  // Terminal actions do not change anymore and need no duplicate detection.
+  for (const auto& actionState : actionStatesMsg->actionStates) {
+    if (actionState.actionStatus == "FINISHED" || actionState.actionStatus == "FAILED")
+      reportedActionStatus.erase(actionState.actionId);
+  }
+}
+
+void ActionClient::SendActionToAgv(const vda5050_msgs::Action& action) {
+  shared_ptr<ActionElement> sentAction = FindAction(action.actionId);
+  if (sentAction) {
+    sentAction->sentToAgv = true;
+    ArmDeadline(*sentAction);
+    ScheduleDeadlineTimer();
+  }
+
+  auto trace = instantActionTraces.find(action.actionId);
+  if (trace != instantActionTraces.end()) trace->second.Mark(iaStages.queued);
+  actionToAgvPub.publish(action);
+  if (trace != instantActionTraces.end()) {
+    trace->second.Mark(iaStages.publish);
+    trace->second.End();
+    instantActionTraces.erase(trace);
+  }
+}
+
+double ActionClient::GetActionDeadline(const ActionElement& action) const {
+  for (auto const& param : action.actionParameters) {
+    if (param.key != "deadline") continue;
+    try {
+      return stod(param.value);
+    } catch (const std::exception& e) {
+      ROS_WARN("Invalid deadline \"%s\" of action %s", param.value.c_str(),
+          action.actionId.c_str());
+    }
+  }
+
+  auto typeDeadline = actionTypeDeadlines.find(action.actionType);
+  if (typeDeadline != actionTypeDeadlines.end()) return typeDeadline->second;
+
+  return defaultActionDeadline;
+}
+
+void ActionClient::ArmDeadline(const ActionElement& action) {
+  double deadline = GetActionDeadline(action);
+  if (deadline > 0.0)
+    actionDeadlines.Arm(action.actionId, ros::Time::now() + ros::Duration(deadline));
+  else
+    actionDeadlines.Disarm(action.actionId);
+}
+
+void ActionClient::ScheduleDeadlineTimer() {
+  boost::optional<ros::Time> nextDeadline = actionDeadlines.NextDeadline();
+  if (!nextDeadline) {
+    deadlineTimer.stop();
+    scheduledDeadline = ros::Time();
+    return;
+  }
+
+  // Firing too early is harmless, the callback reschedules the timer. It only has to be started
+  // again if the next deadline is earlier than the scheduled one.
+  if (!scheduledDeadline.isZero() && scheduledDeadline <= *nextDeadline) return;
+
+  ros::Duration delay = *nextDeadline - ros::Time::now();
+  if (delay < ros::Duration(0.001)) delay = ros::Duration(0.001);
+
+  scheduledDeadline = *nextDeadline;
+  deadlineTimer.stop();
+  deadlineTimer.setPeriod(delay);
+  deadlineTimer.start();
+}
+
+void ActionClient::DeadlineTimerCallback(const ros::TimerEvent& event) {
+  scheduledDeadline = ros::Time();
+
+  for (auto const& actionId : actionDeadlines.PopExpired(ros::Time::now())) {
+    shared_ptr<ActionElement> action = FindAction(actionId);
+    if (action) ActionDeadlineExpired(action);
+  }
+
+  ScheduleDeadlineTimer();
+}
+
+void ActionClient::ActionDeadlineExpired(const shared_ptr<ActionElement>& action) {
+  ROS_WARN("Action %s (%s) did not report a state within its deadline", action->actionId.c_str(),
+      action->actionType.c_str());
+
+  // Ask the AGV to stop the action. Late state updates of the action are ignored.
+  std_msgs::String cancelMsg;
+  cancelMsg.data = action->getActionId();
+  agvActionCancelPub.publish(cancelMsg);
+
+  vda5050_msgs::ActionState state_msg;
+  state_msg.actionId = action->getActionId();
+  state_msg.actionType = action->getActionType();
+  state_msg.actionStatus = "FAILED";
+  state_msg.resultDescription = "deadline expired";
+  ReportActionState(state_msg);
+
+  vda5050_msgs::Errors errorsMsg;
+  errorsMsg.errors.push_back(CreateWarningError("actionDeadlineExpired",
+      "AGV did not report a state of the action within its deadline",
+      {{static_cast<std::string>("actionId"), action->getActionId()},
+          {static_cast<std::string>("actionType"), action->getActionType()}}));
+  actionErrorsPub.publish(errorsMsg);
+
+  ReleaseAction(action, true);
+}
+
+void ActionClient::ReleaseAction(const shared_ptr<ActionElement>& action, bool failed) {
+  if (action->blockingType != "NONE") {
+    std_msgs::String resumeMsg;
+    resumeMsg.data = "RESUME";
+    prDrivingPub.publish(resumeMsg);
+  }
+  activeActionsList.erase(
+      remove(activeActionsList.begin(), activeActionsList.end(), action), activeActionsList.end());
+
+  // An earlier wake-up of the deadline timer is harmless, so it is not rescheduled here.
+  actionDeadlines.Disarm(action->actionId);
+
+  // Actions failing because of an order cancellation must not cancel the order again.
+  if (action->cancelRequested) {
+    CountDownCancellation(action);
+  } else if (failed) {
+    std_msgs::String cancelMsg;
+    cancelMsg.data = "CANCEL ORDER";
+    orderCancelPub.publish(cancelMsg);
+  }
+}
+
 void ActionClient::AddActionToList(
     const vda5050_msgs::Action* incomingAction, string orderId, string state) {
   shared_ptr<ActionElement> newAction = make_shared<ActionElement>(incomingAction, orderId, state);
@@ -276,7 +483,7 @@ bool ActionClient::CheckDriving() {
   if (isDriving) {
     std_msgs::String pauseMsg;
     pauseMsg.data = "PAUSE";
-    messagePublisher["prDriving"]->publish(pauseMsg);
+    prDrivingPub.publish(pauseMsg);
     return false;
   } else
     return true;
@@ -326,73 +533,62 @@ shared_ptr<ActionElement> ActionClient::FindAction(string actionId) {
     return *it;
 }
 
-void ActionClient::UpdateActions() {
-  // check if orders must be cancelled -> block all actions.
-  if (!orderCancellations.empty()) {
-    vector<orderToCancel> orderCancellationsFinished;
-    for (auto& orderCan_it : orderCancellations) {
-      // Remove failed/finished actions from observing list.
-      // FIXME: Does not work <-----------------------------------------------------------------.
-      if (!orderCan_it.actionsToCancel.empty()) {
-        orderCan_it.actionsToCancel.erase(
-            remove_if(orderCan_it.actionsToCancel.begin(), orderCan_it.actionsToCancel.end(),
-                [&](weak_ptr<ActionElement> const& p) { return p.expired(); }),
-            orderCan_it.actionsToCancel.end());
-      }
-      // FIXME: Does not work
-      // Only check the order cancel state, if all actions are cancelled.
-      if (orderCan_it.actionsToCancel.empty()) {
-        // send all actions cancelled signal to order daemon.
-        if (!orderCan_it.allActionsCancelledSent) {
-          std_msgs::String allActionsCancelledMsg;
-          allActionsCancelledMsg.data = orderCan_it.orderIdToCancel;
-          allActionsCancelledPub.publish(allActionsCancelledMsg);
-        }
+void ActionClient::CountDownCancellation(const shared_ptr<ActionElement>& action) {
+  auto cancellation = orderCancellations.find(action->orderId);
+  if (cancellation == orderCancellations.end()) return;
 
-        // Check if order has been cancelled by order daemon.
-        auto orderCancelled = find_if(ordersSucCancelled.begin(), ordersSucCancelled.end(),
-            [orderCan_it](string orderCanc) { return orderCan_it.orderIdToCancel == orderCanc; });
-        // If order has been cancelled by order deamon.
-        if (orderCancelled != ordersSucCancelled.end()) {
-          // Send action state finished.
-          auto actAct_it = find_if(activeActionsList.begin(), activeActionsList.end(),
-              [&orderCan_it](shared_ptr<ActionElement>& activeAction) {
-                return activeAction->compareActionId(orderCan_it.iActionId);
-              });
-          if (actAct_it != activeActionsList.end()) {
-            // Create and publish action state msg.
-            vda5050_msgs::ActionState state_msg;
-            state_msg.actionId = (**actAct_it).getActionId();
-            state_msg.actionType = (**actAct_it).getActionType();
-            state_msg.actionStatus = "FINISHED";
-            state_msg.resultDescription = "";  // Description necessary?.
-            actionStatesPub.publish(state_msg);
-
-            // Remove instant action from active actions list.
-            activeActionsList.erase(actAct_it);
-          } else {
-            ROS_ERROR_STREAM("ACTION NOT FOUND IN ACTIVE ACTIONS!");
-          }
+  if (cancellation->second.outstandingActions > 0) cancellation->second.outstandingActions--;
+  CompleteCancellation(action->orderId);
+}
 
-          // Remove order to cancel from orderSucCancelled list.
-          ordersSucCancelled.erase(orderCancelled);
-          // Remove order to cancel from orderCancellations list.
-          orderCancellationsFinished.push_back(orderCan_it);
-        }
-      }
-    }
-    // Delete from List.
-    for (auto const& finishedOrderCancel : orderCancellationsFinished) {
-      auto ordCan_it = find_if(orderCancellations.begin(), orderCancellations.end(),
-          [&finishedOrderCancel](orderToCancel& orderCancel) {
-            return orderCancel.iActionId == finishedOrderCancel.iActionId;
-          });
-      if (ordCan_it != orderCancellations.end()) orderCancellations.erase(ordCan_it);
-    }
+void ActionClient::CompleteCancellation(const string& orderId) {
+  auto cancellation = orderCancellations.find(orderId);
+  if (cancellation == orderCancellations.end()) return;
+  OrderCancellation& orderCan = cancellation->second;
+
+  // Wait until all cancelled actions stopped on the AGV.
+  if (orderCan.outstandingActions > 0) return;
+
+  // send all actions cancelled signal to order daemon.
+  if (!orderCan.allActionsCancelledSent) {
+    std_msgs::String allActionsCancelledMsg;
+    allActionsCancelledMsg.data = orderId;
+    allActionsCancelledPub.publish(allActionsCancelledMsg);
+    orderCan.allActionsCancelledSent = true;
+  }
+
+  // Wait until the order has been cancelled by order daemon.
+  if (!orderCan.orderCancelled) return;
+
+  if (orderCan.cancelAction) {
+    // Create and publish action state msg.
+    vda5050_msgs::ActionState state_msg;
+    state_msg.actionId = orderCan.cancelAction->getActionId();
+    state_msg.actionType = orderCan.cancelAction->getActionType();
+    state_msg.actionStatus = "FINISHED";
+    state_msg.resultDescription = "";  // Description necessary?.
+    ReportActionState(state_msg);
+
+    // Remove instant action from active actions list.
+    activeActionsList.erase(
+        remove(activeActionsList.begin(), activeActionsList.end(), orderCan.cancelAction),
+        activeActionsList.end());
+  } else {
+    ROS_ERROR_STREAM("ACTION NOT FOUND IN ACTIVE ACTIONS!");
   }
 
+  orderCancellations.erase(cancellation);
+}
+
+void ActionClient::UpdateActions() {
+  connector_utils::MeteredScope scope(&metrics, updateActionsMetric);
+
+  // Block all actions while orders are being cancelled. Cancellations complete on incoming action
+  // states and cancel confirmations, see CompleteCancellation.
+  if (!orderCancellations.empty()) return;
+
   // Instant action routine -> block order actions.
-  else if (!instantActionQueue.empty()) {
+  if (!instantActionQueue.empty()) {
     // get running actions.
     vector<shared_ptr<ActionElement>> runningPausedActions = GetRunningPausedActions();
 
@@ -409,58 +605,37 @@ void ActionClient::UpdateActions() {
 
         if (nextBlockType == "HARD") {
           if (CheckDriving()) {
-            // set sentToAgv to true.
-            auto sentAction = FindAction(instantActionQueue.front().actionId);
-            sentAction->sentToAgv = true;
-
-            // send action.
-            vda5050_msgs::Action instantActionMsg = instantActionQueue.front();
-            messagePublisher["actionToAgv"]->publish(instantActionMsg);
+            // send action to AGV.
+            SendActionToAgv(instantActionQueue.front());
             instantActionQueue.pop_front();
           }
           // Pause all actions.
           std_msgs::String pause_msg;
           pause_msg.data = "PAUSE";
-          messagePublisher["prActions"]->publish(pause_msg);
+          prActionsPub.publish(pause_msg);
         } else if (nextBlockType == "SOFT") {
           if (CheckDriving()) {
-            // set sentToAgv to true.
-            auto sentAction = FindAction(instantActionQueue.front().actionId);
-            sentAction->sentToAgv = true;
-
-            // send action.
-            vda5050_msgs::Action instantActionMsg = instantActionQueue.front();
-            messagePublisher["actionToAgv"]->publish(instantActionMsg);
+            // send action to AGV.
+            SendActionToAgv(instantActionQueue.front());
             instantActionQueue.pop_front();
           }
         } else if (nextBlockType == "NONE") {
-          // set sentToAgv to true.
-          auto sentAction = FindAction(instantActionQueue.front().actionId);
-          sentAction->sentToAgv = true;
-
-          // send action.
-          vda5050_msgs::Action instantActionMsg = instantActionQueue.front();
-          messagePublisher["actionToAgv"]->publish(instantActionMsg);
-
+          // send action to AGV.
+          SendActionToAgv(instantActionQueue.front());
           instantActionQueue.pop_front();
         }
       } else {
         // Pause all actions.
         std_msgs::String pause_msg;
         pause_msg.data = "PAUSE";
-        messagePublisher["prActions"]->publish(pause_msg);
+        prActionsPub.publish(pause_msg);
       }
     }
 
     // no action running.
     else {
-      // set sentToAgv to true.
-      auto sentAction = FindAction(instantActionQueue.front().actionId);
-      sentAction->sentToAgv = true;
-
       // send action to AGV.
-      vda5050_msgs::Action instantActionMsg = instantActionQueue.front();
-      messagePublisher["actionToAgv"]->publish(instantActionMsg);
+      SendActionToAgv(instantActionQueue.front());
       instantActionQueue.pop_front();
     }
   }
@@ -484,7 +659,7 @@ void ActionClient::UpdateActions() {
           if (action_it->state == "PAUSED") {
             std_msgs::String resume_msg;
             resume_msg.data = "RESUME";
-            messagePublisher["prActions"]->publish(resume_msg);
+            prActionsPub.publish(resume_msg);
           }
           // no actions to resume.
           else {
@@ -494,13 +669,8 @@ void ActionClient::UpdateActions() {
               // TODO: Check if last action still running.
               // If driving -> stop, else publish action.
               if (ActionClient::CheckDriving()) {
-                // set sentToAgv to true.
-                auto sentAction = FindAction(orderActionQueue.front().actionId);
-                sentAction->sentToAgv = true;
-
                 // send action to AGV.
-                vda5050_msgs::Action orderActionMsg = orderActionQueue.front();
-                messagePublisher["actionToAgv"]->publish(orderActionMsg);
+                SendActionToAgv(orderActionQueue.front());
                 orderActionQueue.pop_front();
               }
             }
@@ -508,25 +678,15 @@ void ActionClient::UpdateActions() {
             else if (nextBlockType == "SOFT") {
               // If driving -> stop, else publish action.
               if (CheckDriving()) {
-                // set sentToAgv to true.
-                auto sentAction = FindAction(orderActionQueue.front().actionId);
-                sentAction->sentToAgv = true;
-
                 // send action to AGV.
-                vda5050_msgs::Action orderActionMsg = orderActionQueue.front();
-                messagePublisher["actionToAgv"]->publish(orderActionMsg);
+                SendActionToAgv(orderActionQueue.front());
                 orderActionQueue.pop_front();
               }
             }
             // new action not blocking.
             else if (nextBlockType == "NONE") {
-              // set sentToAgv to true.
-              auto sentAction = FindAction(orderActionQueue.front().actionId);
-              sentAction->sentToAgv = true;
-
               // send action to AGV.
-              vda5050_msgs::Action orderActionMsg = orderActionQueue.front();
-              messagePublisher["actionToAgv"]->publish(orderActionMsg);
+              SendActionToAgv(orderActionQueue.front());
               orderActionQueue.pop_front();
             }
           }
@@ -536,29 +696,18 @@ void ActionClient::UpdateActions() {
 
     // no action running.
     else {
-      // set sentToAgv to true.
-      auto sentAction = FindAction(orderActionQueue.front().actionId);
-      sentAction->sentToAgv = true;
-
       // send action to AGV.
-      vda5050_msgs::Action orderActionMsg = orderActionQueue.front();
-      messagePublisher["actionToAgv"]->publish(orderActionMsg);
+      SendActionToAgv(orderActionQueue.front());
       orderActionQueue.pop_front();
     }
   }
 }
 
-int main(int argc, char** argv) {
-  ros::init(argc, argv, "action_deamon");
-
-  ActionClient ActionClient;
-
-  ros::Rate rate(0.05);
-
-  while (ros::ok()) {
-    ActionClient.UpdateActions();
-    ros::spinOnce();
-    rate.sleep();
+void ActionClient::DrainInstantActions() {
+  size_t queued = instantActionQueue.size();
+  while (queued > 0) {
+    UpdateActions();
+    if (instantActionQueue.size() == queued) break;
+    queued = instantActionQueue.size();
   }
-  return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <memory>
+#include "mqtt_bridge/mqtt_bridge.h"
+#include "vda5050_connector/action_client.h"
+#include "vda5050_connector/vda5050_connector.h"
+
+namespace vda5050_connector {
+
+/**
+ * Runs the action client inside a nodelet manager. Messages published as shared pointers are passed
+ * to other nodelets of the same manager without serialization.
+ */
+class ActionClientNodelet : public nodelet::Nodelet {
+ private:
+  std::unique_ptr<ActionClient> actionClient; /**< Action client run by this nodelet. */
+
+  void onInit() override {
+    actionClient.reset(new ActionClient(getNodeHandle(), getPrivateNodeHandle()));
+  }
+};
+
+/**
+ * Runs the VDA 5050 connector inside a nodelet manager. Messages published as shared pointers are
+ * passed to other nodelets of the same manager without serialization.
+ */
+class VDA5050ConnectorNodelet : public nodelet::Nodelet {
+ private:
+  std::unique_ptr<VDA5050Connector> connector; /**< Connector run by this nodelet. */
+
+  void onInit() override {
+    connector.reset(new VDA5050Connector(getNodeHandle(), getPrivateNodeHandle()));
+  }
+
+ public:
+  ~VDA5050ConnectorNodelet() {
+    // Send OFFLINE message to gracefully disconnect.
+    if (connector) connector->PublishConnection(false);
+  }
+};
+
+/**
+ * Runs the MQTT bridge inside a nodelet manager, so the messages of the connector reach the bridge
+ * without serialization.
+ */
+class MqttBridgeNodelet : public nodelet::Nodelet {
+ private:
+  std::unique_ptr<mqtt_bridge::MqttBridge> bridge; /**< Bridge run by this nodelet. */
+
+  void onInit() override {
+    bridge.reset(new mqtt_bridge::MqttBridge(getNodeHandle(), getPrivateNodeHandle()));
+  }
+};
+
+}  // namespace vda5050_connector
+
+PLUGINLIB_EXPORT_CLASS(vda5050_connector::ActionClientNodelet, nodelet::Nodelet)
+PLUGINLIB_EXPORT_CLASS(vda5050_connector::VDA5050ConnectorNodelet, nodelet::Nodelet)
+PLUGINLIB_EXPORT_CLASS(vda5050_connector::MqttBridgeNodelet, nodelet::Nodelet)
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "vda5050_connector/order_intake.h"
+#include <stdexcept>
+#include <vector>
+
+using namespace connector_utils;
+
+/**
+ * Names of the stages, in the order of OrderIntake::Stage.
+ */
+static const char* const STAGE_NAMES[] = {"duplicate filter", "structure validation",
+    "capability validation", "base stitching", "state update", "publish"};
+
+/**
+ * Names of the rejection reasons, in the order of OrderIntake::Rejection.
+ */
+static const char* const REJECTION_NAMES[] = {"duplicate", "stale update", "invalid structure",
+    "exceeds capabilities", "base mismatch", "order active", "out of deviation range"};
+
+static_assert(sizeof(STAGE_NAMES) / sizeof(STAGE_NAMES[0]) == OrderIntake::STAGE_COUNT,
+    "Every stage needs a name");
+static_assert(sizeof(REJECTION_NAMES) / sizeof(REJECTION_NAMES[0]) == OrderIntake::REJECTION_COUNT,
+    "Every rejection needs a name");
+
+/**
+ * Checks the actions of a node or an edge against the capabilities.
+ *
+ * @return  Description of the first violation, empty if there is none.
+ */
+static std::string CheckActions(
+    const std::vector<vda5050_msgs::Action>& actions, const OrderCapabilities& capabilities) {
+  if (capabilities.maxActions > 0 && actions.size() > capabilities.maxActions) {
+    return std::to_string(actions.size()) + " actions, the vehicle supports " +
+           std::to_string(capabilities.maxActions);
+  }
+  for (const auto& action : actions) {
+    if (capabilities.maxIdLength > 0 && action.actionId.size() > capabilities.maxIdLength)
+      return "Action ID " + action.actionId + " is too long";
+    if (!capabilities.actionTypes.empty() && !capabilities.actionTypes.count(action.actionType))
+      return "Action type " + action.actionType + " is not supported";
+  }
+  return "";
+}
+
+bool OrderIntake::Verdict::Reject(Rejection rejection, const std::string& reason) {
+  accepted = false;
+  this->rejection = rejection;
+  this->reason = reason;
+  return false;
+}
+
+OrderIntake::OrderIntake(
+    Metrics* metrics, Tracer* tracer, const OrderCapabilities& capabilities)
+    : metrics(metrics), capabilities(capabilities) {
+  for (size_t stage = 0; stage < STAGE_COUNT; stage++) {
+    stageMetrics[stage] =
+        MeteredScope::AddTimed(metrics, std::string("order ") + STAGE_NAMES[stage]);
+    stageTraces[stage] = tracer->AddStage(std::string("order ") + STAGE_NAMES[stage]);
+  }
+  for (size_t rejection = 0; rejection < REJECTION_COUNT; rejection++) {
+    rejectionMetrics[rejection] =
+        metrics->AddCounter(std::string("order rejected ") + REJECTION_NAMES[rejection]);
+  }
+  acceptedMetric = metrics->AddCounter("order accepted");
+}
+
+const char* OrderIntake::GetRejectionName(Rejection rejection) {
+  return rejection < REJECTION_COUNT ? REJECTION_NAMES[rejection] : "unknown";
+}
+
+bool OrderIntake::FilterDuplicate(const Order& order, State& state, Verdict* verdict) const {
+  // TODO : Check if the state has an active order, not the order ID alone.
+  if (state.GetOrderId() != order.GetOrderId()) return true;
+
+  if (state.GetOrderUpdateId() > order.GetOrderUpdateId())
+    return verdict->Reject(STALE_UPDATE, "Received order update with a lower order update ID");
+  if (state.GetOrderUpdateId() == order.GetOrderUpdateId())
+    return verdict->Reject(DUPLICATE, "Order discarded. Message already received!");
+
+  verdict->update = true;
+  return true;
+}
+
+bool OrderIntake::ValidateStructure(const Order& order, Verdict* verdict) const {
+  try {
+    order.Validate();
+  } catch (const std::exception& e) {
+    return verdict->Reject(INVALID_STRUCTURE, e.what());
+  }
+  return true;
+}
+
+bool OrderIntake::ValidateCapabilities(const Order& order, Verdict* verdict) const {
+  const auto& nodes = order.GetNodes();
+  const auto& edges = order.GetEdges();
+
+  if (capabilities.maxNodes > 0 && nodes.size() > capabilities.maxNodes) {
+    return verdict->Reject(EXCEEDS_CAPABILITIES, "Order has " + std::to_string(nodes.size()) +
+                                                     " nodes, the vehicle supports " +
+                                                     std::to_string(capabilities.maxNodes));
+  }
+  if (capabilities.maxEdges > 0 && edges.size() > capabilities.maxEdges) {
+    return verdict->Reject(EXCEEDS_CAPABILITIES, "Order has " + std::to_string(edges.size()) +
+                                                     " edges, the vehicle supports " +
+                                                     std::to_string(capabilities.maxEdges));
+  }
+  if (capabilities.maxIdLength > 0 && order.GetOrderId().size() > capabilities.maxIdLength)
+    return verdict->Reject(EXCEEDS_CAPABILITIES, "Order ID is too long");
+
+  for (const auto& node : nodes) {
+    if (capabilities.maxIdLength > 0 && node.nodeId.size() > capabilities.maxIdLength)
+      return verdict->Reject(EXCEEDS_CAPABILITIES, "Node ID " + node.nodeId + " is too long");
+    std::string violation = CheckActions(node.actions, capabilities);
+    if (!violation.empty())
+      return verdict->Reject(EXCEEDS_CAPABILITIES, "Node " + node.nodeId + ": " + violation);
+  }
+  for (const auto& edge : edges) {
+    if (capabilities.maxIdLength > 0 && edge.edgeId.size() > capabilities.maxIdLength)
+      return verdict->Reject(EXCEEDS_CAPABILITIES, "Edge ID " + edge.edgeId + " is too long");
+    if (!capabilities.trajectories && !edge.trajectory.controlPoints.empty()) {
+      return verdict->Reject(EXCEEDS_CAPABILITIES,
+          "Edge " + edge.edgeId + " has a trajectory, the vehicle does not follow trajectories");
+    }
+    std::string violation = CheckActions(edge.actions, capabilities);
+    if (!violation.empty())
+      return verdict->Reject(EXCEEDS_CAPABILITIES, "Edge " + edge.edgeId + ": " + violation);
+  }
+  return true;
+}
+
+bool OrderIntake::StitchBase(
+    const Order& order, State& state, const Order& current, Verdict* verdict) const {
+  if (order.GetNodes().empty()) return verdict->Reject(INVALID_STRUCTURE, "Order has no nodes");
+
+  if (verdict->update) {
+    // Compare the information of the last order with the received order update.
+    try {
+      state.ValidateUpdateBase(order);
+    } catch (const std::runtime_error& e) {
+      return verdict->Reject(BASE_MISMATCH, e.what());
+    }
+    return true;
+  }
+
+  // A new order can only be started if no order is active, and the vehicle is in the deviation
+  // range of the first node.
+  if (state.HasActiveOrder(current))
+    return verdict->Reject(ORDER_ACTIVE, "Vehicle received a new order while executing an order!");
+  if (!state.InDeviationRange(order.GetNodes().front())) {
+    return verdict->Reject(OUT_OF_DEVIATION_RANGE,
+        "Vehicle not inside the deviation range of the first node in the order.");
+  }
+  return true;
+}
+
+OrderIntake::Verdict OrderIntake::Check(
+    const Order& order, State& state, const Order& current, TraceSpan* trace) {
+  Verdict verdict;
+  RunStage(DUPLICATE_FILTER, [&] { FilterDuplicate(order, state, &verdict); }, trace);
+  if (verdict.accepted)
+    RunStage(STRUCTURE_VALIDATION, [&] { ValidateStructure(order, &verdict); }, trace);
+  if (verdict.accepted)
+    RunStage(CAPABILITY_VALIDATION, [&] { ValidateCapabilities(order, &verdict); }, trace);
+  if (verdict.accepted)
+    RunStage(BASE_STITCHING, [&] { StitchBase(order, state, current, &verdict); }, trace);
+
+  metrics->Add(verdict.accepted ? acceptedMetric : rejectionMetrics[verdict.rejection]);
+  return verdict;
+}
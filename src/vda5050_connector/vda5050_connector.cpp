@@ -8,263 +8,529 @@
  */
 
 #include "vda5050_connector/vda5050_connector.h"
+#include <ros/serialization.h>
+#include <boost/make_shared.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "mqtt_bridge/vda5050_decoders.h"
 
 using namespace connector_utils;
 
-constexpr char VERSION_PARAM[] = "/header/version";
-constexpr char MANUFACTURER_PARAM[] = "/header/manufacturer";
-constexpr char SN_PARAM[] = "/header/serial_number";
+constexpr char HEADER_NS[] = "/header";
+constexpr char VERSION_PARAM[] = "version";
+constexpr char MANUFACTURER_PARAM[] = "manufacturer";
+constexpr char SN_PARAM[] = "serial_number";
+
+/**
+ * Kinds of the journal records, each holding a serialized message.
+ */
+enum JournalKind : uint8_t {
+  ORDER_ACCEPTED = 1, /**< Order passed to AcceptNewOrder. */
+  ORDER_UPDATED = 2,  /**< Order passed to UpdateExistingOrder. */
+  ORDER_STATE = 3,    /**< State message received on order_state. */
+  ACTION_STATES = 4,  /**< State message received on action_states. */
+  ORDER_SNAPSHOT = 5, /**< Current order, written by a compaction. */
+};
+
+/**
+ * Creates the state of an instant action handled by the connector.
+ */
+static vda5050_msgs::ActionState CreateActionState(
+    const vda5050_msgs::Action& action, const std::string& status) {
+  vda5050_msgs::ActionState actionState;
+  actionState.actionId = action.actionId;
+  actionState.actionType = action.actionType;
+  actionState.actionStatus = status;
+  return actionState;
+}
+
+/**
+ * Serializes a message for the journal.
+ */
+template <typename M>
+static std::vector<uint8_t> Serialize(const M& msg) {
+  std::vector<uint8_t> data(ros::serialization::serializationLength(msg));
+  ros::serialization::OStream stream(data.data(), data.size());
+  ros::serialization::serialize(stream, msg);
+  return data;
+}
+
+/**
+ * Deserializes a message of a journal record.
+ *
+ * @throws ros::serialization::StreamOverrunException if the record is too short.
+ */
+template <typename M>
+static boost::shared_ptr<M> Deserialize(JournalRecord& record) {
+  boost::shared_ptr<M> msg = boost::make_shared<M>();
+  ros::serialization::IStream stream(
+      reinterpret_cast<uint8_t*>(&record.data[0]), record.data.size());
+  ros::serialization::deserialize(stream, *msg);
+  return msg;
+}
 
 /*-------------------------------------VDA5050Connector--------------------------------------------*/
 
-VDA5050Connector::VDA5050Connector() : state(State()), order(Order()) {
+VDA5050Connector::VDA5050Connector()
+    : VDA5050Connector(ros::NodeHandle(), ros::NodeHandle("~")) {}
+
+VDA5050Connector::VDA5050Connector(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh)
+    : VDA5050Connector(nh, private_nh, "") {}
+
+VDA5050Connector::VDA5050Connector(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh,
+    const std::string& serialNumber)
+    : VDA5050Node(nh, private_nh), state(State()), order(Order()),
+      orderIntake(&metrics, &tracer) {
+  orderStages = {tracer.AddStage("order total"), tracer.AddStage("order receipt")};
+  iaStages = {tracer.AddStage("instant action total"), tracer.AddStage("instant action receipt"),
+      tracer.AddStage("instant action publish")};
+  publishStateMetric = connector_utils::MeteredScope::AddTimed(&metrics, "PublishState");
+
   // Link publish and subsription ROS topics*/
   LinkPublishTopics(&(this->nh));
   LinkSubscriptionTopics(&(this->nh));
 
+  // The header fields are global, all of them are fetched at once.
+  ParamTree header = ParamTree::Fetch(HEADER_NS);
+
   // Read header version.
-  if (ros::param::has(VERSION_PARAM)) {
-    std::string version;
-    ros::param::get(VERSION_PARAM, version);
+  std::string version;
+  if (header.Get(VERSION_PARAM, version)) {
     state.SetVersion(version);
   } else {
-    ROS_ERROR("%s not found in the configuration!", VERSION_PARAM);
+    ROS_ERROR("%s/%s not found in the configuration!", HEADER_NS, VERSION_PARAM);
   }
 
   // Read header manufacturer.
-  if (ros::param::has(MANUFACTURER_PARAM)) {
-    std::string manufacturer;
-    ros::param::get(MANUFACTURER_PARAM, manufacturer);
+  std::string manufacturer;
+  if (header.Get(MANUFACTURER_PARAM, manufacturer)) {
     state.SetManufacturer(manufacturer);
   } else {
-    ROS_ERROR("%s not found in the configuration!", MANUFACTURER_PARAM);
+    ROS_ERROR("%s/%s not found in the configuration!", HEADER_NS, MANUFACTURER_PARAM);
   }
 
   // Read header serialNumber.
   // TODO : The serial number needs to be read from the client ID Text file!
-  if (ros::param::has(SN_PARAM)) {
-    std::string sn;
-    ros::param::get(SN_PARAM, sn);
+  std::string sn;
+  if (!serialNumber.empty()) {
+    state.SetSerialNumber(serialNumber);
+  } else if (header.Get(SN_PARAM, sn)) {
     state.SetSerialNumber(sn);
   } else {
-    ROS_ERROR("%s not found in the configuration!", SN_PARAM);
+    ROS_ERROR("%s/%s not found in the configuration!", HEADER_NS, SN_PARAM);
   }
 
-  ros::NodeHandle private_nh("~");
-  double stateMsgPeriod, visMsgPeriod, connMsgPeriod;
-  private_nh.param<double>("publish_periods/state_msg", stateMsgPeriod, 0.8);
-  private_nh.param<double>("publish_periods/visualization_msg", visMsgPeriod, 0.3);
-  private_nh.param<double>("publish_periods/conn_msg", connMsgPeriod, 15.0);
+  ReadPublishConfiguration();
+  params.Param<double>("zones/cell_size", zoneCellSize, 1.0);
+  double maxSpeed;
+  params.Param<double>("order_geometry/max_speed", maxSpeed, 1.0);
+  order.SetMaxSpeed(maxSpeed);
+  ReadCapabilities();
 
-  stateTimer = nh.createTimer(
+  stateTimer = this->nh.createTimer(
       ros::Duration(stateMsgPeriod), std::bind(&VDA5050Connector::PublishState, this));
-  visTimer = nh.createTimer(
+  visTimer = this->nh.createTimer(
       ros::Duration(visMsgPeriod), std::bind(&VDA5050Connector::PublishVisualization, this));
-  connTimer = nh.createTimer(
+  connTimer = this->nh.createTimer(
       ros::Duration(connMsgPeriod), std::bind(&VDA5050Connector::PublishConnection, this, true));
+  updateTimer =
+      this->nh.createTimer(ros::Duration(updatePeriod), std::bind(&VDA5050Connector::Update, this));
   newPublishTrigger = true;
-}
 
-void VDA5050Connector::LinkPublishTopics(ros::NodeHandle* nh) {
-  std::map<std::string, std::string> topicList =
-      GetTopicList(ros::this_node::getName() + "/publish_topics");
-
-  for (const auto& elem : topicList) {
-    if (CheckParamIncludes(elem.first, "order"))
-      orderPublisher = nh->advertise<vda5050_msgs::Order>(elem.second, 100);
-    else if (CheckParamIncludes(elem.first, "instant_action"))
-      iaPublisher = nh->advertise<vda5050_msgs::InstantAction>(elem.second, 100);
-    else if (CheckParamIncludes(elem.first, "state")) {
-      statePublisher = nh->advertise<vda5050_msgs::State>(elem.second, 100);
-    } else if (CheckParamIncludes(elem.first, "visualization")) {
-      visPublisher = nh->advertise<vda5050_msgs::Visualization>(elem.second, 100);
-    } else if (CheckParamIncludes(elem.first, "connection")) {
-      connectionPublisher = nh->advertise<vda5050_msgs::Connection>(elem.second, 100);
+  AddGauge("internal_errors_stamped size", [this] { return internal_errors_stamped.size(); });
+  SetupMetrics();
+  SetupJournal();
+  LogStartupTime();
+}
+
+VDA5050Connector::~VDA5050Connector() { StopPriorityLane(); }
+
+const VDA5050Connector::InstantActionBinding VDA5050Connector::instantActionBindings[] = {
+    {"stateRequest", &VDA5050Connector::HandleStateRequest},
+    {"cancelOrder", &VDA5050Connector::HandleCancelOrder},
+};
+
+const TopicBinding<VDA5050Connector> VDA5050Connector::publishBindings[] = {
+    {"order", 100,
+        &Advertise<VDA5050Connector, vda5050_msgs::Order, &VDA5050Connector::orderPublisher>},
+    {"instant_action", 100,
+        &Advertise<VDA5050Connector, vda5050_msgs::InstantAction, &VDA5050Connector::iaPublisher>},
+    {"state", 100,
+        &Advertise<VDA5050Connector, vda5050_msgs::State, &VDA5050Connector::statePublisher>},
+    {"visualization", 100,
+        &Advertise<VDA5050Connector, vda5050_msgs::Visualization, &VDA5050Connector::visPublisher>},
+    {"connection", 100,
+        &Advertise<VDA5050Connector, vda5050_msgs::Connection,
+            &VDA5050Connector::connectionPublisher>},
+};
+
+const TopicBinding<VDA5050Connector> VDA5050Connector::subscribeBindings[] = {
+    {"order_from_mc", 100,
+        &SubscribeTraced<VDA5050Connector, vda5050_msgs::Order,
+            &VDA5050Connector::OrderCallback>},
+    {"ia_from_mc", 100,
+        &SubscribePriority<VDA5050Connector, vda5050_msgs::InstantAction,
+            &VDA5050Connector::InstantActionCallback>},
+    {"order_state", 100,
+        &Subscribe<VDA5050Connector, vda5050_msgs::State, &VDA5050Connector::OrderStateCallback>},
+    {"action_states", 100,
+        &Subscribe<VDA5050Connector, vda5050_msgs::State, &VDA5050Connector::ActionStatesCallback>},
+    {"action_errors", 100,
+        &Subscribe<VDA5050Connector, vda5050_msgs::Errors,
+            &VDA5050Connector::ActionErrorsCallback>},
+    {"zone_set_id", 100,
+        &Subscribe<VDA5050Connector, std_msgs::String, &VDA5050Connector::ZoneSetIdCallback>},
+    {"pose", 100,
+        &Subscribe<VDA5050Connector, geometry_msgs::Pose, &VDA5050Connector::AGVPositionCallback>},
+    {"localization_score", 100,
+        &Subscribe<VDA5050Connector, std_msgs::Float64, &VDA5050Connector::LocScoreCallback>},
+    {"map_id", 100,
+        &Subscribe<VDA5050Connector, std_msgs::String,
+            &VDA5050Connector::AGVPositionMapIdCallback>},
+    {"position_initialized", 100,
+        &Subscribe<VDA5050Connector, std_msgs::Bool,
+            &VDA5050Connector::AGVPositionInitializedCallback>},
+    {"velocity", 100,
+        &Subscribe<VDA5050Connector, geometry_msgs::Twist, &VDA5050Connector::AGVVelocityCallback>},
+    {"loads", 100,
+        &Subscribe<VDA5050Connector, vda5050_msgs::Loads, &VDA5050Connector::LoadsCallback>},
+    {"paused", 100,
+        &Subscribe<VDA5050Connector, std_msgs::Bool, &VDA5050Connector::PausedCallback>},
+    {"new_base_request", 100,
+        &Subscribe<VDA5050Connector, std_msgs::Bool, &VDA5050Connector::NewBaseRequestCallback>},
+    {"distance_since_last_node", 100,
+        &Subscribe<VDA5050Connector, std_msgs::Float64,
+            &VDA5050Connector::DistanceSinceLastNodeCallback>},
+    {"battery_state", 100,
+        &Subscribe<VDA5050Connector, sensor_msgs::BatteryState,
+            &VDA5050Connector::BatteryStateCallback>},
+    {"operating_mode", 100,
+        &Subscribe<VDA5050Connector, std_msgs::String, &VDA5050Connector::OperatingModeCallback>},
+    {"errors", 100,
+        &Subscribe<VDA5050Connector, vda5050_msgs::Errors, &VDA5050Connector::ErrorsCallback>},
+    {"information", 100,
+        &Subscribe<VDA5050Connector, vda5050_msgs::Information,
+            &VDA5050Connector::InformationCallback>},
+    {"safety_state", 100,
+        &Subscribe<VDA5050Connector, vda5050_msgs::SafetyState,
+            &VDA5050Connector::SafetyStateCallback>},
+    {"interaction_zones", 100,
+        &Subscribe<VDA5050Connector, vda5050_msgs::InteractionZoneStates,
+            &VDA5050Connector::InteractionZoneCallback>},
+    {"zone_set", 10,
+        &Subscribe<VDA5050Connector, std_msgs::String, &VDA5050Connector::ZoneSetCallback>},
+    {"mqtt_link_state", 10,
+        &Subscribe<VDA5050Connector, std_msgs::Bool, &VDA5050Connector::LinkStateCallback>},
+    {"uplink_throttle", 10,
+        &Subscribe<VDA5050Connector, std_msgs::UInt8,
+            &VDA5050Connector::UplinkThrottleCallback>},
+};
+
+size_t VDA5050Connector::LinkPublishTopics(ros::NodeHandle* nh) {
+  return LinkTopics(this, nh, "publish_topics", publishBindings);
+}
+
+size_t VDA5050Connector::LinkSubscriptionTopics(ros::NodeHandle* nh) {
+  return LinkTopics(this, nh, "subscribe_topics", subscribeBindings);
+}
+
+void VDA5050Connector::ReadPublishConfiguration() {
+  params.Param<double>("publish_periods/state_msg", stateMsgPeriod, 0.8);
+  params.Param<double>("publish_periods/visualization_msg", visMsgPeriod, 0.3);
+  params.Param<double>("publish_periods/conn_msg", connMsgPeriod, 15.0);
+  params.Param<double>("update_period", updatePeriod, 1.0);
+  params.Param<double>("uplink_throttle/max_visualization_period", maxVisMsgPeriod, 2.4);
+  params.Param<int>("uplink_throttle/trim_state_level", trimStateLevel, 2);
+  params.Param<double>("visualization_deadband/distance", visDeadbandDistance, 0.0);
+  params.Param<double>("visualization_deadband/angle", visDeadbandAngle, 0.0);
+}
+
+size_t VDA5050Connector::Reconfigure() {
+  ReadPublishConfiguration();
+  stateTimer.setPeriod(ros::Duration(stateMsgPeriod));
+  connTimer.setPeriod(ros::Duration(connMsgPeriod));
+  updateTimer.setPeriod(ros::Duration(updatePeriod));
+  UpdateVisualizationPeriod();
+  return LinkPublishTopics(&nh) + LinkSubscriptionTopics(&nh);
+}
+
+template <typename M>
+void VDA5050Connector::AppendToJournal(uint8_t kind, const M& msg) {
+  if (!journal || replaying) return;
+
+  std::vector<uint8_t> data = Serialize(msg);
+  if (!journal->Append(kind, data.data(), data.size())) {
+    CompactJournal();
+    if (!journal->Append(kind, data.data(), data.size())) {
+      ROS_WARN_THROTTLE(60, "Journal is full, raise journal/capacity");
+      return;
     }
   }
+  if (journalSync) journal->Sync();
 }
 
-void VDA5050Connector::LinkSubscriptionTopics(ros::NodeHandle* nh) {
-  std::map<std::string, std::string> topic_list =
-      GetTopicList(ros::this_node::getName() + "/subscribe_topics");
-  for (const auto& elem : topic_list) {
-    if (CheckParamIncludes(elem.first, "order_from_mc"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::OrderCallback, this)));
-    else if (CheckParamIncludes(elem.first, "ia_from_mc"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::InstantActionCallback, this)));
-    else if (CheckParamIncludes(elem.first, "order_state"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::OrderStateCallback, this)));
-    else if (CheckParamIncludes(elem.first, "zone_set_id"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::ZoneSetIdCallback, this)));
-    else if (CheckParamIncludes(elem.first, "pose"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::AGVPositionCallback, this)));
-    else if (CheckParamIncludes(elem.first, "localization_score"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::LocScoreCallback, this)));
-    else if (CheckParamIncludes(elem.first, "map_id"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::AGVPositionMapIdCallback, this)));
-    else if (CheckParamIncludes(elem.first, "position_initialized"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(nh->subscribe(
-          elem.second, 100, &VDA5050Connector::AGVPositionInitializedCallback, this)));
-    else if (CheckParamIncludes(elem.first, "velocity"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::AGVVelocityCallback, this)));
-    else if (CheckParamIncludes(elem.first, "loads"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::LoadsCallback, this)));
-    else if (CheckParamIncludes(elem.first, "paused"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::PausedCallback, this)));
-    else if (CheckParamIncludes(elem.first, "new_base_request"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::NewBaseRequestCallback, this)));
-    else if (CheckParamIncludes(elem.first, "distance_since_last_node"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::DistanceSinceLastNodeCallback, this)));
-    else if (CheckParamIncludes(elem.first, "battery_state"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::BatteryStateCallback, this)));
-    else if (CheckParamIncludes(elem.first, "operating_mode"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::OperatingModeCallback, this)));
-    else if (CheckParamIncludes(elem.first, "errors"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::ErrorsCallback, this)));
-    else if (CheckParamIncludes(elem.first, "information"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::InformationCallback, this)));
-    else if (CheckParamIncludes(elem.first, "safety_state"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::SafetyStateCallback, this)));
-    else if (CheckParamIncludes(elem.first, "interaction_zones"))
-      this->subscribers.push_back(std::make_shared<ros::Subscriber>(
-          nh->subscribe(elem.second, 100, &VDA5050Connector::InteractionZoneCallback, this)));
-  }
-}
+void VDA5050Connector::SetupJournal() {
+  std::string file;
+  params.Param<std::string>("journal/file", file, "");
+  if (file.empty()) return;
 
-void VDA5050Connector::OrderCallback(const vda5050_msgs::Order::ConstPtr& msg) {
-  ROS_INFO("New order received.");
-  ROS_DEBUG("  Order id : %s", msg->orderId.c_str());
-  ROS_DEBUG("  Order update id : %d", msg->orderUpdateId);
-
-  Order new_order(msg);
+  int capacity;
+  double compactionPeriod;
+  params.Param<int>("journal/capacity", capacity, 16777216);
+  params.Param<double>("journal/compaction_period", compactionPeriod, 60.0);
+  params.Param<bool>("journal/sync", journalSync, false);
 
+  file = GetNamespacedFile(file);
   try {
-    // Run the order validation.
-    new_order.Validate();
-  } catch (const std::runtime_error& e) {
-    ROS_ERROR("Validation error occurred : %s", e.what());
-
-    // Add error and corresponding references to the state.
-    auto error = CreateWarningError("orderValidation", e.what(),
-        {{static_cast<std::string>("orderId"), new_order.GetOrderId()}});
-    AddInternalError(error);
-
-    return;
+    journal.reset(new Journal(file, std::max(capacity, 1024)));
   } catch (const std::exception& e) {
-    ROS_ERROR("Error occurred : %s", e.what());
+    ROS_ERROR("Orders are not journaled: %s", e.what());
+    return;
+  }
 
-    auto error = CreateWarningError(
-        "orderCreation", e.what(), {{static_cast<std::string>("orderId"), new_order.GetOrderId()}});
-    AddInternalError(error);
+  ros::WallTime start = ros::WallTime::now();
+  size_t replayed = ReplayJournal();
+  if (replayed > 0) {
+    ROS_INFO("Restored order %s from %zu journal records of %s in %.1f ms",
+        state.GetOrderId().c_str(), replayed, file.c_str(),
+        (ros::WallTime::now() - start).toSec() * 1000.0);
+    newPublishTrigger = true;
+  }
 
-    return;
+  AddGauge("journal used bytes", [this] { return journal->GetUsed(); });
+  compactionTimer = nh.createTimer(ros::Duration(compactionPeriod),
+      boost::function<void(const ros::TimerEvent&)>(
+          [this](const ros::TimerEvent&) { CompactJournal(); }));
+}
+
+size_t VDA5050Connector::ReplayJournal() {
+  std::vector<JournalRecord> records = journal->Read();
+  replaying = true;
+  size_t replayed = 0;
+  try {
+    for (JournalRecord& record : records) {
+      switch (record.kind) {
+        case ORDER_ACCEPTED:
+          AcceptNewOrder(Order(Deserialize<vda5050_msgs::Order>(record)));
+          break;
+        case ORDER_UPDATED:
+          UpdateExistingOrder(Order(Deserialize<vda5050_msgs::Order>(record)));
+          break;
+        case ORDER_STATE:
+          OrderStateCallback(Deserialize<vda5050_msgs::State>(record));
+          break;
+        case ACTION_STATES:
+          ActionStatesCallback(Deserialize<vda5050_msgs::State>(record));
+          break;
+        case ORDER_SNAPSHOT:
+          order.AcceptNewOrder(Order(Deserialize<vda5050_msgs::Order>(record)));
+          break;
+        default:
+          ROS_WARN("Journal record of unknown kind %d skipped", record.kind);
+          continue;
+      }
+      replayed++;
+    }
+  } catch (const std::exception& e) {
+    ROS_ERROR("Journal replay stopped after %zu records: %s", replayed, e.what());
   }
+  replaying = false;
+  return replayed;
+}
 
-  // TODO : Check if the state has an active order, not the new_order.
-  if (state.GetOrderId() == new_order.GetOrderId()) {
-    // Check if the received order message is an update.
-    if (state.GetOrderUpdateId() > new_order.GetOrderUpdateId()) {
-      std::string error_msg = "Received order update with a lower order update ID";
-      ROS_ERROR("Error has occurred : %s", error_msg.c_str());
+void VDA5050Connector::CompactJournal() {
+  if (!journal || journal->GetRecordCount() <= 2) return;
 
-      // Create error and add error to list of references.
-      auto error = CreateWarningError("orderCreation", error_msg,
-          {{static_cast<std::string>("orderId"), new_order.GetOrderId()},
-              {static_cast<std::string>("orderUpdateId"),
-                  std::to_string(new_order.GetOrderUpdateId())}});
-      AddInternalError(error);
+  // The order and the order fields of the state hold everything the records changed.
+  std::vector<JournalRecord> snapshot;
+  std::vector<uint8_t> data = Serialize(order.GetOrderMsg());
+  snapshot.push_back({ORDER_SNAPSHOT, std::string(data.begin(), data.end())});
+  data = Serialize(state.GetState());
+  snapshot.push_back({ORDER_STATE, std::string(data.begin(), data.end())});
 
+  size_t records = journal->GetRecordCount();
+  try {
+    if (!journal->Compact(snapshot)) {
+      ROS_WARN_THROTTLE(60, "Journal snapshot does not fit into %zu bytes, raise journal/capacity",
+          journal->GetCapacity());
       return;
+    }
+  } catch (const std::exception& e) {
+    ROS_ERROR("Journal compaction failed: %s", e.what());
+    return;
+  }
+  ROS_DEBUG("Journal compacted from %zu to %zu records", records, snapshot.size());
+}
 
-      // Discard any already received order updates.
-    } else if (state.GetOrderUpdateId() == new_order.GetOrderUpdateId()) {
-      ROS_WARN_STREAM("Order discarded. Message already received! "
-                      << new_order.GetOrderId() << ", " << new_order.GetOrderUpdateId());
-      return;
-    } else {
-      // Compare the information of the last order with the newly received order update.
-      try {
-        state.ValidateUpdateBase(new_order);
-      } catch (const std::runtime_error& e) {
-        ROS_ERROR("Update base validation failed. %s", e.what());
+void VDA5050Connector::OrderCallback(const vda5050_msgs::Order::ConstPtr& msg) {
+  ROS_INFO("New order received.");
+  ROS_DEBUG("  Order id : %s", msg->orderId.c_str());
+  ROS_DEBUG("  Order update id : %d", msg->orderUpdateId);
 
-        // Add error to the state message.
+  TraceSpan trace(&tracer, orderStages.total, receiptTime);
+  trace.Mark(orderStages.receipt);
 
-        return;
-      }
+  Order new_order(msg);
+  OrderIntake::Verdict verdict = orderIntake.Check(new_order, state, order, &trace);
+  if (!verdict.accepted) {
+    RejectOrder(new_order, verdict);
+    return;
+  }
 
+  orderIntake.RunStage(OrderIntake::STATE_UPDATE, [&] {
+    if (verdict.update) {
       // Accept the order update by updating the state and the order message.
       UpdateExistingOrder(new_order);
-
-      ROS_INFO("Sending order update");
-
-      // Send the order update.
-      orderPublisher.publish(msg);
+    } else {
+      // Accept the new order by updating the state message and the order.
+      AcceptNewOrder(new_order);
     }
+  }, &trace);
 
-  } else {
-    // If no order is active, and the robot is in the deviation range of the first node, the order
-    // can be started.
-    if (state.HasActiveOrder(order)) {
-      ROS_ERROR("Vehicle received a new order while executing an order!");
+  ROS_INFO("%s", verdict.update ? "Sending order update" : "Sending new order");
+  orderIntake.RunStage(OrderIntake::PUBLISH, [&] { orderPublisher.publish(msg); }, &trace);
 
-      // Create an error and add it to the state message.
+  // Send a new state message on orders and order updates.
+  newPublishTrigger = true;
+  trace.End();
+}
 
-      return;
-    }
+void VDA5050Connector::RejectOrder(const Order& new_order, const OrderIntake::Verdict& verdict) {
+  std::vector<std::pair<std::string, std::string>> references = {
+      {static_cast<std::string>("orderId"), new_order.GetOrderId()}};
 
-    if (state.InDeviationRange(new_order.GetNodes().front())) {
-      // TODO (A-Jammoul) : Accept the new order by updating the state message and the order.
-      // AcceptNewOrder(new_order);
+  switch (verdict.rejection) {
+    case OrderIntake::DUPLICATE:
+      // Resent orders are dropped silently.
+      ROS_WARN_STREAM(verdict.reason << " " << new_order.GetOrderId() << ", "
+                                     << new_order.GetOrderUpdateId());
+      return;
+    case OrderIntake::STALE_UPDATE:
+      references.emplace_back("orderUpdateId", std::to_string(new_order.GetOrderUpdateId()));
+      ROS_ERROR("Error has occurred : %s", verdict.reason.c_str());
+      AddInternalError(CreateWarningError("orderCreation", verdict.reason, references));
+      return;
+    case OrderIntake::INVALID_STRUCTURE:
+    case OrderIntake::EXCEEDS_CAPABILITIES:
+      ROS_ERROR("Validation error occurred : %s", verdict.reason.c_str());
+      AddInternalError(CreateWarningError("orderValidation", verdict.reason, references));
+      return;
+    case OrderIntake::BASE_MISMATCH:
+      ROS_ERROR("Update base validation failed. %s", verdict.reason.c_str());
+      AddInternalError(CreateWarningError("orderUpdateError", verdict.reason, references));
+      return;
+    case OrderIntake::ORDER_ACTIVE:
+      ROS_ERROR("%s", verdict.reason.c_str());
+      AddInternalError(CreateWarningError("orderError", verdict.reason, references));
+      return;
+    case OrderIntake::OUT_OF_DEVIATION_RANGE:
+      ROS_ERROR("%s", verdict.reason.c_str());
+      AddInternalError(CreateWarningError("noRouteError", verdict.reason, references));
+      return;
+    default:
+      ROS_ERROR("Order rejected : %s", verdict.reason.c_str());
+      return;
+  }
+}
 
-      ROS_INFO("Sending new order");
+void VDA5050Connector::ReadCapabilities() {
+  OrderCapabilities capabilities;
+  int limit;
+  params.Param<int>("capabilities/max_nodes", limit, 0);
+  capabilities.maxNodes = static_cast<size_t>(std::max(limit, 0));
+  params.Param<int>("capabilities/max_edges", limit, 0);
+  capabilities.maxEdges = static_cast<size_t>(std::max(limit, 0));
+  params.Param<int>("capabilities/max_actions", limit, 0);
+  capabilities.maxActions = static_cast<size_t>(std::max(limit, 0));
+  params.Param<int>("capabilities/max_id_length", limit, 0);
+  capabilities.maxIdLength = static_cast<size_t>(std::max(limit, 0));
+  params.Param<bool>("capabilities/trajectories", capabilities.trajectories, true);
+  std::vector<std::string> actionTypes;
+  params.Param<std::vector<std::string>>("capabilities/action_types", actionTypes, {});
+  capabilities.actionTypes.insert(actionTypes.begin(), actionTypes.end());
+  orderIntake.SetCapabilities(capabilities);
+}
 
-      // Send the new order.
-      orderPublisher.publish(msg);
+void VDA5050Connector::InstantActionCallback(const vda5050_msgs::InstantAction::ConstPtr& msg) {
+  // Forward instant action message to the vehicle.
+  TraceSpan trace(&tracer, iaStages.total, receiptTime);
+  trace.Mark(iaStages.receipt);
+
+  // The message is copied once one of its actions is not forwarded.
+  vda5050_msgs::InstantAction::Ptr forwarded;
+  for (size_t i = 0; i < msg->actions.size(); i++) {
+    const vda5050_msgs::Action& action = msg->actions[i];
+    bool forward = true;
+    for (const InstantActionBinding& binding : instantActionBindings) {
+      if (action.actionType == binding.actionType) {
+        forward = (this->*binding.handle)(action);
+        break;
+      }
+    }
 
-    } else {
-      // Create error, and add error to the state.
-      ROS_ERROR("Vehicle not inside the deviation range of the first node in the order.");
-      return;
+    if (forward && forwarded) {
+      forwarded->actions.push_back(action);
+    } else if (!forward && !forwarded) {
+      forwarded = boost::make_shared<vda5050_msgs::InstantAction>(*msg);
+      forwarded->actions.resize(i);
     }
   }
 
-  // Send a new state message on orders and order updates.
+  if (!forwarded || !forwarded->actions.empty()) {
+    ROS_INFO("Sending instant action message");
+    if (forwarded)
+      iaPublisher.publish(forwarded);
+    else
+      iaPublisher.publish(msg);
+  }
+  trace.Mark(iaStages.publish);
+  trace.End();
+}
+
+bool VDA5050Connector::HandleStateRequest(const vda5050_msgs::Action& action) {
+  state.UpdateActionStates({CreateActionState(action, vda5050_msgs::ActionState::FINISHED)});
   newPublishTrigger = true;
+  PublishStateOnTrigger();
+  return false;
 }
 
-void VDA5050Connector::InstantActionCallback(const vda5050_msgs::InstantAction::ConstPtr& msg) {
-  // Forward instant action message to the vehicle.
+bool VDA5050Connector::HandleCancelOrder(const vda5050_msgs::Action& action) {
+  if (state.HasActiveOrder(order)) return true;
 
-  ROS_INFO("Sending instant action message");
-  iaPublisher.publish(msg);
+  ROS_WARN("Instant action %s failed, there is no order to cancel", action.actionId.c_str());
+  state.UpdateActionStates({CreateActionState(action, vda5050_msgs::ActionState::FAILED)});
+  AddInternalError(CreateWarningError("noOrderToCancel", "There is no order to cancel.",
+      {{static_cast<std::string>("actionId"), action.actionId}}));
+  newPublishTrigger = true;
+  return false;
 }
 
 void VDA5050Connector::OrderStateCallback(const vda5050_msgs::State::ConstPtr& msg) {
+  AppendToJournal(ORDER_STATE, *msg);
+
   // Read required order state information from the prefilled state message.
-  state.SetOrderState(*msg);
+  state.SetOrderState(msg);
+
+  newPublishTrigger = true;
+}
+
+void VDA5050Connector::ActionStatesCallback(const vda5050_msgs::State::ConstPtr& msg) {
+  AppendToJournal(ACTION_STATES, *msg);
+  state.UpdateActionStates(msg->actionStates);
+
+  newPublishTrigger = true;
+}
+
+void VDA5050Connector::ActionErrorsCallback(const vda5050_msgs::Errors::ConstPtr& msg) {
+  for (const auto& error : msg->errors) AddInternalError(error);
 
   newPublishTrigger = true;
 }
 
 void VDA5050Connector::AcceptNewOrder(const Order& new_order) {
+  AppendToJournal(ORDER_ACCEPTED, new_order.GetOrderMsg());
+
   // Set the nodes, edges and actions in the order and the state messages.
 
   state.AcceptNewOrder(new_order);
@@ -273,6 +539,8 @@ void VDA5050Connector::AcceptNewOrder(const Order& new_order) {
 }
 
 void VDA5050Connector::UpdateExistingOrder(const Order& order_update) {
+  AppendToJournal(ORDER_UPDATED, order_update.GetOrderMsg());
+
   // Update the order with added nodes, edges, new order id and update id.
 
   // TODO (A-Jammoul) : Update the state before the order, because the state needs the old order to
@@ -283,6 +551,14 @@ void VDA5050Connector::UpdateExistingOrder(const Order& order_update) {
   order.UpdateOrder(order_update);
 }
 
+void VDA5050Connector::Update() {
+  MonitorOrder();
+
+  ClearExpiredInternalErrors();
+
+  PublishStateOnTrigger();
+}
+
 void VDA5050Connector::MonitorOrder() {
   // TODO (A-Jammoul): Monitor the state of the order during execution.
   // TODO (A-Jammoul): Add checks to automatically request for new base.
@@ -291,17 +567,75 @@ void VDA5050Connector::MonitorOrder() {
 // State related callbacks
 
 void VDA5050Connector::ZoneSetIdCallback(const std_msgs::String::ConstPtr& msg) {
+  // The zone set id of the zone set the interaction zones are computed from is kept.
+  if (activeZones) return;
   state.SetZoneSetId(msg->data);
 }
 
-void VDA5050Connector::AGVPositionCallback(const geometry_msgs::Pose& msg) {
+void VDA5050Connector::ZoneSetCallback(const std_msgs::String::ConstPtr& msg) {
+  ZoneSet zoneSet;
+  try {
+    mqtt_bridge::JsonReader reader;
+    mqtt_bridge::Decode(reader, msg->data, zoneSet);
+  } catch (const mqtt_bridge::DecodeError& e) {
+    ROS_ERROR("Zone set dropped: %s at %s", e.what(), e.path().c_str());
+    return;
+  }
+
+  std::string mapId = zoneSet.mapId;
+  activeZones = nullptr;
+  ZoneIndex& index = zoneIndexes[mapId] = ZoneIndex(std::move(zoneSet), zoneCellSize);
+  ROS_INFO("Zone set %s of map %s with %zu zones", index.GetZoneSet().zoneSetId.c_str(),
+      mapId.c_str(), index.GetZoneSet().zones.size());
+  ActivateZones();
+}
+
+void VDA5050Connector::ActivateZones() {
+  // Zone sets without a map id apply to all maps without their own zone set.
+  auto index = zoneIndexes.find(state.GetAGVPosition().mapId);
+  if (index == zoneIndexes.end()) index = zoneIndexes.find("");
+  const ZoneIndex* zones = index != zoneIndexes.end() ? &index->second : nullptr;
+  if (zones == activeZones) return;
+
+  activeZones = zones;
+  zonesInside.clear();
+  if (!activeZones) {
+    state.SetZoneSetId("");
+    state.SetInteractionZones(boost::make_shared<vda5050_msgs::InteractionZoneStates>());
+    return;
+  }
+  state.SetZoneSetId(activeZones->GetZoneSet().zoneSetId);
+  // Publishes the zones of the current position even if it lies in no zone.
+  zonesInside.push_back(std::numeric_limits<size_t>::max());
+  UpdateZones(state.GetAGVPosition().x, state.GetAGVPosition().y);
+}
+
+void VDA5050Connector::UpdateZones(double x, double y) {
+  if (!activeZones) return;
+
+  activeZones->Locate(x, y, &locatedZones);
+  if (locatedZones == zonesInside) return;
+  zonesInside.swap(locatedZones);
+
+  vda5050_msgs::InteractionZoneStates::Ptr zones =
+      boost::make_shared<vda5050_msgs::InteractionZoneStates>();
+  zones->interactionZones.resize(zonesInside.size());
+  for (size_t i = 0; i < zonesInside.size(); i++) {
+    zones->interactionZones[i].zoneId = activeZones->GetZoneSet().zones[zonesInside[i]].zoneId;
+    zones->interactionZones[i].zoneStatus = 1;
+  }
+  state.SetInteractionZones(zones);
+}
+
+void VDA5050Connector::AGVPositionCallback(const geometry_msgs::Pose::ConstPtr& msg) {
   // Get the yaw of the robot from the quaternion.
   tf::Quaternion quaternion;
-  tf::quaternionMsgToTF(msg.orientation, quaternion);
+  tf::quaternionMsgToTF(msg->orientation, quaternion);
   double roll, pitch, yaw;
   tf::Matrix3x3(quaternion).getRPY(roll, pitch, yaw);
 
-  state.SetAGVPosition(msg.position.x, msg.position.y, yaw);
+  state.SetAGVPosition(msg->position.x, msg->position.y, yaw);
+  UpdateZones(msg->position.x, msg->position.y);
 }
 
 void VDA5050Connector::LocScoreCallback(const std_msgs::Float64::ConstPtr& msg) {
@@ -314,18 +648,19 @@ void VDA5050Connector::AGVPositionInitializedCallback(const std_msgs::Bool::Cons
 
 void VDA5050Connector::AGVPositionMapIdCallback(const std_msgs::String::ConstPtr& msg) {
   state.SetMapId(msg->data);
+  ActivateZones();
 }
 
-void VDA5050Connector::AGVVelocityCallback(const geometry_msgs::Twist& msg) {
+void VDA5050Connector::AGVVelocityCallback(const geometry_msgs::Twist::ConstPtr& msg) {
   vda5050_msgs::Velocity vel;
-  vel.vx = msg.linear.x;
-  vel.vy = msg.linear.y;
-  vel.omega = msg.angular.z;
+  vel.vx = msg->linear.x;
+  vel.vy = msg->linear.y;
+  vel.omega = msg->angular.z;
 
   state.SetVelocity(vel);
 
   // Set the driving field based on driving velocity.
-  bool is_driving = (msg.linear.x > 0.01 || msg.linear.y > 0.01 || msg.angular.z > 0.01);
+  bool is_driving = (msg->linear.x > 0.01 || msg->linear.y > 0.01 || msg->angular.z > 0.01);
 
   // Trigger a state message publish.
   if (state.GetDriving() != is_driving) newPublishTrigger = true;
@@ -334,7 +669,7 @@ void VDA5050Connector::AGVVelocityCallback(const geometry_msgs::Twist& msg) {
 }
 
 void VDA5050Connector::LoadsCallback(const vda5050_msgs::Loads::ConstPtr& msg) {
-  state.SetLoads(msg->loads);
+  state.SetLoads(msg);
   newPublishTrigger = true;
 }
 
@@ -383,7 +718,7 @@ void VDA5050Connector::ErrorsCallback(const vda5050_msgs::Errors::ConstPtr& msg)
 }
 
 void VDA5050Connector::InformationCallback(const vda5050_msgs::Information::ConstPtr& msg) {
-  state.SetInformation(msg->information);
+  state.SetInformation(msg);
 }
 
 void VDA5050Connector::SafetyStateCallback(const vda5050_msgs::SafetyState::ConstPtr& msg) {
@@ -392,15 +727,43 @@ void VDA5050Connector::SafetyStateCallback(const vda5050_msgs::SafetyState::Cons
 
 void VDA5050Connector::InteractionZoneCallback(
     const vda5050_msgs::InteractionZoneStates::ConstPtr& msg) {
-  state.SetInteractionZones(*msg.get());
+  // Interaction zones are computed from the zone set of the current map if there is one.
+  if (activeZones) return;
+  state.SetInteractionZones(msg);
+}
+
+void VDA5050Connector::LinkStateCallback(const std_msgs::Bool::ConstPtr& msg) {
+  bool wasUp = linkUp;
+  linkUp = msg->data;
+  if (linkUp && !wasUp) PublishConnection(true);
+}
+
+void VDA5050Connector::UplinkThrottleCallback(const std_msgs::UInt8::ConstPtr& msg) {
+  if (msg->data == throttleLevel) return;
+  throttleLevel = msg->data;
+  UpdateVisualizationPeriod();
+}
+
+void VDA5050Connector::UpdateVisualizationPeriod() {
+  // The period only grows, a configured period above the maximum is kept as it is.
+  double period = std::ldexp(visMsgPeriod, std::min(throttleLevel, 16));
+  period = std::max(visMsgPeriod, std::min(period, maxVisMsgPeriod));
+  visTimer.setPeriod(ros::Duration(period));
+  ROS_INFO("Uplink throttle level %d: visualization every %.2f s, %s state messages",
+      throttleLevel, period, TrimState() ? "trimmed" : "full");
 }
 
 void VDA5050Connector::PublishState() {
+  connector_utils::MeteredScope scope(&metrics, publishStateMetric);
+
   // Set current timestamp of message.
   state.SetTimestamp(connector_utils::GetISOCurrentTimestamp());
   state.SetHeaderId(stateHeaderId);
 
-  statePublisher.publish(state.GetState());
+  if (TrimState())
+    statePublisher.publish(state.CreateTrimmedStateMsg());
+  else
+    statePublisher.publish(state.GetState());
 
   // Increase header count.
   stateHeaderId++;
@@ -412,6 +775,15 @@ void VDA5050Connector::PublishState() {
 void VDA5050Connector::PublishVisualization() {
   auto vis = state.CreateVisualizationMsg();
 
+  // Within the deadband, the position is still sent with the longest visualization period.
+  ros::Time now = ros::Time::now();
+  if ((now - lastVisTime).toSec() < maxVisMsgPeriod &&
+      connector_utils::InPositionDeadband(
+          lastVisPosition, vis.agvPosition, visDeadbandDistance, visDeadbandAngle))
+    return;
+  lastVisPosition = vis.agvPosition;
+  lastVisTime = now;
+
   // Set the header fields.
   vis.timestamp = connector_utils::GetISOCurrentTimestamp();
   vis.headerId = visHeaderId;
@@ -423,6 +795,8 @@ void VDA5050Connector::PublishVisualization() {
 }
 
 void VDA5050Connector::PublishConnection(const bool connected) {
+  if (connected && !linkUp) return;
+
   // Create new connection state message.
   vda5050_msgs::Connection connection;
 
@@ -493,27 +867,3 @@ void VDA5050Connector::ClearExpiredInternalErrors() {
 
   internal_errors_stamped.erase(it, internal_errors_stamped.end());
 }
-
-int main(int argc, char** argv) {
-  ros::init(argc, argv, "vda5050_connector");
-
-  VDA5050Connector VDA5050Connector;
-
-  ros::Rate rate(1.0);
-
-  while (ros::ok()) {
-    VDA5050Connector.MonitorOrder();
-
-    VDA5050Connector.ClearExpiredInternalErrors();
-
-    VDA5050Connector.PublishStateOnTrigger();
-
-    ros::spinOnce();
-    rate.sleep();
-  }
-
-  // Send OFFLINE message to gracefully disconnect.
-  VDA5050Connector.PublishConnection(false);
-
-  return 0;
-}
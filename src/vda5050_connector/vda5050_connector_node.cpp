@@ -0,0 +1,23 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "vda5050_connector/vda5050_connector.h"
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "vda5050_connector");
+
+  VDA5050Connector VDA5050Connector;
+
+  ros::spin();
+
+  // Send OFFLINE message to gracefully disconnect.
+  VDA5050Connector.PublishConnection(false);
+
+  return 0;
+}
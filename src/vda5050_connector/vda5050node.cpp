@@ -8,9 +8,15 @@
  */
 
 #include "vda5050_connector/vda5050node.h"
+#include <algorithm>
+#include <cmath>
+#include "diagnostic_msgs/DiagnosticArray.h"
 
 using namespace connector_utils;
 
+/** Seconds a rebound publisher or subscriber is kept, so its last messages are still delivered. */
+constexpr double RETIRE_DELAY = 1.0;
+
 /*
  * TODO: publish to topicPub, if following requirements are met:
  * - received order
@@ -24,6 +30,251 @@ using namespace connector_utils;
  * - every 30 seconds if nothing changed
  */
 
+VDA5050Node::VDA5050Node() : privateNh("~"), startTime(ros::WallTime::now()) {
+  FetchParams();
+  SetupPriorityLane();
+  SetupTracing();
+  SetupReload();
+}
+
+VDA5050Node::VDA5050Node(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh)
+    : nh(nh), privateNh(private_nh), startTime(ros::WallTime::now()) {
+  FetchParams();
+  SetupPriorityLane();
+  SetupTracing();
+  SetupReload();
+}
+
+void VDA5050Node::FetchParams() {
+  ros::WallTime start = ros::WallTime::now();
+  params = ParamTree::Fetch(privateNh.getNamespace());
+  paramsFetchTime = ros::WallTime::now() - start;
+}
+
+void VDA5050Node::SetupPriorityLane() {
+  priorityNh = nh;
+  bool enabled;
+  params.Param<bool>("priority_lane/enabled", enabled, false);
+  if (!enabled) return;
+
+  ros::CallbackQueueInterface* target = nh.getCallbackQueue();
+  if (!target) target = ros::getGlobalCallbackQueue();
+  priorityLane.reset(new PriorityLane(target));
+  nh.setCallbackQueue(priorityLane->GetRegularQueue());
+  priorityNh.setCallbackQueue(priorityLane->GetPriorityQueue());
+}
+
+void VDA5050Node::StopPriorityLane() {
+  if (priorityLane) priorityLane->Stop();
+}
+
+void VDA5050Node::LogStartupTime() {
+  ROS_INFO("%s started in %.1f ms, fetching the configuration took %.1f ms",
+      privateNh.getNamespace().c_str(), (ros::WallTime::now() - startTime).toSec() * 1000.0,
+      paramsFetchTime.toSec() * 1000.0);
+}
+
+void VDA5050Node::SetupTracing() {
+  bool enabled;
+  params.Param<bool>("tracing/enabled", enabled, false);
+  if (!enabled) return;
+
+  double period;
+  int maxEvents;
+  std::string topic;
+  params.Param<double>("tracing/period", period, 5.0);
+  params.Param<std::string>("tracing/topic", topic, "/diagnostics");
+  params.Param<std::string>("tracing/chrome_trace_file", chromeTraceFile, "");
+  params.Param<int>("tracing/chrome_trace_max_events", maxEvents, 100000);
+
+  if (!chromeTraceFile.empty()) chromeTraceFile = GetNamespacedFile(chromeTraceFile);
+
+  tracer.SetEnabled(true);
+  if (!chromeTraceFile.empty()) tracer.KeepEvents(std::max(maxEvents, 0));
+  tracePub = nh.advertise<diagnostic_msgs::DiagnosticArray>(topic, 10);
+  traceTimer = nh.createTimer(ros::Duration(period), &VDA5050Node::PublishTraces, this);
+}
+
+std::string VDA5050Node::GetNamespacedFile(const std::string& file) const {
+  if (nh.getNamespace() == "/") return file;
+  std::string ns = nh.getNamespace().substr(1);
+  std::replace(ns.begin(), ns.end(), '/', '_');
+  size_t extension = file.find_last_of('.');
+  if (extension == std::string::npos || extension < file.find_last_of('/') + 1)
+    extension = file.size();
+  return file.substr(0, extension) + "_" + ns + file.substr(extension);
+}
+
+void VDA5050Node::PublishTraces(const ros::TimerEvent& event) {
+  diagnostic_msgs::DiagnosticArray diagnostics;
+  diagnostics.header.stamp = ros::Time::now();
+
+  // The namespace of the node handle tells the vehicles of a VehicleHost apart.
+  const std::string& ns = privateNh.getNamespace();
+  std::string nodeName = ns.substr(ns.find_last_of('/') + 1);
+  for (const Tracer::StageStats& stats : tracer.TakeStats()) {
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = nodeName + ": " + stats.name;
+    status.hardware_id = nh.getNamespace();
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = "latency in microseconds";
+    auto addValue = [&status](const std::string& key, const std::string& value) {
+      diagnostic_msgs::KeyValue keyValue;
+      keyValue.key = key;
+      keyValue.value = value;
+      status.values.push_back(keyValue);
+    };
+    addValue("count", std::to_string(stats.count));
+    addValue("mean", std::to_string(std::lround(stats.mean)));
+    addValue("p50", std::to_string(std::lround(stats.p50)));
+    addValue("p90", std::to_string(std::lround(stats.p90)));
+    addValue("p99", std::to_string(std::lround(stats.p99)));
+    addValue("max", std::to_string(std::lround(stats.max)));
+    diagnostics.status.push_back(status);
+  }
+  if (!diagnostics.status.empty()) tracePub.publish(diagnostics);
+
+  if (!chromeTraceFile.empty() && !tracer.WriteChromeTrace(chromeTraceFile))
+    ROS_WARN_THROTTLE(60, "Chrome trace could not be written to %s", chromeTraceFile.c_str());
+}
+
+MeteredQueue* VDA5050Node::MeterSubscription(
+    ros::NodeHandle* nh, const std::string& topic, uint32_t queueSize) {
+  ros::CallbackQueueInterface* target = nh->getCallbackQueue();
+  if (!target) target = ros::getGlobalCallbackQueue();
+  meteredSubscriptions.emplace_back(topic, target, queueSize);
+  return &meteredSubscriptions.back().queue;
+}
+
+void VDA5050Node::LinkSubscriber(const std::string& param, const LinkedSubscriber& subscriber) {
+  auto linked = subscribers.find(param);
+  if (linked != subscribers.end()) {
+    retiredSubscribers.push_back(linked->second);
+    retireTimer.stop();
+    retireTimer.start();
+  }
+  subscribers[param] = subscriber;
+}
+
+void VDA5050Node::RetirePublisher(const ros::Publisher& publisher) {
+  retiredPublishers.push_back(publisher);
+  retireTimer.stop();
+  retireTimer.start();
+}
+
+void VDA5050Node::ReleaseRetired(const ros::TimerEvent& event) {
+  retiredPublishers.clear();
+  auto handled = std::remove_if(retiredSubscribers.begin(), retiredSubscribers.end(),
+      [this](LinkedSubscriber& retired) {
+        if (retired.queue->GetDepth() > 0) return false;
+        // The subscription adds no callbacks to its queue once it is shut down.
+        retired.subscriber.shutdown();
+        meteredSubscriptions.remove_if([&retired](const MeteredSubscription& subscription) {
+          return &subscription.queue == retired.queue;
+        });
+        return true;
+      });
+  retiredSubscribers.erase(handled, retiredSubscribers.end());
+  if (!retiredSubscribers.empty()) {
+    retireTimer.stop();
+    retireTimer.start();
+  }
+}
+
+void VDA5050Node::SetupReload() {
+  const std::string& ns = privateNh.getNamespace();
+  reloadService = nh.advertiseService(
+      ns.substr(ns.find_last_of('/') + 1) + "/reload", &VDA5050Node::ReloadCallback, this);
+  retireTimer = nh.createTimer(
+      ros::Duration(RETIRE_DELAY), &VDA5050Node::ReleaseRetired, this, true, false);
+}
+
+size_t VDA5050Node::Reconfigure() { return 0; }
+
+bool VDA5050Node::ReloadCallback(
+    std_srvs::Trigger::Request& request, std_srvs::Trigger::Response& response) {
+  // The current configuration is kept if the namespace was removed.
+  ParamTree fetched = ParamTree::Fetch(privateNh.getNamespace());
+  if (!fetched.Has("")) {
+    response.success = false;
+    response.message = "No configuration found in " + privateNh.getNamespace();
+    return true;
+  }
+  params = fetched;
+  size_t rebound = Reconfigure();
+  response.success = true;
+  response.message = "Reloaded the configuration, " + std::to_string(rebound) + " topics rebound";
+  ROS_INFO("%s: %s", privateNh.getNamespace().c_str(), response.message.c_str());
+  return true;
+}
+
+void VDA5050Node::AddGauge(const std::string& name, const std::function<double()>& value) {
+  gauges.emplace_back(name, value);
+}
+
+void VDA5050Node::SetupMetrics() {
+  bool enabled;
+  params.Param<bool>("metrics/enabled", enabled, true);
+  if (!enabled) return;
+
+  double period;
+  bool diagnostics;
+  std::string topic;
+  params.Param<double>("metrics/period", period, 5.0);
+  params.Param<std::string>("metrics/topic", topic, "metrics");
+  params.Param<bool>("metrics/diagnostics", diagnostics, false);
+
+  metricsPub = nh.advertise<diagnostic_msgs::DiagnosticArray>(topic, 10);
+  if (diagnostics)
+    metricsDiagnosticsPub = nh.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 10);
+  metricsTimer = nh.createTimer(ros::Duration(period), &VDA5050Node::PublishMetrics, this);
+}
+
+void VDA5050Node::PublishMetrics(const ros::TimerEvent& event) {
+  const std::string& ns = privateNh.getNamespace();
+  diagnostic_msgs::DiagnosticStatus status;
+  status.name = ns.substr(ns.find_last_of('/') + 1) + ": metrics";
+  status.hardware_id = nh.getNamespace();
+  status.level = diagnostic_msgs::DiagnosticStatus::OK;
+  auto addValue = [&status](const std::string& key, const std::string& value) {
+    diagnostic_msgs::KeyValue keyValue;
+    keyValue.key = key;
+    keyValue.value = value;
+    status.values.push_back(keyValue);
+  };
+
+  std::vector<std::string> names = metrics.GetNames();
+  std::vector<uint64_t> values = metrics.Read();
+  for (size_t i = 0; i < names.size(); i++) addValue(names[i], std::to_string(values[i]));
+
+  // Queues that filled since the last report may have discarded messages.
+  std::string fullTopics;
+  for (MeteredSubscription& subscription : meteredSubscriptions) {
+    uint64_t full = subscription.queue.GetFull();
+    addValue(subscription.topic + " queue_depth", std::to_string(subscription.queue.GetDepth()));
+    addValue(subscription.topic + " queue_max_depth",
+        std::to_string(subscription.queue.TakeMaxDepth()));
+    addValue(subscription.topic + " queue_full", std::to_string(full));
+    if (full > subscription.reportedFull)
+      fullTopics += (fullTopics.empty() ? "" : ", ") + subscription.topic;
+    subscription.reportedFull = full;
+  }
+  for (const auto& gauge : gauges) addValue(gauge.first, std::to_string(gauge.second()));
+
+  if (fullTopics.empty()) {
+    status.message = "counters since start";
+  } else {
+    status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+    status.message = "subscriber queue full: " + fullTopics;
+  }
+
+  diagnostic_msgs::DiagnosticArray diagnostics;
+  diagnostics.header.stamp = ros::Time::now();
+  diagnostics.status.push_back(status);
+  metricsPub.publish(diagnostics);
+  if (metricsDiagnosticsPub) metricsDiagnosticsPub.publish(diagnostics);
+}
+
 std::map<std::string, std::string> VDA5050Node::GetTopicList(const std::string& full_param_name) {
   return ReadTopicParams(&this->nh, full_param_name);
 }
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "vda5050_connector/vehicle_host.h"
+#include <algorithm>
+#include <cctype>
+#include <thread>
+#include <unordered_set>
+
+using namespace connector_utils;
+
+constexpr char CONNECTOR_NS[] = "connector";
+constexpr char ACTION_CLIENT_NS[] = "action_client";
+constexpr char BRIDGE_NS[] = "mqtt_bridge";
+
+VehicleHost::VehicleHost() : VehicleHost(ros::NodeHandle(), ros::NodeHandle("~")) {}
+
+VehicleHost::VehicleHost(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh)
+    : nh(nh), privateNh(private_nh) {
+  ParamTree params = ParamTree::Fetch(privateNh.getNamespace());
+  std::vector<std::string> serialNumbers;
+  if (!params.Get("vehicles", serialNumbers) || serialNumbers.empty())
+    ROS_ERROR("%s/vehicles not found in the configuration!", privateNh.getNamespace().c_str());
+
+  int threads;
+  params.Param<int>(
+      "threads", threads, static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)));
+  pool.reset(new StrandPool(std::max(threads, 1)));
+
+  // The bridge subscribes to the topics of the vehicles, so it is created first to not miss the
+  // first messages.
+  if (params.Has(std::string(BRIDGE_NS) + "/bridge")) {
+    std::vector<mqtt_bridge::BridgedVehicle> bridged;
+    for (const std::string& serialNumber : serialNumbers)
+      bridged.push_back({serialNumber, VehicleNamespace(serialNumber)});
+    bridgeStrand.reset(new CallbackStrand(pool.get()));
+    ros::NodeHandle bridgeNh(this->nh);
+    bridgeNh.setCallbackQueue(bridgeStrand.get());
+    bridge.reset(
+        new mqtt_bridge::MqttBridge(bridgeNh, ros::NodeHandle(privateNh, BRIDGE_NS), bridged));
+  }
+
+  std::vector<std::string> topics = ReadVehicleTopics(params);
+  ros::NodeHandle connectorNh(privateNh, CONNECTOR_NS);
+  ros::NodeHandle actionClientNh(privateNh, ACTION_CLIENT_NS);
+  vehicles.reserve(serialNumbers.size());
+  for (const std::string& serialNumber : serialNumbers) {
+    std::string ns = VehicleNamespace(serialNumber);
+    ros::M_string remappings;
+    for (const std::string& topic : topics) remappings[topic] = NamespacedTopic(ns, topic);
+
+    Vehicle vehicle;
+    vehicle.serialNumber = serialNumber;
+    vehicle.strand.reset(new CallbackStrand(pool.get()));
+    ros::NodeHandle vehicleNh(this->nh, ns, remappings);
+    vehicleNh.setCallbackQueue(vehicle.strand.get());
+    vehicle.connector.reset(new VDA5050Connector(vehicleNh, connectorNh, serialNumber));
+    vehicle.actionClient.reset(new ActionClient(vehicleNh, actionClientNh));
+    vehicles.push_back(std::move(vehicle));
+  }
+
+  ROS_INFO("Hosting %zu vehicles on %zu threads%s", vehicles.size(), pool->GetThreadCount(),
+      bridge ? " with one MQTT connection" : "");
+}
+
+VehicleHost::~VehicleHost() {
+  // Send OFFLINE message to gracefully disconnect.
+  for (Vehicle& vehicle : vehicles) vehicle.connector->PublishConnection(false);
+  pool->Stop();
+  // The pool drops the waiting callbacks, the OFFLINE messages among them are forwarded here.
+  if (bridgeStrand) bridgeStrand->Drain();
+}
+
+std::string VehicleHost::VehicleNamespace(const std::string& serialNumber) {
+  std::string ns = serialNumber;
+  for (char& c : ns) {
+    if (!std::isalnum(static_cast<unsigned char>(c))) c = '_';
+  }
+  // ROS names have to start with a letter.
+  if (ns.empty() || !std::isalpha(static_cast<unsigned char>(ns[0]))) ns = "agv_" + ns;
+  return ns;
+}
+
+std::vector<std::string> VehicleHost::ReadVehicleTopics(const ParamTree& params) {
+  std::vector<std::string> sharedTopics;
+  if (!params.Get("shared_topics", sharedTopics))
+    sharedTopics = {"/mqtt_link_state", "/uplink_throttle"};
+  std::unordered_set<std::string> shared(sharedTopics.begin(), sharedTopics.end());
+
+  // Relative topics are resolved in the namespace of the vehicle anyway.
+  std::unordered_set<std::string> topics;
+  for (const char* node : {CONNECTOR_NS, ACTION_CLIENT_NS}) {
+    for (const auto& param : params.GetStrings(node)) {
+      const std::string& topic = param.second;
+      if (param.first.find("_topics/") == std::string::npos || topic.empty() || topic[0] != '/' ||
+          shared.count(topic))
+        continue;
+      topics.insert(topic);
+    }
+  }
+  return std::vector<std::string>(topics.begin(), topics.end());
+}
@@ -0,0 +1,21 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "vda5050_connector/vehicle_host.h"
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "vehicle_host");
+
+  // The callbacks are called by the threads of the host, the main thread only waits.
+  VehicleHost vehicleHost;
+
+  ros::waitForShutdown();
+
+  return 0;
+}
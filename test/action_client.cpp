@@ -0,0 +1,138 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <boost/make_shared.hpp>
+#include <string>
+#include "ros/ros.h"
+#include "vda5050_connector/action_client.h"
+
+/**
+ * Sends an instant action without blocking to the action client, which passes it to the AGV.
+ */
+static void SendInstantAction(ActionClient* client, const std::string& actionId) {
+  vda5050_msgs::InstantAction::Ptr msg = boost::make_shared<vda5050_msgs::InstantAction>();
+  vda5050_msgs::Action action;
+  action.actionId = actionId;
+  action.actionType = "pick";
+  action.blockingType = "NONE";
+  msg->actions.push_back(action);
+  client->InstantActionsCallback(msg);
+}
+
+/**
+ * Reports a state of an action from the AGV.
+ */
+static void ReportState(
+    ActionClient* client, const std::string& actionId, const std::string& status) {
+  vda5050_msgs::ActionState::Ptr msg = boost::make_shared<vda5050_msgs::ActionState>();
+  msg->actionId = actionId;
+  msg->actionType = "pick";
+  msg->actionStatus = status;
+  client->AgvActionStateCallback(msg);
+}
+
+TEST(ActionClient, FailsActionsWithoutStateAfterTheirDeadline) {
+  ros::NodeHandle privateNh("~silent_action");
+  privateNh.setParam("action_deadlines/default", 0.1);
+  ActionClient client(ros::NodeHandle(), privateNh);
+
+  SendInstantAction(&client, "silent");
+  ASSERT_TRUE(client.FindAction("silent"));
+  ros::WallDuration(0.3).sleep();
+  client.DeadlineTimerCallback(ros::TimerEvent());
+
+  EXPECT_FALSE(client.FindAction("silent"));
+}
+
+TEST(ActionClient, RunningActionsOutliveTheirDeadline) {
+  ros::NodeHandle privateNh("~running_action");
+  privateNh.setParam("action_deadlines/default", 0.1);
+  ActionClient client(ros::NodeHandle(), privateNh);
+
+  // A long action, e.g. charging, that reported once and is paused later.
+  SendInstantAction(&client, "running");
+  ReportState(&client, "running", "RUNNING");
+  ros::WallDuration(0.3).sleep();
+  client.DeadlineTimerCallback(ros::TimerEvent());
+  ReportState(&client, "running", "PAUSED");
+  ros::WallDuration(0.3).sleep();
+  client.DeadlineTimerCallback(ros::TimerEvent());
+
+  ASSERT_TRUE(client.FindAction("running"));
+  EXPECT_EQ("PAUSED", client.FindAction("running")->state);
+}
+
+TEST(ActionClient, FailsSecondCancelOfAnOrder) {
+  ActionClient client(ros::NodeHandle(), ros::NodeHandle("~cancel_action"));
+  vda5050_msgs::InstantAction::Ptr msg = boost::make_shared<vda5050_msgs::InstantAction>();
+  vda5050_msgs::Action cancel;
+  cancel.actionType = "cancelOrder";
+  cancel.blockingType = "HARD";
+  cancel.actionParameters.resize(1);
+  cancel.actionParameters[0].key = "orderId";
+  cancel.actionParameters[0].value = "order";
+  cancel.actionId = "first";
+  msg->actions.push_back(cancel);
+  cancel.actionId = "second";
+  msg->actions.push_back(cancel);
+  client.InstantActionsCallback(msg);
+
+  // The first cancel waits for the order daemon, the second is released right away.
+  EXPECT_TRUE(client.FindAction("first"));
+  EXPECT_FALSE(client.FindAction("second"));
+}
+
+TEST(ActionClient, CompletesCancellationsWhenTheLastActionStops) {
+  ActionClient client(ros::NodeHandle(), ros::NodeHandle("~cancelled_order"));
+  vda5050_msgs::Action orderAction;
+  orderAction.actionId = "order_pick";
+  orderAction.actionType = "pick";
+  orderAction.blockingType = "NONE";
+  client.AddActionToList(&orderAction, "order", "WAITING");
+  std_msgs::String::Ptr trigger = boost::make_shared<std_msgs::String>();
+  trigger->data = "order_pick";
+  client.OrderTriggerCallback(trigger);
+  client.UpdateActions();
+  ReportState(&client, "order_pick", "RUNNING");
+
+  vda5050_msgs::InstantAction::Ptr msg = boost::make_shared<vda5050_msgs::InstantAction>();
+  vda5050_msgs::Action cancel;
+  cancel.actionId = "cancel";
+  cancel.actionType = "cancelOrder";
+  cancel.blockingType = "HARD";
+  cancel.actionParameters.resize(1);
+  cancel.actionParameters[0].key = "orderId";
+  cancel.actionParameters[0].value = "order";
+  msg->actions.push_back(cancel);
+  client.InstantActionsCallback(msg);
+
+  // Actions wait until the cancellation is complete.
+  SendInstantAction(&client, "next");
+  ASSERT_TRUE(client.FindAction("next"));
+  EXPECT_FALSE(client.FindAction("next")->sentToAgv);
+
+  // The AGV stopped the action, the cancel action waits for the order daemon.
+  ReportState(&client, "order_pick", "FAILED");
+  EXPECT_FALSE(client.FindAction("order_pick"));
+  EXPECT_TRUE(client.FindAction("cancel"));
+
+  std_msgs::String::Ptr cancelled = boost::make_shared<std_msgs::String>();
+  cancelled->data = "order";
+  client.OrderCancelCallback(cancelled);
+  EXPECT_FALSE(client.FindAction("cancel"));
+  ASSERT_TRUE(client.FindAction("next"));
+  EXPECT_TRUE(client.FindAction("next")->sentToAgv);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "tester");
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "mqtt_bridge/bandwidth_governor.h"
+
+using namespace mqtt_bridge;
+
+/**
+ * Byte counters of a state and a visualization topic, advanced by constant rates.
+ */
+struct Uplink {
+  std::vector<OutboundStats> stats;
+  double now{0.0};
+
+  Uplink() {
+    stats.resize(2);
+    stats[0].topic = "state";
+    stats[0].sentBytes = 0;
+    stats[1].topic = "vis";
+    stats[1].sentBytes = 0;
+  }
+
+  /**
+   * Advances the counters by one second and samples them. Returns the level after the sample.
+   */
+  int Step(BandwidthGovernor& governor, uint64_t stateRate, uint64_t visRate) {
+    now += 1.0;
+    stats[0].sentBytes += stateRate;
+    stats[1].sentBytes += visRate;
+    governor.Update(now, stats);
+    return governor.GetLevel();
+  }
+};
+
+GovernorOptions Options(double budget) {
+  GovernorOptions options;
+  options.budget = budget;
+  options.raiseDelay = 2.0;
+  options.recoverDelay = 5.0;
+  options.smoothing = 1.0;
+  options.maxLevel = 3;
+  return options;
+}
+
+TEST(BandwidthGovernor, MeasuresRatesPerTopic) {
+  GovernorOptions options = Options(0.0);
+  options.smoothing = 0.5;
+  BandwidthGovernor governor(options);
+  Uplink uplink;
+  governor.Update(0.0, uplink.stats);
+  EXPECT_EQ(0.0, governor.GetRate());
+
+  uplink.Step(governor, 1000, 3000);
+  EXPECT_DOUBLE_EQ(500.0, governor.GetTopicRates()[0].bytesPerSecond);
+  EXPECT_DOUBLE_EQ(1500.0, governor.GetTopicRates()[1].bytesPerSecond);
+  uplink.Step(governor, 1000, 3000);
+  EXPECT_DOUBLE_EQ(750.0, governor.GetTopicRates()[0].bytesPerSecond);
+  EXPECT_DOUBLE_EQ(3000.0, governor.GetRate());
+  EXPECT_EQ("vis", governor.GetTopicRates()[1].topic);
+
+  // Without budget, the level never changes.
+  for (int i = 0; i < 10; i++) EXPECT_EQ(0, uplink.Step(governor, 100000, 100000));
+}
+
+TEST(BandwidthGovernor, RaisesLevelStepwiseOverBudget) {
+  BandwidthGovernor governor(Options(1000.0));
+  Uplink uplink;
+  governor.Update(0.0, uplink.stats);
+
+  EXPECT_EQ(0, uplink.Step(governor, 500, 400));
+  EXPECT_EQ(1, uplink.Step(governor, 500, 2000));
+  // The producers get the raise delay to react before the next raise.
+  EXPECT_EQ(1, uplink.Step(governor, 500, 2000));
+  EXPECT_EQ(2, uplink.Step(governor, 500, 2000));
+  EXPECT_EQ(2, uplink.Step(governor, 500, 2000));
+  EXPECT_EQ(3, uplink.Step(governor, 500, 2000));
+  for (int i = 0; i < 5; i++) EXPECT_EQ(3, uplink.Step(governor, 500, 2000));
+  EXPECT_EQ(3, governor.GetRaises());
+}
+
+TEST(BandwidthGovernor, RecoversWithHysteresis) {
+  BandwidthGovernor governor(Options(1000.0));
+  Uplink uplink;
+  governor.Update(0.0, uplink.stats);
+  for (int i = 0; i < 3; i++) uplink.Step(governor, 500, 2000);
+  ASSERT_EQ(2, uplink.Step(governor, 500, 2000));
+
+  // Below the budget but above the recover fraction, the level is kept.
+  for (int i = 0; i < 10; i++) EXPECT_EQ(2, uplink.Step(governor, 500, 300));
+
+  // Each level is lowered after the rate stayed low for the recover delay.
+  for (int i = 0; i < 5; i++) EXPECT_EQ(2, uplink.Step(governor, 300, 300));
+  EXPECT_EQ(1, uplink.Step(governor, 300, 300));
+  for (int i = 0; i < 4; i++) EXPECT_EQ(1, uplink.Step(governor, 300, 300));
+  EXPECT_EQ(0, uplink.Step(governor, 300, 300));
+  EXPECT_EQ(2, governor.GetRecoveries());
+
+  // A burst resets the recover delay.
+  uplink.Step(governor, 500, 2000);
+  ASSERT_EQ(1, uplink.Step(governor, 500, 2000));
+  for (int i = 0; i < 3; i++) uplink.Step(governor, 300, 300);
+  uplink.Step(governor, 500, 300);
+  for (int i = 0; i < 5; i++) EXPECT_EQ(1, uplink.Step(governor, 300, 300));
+  EXPECT_EQ(0, uplink.Step(governor, 300, 300));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <limits>
+#include <string>
+#include "mqtt_bridge/cbor_transcoder.h"
+#include "mqtt_bridge/cbor_writer.h"
+#include "mqtt_bridge/vda5050_json.h"
+
+using namespace mqtt_bridge;
+
+/**
+ * Converts a hex string, e.g. "a161616101", to bytes.
+ */
+std::string FromHex(const std::string& hex) {
+  std::string bytes;
+  for (size_t i = 0; i + 1 < hex.size(); i += 2)
+    bytes += static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16));
+  return bytes;
+}
+
+std::string ToJson(const std::string& cbor, const DecodeLimits& limits = DecodeLimits()) {
+  CborTranscoder transcoder(limits);
+  JsonWriter json;
+  transcoder.ToJson(cbor, json);
+  return json.str();
+}
+
+DecodeError TranscodeInvalid(const std::string& cbor, const DecodeLimits& limits = DecodeLimits()) {
+  try {
+    ToJson(cbor, limits);
+  } catch (const DecodeError& e) {
+    return e;
+  }
+  ADD_FAILURE() << "No error for " << cbor.size() << " bytes";
+  return DecodeError(DecodeError::SYNTAX, 0, "", "");
+}
+
+template <typename M>
+std::string EncodeCbor(const M& msg, bool packKeys = false) {
+  CborWriter writer(packKeys);
+  Encode(writer, msg);
+  return writer.str();
+}
+
+vda5050_msgs::State CreateState() {
+  vda5050_msgs::State state;
+  state.headerId = 70000;
+  state.timestamp = "2022-06-01T12:00:00.00Z";
+  state.version = "2.0.0";
+  state.manufacturer = "fml";
+  state.serialNumber = "agv \"1\"\n";
+  state.orderId = "order_1";
+  state.driving = true;
+  state.distanceSinceLastNode = 0.1;
+
+  for (uint32_t i = 0; i < 30; i++) {
+    vda5050_msgs::NodeState nodeState;
+    nodeState.nodeId = "node_" + std::to_string(i);
+    nodeState.sequenceId = 2 * i;
+    nodeState.released = i < 10;
+    nodeState.nodePosition.x = 0.37 * i;
+    nodeState.nodePosition.y = 12.125 - i;
+    nodeState.nodePosition.theta = -1.5707963267948966;
+    nodeState.nodePosition.mapId = "hall_1";
+    state.nodeStates.push_back(nodeState);
+  }
+
+  state.agvPosition.x = 1e-7;
+  state.agvPosition.y = -123456.789;
+  state.batteryState.batteryCharge = 87.5;
+  state.batteryState.batteryHealth = -1;
+  state.batteryState.reach = 4000000000u;
+  return state;
+}
+
+TEST(CborWriter, WritesShortestForms) {
+  CborWriter w;
+  w.BeginArray(9);
+  w.Uint(23);
+  w.Uint(24);
+  w.Int(-1);
+  w.Int(-1000);
+  w.Double(0.5);
+  w.Double(0.1);
+  w.Double(2.0);
+  w.Bool(true);
+  w.Null();
+  w.EndArray();
+  EXPECT_EQ(FromHex("89171818203903e7fa3f000000fb3fb999999999999a02f5f6"), w.str());
+
+  w.Clear();
+  w.BeginObject();
+  w.Key("a");
+  w.String("xyz");
+  w.EndObject();
+  EXPECT_EQ(FromHex("bf61616378797aff"), w.str());
+
+  // Packed keys are written as their index, other keys as text.
+  CborWriter packed(true);
+  packed.BeginObject();
+  packed.Key("nodeId");
+  packed.Uint(1);
+  packed.Key("headerId");
+  packed.Uint(2);
+  packed.Key("a");
+  packed.Uint(3);
+  packed.EndObject();
+  EXPECT_EQ(FromHex("bf0001184902616103ff"), packed.str());
+  EXPECT_STREQ("headerId", PackedKey(0x49));
+  EXPECT_EQ(nullptr, PackedKey(1000));
+}
+
+TEST(CborTranscoder, ReadsRfcExamples) {
+  EXPECT_EQ("1000", ToJson(FromHex("1903e8")));
+  EXPECT_EQ("-1000", ToJson(FromHex("3903e7")));
+  EXPECT_EQ("18446744073709551615", ToJson(FromHex("1bffffffffffffffff")));
+  EXPECT_EQ("1", ToJson(FromHex("f93c00")));
+  EXPECT_EQ("65504", ToJson(FromHex("f97bff")));
+  EXPECT_EQ("-4.1", ToJson(FromHex("fbc010666666666666")));
+  EXPECT_EQ("100000", ToJson(FromHex("fa47c35000")));
+  EXPECT_EQ("null", ToJson(FromHex("f97e00")));
+  EXPECT_EQ("null", ToJson(FromHex("f7")));
+  EXPECT_EQ("\"streaming\"", ToJson(FromHex("7f657374726561646d696e67ff")));
+  EXPECT_EQ("{\"a\":1,\"b\":[2,3]}", ToJson(FromHex("a26161016162820203")));
+  EXPECT_EQ("[\"a\",{\"b\":\"c\"}]", ToJson(FromHex("826161bf61626163ff")));
+  EXPECT_EQ("[1,[2,3],[4,5]]", ToJson(FromHex("9f018202039f0405ffff")));
+  EXPECT_EQ("\"2013-03-21T20:04:00Z\"",
+      ToJson(FromHex("c074323031332d30332d32315432303a30343a30305a")));
+  // Keys and strings are escaped for JSON.
+  EXPECT_EQ("{\"\\\"\":\"\\n\"}", ToJson(FromHex("a16122610a")));
+}
+
+TEST(CborTranscoder, MessagesMatchJsonEncoding) {
+  vda5050_msgs::State state = CreateState();
+  std::string cbor = EncodeCbor(state);
+  std::string json = Serialize(state);
+  std::string packed = EncodeCbor(state, true);
+  EXPECT_EQ(json, ToJson(cbor));
+  EXPECT_EQ(json, ToJson(packed));
+  EXPECT_LT(cbor.size(), json.size());
+  EXPECT_LT(packed.size(), json.size() / 2);
+
+  vda5050_msgs::State empty;
+  EXPECT_EQ(Serialize(empty), ToJson(EncodeCbor(empty)));
+
+  vda5050_msgs::Visualization vis;
+  vis.agvPosition.x = 1.5;
+  vis.velocity.omega = -0.25;
+  EXPECT_EQ(Serialize(vis), ToJson(EncodeCbor(vis)));
+  EXPECT_EQ(Serialize(vis), ToJson(EncodeCbor(vis, true)));
+
+  vda5050_msgs::Connection connection;
+  connection.connectionState = "CONNECTIONBROKEN";
+  EXPECT_EQ(Serialize(connection), ToJson(EncodeCbor(connection)));
+
+  // The JSON of the gateway decodes to the original message.
+  vda5050_msgs::State decoded;
+  Deserialize(ToJson(cbor), decoded);
+  EXPECT_EQ(state.serialNumber, decoded.serialNumber);
+  EXPECT_EQ(state.nodeStates[29].nodePosition.x, decoded.nodeStates[29].nodePosition.x);
+  EXPECT_EQ(state.agvPosition.y, decoded.agvPosition.y);
+  EXPECT_EQ(state.batteryState.reach, decoded.batteryState.reach);
+}
+
+TEST(CborTranscoder, StructuredErrors) {
+  DecodeError error = TranscodeInvalid(FromHex("a1616182014101"));
+  EXPECT_EQ(DecodeError::UNEXPECTED_TYPE, error.code());
+  EXPECT_EQ("a[1]", error.path());
+  EXPECT_EQ(6, error.offset());
+
+  EXPECT_EQ(DecodeError::SYNTAX, TranscodeInvalid(FromHex("8301")).code());
+  EXPECT_EQ(DecodeError::SYNTAX, TranscodeInvalid(FromHex("6461")).code());
+  EXPECT_EQ(DecodeError::SYNTAX, TranscodeInvalid(FromHex("0101")).code());
+  EXPECT_EQ(DecodeError::SYNTAX, TranscodeInvalid(FromHex("ff")).code());
+  EXPECT_EQ(DecodeError::UNEXPECTED_TYPE, TranscodeInvalid(FromHex("a1f402")).code());
+  EXPECT_EQ(DecodeError::UNEXPECTED_TYPE, TranscodeInvalid(FromHex("a11903e802")).code());
+  EXPECT_EQ(DecodeError::NUMBER_OUT_OF_RANGE,
+      TranscodeInvalid(FromHex("3bffffffffffffffff")).code());
+}
+
+TEST(CborTranscoder, EnforcesLimits) {
+  DecodeLimits limits;
+  limits.maxDepth = 3;
+  limits.maxArraySize = 2;
+  limits.maxStringLength = 3;
+
+  EXPECT_EQ(DecodeError::TOO_DEEP, TranscodeInvalid(FromHex("81818181"), limits).code());
+  EXPECT_EQ(DecodeError::ARRAY_TOO_LARGE, TranscodeInvalid(FromHex("83010203"), limits).code());
+  EXPECT_EQ(DecodeError::ARRAY_TOO_LARGE, TranscodeInvalid(FromHex("9f010203ff"), limits).code());
+  EXPECT_EQ(DecodeError::STRING_TOO_LONG, TranscodeInvalid(FromHex("6461626364"), limits).code());
+  EXPECT_EQ(
+      DecodeError::STRING_TOO_LONG, TranscodeInvalid(FromHex("7f626162626364ff"), limits).code());
+
+  limits.maxPayloadSize = 2;
+  EXPECT_EQ(DecodeError::PAYLOAD_TOO_LARGE, TranscodeInvalid(FromHex("830102"), limits).code());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "utils/deadline_scheduler.h"
+#include <gtest/gtest.h>
+
+using namespace connector_utils;
+
+TEST(DeadlineScheduler, PopsExpiredInOrder) {
+  DeadlineScheduler scheduler;
+  scheduler.Arm("b", ros::Time(20.0));
+  scheduler.Arm("a", ros::Time(10.0));
+  scheduler.Arm("c", ros::Time(30.0));
+
+  ASSERT_TRUE(scheduler.NextDeadline());
+  EXPECT_EQ(ros::Time(10.0), *scheduler.NextDeadline());
+
+  std::vector<std::string> expired = scheduler.PopExpired(ros::Time(25.0));
+  ASSERT_EQ(2, expired.size());
+  EXPECT_EQ("a", expired[0]);
+  EXPECT_EQ("b", expired[1]);
+  EXPECT_EQ(1, scheduler.Size());
+  EXPECT_TRUE(scheduler.IsArmed("c"));
+}
+
+TEST(DeadlineScheduler, DisarmAndRearm) {
+  DeadlineScheduler scheduler;
+  scheduler.Arm("a", ros::Time(10.0));
+  scheduler.Arm("b", ros::Time(20.0));
+
+  EXPECT_TRUE(scheduler.Disarm("a"));
+  EXPECT_FALSE(scheduler.Disarm("a"));
+  EXPECT_EQ(ros::Time(20.0), *scheduler.NextDeadline());
+
+  // Re-arming moves the deadline, the old entry must not expire.
+  scheduler.Arm("b", ros::Time(40.0));
+  EXPECT_TRUE(scheduler.PopExpired(ros::Time(30.0)).empty());
+  EXPECT_EQ(ros::Time(40.0), *scheduler.NextDeadline());
+
+  EXPECT_EQ(1, scheduler.PopExpired(ros::Time(40.0)).size());
+  EXPECT_FALSE(scheduler.NextDeadline());
+}
+
+TEST(DeadlineScheduler, RearmingManyTimes) {
+  DeadlineScheduler scheduler;
+  for (int i = 1; i <= 1000; i++) scheduler.Arm("a", ros::Time(i));
+
+  EXPECT_EQ(1, scheduler.Size());
+  EXPECT_TRUE(scheduler.PopExpired(ros::Time(999.0)).empty());
+  EXPECT_EQ(1, scheduler.PopExpired(ros::Time(1000.0)).size());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
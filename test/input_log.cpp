@@ -0,0 +1,138 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "utils/input_log.h"
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace connector_utils;
+
+/**
+ * Log file in /tmp that is removed after each test.
+ */
+class InputLogTest : public ::testing::Test {
+ protected:
+  std::string path{"/tmp/vda5050_input_log_test_" + std::to_string(::getpid())};
+
+  void SetUp() override { std::remove(path.c_str()); }
+  void TearDown() override { std::remove(path.c_str()); }
+
+  static LoggedTopic Topic(const std::string& key) {
+    return {key, "/" + key, "std_msgs/String", "992ce8a1687cec8c8bd883ec73ca41d1", "string data"};
+  }
+
+  /**
+   * Writes messages 0 to count - 1 alternating to two topics, 100 ms apart. Each message holds its
+   * number as a byte.
+   */
+  void WriteLog(int count) {
+    InputLogWriter writer(path);
+    uint16_t topics[2] = {writer.AddTopic(Topic("pose")), writer.AddTopic(Topic("order_from_mc"))};
+    for (int i = 0; i < count; i++) {
+      uint8_t data = i;
+      writer.Write(topics[i % 2], 5000000000 + i * 100000000LL, &data, 1);
+    }
+  }
+
+  static std::vector<int> ReadAll(InputLogReader& reader) {
+    std::vector<int> numbers;
+    LoggedMessage message;
+    while (reader.Next(&message)) {
+      EXPECT_EQ(1, message.data.size());
+      EXPECT_EQ(message.data[0] % 2, message.topic);
+      EXPECT_EQ(5000000000 + message.data[0] * 100000000LL, message.time);
+      numbers.push_back(message.data[0]);
+    }
+    return numbers;
+  }
+
+  /**
+   * Cuts the index and the last byte of the last message from the log, like a recorder that was
+   * killed while writing.
+   */
+  void CutIndex() {
+    FILE* file = std::fopen(path.c_str(), "rb+");
+    ASSERT_NE(nullptr, file);
+    uint64_t indexOffset;
+    std::fseek(file, -12, SEEK_END);
+    ASSERT_EQ(1, std::fread(&indexOffset, sizeof(indexOffset), 1, file));
+    ASSERT_EQ(0, ::ftruncate(fileno(file), indexOffset - 1));
+    std::fclose(file);
+  }
+};
+
+TEST_F(InputLogTest, ReadsMessagesInOrder) {
+  WriteLog(50);
+
+  InputLogReader reader(path);
+  EXPECT_TRUE(reader.IsIndexed());
+  ASSERT_EQ(2, reader.GetTopics().size());
+  EXPECT_EQ("order_from_mc", reader.GetTopics()[1].key);
+  EXPECT_EQ("/order_from_mc", reader.GetTopics()[1].name);
+  EXPECT_EQ("string data", reader.GetTopics()[1].definition);
+  EXPECT_EQ(50, reader.GetMessageCount());
+  EXPECT_EQ(25, reader.GetTopicCounts()[0]);
+  EXPECT_EQ(5000000000, reader.GetStartTime());
+  EXPECT_EQ(9900000000, reader.GetEndTime());
+
+  std::vector<int> numbers = ReadAll(reader);
+  ASSERT_EQ(50, numbers.size());
+  for (int i = 0; i < 50; i++) EXPECT_EQ(i, numbers[i]);
+}
+
+TEST_F(InputLogTest, SeeksToTime) {
+  WriteLog(50);
+
+  InputLogReader reader(path);
+  reader.Seek(7250000000);
+  std::vector<int> numbers = ReadAll(reader);
+  ASSERT_EQ(27, numbers.size());
+  EXPECT_EQ(23, numbers.front());
+
+  // Seeking back before the first message starts over.
+  reader.Seek(0);
+  EXPECT_EQ(50, ReadAll(reader).size());
+  reader.Seek(20000000000);
+  EXPECT_TRUE(ReadAll(reader).empty());
+}
+
+TEST_F(InputLogTest, RecoversLogWithoutIndex) {
+  WriteLog(50);
+  CutIndex();
+
+  InputLogReader reader(path);
+  EXPECT_FALSE(reader.IsIndexed());
+  EXPECT_EQ(2, reader.GetTopics().size());
+  EXPECT_EQ(49, reader.GetMessageCount());
+  EXPECT_EQ(9800000000, reader.GetEndTime());
+
+  std::vector<int> numbers = ReadAll(reader);
+  ASSERT_EQ(49, numbers.size());
+  EXPECT_EQ(48, numbers.back());
+
+  reader.Seek(9000000000);
+  EXPECT_EQ(9, ReadAll(reader).size());
+}
+
+TEST_F(InputLogTest, RejectsOtherFiles) {
+  FILE* file = std::fopen(path.c_str(), "wb");
+  std::fputs("not a log", file);
+  std::fclose(file);
+  EXPECT_THROW(InputLogReader reader(path), std::runtime_error);
+  EXPECT_THROW(InputLogReader reader(path + "_missing"), std::runtime_error);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "utils/journal.h"
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "utils/mapped_file.h"
+
+using namespace connector_utils;
+
+/**
+ * Journal file in /tmp that is removed after each test.
+ */
+class JournalTest : public ::testing::Test {
+ protected:
+  std::string path{"/tmp/vda5050_journal_test_" + std::to_string(::getpid())};
+
+  void SetUp() override { std::remove(path.c_str()); }
+  void TearDown() override {
+    std::remove(path.c_str());
+    std::remove((path + ".compact").c_str());
+  }
+
+  static bool Append(Journal& journal, uint8_t kind, const std::string& data) {
+    return journal.Append(kind, data.data(), data.size());
+  }
+};
+
+TEST_F(JournalTest, KeepsRecordsAcrossRestarts) {
+  {
+    Journal journal(path, 4096);
+    ASSERT_TRUE(Append(journal, 1, "order-1"));
+    ASSERT_TRUE(Append(journal, 2, ""));
+    ASSERT_TRUE(Append(journal, 3, "state-1"));
+  }
+
+  Journal journal(path, 4096);
+  std::vector<JournalRecord> records = journal.Read();
+  ASSERT_EQ(3, records.size());
+  EXPECT_EQ(3, journal.GetRecordCount());
+  EXPECT_EQ(1, records[0].kind);
+  EXPECT_EQ("order-1", records[0].data);
+  EXPECT_EQ(2, records[1].kind);
+  EXPECT_EQ("", records[1].data);
+  EXPECT_EQ("state-1", records[2].data);
+}
+
+TEST_F(JournalTest, DiscardsDamagedRecords) {
+  size_t intact;
+  {
+    Journal journal(path, 4096);
+    ASSERT_TRUE(Append(journal, 1, "order-1"));
+    intact = journal.GetUsed();
+    ASSERT_TRUE(Append(journal, 1, "order-2"));
+    ASSERT_TRUE(Append(journal, 1, "order-3"));
+  }
+  {
+    // A crash while writing the second record leaves it half written.
+    MappedFile file(path, 4096);
+    file.Data()[intact + 12] = 'X';
+  }
+
+  Journal journal(path, 4096);
+  std::vector<JournalRecord> records = journal.Read();
+  ASSERT_EQ(1, records.size());
+  EXPECT_EQ("order-1", records[0].data);
+  EXPECT_EQ(intact, journal.GetUsed());
+
+  // New records are appended behind the intact ones.
+  ASSERT_TRUE(Append(journal, 1, "order-4"));
+  EXPECT_EQ("order-4", journal.Read()[1].data);
+}
+
+TEST_F(JournalTest, ClearsFilesOfAnotherCapacity) {
+  {
+    Journal journal(path, 4096);
+    ASSERT_TRUE(Append(journal, 1, "order-1"));
+  }
+  Journal journal(path, 8192);
+  EXPECT_EQ(0, journal.GetRecordCount());
+  EXPECT_TRUE(journal.Read().empty());
+}
+
+TEST_F(JournalTest, RefusesRecordsWhenFull) {
+  Journal journal(path, 128);
+  size_t appended = 0;
+  while (Append(journal, 1, "0123456789")) appended++;
+
+  // A header of 24 bytes and records of 9 + 10 bytes.
+  EXPECT_EQ(5, appended);
+  EXPECT_EQ(5, journal.GetRecordCount());
+  EXPECT_LE(journal.GetUsed(), journal.GetCapacity());
+  EXPECT_TRUE(Append(journal, 1, ""));
+}
+
+TEST_F(JournalTest, CompactsToASnapshot) {
+  Journal journal(path, 4096);
+  for (int i = 0; i < 50; i++) ASSERT_TRUE(Append(journal, 1, "update-" + std::to_string(i)));
+
+  ASSERT_TRUE(journal.Compact({{7, "snapshot"}}));
+  EXPECT_EQ(1, journal.GetRecordCount());
+  ASSERT_TRUE(Append(journal, 1, "update-50"));
+
+  // Snapshots that do not fit leave the journal unchanged.
+  EXPECT_FALSE(journal.Compact({{7, std::string(4096, 'x')}}));
+  EXPECT_EQ(2, journal.GetRecordCount());
+
+  Journal reopened(path, 4096);
+  std::vector<JournalRecord> records = reopened.Read();
+  ASSERT_EQ(2, records.size());
+  EXPECT_EQ(7, records[0].kind);
+  EXPECT_EQ("snapshot", records[0].data);
+  EXPECT_EQ("update-50", records[1].data);
+}
+
+TEST_F(JournalTest, RecoversWithinMilliseconds) {
+  // A journal between two compactions: orders of some kilobytes and many small state updates.
+  const size_t capacity = 16 << 20;
+  {
+    Journal journal(path, capacity);
+    std::string order(4096, 'o');
+    std::string state(128, 's');
+    for (int i = 0; i < 10000; i++) {
+      ASSERT_TRUE(i % 100 == 0 ? Append(journal, 1, order) : Append(journal, 2, state));
+    }
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  Journal journal(path, capacity);
+  std::vector<JournalRecord> records = journal.Read();
+  std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+
+  ASSERT_EQ(10000, records.size());
+  // Checking and reading 1.7 MB takes a few milliseconds, the bound leaves room for slow machines.
+  EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 200);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include "mqtt_bridge/json_reader.h"
+#include "mqtt_bridge/vda5050_decoders.h"
+#include "mqtt_bridge/vda5050_json.h"
+
+using namespace mqtt_bridge;
+
+// Counts the allocations of the test process.
+size_t allocations = 0;
+
+void* operator new(size_t size) {
+  allocations++;
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+vda5050_msgs::Order CreateOrder(uint32_t nodes) {
+  vda5050_msgs::Order order;
+  order.headerId = 1;
+  order.timestamp = "2022-06-01T12:00:00.00Z";
+  order.version = "2.0.0";
+  order.manufacturer = "fml";
+  order.serialNumber = "agv_1";
+  order.orderId = "order_with_a_long_identifier";
+  order.orderUpdateId = 4;
+
+  for (uint32_t i = 0; i < nodes; i++) {
+    vda5050_msgs::Node node;
+    node.nodeId = "node_with_a_long_identifier_" + std::to_string(i);
+    node.sequenceId = 2 * i;
+    node.released = true;
+    node.nodePosition.x = 0.5 * i;
+    node.nodePosition.mapId = "hall_1";
+    vda5050_msgs::Action action;
+    action.actionId = "action_with_a_long_identifier_" + std::to_string(i);
+    action.actionType = "pick";
+    action.blockingType = "HARD";
+    vda5050_msgs::ActionParameter parameter;
+    parameter.key = "stationType";
+    parameter.value = "floor";
+    action.actionParameters.push_back(parameter);
+    node.actions.push_back(action);
+    order.nodes.push_back(node);
+
+    if (i + 1 == nodes) break;
+    vda5050_msgs::Edge edge;
+    edge.edgeId = "edge_with_a_long_identifier_" + std::to_string(i);
+    edge.sequenceId = 2 * i + 1;
+    edge.released = true;
+    edge.startNodeId = node.nodeId;
+    edge.endNodeId = "node_with_a_long_identifier_" + std::to_string(i + 1);
+    edge.maxSpeed = 1.5;
+    order.edges.push_back(edge);
+  }
+  return order;
+}
+
+DecodeError DecodeInvalid(const std::string& payload, const DecodeLimits& limits = DecodeLimits()) {
+  JsonReader reader(limits);
+  vda5050_msgs::Order order;
+  try {
+    Decode(reader, payload, order);
+  } catch (const DecodeError& e) {
+    return e;
+  }
+  ADD_FAILURE() << "No error for " << payload;
+  return DecodeError(DecodeError::SYNTAX, 0, "", "");
+}
+
+TEST(JsonDecoder, LargeOrderRoundTrip) {
+  vda5050_msgs::Order order = CreateOrder(1000);
+  std::string payload = Serialize(order);
+
+  JsonReader reader;
+  vda5050_msgs::Order decoded;
+  Decode(reader, payload, decoded);
+  ASSERT_EQ(1000, decoded.nodes.size());
+  ASSERT_EQ(999, decoded.edges.size());
+  EXPECT_EQ(order.orderId, decoded.orderId);
+  EXPECT_EQ(order.nodes[500].nodeId, decoded.nodes[500].nodeId);
+  EXPECT_EQ(order.nodes[500].nodePosition.x, decoded.nodes[500].nodePosition.x);
+  EXPECT_EQ("floor", decoded.nodes[999].actions[0].actionParameters[0].value);
+  EXPECT_EQ(order.edges[998].endNodeId, decoded.edges[998].endNodeId);
+  EXPECT_TRUE(decoded.edges[998].released);
+
+  // The second decode into the same message reuses all strings and vectors.
+  size_t before = allocations;
+  Decode(reader, payload, decoded);
+  EXPECT_EQ(before, allocations);
+  EXPECT_EQ(order.nodes[999].nodeId, decoded.nodes[999].nodeId);
+}
+
+TEST(JsonDecoder, ReusedMessageIsReset) {
+  JsonReader reader;
+  vda5050_msgs::InstantAction ia;
+  Decode(reader,
+      "{\"headerId\": 1, \"serialNumber\": \"agv_1\", \"actions\": [{\"actionId\": \"a1\", "
+      "\"actionDescription\": \"first\"}, {\"actionId\": \"a2\"}]}",
+      ia);
+  ASSERT_EQ(2, ia.actions.size());
+
+  Decode(reader, "{\"headerId\": 2, \"serialNumber\": null, \"actions\": [{\"actionId\": \"b1\"}]}",
+      ia);
+  EXPECT_EQ(2, ia.headerId);
+  EXPECT_TRUE(ia.serialNumber.empty());
+  ASSERT_EQ(1, ia.actions.size());
+  EXPECT_EQ("b1", ia.actions[0].actionId);
+  EXPECT_TRUE(ia.actions[0].actionDescription.empty());
+}
+
+TEST(JsonDecoder, ReadsForeignJson) {
+  JsonReader reader;
+  vda5050_msgs::Order order;
+  Decode(reader,
+      " {\"orderId\": \"o\\u00e4\\ud83d\\ude00\\n\", \"unknown\": {\"a\": [1, {\"b\": null}]}, "
+      "\"orderUpdateId\": 3.0, \"nodes\": [{\"released\": 1, \"nodePosition\": {\"x\": -1.5e2}, "
+      "\"actions\": [{\"actionParameters\": [{\"key\": \"k\", \"value\": [1, \"x\"]}]}]}]} ",
+      order);
+  EXPECT_EQ("o\xc3\xa4\xf0\x9f\x98\x80\n", order.orderId);
+  EXPECT_EQ(3, order.orderUpdateId);
+  ASSERT_EQ(1, order.nodes.size());
+  EXPECT_TRUE(order.nodes[0].released);
+  EXPECT_EQ(-150.0, order.nodes[0].nodePosition.x);
+  EXPECT_EQ("[1, \"x\"]", order.nodes[0].actions[0].actionParameters[0].value);
+}
+
+TEST(JsonDecoder, ReadsZoneSets) {
+  JsonReader reader;
+  connector_utils::ZoneSet zoneSet;
+  Decode(reader,
+      "{\"headerId\": 1, \"zoneSetId\": \"hall_1\", \"mapId\": \"map_1\", \"zones\": "
+      "[{\"zoneId\": \"dock\", \"zoneType\": \"INTERACTION\", \"vertices\": [{\"x\": 0, "
+      "\"y\": 0}, {\"x\": 4.5, \"y\": 0}, {\"x\": 4.5, \"y\": -2, \"z\": 1}]}, {}]}",
+      zoneSet);
+  EXPECT_EQ("hall_1", zoneSet.zoneSetId);
+  EXPECT_EQ("map_1", zoneSet.mapId);
+  ASSERT_EQ(2, zoneSet.zones.size());
+  EXPECT_EQ("dock", zoneSet.zones[0].zoneId);
+  EXPECT_EQ("INTERACTION", zoneSet.zones[0].zoneType);
+  ASSERT_EQ(3, zoneSet.zones[0].vertices.size());
+  EXPECT_EQ(4.5, zoneSet.zones[0].vertices[2].x);
+  EXPECT_EQ(-2.0, zoneSet.zones[0].vertices[2].y);
+  EXPECT_TRUE(zoneSet.zones[1].vertices.empty());
+}
+
+TEST(JsonDecoder, StructuredErrors) {
+  DecodeError error = DecodeInvalid("{\"nodes\": [{}, {\"actions\": [{\"actionId\": 5}]}]}");
+  EXPECT_EQ(DecodeError::UNEXPECTED_TYPE, error.code());
+  EXPECT_EQ("nodes[1].actions[0].actionId", error.path());
+  EXPECT_EQ(41, error.offset());
+
+  EXPECT_EQ(DecodeError::SYNTAX, DecodeInvalid("{\"orderId\": \"o\",}").code());
+  EXPECT_EQ(DecodeError::SYNTAX, DecodeInvalid("{\"orderId\": \"o\"} x").code());
+  EXPECT_EQ(DecodeError::SYNTAX, DecodeInvalid("{\"orderId\": \"o").code());
+  EXPECT_EQ(DecodeError::SYNTAX, DecodeInvalid("{\"orderUpdateId\": 01}").code());
+  EXPECT_EQ(DecodeError::UNEXPECTED_TYPE, DecodeInvalid("[]").code());
+  EXPECT_EQ(DecodeError::NUMBER_OUT_OF_RANGE, DecodeInvalid("{\"headerId\": -1}").code());
+  EXPECT_EQ(DecodeError::NUMBER_OUT_OF_RANGE, DecodeInvalid("{\"headerId\": 4294967296}").code());
+  EXPECT_EQ(DecodeError::UNEXPECTED_TYPE, DecodeInvalid("{\"headerId\": 1.5}").code());
+}
+
+TEST(JsonDecoder, EnforcesLimits) {
+  DecodeLimits limits;
+  limits.maxPayloadSize = 64;
+  limits.maxDepth = 4;
+  limits.maxArraySize = 2;
+  limits.maxStringLength = 8;
+
+  EXPECT_EQ(DecodeError::PAYLOAD_TOO_LARGE,
+      DecodeInvalid("{\"orderId\": \"" + std::string(100, 'o') + "\"}", limits).code());
+  EXPECT_EQ(
+      DecodeError::STRING_TOO_LONG, DecodeInvalid("{\"orderId\": \"123456789\"}", limits).code());
+  EXPECT_EQ(
+      DecodeError::ARRAY_TOO_LARGE, DecodeInvalid("{\"nodes\": [{}, {}, {}]}", limits).code());
+  EXPECT_EQ(DecodeError::TOO_DEEP, DecodeInvalid("{\"x\": [[[[1]]]]}", limits).code());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
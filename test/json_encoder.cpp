@@ -0,0 +1,392 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "mqtt_bridge/json_writer.h"
+#include "mqtt_bridge/vda5050_encoders.h"
+#include "mqtt_bridge/vda5050_json.h"
+
+using namespace mqtt_bridge;
+
+/*--------------------------------Schema--------------------------------------------------------*/
+
+// Subset of the VDA 5050 2.0 JSON schemas: types of the properties and the required ones.
+
+enum class JsonType { String, Integer, Number, Boolean, Object, Array };
+
+struct SchemaProperty {
+  const char* key;
+  JsonType type;
+  bool required;
+};
+
+const std::vector<SchemaProperty> HEADER_SCHEMA = {
+    {"headerId", JsonType::Integer, true},
+    {"timestamp", JsonType::String, true},
+    {"version", JsonType::String, true},
+    {"manufacturer", JsonType::String, true},
+    {"serialNumber", JsonType::String, true},
+};
+
+const std::vector<SchemaProperty> STATE_SCHEMA = {
+    {"orderId", JsonType::String, true},
+    {"orderUpdateId", JsonType::Integer, true},
+    {"zoneSetId", JsonType::String, false},
+    {"lastNodeId", JsonType::String, true},
+    {"lastNodeSequenceId", JsonType::Integer, true},
+    {"driving", JsonType::Boolean, true},
+    {"paused", JsonType::Boolean, false},
+    {"newBaseRequest", JsonType::Boolean, false},
+    {"distanceSinceLastNode", JsonType::Number, false},
+    {"operatingMode", JsonType::String, true},
+    {"nodeStates", JsonType::Array, true},
+    {"edgeStates", JsonType::Array, true},
+    {"agvPosition", JsonType::Object, false},
+    {"velocity", JsonType::Object, false},
+    {"loads", JsonType::Array, false},
+    {"actionStates", JsonType::Array, true},
+    {"batteryState", JsonType::Object, true},
+    {"errors", JsonType::Array, true},
+    {"information", JsonType::Array, false},
+    {"safetyState", JsonType::Object, true},
+};
+
+const std::vector<SchemaProperty> NODE_STATE_SCHEMA = {
+    {"nodeId", JsonType::String, true},
+    {"sequenceId", JsonType::Integer, true},
+    {"nodeDescription", JsonType::String, false},
+    {"nodePosition", JsonType::Object, false},
+    {"released", JsonType::Boolean, true},
+};
+
+const std::vector<SchemaProperty> NODE_POSITION_SCHEMA = {
+    {"x", JsonType::Number, true},
+    {"y", JsonType::Number, true},
+    {"theta", JsonType::Number, false},
+    {"allowedDeviationXY", JsonType::Number, false},
+    {"allowedDeviationTheta", JsonType::Number, false},
+    {"mapId", JsonType::String, true},
+    {"mapDescription", JsonType::String, false},
+};
+
+const std::vector<SchemaProperty> EDGE_STATE_SCHEMA = {
+    {"edgeId", JsonType::String, true},
+    {"sequenceId", JsonType::Integer, true},
+    {"edgeDescription", JsonType::String, false},
+    {"released", JsonType::Boolean, true},
+    {"trajectory", JsonType::Object, false},
+};
+
+const std::vector<SchemaProperty> TRAJECTORY_SCHEMA = {
+    {"degree", JsonType::Number, true},
+    {"knotVector", JsonType::Array, true},
+    {"controlPoints", JsonType::Array, true},
+};
+
+const std::vector<SchemaProperty> AGV_POSITION_SCHEMA = {
+    {"x", JsonType::Number, true},
+    {"y", JsonType::Number, true},
+    {"theta", JsonType::Number, true},
+    {"mapId", JsonType::String, true},
+    {"mapDescription", JsonType::String, false},
+    {"positionInitialized", JsonType::Boolean, true},
+    {"localizationScore", JsonType::Number, false},
+    {"deviationRange", JsonType::Number, false},
+};
+
+const std::vector<SchemaProperty> VELOCITY_SCHEMA = {
+    {"vx", JsonType::Number, false},
+    {"vy", JsonType::Number, false},
+    {"omega", JsonType::Number, false},
+};
+
+const std::vector<SchemaProperty> ACTION_STATE_SCHEMA = {
+    {"actionId", JsonType::String, true},
+    {"actionType", JsonType::String, false},
+    {"actionDescription", JsonType::String, false},
+    {"actionStatus", JsonType::String, true},
+    {"resultDescription", JsonType::String, false},
+};
+
+const std::vector<SchemaProperty> BATTERY_STATE_SCHEMA = {
+    {"batteryCharge", JsonType::Number, true},
+    {"batteryVoltage", JsonType::Number, false},
+    {"batteryHealth", JsonType::Integer, false},
+    {"charging", JsonType::Boolean, true},
+    {"reach", JsonType::Integer, false},
+};
+
+const std::vector<SchemaProperty> ERROR_SCHEMA = {
+    {"errorType", JsonType::String, true},
+    {"errorReferences", JsonType::Array, false},
+    {"errorDescription", JsonType::String, false},
+    {"errorLevel", JsonType::String, true},
+};
+
+const std::vector<SchemaProperty> SAFETY_STATE_SCHEMA = {
+    {"eStop", JsonType::String, true},
+    {"fieldViolation", JsonType::Boolean, true},
+};
+
+const std::vector<SchemaProperty> CONNECTION_SCHEMA = {
+    {"connectionState", JsonType::String, true},
+};
+
+bool HasType(const Json::Value& value, JsonType type) {
+  switch (type) {
+    case JsonType::String:
+      return value.isString();
+    case JsonType::Integer:
+      return value.isIntegral();
+    case JsonType::Number:
+      return value.isNumeric();
+    case JsonType::Boolean:
+      return value.isBool();
+    case JsonType::Object:
+      return value.isObject();
+    case JsonType::Array:
+      return value.isArray();
+  }
+  return false;
+}
+
+void ExpectConforms(
+    const Json::Value& json, const std::vector<SchemaProperty>& schema, const std::string& path) {
+  ASSERT_TRUE(json.isObject()) << path;
+  for (const auto& property : schema) {
+    if (!json.isMember(property.key)) {
+      EXPECT_FALSE(property.required) << path << "." << property.key << " is missing";
+      continue;
+    }
+    EXPECT_TRUE(HasType(json[property.key], property.type))
+        << path << "." << property.key << " has the wrong type";
+  }
+}
+
+void ExpectStateConforms(const Json::Value& json) {
+  ExpectConforms(json, HEADER_SCHEMA, "state");
+  ExpectConforms(json, STATE_SCHEMA, "state");
+  for (const auto& nodeState : json["nodeStates"]) {
+    ExpectConforms(nodeState, NODE_STATE_SCHEMA, "nodeStates[]");
+    ExpectConforms(nodeState["nodePosition"], NODE_POSITION_SCHEMA, "nodeStates[].nodePosition");
+  }
+  for (const auto& edgeState : json["edgeStates"]) {
+    ExpectConforms(edgeState, EDGE_STATE_SCHEMA, "edgeStates[]");
+    ExpectConforms(edgeState["trajectory"], TRAJECTORY_SCHEMA, "edgeStates[].trajectory");
+  }
+  for (const auto& actionState : json["actionStates"])
+    ExpectConforms(actionState, ACTION_STATE_SCHEMA, "actionStates[]");
+  for (const auto& error : json["errors"]) ExpectConforms(error, ERROR_SCHEMA, "errors[]");
+  ExpectConforms(json["agvPosition"], AGV_POSITION_SCHEMA, "agvPosition");
+  ExpectConforms(json["velocity"], VELOCITY_SCHEMA, "velocity");
+  ExpectConforms(json["batteryState"], BATTERY_STATE_SCHEMA, "batteryState");
+  ExpectConforms(json["safetyState"], SAFETY_STATE_SCHEMA, "safetyState");
+}
+
+Json::Value Parse(const std::string& payload) {
+  Json::CharReaderBuilder builder;
+  Json::CharReaderBuilder::strictMode(&builder.settings_);
+  std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+  Json::Value json;
+  std::string errors;
+  EXPECT_TRUE(reader->parse(payload.data(), payload.data() + payload.size(), &json, &errors))
+      << errors << "\n"
+      << payload;
+  return json;
+}
+
+/*--------------------------------Messages------------------------------------------------------*/
+
+vda5050_msgs::State CreateState() {
+  vda5050_msgs::State state;
+  state.headerId = 12;
+  state.timestamp = "2022-06-01T12:00:00.00Z";
+  state.version = "2.0.0";
+  state.manufacturer = "fml";
+  state.serialNumber = "agv \"1\"";
+  state.orderId = "order_1";
+  state.orderUpdateId = 2;
+  state.lastNodeId = "node_0";
+  state.driving = true;
+  state.distanceSinceLastNode = 0.1;
+  state.operatingMode = "AUTOMATIC";
+
+  for (uint32_t i = 0; i < 3; i++) {
+    vda5050_msgs::NodeState nodeState;
+    nodeState.nodeId = "node_" + std::to_string(i + 1);
+    nodeState.sequenceId = 2 * i + 2;
+    nodeState.released = i == 0;
+    nodeState.nodePosition.x = i * 1.25;
+    nodeState.nodePosition.y = -1.0 / 3.0;
+    nodeState.nodePosition.mapId = "map";
+    state.nodeStates.push_back(nodeState);
+
+    vda5050_msgs::EdgeState edgeState;
+    edgeState.edgeId = "edge_" + std::to_string(i + 1);
+    edgeState.sequenceId = 2 * i + 1;
+    edgeState.trajectory.degree = 1;
+    edgeState.trajectory.knotVector = {0.0, 0.5, 1.0};
+    vda5050_msgs::ControlPoint controlPoint;
+    controlPoint.x = 1e-7;
+    controlPoint.y = 123456.789;
+    controlPoint.weight = 1.0;
+    edgeState.trajectory.controlPoints.push_back(controlPoint);
+    state.edgeStates.push_back(edgeState);
+  }
+
+  vda5050_msgs::ActionState actionState;
+  actionState.actionId = "action_1";
+  actionState.actionStatus = "RUNNING";
+  actionState.resultDescription = "line\nbreak\ttab";
+  state.actionStates.push_back(actionState);
+
+  state.agvPosition.x = 10.5;
+  state.agvPosition.theta = -3.14159;
+  state.agvPosition.mapId = "map";
+  state.agvPosition.positionInitialized = true;
+  state.velocity.vx = 0.75;
+  state.batteryState.batteryCharge = 87.5;
+  state.batteryState.batteryHealth = -1;
+  state.batteryState.reach = 4000000000u;
+
+  vda5050_msgs::Error error;
+  error.errorType = "orderError";
+  error.errorLevel = "WARNING";
+  vda5050_msgs::ErrorReference reference;
+  reference.referenceKey = "orderId";
+  reference.referenceValue = "order_1";
+  error.errorReferences.push_back(reference);
+  state.errors.push_back(error);
+
+  state.safetyState.eStop = "NONE";
+
+  vda5050_msgs::InteractionZoneState zone;
+  zone.zoneId = "zone_1";
+  zone.zoneStatus = 200;
+  state.interactionZones.push_back(zone);
+
+  return state;
+}
+
+/*--------------------------------Tests---------------------------------------------------------*/
+
+TEST(JsonWriter, Numbers) {
+  JsonWriter w;
+  w.BeginArray(9);
+  w.Double(0.1);
+  w.Double(1.0);
+  w.Double(-2.5);
+  w.Double(1.0 / 3.0);
+  w.Double(1e300);
+  w.Double(std::numeric_limits<double>::quiet_NaN());
+  w.Int(std::numeric_limits<int64_t>::min());
+  w.Uint(std::numeric_limits<uint64_t>::max());
+  w.Bool(false);
+  w.EndArray();
+
+  Json::Value json = Parse(w.str());
+  ASSERT_EQ(9, json.size());
+  EXPECT_EQ("[0.1,1,-2.5,", w.str().substr(0, 12));
+  EXPECT_EQ(1.0 / 3.0, json[3].asDouble());
+  EXPECT_EQ(1e300, json[4].asDouble());
+  EXPECT_TRUE(json[5].isNull());
+  EXPECT_EQ(std::numeric_limits<int64_t>::min(), json[6].asInt64());
+  EXPECT_EQ(std::numeric_limits<uint64_t>::max(), json[7].asUInt64());
+}
+
+TEST(JsonWriter, EscapesStrings) {
+  std::string value = "quote \" backslash \\ newline \n control \x01 umlaut \xc3\xa4";
+  JsonWriter w;
+  w.BeginObject();
+  w.Key("value");
+  w.String(value);
+  w.EndObject();
+
+  EXPECT_EQ(value, Parse(w.str())["value"].asString());
+}
+
+TEST(JsonWriter, ReusesBuffer) {
+  vda5050_msgs::State state = CreateState();
+  JsonWriter w;
+  Encode(w, state);
+  std::string first = w.str();
+  const char* data = w.str().data();
+
+  w.Clear();
+  Encode(w, state);
+  EXPECT_EQ(first, w.str());
+  EXPECT_EQ(data, w.str().data());
+}
+
+TEST(Vda5050Encoders, StateConformsToSchema) {
+  ExpectStateConforms(Parse(Serialize(CreateState())));
+
+  // Empty messages have to conform as well.
+  ExpectStateConforms(Parse(Serialize(vda5050_msgs::State())));
+}
+
+TEST(Vda5050Encoders, StateRoundTrip) {
+  vda5050_msgs::State state = CreateState();
+  vda5050_msgs::State parsed;
+  Deserialize(Serialize(state), parsed);
+
+  EXPECT_EQ(state.headerId, parsed.headerId);
+  EXPECT_EQ(state.serialNumber, parsed.serialNumber);
+  EXPECT_TRUE(parsed.driving);
+  EXPECT_EQ(state.distanceSinceLastNode, parsed.distanceSinceLastNode);
+  ASSERT_EQ(3, parsed.nodeStates.size());
+  EXPECT_EQ(state.nodeStates[1].nodeId, parsed.nodeStates[1].nodeId);
+  EXPECT_EQ(state.nodeStates[1].sequenceId, parsed.nodeStates[1].sequenceId);
+  EXPECT_EQ(state.nodeStates[2].nodePosition.y, parsed.nodeStates[2].nodePosition.y);
+  ASSERT_EQ(3, parsed.edgeStates.size());
+  EXPECT_EQ(state.edgeStates[0].trajectory.knotVector, parsed.edgeStates[0].trajectory.knotVector);
+  EXPECT_EQ(state.edgeStates[0].trajectory.controlPoints[0].x,
+      parsed.edgeStates[0].trajectory.controlPoints[0].x);
+  ASSERT_EQ(1, parsed.actionStates.size());
+  EXPECT_EQ(state.actionStates[0].resultDescription, parsed.actionStates[0].resultDescription);
+  EXPECT_EQ(state.agvPosition.theta, parsed.agvPosition.theta);
+  EXPECT_EQ(state.batteryState.batteryHealth, parsed.batteryState.batteryHealth);
+  EXPECT_EQ(state.batteryState.reach, parsed.batteryState.reach);
+  ASSERT_EQ(1, parsed.errors.size());
+  EXPECT_EQ("order_1", parsed.errors[0].errorReferences[0].referenceValue);
+  ASSERT_EQ(1, parsed.interactionZones.size());
+  EXPECT_EQ(200, parsed.interactionZones[0].zoneStatus);
+}
+
+TEST(Vda5050Encoders, VisualizationAndConnection) {
+  vda5050_msgs::Visualization vis;
+  vis.headerId = 3;
+  vis.agvPosition.x = 1.5;
+  vis.agvPosition.mapId = "map";
+  vis.velocity.omega = -0.25;
+
+  Json::Value json = Parse(Serialize(vis));
+  ExpectConforms(json, HEADER_SCHEMA, "visualization");
+  ExpectConforms(json["agvPosition"], AGV_POSITION_SCHEMA, "agvPosition");
+  EXPECT_EQ(-0.25, json["velocity"]["omega"].asDouble());
+
+  vda5050_msgs::Connection connection;
+  connection.connectionState = "ONLINE";
+  json = Parse(Serialize(connection));
+  ExpectConforms(json, HEADER_SCHEMA, "connection");
+  ExpectConforms(json, CONNECTION_SCHEMA, "connection");
+  EXPECT_EQ("ONLINE", json["connectionState"].asString());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "utils/metrics.h"
+#include <gtest/gtest.h>
+#include <ros/callback_queue.h>
+#include <boost/make_shared.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace connector_utils;
+
+/**
+ * Callback that counts its calls.
+ */
+class CountingCallback : public ros::CallbackInterface {
+ public:
+  int calls{0};
+
+  CallResult call() override {
+    calls++;
+    return Success;
+  }
+};
+
+TEST(Metrics, SumsTheCountsOfAllThreads) {
+  Metrics metrics;
+  size_t calls = metrics.AddCounter("calls");
+  size_t bytes = metrics.AddCounter("bytes");
+  EXPECT_EQ(calls, metrics.AddCounter("calls"));
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&metrics, calls, bytes] {
+      for (int j = 0; j < 100000; j++) {
+        metrics.Add(calls);
+        metrics.Add(bytes, 3);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  // The counts of ended threads are kept.
+  std::vector<uint64_t> values = metrics.Read();
+  ASSERT_EQ(2, values.size());
+  EXPECT_EQ(400000, values[calls]);
+  EXPECT_EQ(1200000, values[bytes]);
+  EXPECT_EQ("bytes", metrics.GetNames()[bytes]);
+}
+
+TEST(Metrics, InstancesCountIndependently) {
+  Metrics first;
+  size_t counter = first.AddCounter("calls");
+  first.Add(counter, 5);
+  {
+    Metrics second;
+    second.Add(second.AddCounter("calls"), 7);
+    EXPECT_EQ(7, second.Read()[0]);
+  }
+  Metrics third;
+  third.AddCounter("calls");
+  EXPECT_EQ(0, third.Read()[0]);
+  EXPECT_EQ(5, first.Read()[counter]);
+}
+
+TEST(Metrics, SharesTheLastCounterWhenFull) {
+  Metrics metrics;
+  for (size_t i = 0; i < Metrics::MAX_COUNTERS; i++) metrics.AddCounter(std::to_string(i));
+  EXPECT_EQ(Metrics::MAX_COUNTERS - 1, metrics.AddCounter("more"));
+  EXPECT_EQ(Metrics::MAX_COUNTERS, metrics.GetNames().size());
+}
+
+TEST(MeteredScope, CountsCallsAndTime) {
+  Metrics metrics;
+  size_t timed = MeteredScope::AddTimed(&metrics, "UpdateActions");
+  for (int i = 0; i < 3; i++) {
+    MeteredScope scope(&metrics, timed);
+    volatile uint64_t sum = 0;
+    for (int j = 0; j < 100000; j++) sum += j;
+  }
+
+  std::vector<std::string> names = metrics.GetNames();
+  std::vector<uint64_t> values = metrics.Read();
+  EXPECT_EQ("UpdateActions calls", names[timed]);
+  EXPECT_EQ("UpdateActions wall_ns", names[timed + 1]);
+  EXPECT_EQ("UpdateActions cpu_ns", names[timed + 2]);
+  EXPECT_EQ(3, values[timed]);
+  EXPECT_GT(values[timed + 1], 0);
+  EXPECT_GT(values[timed + 2], 0);
+}
+
+TEST(MeteredQueue, TracksDepthAndFullQueue) {
+  ros::CallbackQueue target;
+  MeteredQueue queue(&target, 3);
+  boost::shared_ptr<CountingCallback> callback = boost::make_shared<CountingCallback>();
+
+  // Like a subscription, ROS adds its subscriber queue once per message.
+  for (int i = 0; i < 3; i++) queue.addCallback(callback, 1);
+  EXPECT_EQ(3, queue.GetDepth());
+  EXPECT_EQ(1, queue.GetFull());
+
+  target.callAvailable();
+  EXPECT_EQ(3, callback->calls);
+  EXPECT_EQ(0, queue.GetDepth());
+  EXPECT_EQ(3, queue.TakeMaxDepth());
+  EXPECT_EQ(0, queue.TakeMaxDepth());
+
+  queue.addCallback(callback, 1);
+  queue.removeByID(1);
+  EXPECT_EQ(0, queue.GetDepth());
+  EXPECT_TRUE(target.isEmpty());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,265 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <ros/callback_queue.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mqtt_bridge/mqtt_bridge.h"
+#include "mqtt_bridge/mqtt_client.h"
+#include "mqtt_bridge/vda5050_json.h"
+
+using namespace mqtt_bridge;
+
+/**
+ * Collects the messages received by a client.
+ */
+struct Inbox {
+  std::mutex mutex;
+  std::condition_variable received;
+  std::vector<std::pair<std::string, std::string>> messages;
+
+  void Add(const std::string& topic, const std::string& payload) {
+    std::lock_guard<std::mutex> lock(mutex);
+    messages.emplace_back(topic, payload);
+    received.notify_all();
+  }
+
+  bool WaitFor(size_t count, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return received.wait_for(lock, timeout, [&]() { return messages.size() >= count; });
+  }
+};
+
+bool WaitForConnection(const MqttClient& client, std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!client.IsConnected() && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  return client.IsConnected();
+}
+
+/**
+ * Options for the broker on localhost. The broker tests are skipped if it is not running.
+ */
+MqttOptions LocalBroker(const std::string& clientId) {
+  MqttOptions options;
+  options.host = "localhost";
+  options.port = 1883;
+  options.clientId = clientId + "_" + std::to_string(getpid());
+  return options;
+}
+
+vda5050_msgs::Order CreateOrder() {
+  vda5050_msgs::Order order;
+  order.headerId = 42;
+  order.timestamp = "2022-06-01T12:00:00.00Z";
+  order.version = "2.0.0";
+  order.manufacturer = "fml";
+  order.serialNumber = "agv_1";
+  order.orderId = "order_1";
+  order.orderUpdateId = 3;
+
+  vda5050_msgs::Node node;
+  node.nodeId = "node_1";
+  node.sequenceId = 0;
+  node.released = true;
+  node.nodePosition.x = 1.5;
+  node.nodePosition.y = -2.25;
+  node.nodePosition.mapId = "map";
+
+  vda5050_msgs::Action action;
+  action.actionId = "action_1";
+  action.actionType = "pick";
+  action.blockingType = "HARD";
+  vda5050_msgs::ActionParameter param;
+  param.key = "stationType";
+  param.value = "floor";
+  action.actionParameters.push_back(param);
+  node.actions.push_back(action);
+  order.nodes.push_back(node);
+
+  vda5050_msgs::Edge edge;
+  edge.edgeId = "edge_1";
+  edge.sequenceId = 1;
+  edge.startNodeId = "node_1";
+  edge.endNodeId = "node_2";
+  edge.maxSpeed = 1.2;
+  edge.trajectory.degree = 2;
+  edge.trajectory.knotVector = {0.0, 0.0, 0.0, 1.0, 1.0, 1.0};
+  vda5050_msgs::ControlPoint controlPoint;
+  controlPoint.x = 3.0;
+  controlPoint.weight = 1.0;
+  edge.trajectory.controlPoints.push_back(controlPoint);
+  order.edges.push_back(edge);
+
+  return order;
+}
+
+void ExpectOrdersEqual(const vda5050_msgs::Order& expected, const vda5050_msgs::Order& actual) {
+  EXPECT_EQ(expected.headerId, actual.headerId);
+  EXPECT_EQ(expected.timestamp, actual.timestamp);
+  EXPECT_EQ(expected.serialNumber, actual.serialNumber);
+  EXPECT_EQ(expected.orderId, actual.orderId);
+  EXPECT_EQ(expected.orderUpdateId, actual.orderUpdateId);
+  ASSERT_EQ(expected.nodes.size(), actual.nodes.size());
+  EXPECT_EQ(expected.nodes[0].nodeId, actual.nodes[0].nodeId);
+  EXPECT_TRUE(actual.nodes[0].released);
+  EXPECT_DOUBLE_EQ(expected.nodes[0].nodePosition.y, actual.nodes[0].nodePosition.y);
+  ASSERT_EQ(1, actual.nodes[0].actions.size());
+  ASSERT_EQ(1, actual.nodes[0].actions[0].actionParameters.size());
+  EXPECT_EQ("floor", actual.nodes[0].actions[0].actionParameters[0].value);
+  ASSERT_EQ(expected.edges.size(), actual.edges.size());
+  EXPECT_DOUBLE_EQ(expected.edges[0].maxSpeed, actual.edges[0].maxSpeed);
+  EXPECT_EQ(expected.edges[0].trajectory.knotVector, actual.edges[0].trajectory.knotVector);
+  ASSERT_EQ(1, actual.edges[0].trajectory.controlPoints.size());
+}
+
+TEST(Vda5050Json, OrderRoundTrip) {
+  vda5050_msgs::Order order = CreateOrder();
+
+  vda5050_msgs::Order parsed;
+  Deserialize(Serialize(order), parsed);
+  ExpectOrdersEqual(order, parsed);
+}
+
+TEST(Vda5050Json, ParsesForeignJson) {
+  // Parameter values of any type and missing optional keys, as sent by a master control.
+  std::string payload =
+      "{\"headerId\": 7, \"actions\": [{\"actionId\": \"a1\", \"actionType\": \"stateRequest\", "
+      "\"blockingType\": \"NONE\", \"actionParameters\": [{\"key\": \"n\", \"value\": 3}]}]}";
+
+  vda5050_msgs::InstantAction ia;
+  Deserialize(payload, ia);
+  EXPECT_EQ(7, ia.headerId);
+  ASSERT_EQ(1, ia.actions.size());
+  EXPECT_EQ("stateRequest", ia.actions[0].actionType);
+  EXPECT_EQ("3", ia.actions[0].actionParameters[0].value);
+  EXPECT_TRUE(ia.serialNumber.empty());
+}
+
+TEST(Vda5050Json, RejectsInvalidPayload) {
+  vda5050_msgs::Order order;
+  EXPECT_THROW(Deserialize("{\"orderId\": ", order), std::invalid_argument);
+  EXPECT_THROW(Deserialize("{\"nodes\": 5}", order), std::invalid_argument);
+  EXPECT_THROW(Deserialize("[1, 2]", order), std::invalid_argument);
+}
+
+TEST(MqttClient, PublishSubscribe) {
+  MqttClient subscriber(LocalBroker("test_subscriber"));
+  Inbox inbox;
+  subscriber.SetMessageCallback([&inbox](const std::string& topic, const std::string& payload) {
+    inbox.Add(topic, payload);
+  });
+  std::string topic = "test/" + std::to_string(getpid()) + "/order";
+  subscriber.Subscribe(topic, 1);
+  subscriber.Connect();
+  if (!WaitForConnection(subscriber, std::chrono::milliseconds(1000)))
+    GTEST_SKIP() << "No MQTT broker on localhost:1883";
+
+  MqttClient publisher(LocalBroker("test_publisher"));
+  publisher.Connect();
+  ASSERT_TRUE(WaitForConnection(publisher, std::chrono::milliseconds(1000)));
+
+  // The subscription is sent asynchronously after connecting.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  vda5050_msgs::Order order = CreateOrder();
+  ASSERT_TRUE(publisher.Publish(topic, Serialize(order), 1, false));
+
+  ASSERT_TRUE(inbox.WaitFor(1, std::chrono::milliseconds(2000)));
+  EXPECT_EQ(topic, inbox.messages[0].first);
+  vda5050_msgs::Order received;
+  Deserialize(inbox.messages[0].second, received);
+  ExpectOrdersEqual(order, received);
+}
+
+TEST(MqttClient, LastWillOnConnectionLoss) {
+  std::string topic = "test/" + std::to_string(getpid()) + "/connection";
+
+  MqttClient subscriber(LocalBroker("test_will_subscriber"));
+  Inbox inbox;
+  subscriber.SetMessageCallback([&inbox](const std::string& topic, const std::string& payload) {
+    inbox.Add(topic, payload);
+  });
+  subscriber.Subscribe(topic, 1);
+  subscriber.Connect();
+  if (!WaitForConnection(subscriber, std::chrono::milliseconds(1000)))
+    GTEST_SKIP() << "No MQTT broker on localhost:1883";
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  vda5050_msgs::Connection will;
+  will.serialNumber = "agv_1";
+  will.connectionState = "CONNECTIONBROKEN";
+
+  // The child process dies without disconnecting, like a vehicle dropping off the network.
+  pid_t child = fork();
+  ASSERT_NE(-1, child);
+  if (child == 0) {
+    MqttOptions options = LocalBroker("test_will_publisher");
+    options.willTopic = topic;
+    options.willPayload = Serialize(will);
+    options.willRetain = false;
+    MqttClient client(options);
+    client.Connect();
+    WaitForConnection(client, std::chrono::milliseconds(1000));
+    _exit(0);
+  }
+  waitpid(child, nullptr, 0);
+
+  ASSERT_TRUE(inbox.WaitFor(1, std::chrono::milliseconds(5000)));
+  vda5050_msgs::Connection received;
+  Deserialize(inbox.messages[0].second, received);
+  EXPECT_EQ("CONNECTIONBROKEN", received.connectionState);
+  EXPECT_EQ("agv_1", received.serialNumber);
+}
+
+TEST(MqttBridge, DisconnectsBeforeItIsDestroyed) {
+  if (!ros::master::check()) GTEST_SKIP() << "No ROS master";
+  MqttClient probe(LocalBroker("test_probe"));
+  probe.Connect();
+  if (!WaitForConnection(probe, std::chrono::milliseconds(1000)))
+    GTEST_SKIP() << "No MQTT broker on localhost:1883";
+
+  std::string prefix = "/test_" + std::to_string(getpid());
+  ros::NodeHandle nh;
+  ros::NodeHandle privateNh("~destroyed_bridge");
+  privateNh.setParam("mqtt/connection/host", "localhost");
+  privateNh.setParam("mqtt/connection/port", 1883);
+  privateNh.setParam("mqtt/client/client_id", LocalBroker("test_destroyed_bridge").clientId);
+  privateNh.setParam("link_state_topic", prefix + "/mqtt_link_state");
+
+  std::vector<bool> linkStates;
+  boost::function<void(const std_msgs::Bool::ConstPtr&)> callback =
+      [&linkStates](const std_msgs::Bool::ConstPtr& msg) { linkStates.push_back(msg->data); };
+  ros::Subscriber linkState = nh.subscribe(prefix + "/mqtt_link_state", 10, callback);
+  {
+    MqttBridge bridge(nh, privateNh);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    auto online = [&linkStates]() { return !linkStates.empty() && linkStates.back(); };
+    while (!online() && std::chrono::steady_clock::now() < deadline)
+      ros::getGlobalCallbackQueue()->callAvailable(ros::WallDuration(0.01));
+    ASSERT_FALSE(linkStates.empty());
+    ASSERT_TRUE(linkStates.back());
+  }
+
+  // The disconnect was reported by the network loop while the bridge still existed.
+  ros::getGlobalCallbackQueue()->callAvailable(ros::WallDuration(0.5));
+  EXPECT_FALSE(linkStates.back());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "mqtt_bridge_tester");
+  return RUN_ALL_TESTS();
+}
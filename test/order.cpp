@@ -0,0 +1,134 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <boost/make_shared.hpp>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+#include "models/Order.h"
+
+/**
+ * Builds an order through the given positions, all nodes and edges are released.
+ */
+static vda5050_msgs::Order::Ptr MakeOrder(
+    const std::vector<std::pair<double, double>>& positions, uint32_t first_sequence_id = 0) {
+  vda5050_msgs::Order::Ptr msg = boost::make_shared<vda5050_msgs::Order>();
+  msg->orderId = "order";
+  for (size_t i = 0; i < positions.size(); i++) {
+    vda5050_msgs::Node node;
+    node.nodeId = "node_" + std::to_string(first_sequence_id / 2 + i);
+    node.sequenceId = first_sequence_id + 2 * i;
+    node.released = true;
+    node.nodePosition.x = positions[i].first;
+    node.nodePosition.y = positions[i].second;
+    if (i > 0) {
+      vda5050_msgs::Edge edge;
+      edge.edgeId = "edge_" + std::to_string(node.sequenceId - 1);
+      edge.sequenceId = node.sequenceId - 1;
+      edge.released = true;
+      edge.startNodeId = msg->nodes.back().nodeId;
+      edge.endNodeId = node.nodeId;
+      msg->edges.push_back(edge);
+    }
+    msg->nodes.push_back(node);
+  }
+  return msg;
+}
+
+TEST(Order, ComputesDistancesAndEtasOfStraightEdges) {
+  vda5050_msgs::Order::Ptr msg = MakeOrder({{0, 0}, {3, 4}, {3, 10}, {0, 10}});
+  msg->edges[0].maxSpeed = 0.5;
+  msg->edges[1].maxSpeed = 4.0;
+  Order order;
+  order.SetMaxSpeed(2.0);
+  order.AcceptNewOrder(Order(msg));
+
+  EXPECT_DOUBLE_EQ(5.0, order.GetEdgeLength(0));
+  EXPECT_DOUBLE_EQ(6.0, order.GetEdgeLength(1));
+  EXPECT_DOUBLE_EQ(0.0, order.GetDistanceToNode(0));
+  EXPECT_DOUBLE_EQ(11.0, order.GetDistanceToNode(2));
+  EXPECT_DOUBLE_EQ(14.0, order.GetDistanceToNode(3));
+
+  // Speed limits of the edges above the speed of the vehicle and missing ones use the vehicle's.
+  EXPECT_DOUBLE_EQ(0.0, order.GetEtaToNode(0));
+  EXPECT_DOUBLE_EQ(10.0, order.GetEtaToNode(1));
+  EXPECT_DOUBLE_EQ(13.0, order.GetEtaToNode(2));
+  EXPECT_DOUBLE_EQ(14.5, order.GetEtaToNode(3));
+}
+
+TEST(Order, MeasuresTrajectoriesOfEdges) {
+  vda5050_msgs::Order::Ptr msg = MakeOrder({{1, 0}, {0, 1}, {0, 3}, {5, 3}});
+
+  // Quarter of the unit circle as rational quadratic curve.
+  auto& arc = msg->edges[0].trajectory;
+  arc.degree = 2;
+  arc.knotVector = {0, 0, 0, 1, 1, 1};
+  arc.controlPoints.resize(3);
+  arc.controlPoints[0].x = 1.0;
+  arc.controlPoints[1].x = 1.0;
+  arc.controlPoints[1].y = 1.0;
+  arc.controlPoints[1].weight = std::sqrt(0.5);
+  arc.controlPoints[2].y = 1.0;
+
+  // Polyline with a detour, weights are left out.
+  auto& polyline = msg->edges[1].trajectory;
+  polyline.degree = 1;
+  polyline.knotVector = {0, 0, 0.5, 1, 1};
+  polyline.controlPoints.resize(3);
+  polyline.controlPoints[0].y = 1.0;
+  polyline.controlPoints[1].x = 2.0;
+  polyline.controlPoints[1].y = 1.0;
+  polyline.controlPoints[2].y = 3.0;
+
+  // A trajectory with a wrong number of knots is ignored for the length of the edge.
+  msg->edges[2].length = 7.0;
+  msg->edges[2].trajectory.degree = 3;
+  msg->edges[2].trajectory.knotVector = {0, 1};
+  msg->edges[2].trajectory.controlPoints.resize(4);
+
+  Order order;
+  order.AcceptNewOrder(Order(msg));
+
+  EXPECT_NEAR(M_PI / 2, order.GetEdgeLength(0), 1e-3);
+  EXPECT_NEAR(2.0 + std::sqrt(8.0), order.GetEdgeLength(1), 1e-9);
+  EXPECT_DOUBLE_EQ(7.0, order.GetEdgeLength(2));
+  EXPECT_NEAR(M_PI / 2 + 2.0 + std::sqrt(8.0) + 7.0, order.GetDistanceToNode(3), 1e-3);
+}
+
+TEST(Order, KeepsTheGeometryOfTheBaseOnUpdates) {
+  vda5050_msgs::Order::Ptr msg = MakeOrder({{0, 0}, {1, 0}, {2, 0}, {3, 0}});
+  msg->nodes[3].released = false;
+  msg->edges[2].released = false;
+  Order order;
+  order.AcceptNewOrder(Order(msg));
+  EXPECT_DOUBLE_EQ(3.0, order.GetDistanceToNode(3));
+
+  // The update starts at the last node of the base and replaces the horizon.
+  vda5050_msgs::Order::Ptr update = MakeOrder({{2, 0}, {2, 5}, {2, 7}}, 4);
+  update->orderUpdateId = 1;
+  order.UpdateOrder(Order(update));
+
+  ASSERT_EQ(5, order.GetNodes().size());
+  ASSERT_EQ(4, order.GetEdges().size());
+  EXPECT_DOUBLE_EQ(2.0, order.GetDistanceToNode(2));
+  EXPECT_DOUBLE_EQ(7.0, order.GetDistanceToNode(3));
+  EXPECT_DOUBLE_EQ(9.0, order.GetDistanceToNode(4));
+  EXPECT_DOUBLE_EQ(9.0, order.GetEtaToNode(4));
+
+  EXPECT_EQ(3, order.GetNodeIndex(6).value());
+  EXPECT_FALSE(order.GetNodeIndex(5));
+  EXPECT_FALSE(order.GetNodeIndex(10));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <boost/make_shared.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ros/ros.h"
+#include "vda5050_connector/order_intake.h"
+
+using namespace connector_utils;
+
+/**
+ * Builds an order with nodes along the x axis, the first released ones form the base.
+ */
+static Order MakeOrder(const std::string& orderId, uint32_t orderUpdateId, size_t nodes,
+    size_t released, uint32_t first_sequence_id = 0) {
+  vda5050_msgs::Order::Ptr msg = boost::make_shared<vda5050_msgs::Order>();
+  msg->orderId = orderId;
+  msg->orderUpdateId = orderUpdateId;
+  for (size_t i = 0; i < nodes; i++) {
+    vda5050_msgs::Node node;
+    node.nodeId = "node_" + std::to_string(first_sequence_id / 2 + i);
+    node.sequenceId = first_sequence_id + 2 * i;
+    node.released = i < released;
+    node.nodePosition.x = static_cast<double>(first_sequence_id / 2 + i);
+    if (i > 0) {
+      vda5050_msgs::Edge edge;
+      edge.edgeId = "edge_" + std::to_string(node.sequenceId - 1);
+      edge.sequenceId = node.sequenceId - 1;
+      edge.released = node.released;
+      edge.startNodeId = msg->nodes.back().nodeId;
+      edge.endNodeId = node.nodeId;
+      msg->edges.push_back(edge);
+    }
+    msg->nodes.push_back(node);
+  }
+  return Order(msg);
+}
+
+/**
+ * Get the value of a counter by its name.
+ */
+static uint64_t Count(const Metrics& metrics, const std::string& name) {
+  std::vector<std::string> names = metrics.GetNames();
+  std::vector<uint64_t> values = metrics.Read();
+  for (size_t i = 0; i < names.size(); i++) {
+    if (names[i] == name) return values[i];
+  }
+  ADD_FAILURE() << "No counter " << name;
+  return 0;
+}
+
+TEST(OrderIntake, FiltersResentAndStaleUpdates) {
+  Metrics metrics;
+  Tracer tracer;
+  OrderIntake intake(&metrics, &tracer);
+  State state;
+  state.AcceptNewOrder(MakeOrder("order", 1, 3, 3));
+
+  OrderIntake::Verdict resent;
+  EXPECT_FALSE(intake.FilterDuplicate(MakeOrder("order", 1, 3, 3), state, &resent));
+  EXPECT_EQ(OrderIntake::DUPLICATE, resent.rejection);
+
+  OrderIntake::Verdict stale;
+  EXPECT_FALSE(intake.FilterDuplicate(MakeOrder("order", 0, 3, 3), state, &stale));
+  EXPECT_EQ(OrderIntake::STALE_UPDATE, stale.rejection);
+
+  OrderIntake::Verdict update;
+  EXPECT_TRUE(intake.FilterDuplicate(MakeOrder("order", 2, 3, 3), state, &update));
+  EXPECT_TRUE(update.update);
+
+  OrderIntake::Verdict other;
+  EXPECT_TRUE(intake.FilterDuplicate(MakeOrder("other", 0, 3, 3), state, &other));
+  EXPECT_FALSE(other.update);
+}
+
+TEST(OrderIntake, ValidatesStructureAndCapabilities) {
+  Metrics metrics;
+  Tracer tracer;
+  OrderCapabilities capabilities;
+  capabilities.maxNodes = 4;
+  capabilities.maxIdLength = 10;
+  capabilities.trajectories = false;
+  capabilities.actionTypes = {"pick", "drop"};
+  OrderIntake intake(&metrics, &tracer, capabilities);
+
+  Order line = MakeOrder("order", 0, 3, 3);
+  vda5050_msgs::Order::Ptr msg = boost::make_shared<vda5050_msgs::Order>();
+  msg->orderId = "order";
+  msg->nodes = line.GetNodes();
+  msg->edges = line.GetEdges();
+  msg->edges[1].startNodeId = "node_0";
+  OrderIntake::Verdict structure;
+  EXPECT_FALSE(intake.ValidateStructure(Order(msg), &structure));
+  EXPECT_EQ(OrderIntake::INVALID_STRUCTURE, structure.rejection);
+
+  OrderIntake::Verdict valid;
+  EXPECT_TRUE(intake.ValidateStructure(line, &valid));
+  EXPECT_TRUE(intake.ValidateCapabilities(line, &valid));
+  EXPECT_TRUE(valid.accepted);
+
+  OrderIntake::Verdict tooLong;
+  EXPECT_FALSE(intake.ValidateCapabilities(MakeOrder("order", 0, 5, 5), &tooLong));
+  EXPECT_EQ(OrderIntake::EXCEEDS_CAPABILITIES, tooLong.rejection);
+
+  msg = boost::make_shared<vda5050_msgs::Order>();
+  msg->orderId = "order";
+  msg->nodes = line.GetNodes();
+  msg->edges = line.GetEdges();
+  msg->nodes[1].actions.resize(1);
+  msg->nodes[1].actions[0].actionType = "charge";
+  OrderIntake::Verdict unknownAction;
+  EXPECT_FALSE(intake.ValidateCapabilities(Order(msg), &unknownAction));
+  EXPECT_NE(std::string::npos, unknownAction.reason.find("charge"));
+
+  msg->nodes[1].actions[0].actionType = "pick";
+  msg->edges[0].trajectory.controlPoints.resize(2);
+  OrderIntake::Verdict trajectory;
+  EXPECT_FALSE(intake.ValidateCapabilities(Order(msg), &trajectory));
+  EXPECT_EQ(OrderIntake::EXCEEDS_CAPABILITIES, trajectory.rejection);
+}
+
+TEST(OrderIntake, StitchesUpdatesToTheBase) {
+  Metrics metrics;
+  Tracer tracer;
+  OrderIntake intake(&metrics, &tracer);
+  State state;
+  Order current = MakeOrder("order", 0, 4, 3);
+  state.AcceptNewOrder(current);
+
+  // The update has to start at the last node of the base, node_2.
+  OrderIntake::Verdict stitched;
+  stitched.update = true;
+  EXPECT_TRUE(intake.StitchBase(MakeOrder("order", 1, 3, 3, 4), state, current, &stitched));
+  OrderIntake::Verdict mismatch;
+  mismatch.update = true;
+  EXPECT_FALSE(intake.StitchBase(MakeOrder("order", 1, 3, 3, 6), state, current, &mismatch));
+  EXPECT_EQ(OrderIntake::BASE_MISMATCH, mismatch.rejection);
+
+  // A new order waits until the current one is done.
+  OrderIntake::Verdict active;
+  EXPECT_FALSE(intake.StitchBase(MakeOrder("other", 0, 2, 2), state, current, &active));
+  EXPECT_EQ(OrderIntake::ORDER_ACTIVE, active.rejection);
+
+  State idle;
+  OrderIntake::Verdict started;
+  EXPECT_TRUE(intake.StitchBase(MakeOrder("other", 0, 2, 2), idle, Order(), &started));
+  OrderIntake::Verdict away;
+  EXPECT_FALSE(intake.StitchBase(MakeOrder("other", 0, 2, 2, 4), idle, Order(), &away));
+  EXPECT_EQ(OrderIntake::OUT_OF_DEVIATION_RANGE, away.rejection);
+}
+
+TEST(OrderIntake, CountsRejectionsByReasonAndTimesTheStages) {
+  Metrics metrics;
+  Tracer tracer;
+  OrderIntake intake(&metrics, &tracer);
+  State state;
+  Order current = MakeOrder("order", 1, 3, 3);
+  state.AcceptNewOrder(current);
+
+  EXPECT_FALSE(intake.Check(MakeOrder("order", 1, 3, 3), state, current).accepted);
+  EXPECT_FALSE(intake.Check(MakeOrder("order", 1, 3, 3), state, current).accepted);
+  EXPECT_FALSE(intake.Check(MakeOrder("order", 0, 3, 3), state, current).accepted);
+  EXPECT_FALSE(intake.Check(MakeOrder("other", 0, 3, 3), state, current).accepted);
+  Order update = MakeOrder("order", 2, 2, 2, 4);
+  OrderIntake::Verdict verdict = intake.Check(update, state, current);
+  EXPECT_TRUE(verdict.accepted);
+  EXPECT_TRUE(verdict.update);
+  intake.RunStage(OrderIntake::STATE_UPDATE, [&] { state.UpdateOrder(current, update); });
+
+  EXPECT_EQ(2, Count(metrics, "order rejected duplicate"));
+  EXPECT_EQ(1, Count(metrics, "order rejected stale update"));
+  EXPECT_EQ(1, Count(metrics, "order rejected order active"));
+  EXPECT_EQ(0, Count(metrics, "order rejected base mismatch"));
+  EXPECT_EQ(1, Count(metrics, "order accepted"));
+
+  // The stages after a rejection are not run.
+  EXPECT_EQ(5, Count(metrics, "order duplicate filter calls"));
+  EXPECT_EQ(2, Count(metrics, "order structure validation calls"));
+  EXPECT_EQ(2, Count(metrics, "order base stitching calls"));
+  EXPECT_EQ(1, Count(metrics, "order state update calls"));
+  EXPECT_EQ(0, Count(metrics, "order publish calls"));
+}
+
+TEST(OrderIntake, PassesOrdersOfVehiclesConcurrently) {
+  constexpr int VEHICLES = 8;
+  constexpr int ORDERS = 200;
+  Metrics metrics;
+  Tracer tracer;
+  OrderIntake intake(&metrics, &tracer);
+
+  // Each vehicle keeps its state, the intake and the metrics are shared by all of them.
+  std::vector<std::thread> vehicles;
+  for (int v = 0; v < VEHICLES; v++) {
+    vehicles.emplace_back([&intake, v]() {
+      State state;
+      Order current;
+      for (int i = 0; i < ORDERS; i++) {
+        Order order = MakeOrder("order_" + std::to_string(v) + "_" + std::to_string(i), 0, 3, 3);
+        OrderIntake::Verdict verdict = intake.Check(order, state, current);
+        if (!verdict.accepted) continue;
+        intake.RunStage(OrderIntake::STATE_UPDATE, [&] {
+          // The vehicle drives the order at once, so the next order is accepted too.
+          current.AcceptNewOrder(order);
+          state.AcceptNewOrder(order);
+          vda5050_msgs::State::Ptr done = boost::make_shared<vda5050_msgs::State>();
+          done->orderId = order.GetOrderId();
+          state.SetOrderState(done);
+        });
+        intake.Check(order, state, current);
+      }
+    });
+  }
+  for (auto& vehicle : vehicles) vehicle.join();
+
+  EXPECT_EQ(VEHICLES * ORDERS, Count(metrics, "order accepted"));
+  EXPECT_EQ(VEHICLES * ORDERS, Count(metrics, "order rejected duplicate"));
+  EXPECT_EQ(0, Count(metrics, "order rejected order active"));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "tester");
+  return RUN_ALL_TESTS();
+}
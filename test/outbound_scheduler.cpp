@@ -0,0 +1,150 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "mqtt_bridge/outbound_scheduler.h"
+
+using namespace mqtt_bridge;
+
+/**
+ * Transport that takes messages but only publishes them when told to, like a slow uplink.
+ */
+struct SlowTransport {
+  std::vector<std::string> sent;
+  bool accepting{true};
+
+  OutboundScheduler::SendFunction Send() {
+    return [this](const std::string& topic, const std::string& payload, int qos, bool retain) {
+      if (!accepting) return false;
+      sent.push_back(topic + ":" + payload);
+      return true;
+    };
+  }
+};
+
+OutboundPolicy Policy(int priority, DropPolicy dropPolicy, size_t queueDepth = 10) {
+  OutboundPolicy policy;
+  policy.priority = priority;
+  policy.dropPolicy = dropPolicy;
+  policy.queueDepth = queueDepth;
+  return policy;
+}
+
+TEST(OutboundScheduler, SendsByPriorityWhenUplinkIsBusy) {
+  SlowTransport transport;
+  OutboundScheduler scheduler(transport.Send(), 1);
+  size_t vis = scheduler.AddTopic("vis", 0, false, Policy(0, DropPolicy::LATEST_ONLY));
+  size_t state = scheduler.AddTopic("state", 0, false, Policy(2, DropPolicy::NEVER_DROP));
+  scheduler.SetConnected(true);
+
+  scheduler.Enqueue(vis, "v1");
+  scheduler.Enqueue(vis, "v2");
+  scheduler.Enqueue(state, "s1");
+  scheduler.Enqueue(vis, "v3");
+  scheduler.Enqueue(state, "s2");
+  ASSERT_EQ(std::vector<std::string>({"vis:v1"}), transport.sent);
+
+  for (int i = 0; i < 5; i++) scheduler.OnPublished();
+  // State messages overtake the waiting visualization message, which only keeps the latest one.
+  EXPECT_EQ(std::vector<std::string>({"vis:v1", "state:s1", "state:s2", "vis:v3"}), transport.sent);
+
+  std::vector<OutboundStats> stats = scheduler.GetStats();
+  EXPECT_EQ(2, stats[vis].sent);
+  EXPECT_EQ(4, stats[vis].sentBytes);
+  EXPECT_EQ(1, stats[vis].dropped);
+  EXPECT_EQ(2, stats[state].sent);
+  EXPECT_EQ(0, stats[state].dropped);
+}
+
+TEST(OutboundScheduler, DropsOldestBeyondQueueDepth) {
+  SlowTransport transport;
+  OutboundScheduler scheduler(transport.Send(), 1);
+  size_t topic = scheduler.AddTopic("t", 0, false, Policy(0, DropPolicy::DROP_OLDEST, 2));
+
+  // Nothing is sent while disconnected.
+  for (int i = 0; i < 5; i++) scheduler.Enqueue(topic, std::to_string(i));
+  EXPECT_TRUE(transport.sent.empty());
+  EXPECT_EQ(2, scheduler.GetStats()[topic].depth);
+  EXPECT_EQ(3, scheduler.GetStats()[topic].dropped);
+
+  scheduler.SetConnected(true);
+  scheduler.OnPublished();
+  EXPECT_EQ(std::vector<std::string>({"t:3", "t:4"}), transport.sent);
+}
+
+TEST(OutboundScheduler, NeverDropKeepsMessagesTheTransportRejected) {
+  SlowTransport transport;
+  OutboundScheduler scheduler(transport.Send(), 10);
+  size_t state = scheduler.AddTopic("state", 0, false, Policy(2, DropPolicy::NEVER_DROP));
+  scheduler.SetConnected(true);
+
+  transport.accepting = false;
+  for (int i = 0; i < 100; i++) scheduler.Enqueue(state, std::to_string(i));
+  EXPECT_EQ(100, scheduler.GetStats()[state].depth);
+  EXPECT_EQ(0, scheduler.GetInFlight());
+
+  transport.accepting = true;
+  scheduler.SetConnected(true);
+  EXPECT_EQ(10, transport.sent.size());
+  for (int i = 0; i < 90; i++) scheduler.OnPublished();
+  ASSERT_EQ(100, transport.sent.size());
+  for (int i = 0; i < 100; i++) EXPECT_EQ("state:" + std::to_string(i), transport.sent[i]);
+  EXPECT_EQ(0, scheduler.GetStats()[state].dropped);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+TEST(OutboundScheduler, ReplaysSpoolAfterReconnect) {
+  std::string path = "/tmp/vda5050_scheduler_spool_" + std::to_string(::getpid());
+  std::remove(path.c_str());
+
+  SlowTransport transport;
+  OutboundScheduler scheduler(transport.Send(), 10);
+  size_t state = scheduler.AddTopic("state", 0, false, Policy(2, DropPolicy::NEVER_DROP));
+  size_t vis = scheduler.AddTopic("vis", 0, false, Policy(0, DropPolicy::LATEST_ONLY));
+  scheduler.AttachSpool(state, std::unique_ptr<Spool>(new Spool(path, 4096)));
+
+  // The transport loses the connection while the first message waits.
+  transport.accepting = false;
+  scheduler.SetConnected(true);
+  scheduler.Enqueue(state, "s0");
+  scheduler.SetConnected(false);
+  for (int i = 1; i < 5; i++) scheduler.Enqueue(state, "s" + std::to_string(i));
+  EXPECT_EQ(5, scheduler.GetStats()[state].spooled);
+  EXPECT_EQ(0, scheduler.GetStats()[state].depth);
+
+  // After the reconnect, the spool is replayed at the given budget, newer messages wait behind it.
+  transport.accepting = true;
+  scheduler.SetConnected(true);
+  scheduler.Enqueue(vis, "v0");
+  scheduler.Enqueue(state, "s5");
+  EXPECT_EQ(std::vector<std::string>({"vis:v0"}), transport.sent);
+
+  scheduler.ReplaySpools(2);
+  EXPECT_EQ(std::vector<std::string>({"vis:v0", "state:s0", "state:s1"}), transport.sent);
+  scheduler.ReplaySpools(10);
+  EXPECT_EQ(std::vector<std::string>(
+                {"vis:v0", "state:s0", "state:s1", "state:s2", "state:s3", "state:s4", "state:s5"}),
+      transport.sent);
+
+  // Once the spool is empty, messages are sent right away again.
+  scheduler.Enqueue(state, "s6");
+  EXPECT_EQ("state:s6", transport.sent.back());
+  EXPECT_EQ(0, scheduler.GetStats()[state].spooled);
+  EXPECT_EQ(0, scheduler.GetStats()[state].dropped);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "utils/param_tree.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "ros/ros.h"
+
+using namespace connector_utils;
+
+/**
+ * Parameters like the ones of config/vda5050_connector.yaml, as fetched from the server.
+ */
+static ParamTree ConnectorParams() {
+  XmlRpc::XmlRpcValue root;
+  root["subscribe_topics"]["pose"] = "/pose";
+  root["subscribe_topics"]["order_from_mc"] = "order_from_mc";
+  root["publish_topics"]["state"] = "/state";
+  root["publish_periods"]["state_msg"] = 0.8;
+  root["update_period"] = 1;
+  root["tracing"]["enabled"] = true;
+  root["vehicles"][0] = "agv_1";
+  root["vehicles"][1] = "agv_2";
+  root["action_deadlines"]["types"]["pick"] = 30;
+  root["action_deadlines"]["types"]["drop"] = 12.5;
+  return ParamTree(root);
+}
+
+TEST(ParamTree, ReadsParametersByPath) {
+  ParamTree params = ConnectorParams();
+
+  double period = 0.0;
+  EXPECT_TRUE(params.Get("publish_periods/state_msg", period));
+  EXPECT_DOUBLE_EQ(0.8, period);
+  // Integers are also read as doubles, like with ros::param.
+  EXPECT_TRUE(params.Get("update_period", period));
+  EXPECT_DOUBLE_EQ(1.0, period);
+
+  bool enabled = false;
+  EXPECT_TRUE(params.Get("tracing/enabled", enabled));
+  EXPECT_TRUE(enabled);
+
+  std::vector<std::string> vehicles;
+  EXPECT_TRUE(params.Get("vehicles", vehicles));
+  EXPECT_EQ((std::vector<std::string>{"agv_1", "agv_2"}), vehicles);
+
+  std::map<std::string, double> deadlines;
+  EXPECT_TRUE(params.Get("action_deadlines/types", deadlines));
+  EXPECT_DOUBLE_EQ(30.0, deadlines["pick"]);
+  EXPECT_DOUBLE_EQ(12.5, deadlines["drop"]);
+
+  // Lists of structs, e.g. the bridges of the MQTT bridge, are read as they are.
+  XmlRpc::XmlRpcValue list;
+  EXPECT_TRUE(params.Get("vehicles", list));
+  EXPECT_EQ(XmlRpc::XmlRpcValue::TypeArray, list.getType());
+  EXPECT_EQ(2, list.size());
+
+  EXPECT_TRUE(params.Has("publish_topics"));
+  EXPECT_FALSE(params.Has("publish_topics/visualization"));
+}
+
+TEST(ParamTree, UsesDefaultsForMissingParameters) {
+  ParamTree params = ConnectorParams();
+
+  double period;
+  EXPECT_FALSE(params.Param("publish_periods/conn_msg", period, 15.0));
+  EXPECT_DOUBLE_EQ(15.0, period);
+
+  // Parameters of another type are not converted.
+  std::string topic;
+  EXPECT_FALSE(params.Param("update_period", topic, std::string("none")));
+  EXPECT_EQ("none", topic);
+  int periodMs;
+  EXPECT_FALSE(params.Param("publish_periods/state_msg", periodMs, 800));
+  EXPECT_EQ(800, periodMs);
+
+  // Paths through parameters that are no namespace do not exist.
+  EXPECT_FALSE(params.Param("update_period/value", period, 2.0));
+
+  ParamTree empty;
+  EXPECT_FALSE(empty.Has(""));
+  EXPECT_TRUE(empty.GetStrings("subscribe_topics").empty());
+}
+
+TEST(ParamTree, CollectsTopicsOfAParamFamily) {
+  ParamTree params = ConnectorParams();
+
+  std::map<std::string, std::string> topics = params.GetStrings("subscribe_topics");
+  ASSERT_EQ(2, topics.size());
+  EXPECT_EQ("/pose", topics["subscribe_topics/pose"]);
+  EXPECT_EQ("order_from_mc", topics["subscribe_topics/order_from_mc"]);
+
+  // Strings in arrays are no topics.
+  EXPECT_EQ(3, params.GetStrings("").size());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "tester");
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <boost/make_shared.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "utils/priority_lane.h"
+
+using namespace connector_utils;
+
+/**
+ * Callback of a node that takes some time and checks that no other callback of the node runs at
+ * the same time.
+ */
+class NodeCallback : public ros::CallbackInterface {
+ public:
+  struct Node {
+    std::atomic<int> running{0};
+    std::atomic<bool> overlapped{false};
+    std::atomic<int> calls{0};
+  };
+
+  NodeCallback(Node* node, std::chrono::microseconds duration, int* callsBefore = nullptr)
+      : node(node), duration(duration), callsBefore(callsBefore) {}
+
+  CallResult call() override {
+    if (node->running++ > 0) node->overlapped = true;
+    if (callsBefore) *callsBefore = node->calls;
+    std::this_thread::sleep_for(duration);
+    node->calls++;
+    node->running--;
+    return Success;
+  }
+
+ private:
+  Node* node;
+  std::chrono::microseconds duration;
+  int* callsBefore;
+};
+
+TEST(PriorityLane, CallsPriorityCallbacksBeforeQueuedRegularOnes) {
+  constexpr int REGULAR = 500;
+  ros::CallbackQueue target;
+  PriorityLane lane(&target);
+  NodeCallback::Node node;
+
+  // A backlog of regular callbacks, e.g. poses, called by the spinner of the node.
+  for (int i = 0; i < REGULAR; i++) {
+    lane.GetRegularQueue()->addCallback(
+        boost::make_shared<NodeCallback>(&node, std::chrono::microseconds(100)), 0);
+  }
+  std::thread spinner([&target]() { target.callAvailable(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+  int callsBefore = -1;
+  auto start = std::chrono::steady_clock::now();
+  lane.GetPriorityQueue()->addCallback(
+      boost::make_shared<NodeCallback>(&node, std::chrono::microseconds(0), &callsBefore), 0);
+  while (callsBefore < 0 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+    std::this_thread::yield();
+  double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  spinner.join();
+
+  // The priority callback only waited for the regular callback that was running.
+  EXPECT_GE(callsBefore, 0);
+  EXPECT_LT(callsBefore, REGULAR / 2);
+  EXPECT_LT(latency, 0.01);
+  EXPECT_EQ(REGULAR + 1, node.calls);
+  EXPECT_FALSE(node.overlapped);
+}
+
+TEST(PriorityLane, NeverCallsTheNodeFromTwoThreads) {
+  constexpr int CALLBACKS = 300;
+  ros::CallbackQueue target;
+  NodeCallback::Node node;
+  {
+    PriorityLane lane(&target);
+    std::thread spinner([&]() {
+      while (node.calls < 2 * CALLBACKS) target.callAvailable(ros::WallDuration(0.01));
+    });
+    for (int i = 0; i < CALLBACKS; i++) {
+      lane.GetRegularQueue()->addCallback(
+          boost::make_shared<NodeCallback>(&node, std::chrono::microseconds(20)), 0);
+      lane.GetPriorityQueue()->addCallback(
+          boost::make_shared<NodeCallback>(&node, std::chrono::microseconds(20)), 0);
+    }
+    spinner.join();
+  }
+
+  EXPECT_EQ(2 * CALLBACKS, node.calls);
+  EXPECT_FALSE(node.overlapped);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
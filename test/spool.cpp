@@ -0,0 +1,121 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <string>
+#include "mqtt_bridge/spool.h"
+#include "utils/mapped_file.h"
+
+using namespace mqtt_bridge;
+
+/**
+ * Spool file in /tmp that is removed after each test.
+ */
+class SpoolTest : public ::testing::Test {
+ protected:
+  std::string path{"/tmp/vda5050_spool_test_" + std::to_string(::getpid())};
+
+  void SetUp() override { std::remove(path.c_str()); }
+  void TearDown() override { std::remove(path.c_str()); }
+
+  static std::string Pop(Spool& spool) {
+    std::string payload;
+    EXPECT_TRUE(spool.Front(&payload));
+    spool.Pop();
+    return payload;
+  }
+};
+
+TEST_F(SpoolTest, KeepsOrderAcrossTheEndOfTheRing) {
+  Spool spool(path, 64);
+  size_t dropped;
+
+  // Records of 8 + 10 bytes wrap around the end of the ring several times.
+  for (int i = 0; i < 20; i++) {
+    ASSERT_TRUE(spool.Append("payload-" + std::to_string(10 + i), &dropped));
+    EXPECT_EQ(0, dropped);
+    EXPECT_EQ("payload-" + std::to_string(10 + i), Pop(spool));
+  }
+  EXPECT_TRUE(spool.Empty());
+}
+
+TEST_F(SpoolTest, DropsOldestWhenFull) {
+  Spool spool(path, 64);
+  size_t dropped;
+
+  // Three records of 18 bytes fit, the fourth one drops the oldest.
+  for (int i = 0; i < 3; i++) ASSERT_TRUE(spool.Append("payload-1" + std::to_string(i), &dropped));
+  EXPECT_EQ(0, dropped);
+  ASSERT_TRUE(spool.Append("payload-13", &dropped));
+  EXPECT_EQ(1, dropped);
+  EXPECT_EQ(3, spool.Size());
+  EXPECT_EQ("payload-11", Pop(spool));
+
+  // Payloads larger than the ring are rejected without touching the stored ones.
+  EXPECT_FALSE(spool.Append(std::string(60, 'x'), &dropped));
+  EXPECT_EQ(2, spool.Size());
+  EXPECT_EQ("payload-12", Pop(spool));
+  EXPECT_EQ("payload-13", Pop(spool));
+}
+
+TEST_F(SpoolTest, SurvivesReopen) {
+  {
+    Spool spool(path, 256);
+    size_t dropped;
+    for (int i = 0; i < 5; i++) spool.Append("state " + std::to_string(i), &dropped);
+    Pop(spool);
+    spool.Sync();
+  }
+
+  Spool spool(path, 256);
+  ASSERT_EQ(4, spool.Size());
+  for (int i = 1; i < 5; i++) EXPECT_EQ("state " + std::to_string(i), Pop(spool));
+}
+
+TEST_F(SpoolTest, DiscardsDamagedRecordsOnReopen) {
+  {
+    Spool spool(path, 256);
+    size_t dropped;
+    spool.Append("first", &dropped);
+    spool.Append("second", &dropped);
+    spool.Append("third", &dropped);
+  }
+  {
+    // Damage the payload of the second record, e.g. by a crash while it was written. The ring
+    // follows the 40 byte file header, each record has a header of 8 bytes.
+    connector_utils::MappedFile file(path, 40 + 256);
+    char* second = file.Data() + 40 + 8 + 5 + 8;
+    second[0] = 'X';
+  }
+
+  Spool spool(path, 256);
+  ASSERT_EQ(1, spool.Size());
+  EXPECT_EQ("first", Pop(spool));
+
+  size_t dropped;
+  spool.Append("fourth", &dropped);
+  EXPECT_EQ("fourth", Pop(spool));
+}
+
+TEST_F(SpoolTest, ClearsFileOfOtherCapacity) {
+  {
+    Spool spool(path, 256);
+    size_t dropped;
+    spool.Append("old", &dropped);
+  }
+  Spool spool(path, 128);
+  EXPECT_TRUE(spool.Empty());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <boost/make_shared.hpp>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "models/State.h"
+
+/** Allocations counted while counting is enabled. */
+static size_t allocations = 0;
+static bool countAllocations = false;
+
+void* operator new(std::size_t size) {
+  if (countAllocations) allocations++;
+  void* memory = std::malloc(size == 0 ? 1 : size);
+  if (!memory) throw std::bad_alloc();
+  return memory;
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+/**
+ * Incoming messages of one publish cycle, as received by the connector callbacks.
+ */
+struct Cycle {
+  vda5050_msgs::State::Ptr orderState = boost::make_shared<vda5050_msgs::State>();
+  vda5050_msgs::State::Ptr actionStates = boost::make_shared<vda5050_msgs::State>();
+  vda5050_msgs::Loads::Ptr loads = boost::make_shared<vda5050_msgs::Loads>();
+  vda5050_msgs::Information::Ptr information = boost::make_shared<vda5050_msgs::Information>();
+  vda5050_msgs::InteractionZoneStates::Ptr zones =
+      boost::make_shared<vda5050_msgs::InteractionZoneStates>();
+
+  /**
+   * Fills the messages, ids are longer than the small string buffer, so they are allocated.
+   */
+  explicit Cycle(int number) {
+    std::string suffix = "_of_publish_cycle_" + std::to_string(number);
+    orderState->orderId = "order" + suffix;
+    orderState->lastNodeId = "node_0" + suffix;
+    for (int i = 0; i < 20; i++) {
+      vda5050_msgs::NodeState node;
+      node.nodeId = "node_" + std::to_string(i) + suffix;
+      node.released = i < 10;
+      orderState->nodeStates.push_back(node);
+      vda5050_msgs::ActionState action;
+      action.actionId = "action_" + std::to_string(i) + suffix;
+      action.actionStatus = vda5050_msgs::ActionState::WAITING;
+      orderState->actionStates.push_back(action);
+    }
+    vda5050_msgs::ActionState running = orderState->actionStates[0];
+    running.actionStatus = vda5050_msgs::ActionState::RUNNING;
+    actionStates->actionStates.push_back(running);
+
+    loads->loads.resize(2);
+    loads->loads[0].loadId = "load_0" + suffix;
+    information->information.resize(3);
+    information->information[0].infoDescription = "information" + suffix;
+    zones->interactionZones.resize(4);
+    zones->interactionZones[0].zoneId = "zone_0" + suffix;
+    zones->interactionZones[0].zoneStatus = 2;
+  }
+
+  /**
+   * Passes the messages to the state like the connector callbacks and composes the state message.
+   */
+  const vda5050_msgs::State& Run(State& state) const {
+    state.SetOrderState(orderState);
+    state.UpdateActionStates(actionStates->actionStates);
+    state.SetLoads(loads);
+    state.SetInformation(information);
+    state.SetInteractionZones(zones);
+    return state.GetState();
+  }
+};
+
+TEST(State, ComposesTheKeptMessages) {
+  State state;
+  Cycle cycle(1);
+  const vda5050_msgs::State& msg = cycle.Run(state);
+
+  EXPECT_EQ("order_of_publish_cycle_1", msg.orderId);
+  ASSERT_EQ(20, msg.nodeStates.size());
+  ASSERT_EQ(20, msg.actionStates.size());
+  EXPECT_EQ(vda5050_msgs::ActionState::RUNNING, msg.actionStates[0].actionStatus);
+  EXPECT_EQ(vda5050_msgs::ActionState::WAITING, msg.actionStates[1].actionStatus);
+  EXPECT_EQ("load_0_of_publish_cycle_1", msg.loads[0].loadId);
+  EXPECT_EQ(3, msg.information.size());
+  // Zone states other than 0 are sent as 1.
+  EXPECT_EQ(1, msg.interactionZones[0].zoneStatus);
+  EXPECT_EQ(2, cycle.zones->interactionZones[0].zoneStatus);
+
+  // The incoming messages are not changed.
+  EXPECT_EQ(vda5050_msgs::ActionState::WAITING, cycle.orderState->actionStates[0].actionStatus);
+}
+
+TEST(State, KeepsOnlyTheLatestMessageOfASection) {
+  State state;
+  Cycle first(1);
+  Cycle second(2);
+  state.SetLoads(first.loads);
+  state.SetLoads(second.loads);
+  second.loads->loads.clear();
+
+  // Loads are read when the state message is composed, not when they are set.
+  EXPECT_TRUE(state.GetState().loads.empty());
+  EXPECT_EQ(1, first.loads.use_count());
+  EXPECT_EQ(1, second.loads.use_count());
+}
+
+TEST(State, PublishCycleAllocatesNothingOnceWarm) {
+  State state;
+  Cycle warmUp(1);
+  warmUp.Run(state);
+
+  // Messages of the same shape reuse the memory of the composed message.
+  Cycle cycle(2);
+  allocations = 0;
+  countAllocations = true;
+  const vda5050_msgs::State& msg = cycle.Run(state);
+  countAllocations = false;
+
+  EXPECT_EQ(0, allocations);
+  EXPECT_EQ("order_of_publish_cycle_2", msg.orderId);
+  EXPECT_EQ("node_19_of_publish_cycle_2", msg.nodeStates.back().nodeId);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "utils/strand_pool.h"
+
+using namespace connector_utils;
+
+/**
+ * Callback that appends its number to the log of its strand and checks that no other callback of
+ * the strand runs at the same time.
+ */
+class LoggingCallback : public ros::CallbackInterface {
+ public:
+  struct Log {
+    std::vector<int> numbers;
+    std::atomic<int> running{0};
+    std::atomic<bool> overlapped{false};
+  };
+
+  LoggingCallback(Log* log, int number, std::atomic<int>* done)
+      : log(log), number(number), done(done) {}
+
+  CallResult call() override {
+    if (log->running++ > 0) log->overlapped = true;
+    std::this_thread::sleep_for(std::chrono::microseconds(10));
+    log->numbers.push_back(number);
+    log->running--;
+    (*done)++;
+    return Success;
+  }
+
+ private:
+  Log* log;
+  int number;
+  std::atomic<int>* done;
+};
+
+void WaitFor(const std::atomic<int>& done, int expected) {
+  for (int i = 0; i < 5000 && done < expected; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+TEST(StrandPool, CallsCallbacksOfAStrandInOrder) {
+  constexpr int STRANDS = 8;
+  constexpr int CALLBACKS = 200;
+  StrandPool pool(4);
+  std::vector<std::unique_ptr<CallbackStrand>> strands;
+  std::vector<LoggingCallback::Log> logs(STRANDS);
+  for (int i = 0; i < STRANDS; i++) strands.emplace_back(new CallbackStrand(&pool));
+
+  // Callbacks are added from several threads, like roscpp does for timers and subscriptions.
+  std::atomic<int> done{0};
+  std::vector<std::thread> producers;
+  for (int s = 0; s < STRANDS; s++) {
+    producers.emplace_back([&, s]() {
+      for (int i = 0; i < CALLBACKS; i++)
+        strands[s]->addCallback(boost::make_shared<LoggingCallback>(&logs[s], i, &done));
+    });
+  }
+  for (std::thread& producer : producers) producer.join();
+  WaitFor(done, STRANDS * CALLBACKS);
+  pool.Stop();
+
+  ASSERT_EQ(STRANDS * CALLBACKS, done);
+  for (const LoggingCallback::Log& log : logs) {
+    EXPECT_FALSE(log.overlapped);
+    ASSERT_EQ(CALLBACKS, log.numbers.size());
+    for (int i = 0; i < CALLBACKS; i++) EXPECT_EQ(i, log.numbers[i]);
+  }
+}
+
+TEST(StrandPool, RunsStrandsInParallel) {
+  StrandPool pool(2);
+  CallbackStrand first(&pool), second(&pool);
+  LoggingCallback::Log firstLog, secondLog;
+  std::atomic<int> done{0};
+
+  // A blocked strand does not keep the other thread from running the second strand.
+  std::atomic<bool> release{false};
+  class BlockingCallback : public ros::CallbackInterface {
+   public:
+    explicit BlockingCallback(std::atomic<bool>* release) : release(release) {}
+    CallResult call() override {
+      while (!*release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      return Success;
+    }
+
+   private:
+    std::atomic<bool>* release;
+  };
+  first.addCallback(boost::make_shared<BlockingCallback>(&release));
+  first.addCallback(boost::make_shared<LoggingCallback>(&firstLog, 1, &done));
+  second.addCallback(boost::make_shared<LoggingCallback>(&secondLog, 2, &done));
+
+  WaitFor(done, 1);
+  EXPECT_EQ(1, done);
+  EXPECT_EQ(1, secondLog.numbers.size());
+  EXPECT_TRUE(firstLog.numbers.empty());
+
+  release = true;
+  WaitFor(done, 2);
+  EXPECT_EQ(std::vector<int>({1}), firstLog.numbers);
+  EXPECT_EQ(2, pool.GetThreadCount());
+}
+
+TEST(StrandPool, DrainsStrandsAfterTheStop) {
+  StrandPool pool(1);
+  pool.Stop();
+  CallbackStrand strand(&pool);
+  LoggingCallback::Log log;
+  std::atomic<int> done{0};
+
+  // The stopped pool does not call the callbacks, the strand calls them on this thread.
+  for (int i = 0; i < 3; i++)
+    strand.addCallback(boost::make_shared<LoggingCallback>(&log, i, &done));
+  EXPECT_EQ(0, done);
+  strand.Drain();
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), log.numbers);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
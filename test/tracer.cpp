@@ -0,0 +1,84 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "utils/tracer.h"
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace connector_utils;
+
+TEST(LatencyHistogram, BucketsCoverAllLatencies) {
+  for (int bucket = 0; bucket < LatencyHistogram::BUCKETS; bucket++) {
+    uint64_t lower = LatencyHistogram::LowerBound(bucket);
+    EXPECT_EQ(bucket, LatencyHistogram::BucketOf(lower));
+    if (bucket > 0) EXPECT_EQ(bucket - 1, LatencyHistogram::BucketOf(lower - 1));
+  }
+  EXPECT_EQ(LatencyHistogram::BUCKETS - 1, LatencyHistogram::BucketOf(UINT64_MAX));
+}
+
+TEST(LatencyHistogram, PercentilesAreWithinAQuarter) {
+  LatencyHistogram histogram;
+  for (uint64_t i = 1; i <= 1000; i++) histogram.Record(i * 1000);
+
+  LatencyHistogram::Snapshot snapshot = histogram.Take();
+  EXPECT_EQ(1000, snapshot.count);
+  EXPECT_EQ(1000000, snapshot.max);
+  EXPECT_NEAR(500000, snapshot.Percentile(0.5), 125000);
+  EXPECT_NEAR(990000, snapshot.Percentile(0.99), 247500);
+  EXPECT_GE(snapshot.Percentile(0.99), 990000);
+  EXPECT_EQ(1000000, snapshot.Percentile(1.0));
+
+  // Taking empties the histogram.
+  EXPECT_EQ(0, histogram.Take().count);
+}
+
+TEST(Tracer, RecordsStagesOfSpans) {
+  Tracer tracer;
+  size_t total = tracer.AddStage("order total");
+  size_t validate = tracer.AddStage("order validate");
+  EXPECT_EQ(validate, tracer.AddStage("order validate"));
+
+  // Nothing is recorded while disabled.
+  TraceSpan disabled(&tracer, total);
+  disabled.Mark(validate);
+  disabled.End();
+  EXPECT_TRUE(tracer.TakeStats().empty());
+
+  tracer.SetEnabled(true);
+  tracer.KeepEvents(10);
+  for (int i = 0; i < 3; i++) {
+    TraceSpan span(&tracer, total);
+    span.Mark(validate);
+    span.End();
+  }
+  std::vector<Tracer::StageStats> stats = tracer.TakeStats();
+  ASSERT_EQ(2, stats.size());
+  EXPECT_EQ("order total", stats[0].name);
+  EXPECT_EQ(3, stats[0].count);
+  EXPECT_EQ(3, stats[1].count);
+  EXPECT_LE(stats[1].p50, stats[1].max * 1.25 + 1e-3);
+
+  std::string path = "/tmp/tracer_test_" + std::to_string(getpid()) + ".json";
+  ASSERT_TRUE(tracer.WriteChromeTrace(path));
+  std::ifstream file(path);
+  std::stringstream content;
+  content << file.rdbuf();
+  std::remove(path.c_str());
+  EXPECT_NE(std::string::npos, content.str().find("\"traceEvents\""));
+  EXPECT_NE(std::string::npos, content.str().find("\"name\":\"order validate\""));
+  EXPECT_NE(std::string::npos, content.str().find("\"ph\":\"e\""));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -23,6 +23,29 @@ TEST(Utils, CheckRange) {
   EXPECT_FALSE(CheckRange(lowerRange, upperRange, upperRange + 0.2));
   EXPECT_FALSE(CheckRange(lowerRange, upperRange, lowerRange - 0.2));
 }
+TEST(Utils, NamespacedTopic) {
+  EXPECT_EQ("/agv_1/state", NamespacedTopic("agv_1", "/state"));
+  EXPECT_EQ("/agv_1/state", NamespacedTopic("agv_1", "state"));
+  EXPECT_EQ("/fleet/agv_1/state", NamespacedTopic("fleet/agv_1", "/state"));
+}
+TEST(Utils, InPositionDeadband) {
+  vda5050_msgs::AGVPosition last;
+  vda5050_msgs::AGVPosition position;
+  position.x = 0.05;
+  position.theta = 1.0;
+
+  // Without an angle, the heading is ignored.
+  EXPECT_TRUE(InPositionDeadband(last, position, 0.1, 0.0));
+  EXPECT_FALSE(InPositionDeadband(last, position, 0.1, 0.5));
+  EXPECT_TRUE(InPositionDeadband(last, position, 0.1, 1.5));
+  EXPECT_FALSE(InPositionDeadband(last, position, 0.01, 0.0));
+  EXPECT_FALSE(InPositionDeadband(last, position, 0.0, 1.5));
+
+  // Turns across +-pi are measured the short way.
+  last.theta = M_PI - 0.01;
+  position.theta = -M_PI + 0.01;
+  EXPECT_TRUE(InPositionDeadband(last, position, 0.1, 0.1));
+}
 
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
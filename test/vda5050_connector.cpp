@@ -0,0 +1,68 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <boost/make_shared.hpp>
+#include <cstdio>
+#include <string>
+#include "ros/ros.h"
+#include "vda5050_connector/vda5050_connector.h"
+
+/**
+ * Builds an order of two released nodes, the first one at the origin where the vehicle starts.
+ */
+static vda5050_msgs::Order::Ptr MakeOrder(const std::string& orderId) {
+  vda5050_msgs::Order::Ptr msg = boost::make_shared<vda5050_msgs::Order>();
+  msg->orderId = orderId;
+  for (int i = 0; i < 2; i++) {
+    vda5050_msgs::Node node;
+    node.nodeId = "node_" + std::to_string(i);
+    node.sequenceId = 2 * i;
+    node.released = true;
+    node.nodePosition.x = i;
+    node.nodePosition.allowedDeviationXY = 0.5;
+    node.nodePosition.allowedDeviationTheta = 3.14;
+    msg->nodes.push_back(node);
+  }
+  vda5050_msgs::Edge edge;
+  edge.edgeId = "edge_1";
+  edge.sequenceId = 1;
+  edge.released = true;
+  edge.startNodeId = "node_0";
+  edge.endNodeId = "node_1";
+  msg->edges.push_back(edge);
+  return msg;
+}
+
+TEST(VDA5050Connector, RestoresTheAcceptedOrderFromTheJournal) {
+  std::string file = "/tmp/vda5050_connector_test_" + std::to_string(::getpid());
+  std::remove(file.c_str());
+  ros::NodeHandle privateNh("~journaled_connector");
+  privateNh.setParam("journal/file", file);
+
+  {
+    VDA5050Connector connector(ros::NodeHandle(), privateNh, "serial");
+    connector.OrderCallback(MakeOrder("order"));
+    ASSERT_EQ("order", connector.GetState().GetOrderId());
+  }
+
+  // The restarted connector replays the journal before it receives anything.
+  VDA5050Connector restarted(ros::NodeHandle(), privateNh, "serial");
+  EXPECT_EQ("order", restarted.GetState().GetOrderId());
+  EXPECT_EQ("order", restarted.GetOrder().GetOrderId());
+  EXPECT_EQ(2, restarted.GetOrder().GetNodes().size());
+  std::remove(file.c_str());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "tester");
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2022 Technical University of Munich, Chair of Materials Handling,
+ * Material Flow, Logistics – All Rights Reserved
+ *
+ * You may use, distribute and modify this code under the terms of the 3-clause
+ * BSD license. You should have received a copy of that license with this file.
+ * If not, please write to {kontakt.fml@ed.tum.de}.
+ */
+
+#include "utils/zone_index.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace connector_utils;
+
+/**
+ * Zone of an axis-aligned rectangle.
+ */
+static Zone Rectangle(const std::string& id, double minX, double minY, double maxX, double maxY) {
+  return {id, "INTERACTION", {{minX, minY}, {maxX, minY}, {maxX, maxY}, {minX, maxY}}};
+}
+
+TEST(ZoneIndex, LocatesPointsInOverlappingZones) {
+  ZoneSet zoneSet{"hall_1", "map_1", {}};
+  zoneSet.zones.push_back(Rectangle("dock", 0.0, 0.0, 4.0, 4.0));
+  zoneSet.zones.push_back(Rectangle("aisle", 2.0, 2.0, 12.0, 3.0));
+  // Triangle, the corner at (10, 10) is outside of it.
+  zoneSet.zones.push_back({"ramp", "SPEED_LIMIT", {{8.0, 8.0}, {12.0, 8.0}, {8.0, 12.0}}});
+  zoneSet.zones.push_back({"line", "INVALID", {{0.0, 0.0}, {20.0, 20.0}}});
+  ZoneIndex index(zoneSet, 1.0);
+
+  // Zones with less than three vertices are left out.
+  ASSERT_EQ(3, index.GetZoneSet().zones.size());
+  EXPECT_EQ("hall_1", index.GetZoneSet().zoneSetId);
+
+  std::vector<size_t> zones;
+  index.Locate(1.0, 1.0, &zones);
+  EXPECT_EQ((std::vector<size_t>{0}), zones);
+  index.Locate(3.0, 2.5, &zones);
+  EXPECT_EQ((std::vector<size_t>{0, 1}), zones);
+  index.Locate(11.5, 2.5, &zones);
+  EXPECT_EQ((std::vector<size_t>{1}), zones);
+  index.Locate(9.0, 9.0, &zones);
+  EXPECT_EQ((std::vector<size_t>{2}), zones);
+  index.Locate(11.5, 11.5, &zones);
+  EXPECT_TRUE(zones.empty());
+  index.Locate(-1.0, 1.0, &zones);
+  EXPECT_TRUE(zones.empty());
+  index.Locate(1.0, 100.0, &zones);
+  EXPECT_TRUE(zones.empty());
+}
+
+TEST(ZoneIndex, EmptyIndexContainsNothing) {
+  std::vector<size_t> zones{7};
+  ZoneIndex().Locate(0.0, 0.0, &zones);
+  EXPECT_TRUE(zones.empty());
+  ZoneIndex(ZoneSet{"empty", "map_1", {}}, 1.0).Locate(0.0, 0.0, &zones);
+  EXPECT_TRUE(zones.empty());
+}
+
+TEST(ZoneIndex, LimitsTheNumberOfCells) {
+  // A grid of 1 cm cells over 100 km would have 10^14 cells.
+  ZoneSet zoneSet{"site", "map_1", {}};
+  zoneSet.zones.push_back(Rectangle("west", 0.0, 0.0, 1.0, 1.0));
+  zoneSet.zones.push_back(Rectangle("east", 99999.0, 99999.0, 100000.0, 100000.0));
+  ZoneIndex index(zoneSet, 0.01);
+
+  std::vector<size_t> zones;
+  index.Locate(99999.5, 99999.5, &zones);
+  EXPECT_EQ((std::vector<size_t>{1}), zones);
+  index.Locate(0.5, 0.5, &zones);
+  EXPECT_EQ((std::vector<size_t>{0}), zones);
+}
+
+TEST(ZoneIndex, LocatesAtPoseRateInLargeZoneSets) {
+  // 10000 zones of 1 m on a 100 m x 100 m site.
+  ZoneSet zoneSet{"site", "map_1", {}};
+  for (int x = 0; x < 100; x++) {
+    for (int y = 0; y < 100; y++) {
+      zoneSet.zones.push_back(Rectangle(
+          std::to_string(x) + "_" + std::to_string(y), x + 0.1, y + 0.1, x + 0.9, y + 0.9));
+    }
+  }
+  ZoneIndex index(zoneSet, 1.0);
+
+  std::vector<size_t> zones;
+  size_t found = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 100000; i++) {
+    index.Locate((i % 1000) * 0.1, (i / 1000) * 1.0 + 0.5, &zones);
+    found += zones.size();
+  }
+  std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+
+  // 8 of each 10 positions along x are inside of a zone.
+  EXPECT_EQ(80000, found);
+  // A pose takes well below a microsecond, the bound leaves room for slow machines.
+  EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 200);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}